@@ -0,0 +1,186 @@
+/**
+ * VM dispatch benchmark
+ *
+ * Compares the threaded run_frame() engine against the checked switch
+ * loop on tight interpreter loops, and the baseline JIT (jit.hpp)
+ * against the threaded engine. The fn_* cases time a function body
+ * (fast locals, and so the LOAD_FAST superinstructions) by running its
+ * code object directly, since the VM cannot call functions yet.
+ *
+ * Build and run:
+ *   g++ -std=c++20 -O3 -DNDEBUG -I. benchmarks/bench_dispatch.cpp -o bench_dispatch
+ *   (add -DCPYTHON_CPP_ATOMIC_REFCOUNT=0 to measure plain refcounts,
+ *    -DCPYTHON_CPP_SMALL_OBJECT_ALLOCATOR=0 to allocate objects with new)
+ *   ./bench_dispatch [iterations] [repetitions] [--no-optimize] [--profile PREFIX]
+ *
+ * --profile also runs each case once with the opcode profiler on and
+ * writes PREFIX_<case>.json and PREFIX_<case>.folded (flamegraph.pl
+ * input) for it.
+ */
+
+#include "src/parser/parser.hpp"
+#include "src/compiler/bytecode_compiler.hpp"
+#include "src/vm/vm.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cpython_cpp;
+
+struct BenchCase {
+    std::string name;
+    std::string source;
+};
+
+static std::shared_ptr<compiler::CodeObject> compile_source(const std::string& source, bool optimize) {
+    parser::Parser parser(source);
+    auto module = parser.parse();
+    compiler::BytecodeCompiler compiler;
+    compiler.set_optimize(optimize);
+    auto code = compiler.compile(*module, "<bench>");
+    
+    // Function cases run the body of the first (only) def
+    if (source.rfind("def ", 0) == 0) {
+        for (const auto& constant : code->co_consts) {
+            if (auto* body = std::get_if<std::shared_ptr<compiler::CodeObject>>(&constant)) {
+                return *body;
+            }
+        }
+    }
+    return code;
+}
+
+// Best-of-N wall time in milliseconds
+static double time_mode(const std::shared_ptr<compiler::CodeObject>& code,
+                        vm::DispatchMode mode, bool jit, int repetitions) {
+    double best = 1e300;
+    for (int rep = 0; rep < repetitions; ++rep) {
+        vm::VirtualMachine machine;
+        machine.set_dispatch_mode(mode);
+        machine.set_jit(jit);
+        auto start = std::chrono::steady_clock::now();
+        machine.execute(code);
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    return best;
+}
+
+// One profiled run of the threaded engine; returns its wall time in milliseconds
+static double profile_case(const std::shared_ptr<compiler::CodeObject>& code, const std::string& path,
+                           uint64_t& instructions) {
+    vm::VirtualMachine machine;
+    machine.set_profiling(true);
+    auto start = std::chrono::steady_clock::now();
+    machine.execute(code);
+    auto stop = std::chrono::steady_clock::now();
+    machine.set_profiling(false);
+    
+    std::ofstream json(path + ".json");
+    machine.profiler().write_json(json);
+    std::ofstream folded(path + ".folded");
+    machine.profiler().write_folded_stacks(folded);
+    instructions = machine.profiler().total_instructions();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    bool optimize = true;
+    std::string profile_prefix;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-optimize") {
+            optimize = false;
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profile_prefix = argv[++i];
+        }
+    }
+    std::string n = std::to_string(iterations);
+
+    std::vector<BenchCase> cases = {
+        {"while_count", "i = 0\nwhile i < " + n + ":\n    i = i + 1\n"},
+        {"while_sum",
+         "i = 0\ntotal = 0\nwhile i < " + n + ":\n    total = total + i\n    i = i + 1\n"},
+        {"while_branch",
+         "i = 0\nodd = 0\nwhile i < " + n + ":\n    i = i + 1\n    if i & 1:\n        odd = odd + 1\n"},
+        {"while_float",
+         "i = 0\nx = 0.5\nwhile i < " + n + ":\n    x = x * 1.0000001 + 0.5\n    i = i + 1\n"},
+        {"while_str_copy",
+         "i = 0\ns = 'spam'\nwhile i < " + n + ":\n    t = s\n    i = i + 1\n"},
+        {"for_range_sum", "total = 0\nfor i in range(" + n + "):\n    total = total + i\n"},
+        {"fn_while_count", "def f():\n    i = 0\n    while i < " + n + ":\n        i = i + 1\n"},
+        {"fn_while_sum",
+         "def f():\n    i = 0\n    total = 0\n    while i < " + n + ":\n"
+         "        total = total + i\n        i = i + 1\n"},
+        {"fn_for_range_sum",
+         "def f():\n    total = 0\n    for i in range(" + n + "):\n        total = total + i\n"},
+        {"fn_str_append", "def f():\n    s = ''\n    for i in range(" + n + "):\n        s += 'ab'\n"},
+        {"fn_fstring", "def f():\n    for i in range(" + n + "):\n        s = f'{i}:{i:>8}|'\n"},
+        {"fn_alloc_churn", "def f():\n    for i in range(" + n + "):\n        t = (i, [i, i], (i, i))\n"},
+    };
+
+    std::cout << "VM dispatch benchmark (" << iterations << " iterations, best of "
+              << repetitions << ")\n";
+#if CPYTHON_CPP_COMPUTED_GOTO
+    std::cout << "Threaded engine: computed goto\n";
+#else
+    std::cout << "Threaded engine: switch fallback\n";
+#endif
+#if CPYTHON_CPP_ATOMIC_REFCOUNT
+    std::cout << "Refcounts: atomic\n";
+#else
+    std::cout << "Refcounts: non-atomic\n";
+#endif
+    std::cout << "Object allocator: " << (CPYTHON_CPP_SMALL_OBJECT_ALLOCATOR ? "size-class pools" : "operator new") << "\n";
+    std::cout << "Peephole optimizer: " << (optimize ? "on" : "off") << "\n";
+    std::cout << "Baseline JIT: " << (CPYTHON_CPP_JIT ? "x86-64" : "unavailable") << "\n\n";
+    std::cout << std::left << std::setw(16) << "case"
+              << std::right << std::setw(14) << "switch (ms)"
+              << std::setw(16) << "threaded (ms)"
+              << std::setw(10) << "speedup"
+              << std::setw(12) << "jit (ms)"
+              << std::setw(10) << "speedup" << "\n";
+    std::cout << std::string(78, '-') << "\n";
+
+    std::vector<double> threaded_times;
+    for (const auto& bench : cases) {
+        auto code = compile_source(bench.source, optimize);
+        double switch_ms = time_mode(code, vm::DispatchMode::Switch, false, repetitions);
+        double threaded_ms = time_mode(code, vm::DispatchMode::Threaded, false, repetitions);
+        double jit_ms = time_mode(code, vm::DispatchMode::Threaded, true, repetitions);
+        threaded_times.push_back(threaded_ms);
+        std::cout << std::left << std::setw(16) << bench.name
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(14) << switch_ms
+                  << std::setw(16) << threaded_ms
+                  << std::setprecision(2) << std::setw(9) << (switch_ms / threaded_ms) << "x"
+                  << std::setprecision(3) << std::setw(12) << jit_ms
+                  << std::setprecision(2) << std::setw(9) << (threaded_ms / jit_ms) << "x\n";
+    }
+
+    if (!profile_prefix.empty()) {
+        std::cout << "\n" << std::left << std::setw(16) << "profiled case"
+                  << std::right << std::setw(14) << "instructions"
+                  << std::setw(16) << "profiled (ms)"
+                  << std::setw(10) << "overhead" << "\n";
+        std::cout << std::string(56, '-') << "\n";
+        for (size_t i = 0; i < cases.size(); ++i) {
+            auto code = compile_source(cases[i].source, optimize);
+            uint64_t instructions = 0;
+            double profiled_ms = profile_case(code, profile_prefix + "_" + cases[i].name, instructions);
+            std::cout << std::left << std::setw(16) << cases[i].name
+                      << std::right << std::setw(14) << instructions
+                      << std::fixed << std::setprecision(3) << std::setw(16) << profiled_ms
+                      << std::setprecision(2) << std::setw(9) << (profiled_ms / threaded_times[i]) << "x\n";
+        }
+    }
+
+    return 0;
+}
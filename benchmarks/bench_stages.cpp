@@ -0,0 +1,389 @@
+/**
+ * Pipeline stage benchmark
+ *
+ * Times each stage of the pipeline in-process, on generated corpora from
+ * 1KB to 10MB:
+ *   tokenize  Tokenizer::tokenize() over the whole source
+ *   parse     Parser::parse() (which tokenizes as it goes)
+ *   compile   BytecodeCompiler::compile() of the parsed module
+ *   execute   VirtualMachine::execute() of the module code, in a fresh VM
+ * Only the stage call itself is timed: inputs are built beforehand, and
+ * the parser's debug trace on stderr is muted while timing. Each stage
+ * runs its warmup runs, then its timed repetitions. The report gives
+ * min, median, p90, p99 and mean per stage and size, plus allocations
+ * per run: operator new calls (aligned ones included) and small-object
+ * pool blocks.
+ *
+ * Build and run:
+ *   g++ -std=c++20 -O3 -DNDEBUG -I. benchmarks/bench_stages.cpp -o bench_stages
+ *   ./bench_stages [--sizes 1KB,10KB,100KB,1MB,10MB] [--reps N] [--warmup N]
+ *                  [--stages tokenize,parse,compile,execute]
+ *                  [--json results.json] [--baseline previous.json]
+ *
+ * --json writes the results for the benchmark workflow. --baseline reads
+ * a file an earlier --json run wrote and adds the speedup of each median.
+ */
+
+#include "src/parser/tokenizer.hpp"
+#include "src/parser/parser.hpp"
+#include "src/compiler/bytecode_compiler.hpp"
+#include "src/vm/vm.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cpython_cpp;
+
+// === Allocation counting: every operator new in this process ===
+// All forms are replaced (plain, array, aligned and nothrow), so every
+// allocation and its delete go through the same pair of helpers. Memory
+// comes from malloc through helpers that are never inlined: GCC otherwise
+// pairs the free() in operator delete with the new-expression it was
+// inlined into and warns (-Wmismatched-new-delete).
+
+static std::atomic<uint64_t> heap_allocations{0};
+
+CPYTHON_CPP_NOINLINE static void* counted_malloc(size_t size) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+    throw std::bad_alloc();
+}
+
+CPYTHON_CPP_NOINLINE static void counted_free(void* ptr) noexcept { std::free(ptr); }
+
+// Over-allocate and keep the malloc pointer just below the aligned block
+CPYTHON_CPP_NOINLINE static void* counted_aligned_malloc(size_t size, std::align_val_t alignment) {
+    size_t align = std::max(static_cast<size_t>(alignment), alignof(void*));
+    char* raw = static_cast<char*>(counted_malloc(size + align + sizeof(void*)));
+    uintptr_t block = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(uintptr_t(align) - 1);
+    reinterpret_cast<void**>(block)[-1] = raw;
+    return reinterpret_cast<void*>(block);
+}
+
+CPYTHON_CPP_NOINLINE static void counted_aligned_free(void* ptr) noexcept {
+    if (ptr) counted_free(static_cast<void**>(ptr)[-1]);
+}
+
+void* operator new(size_t size) { return counted_malloc(size); }
+void* operator new[](size_t size) { return counted_malloc(size); }
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { counted_free(ptr); }
+
+void* operator new(size_t size, std::align_val_t alignment) { return counted_aligned_malloc(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return counted_aligned_malloc(size, alignment); }
+void operator delete(void* ptr, std::align_val_t) noexcept { counted_aligned_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { counted_aligned_free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { counted_aligned_free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { counted_aligned_free(ptr); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try { return counted_malloc(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try { return counted_malloc(size); } catch (...) { return nullptr; }
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return counted_aligned_malloc(size, alignment); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try { return counted_aligned_malloc(size, alignment); } catch (...) { return nullptr; }
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { counted_aligned_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { counted_aligned_free(ptr); }
+
+struct AllocationCount {
+    uint64_t heap = 0;  // operator new calls
+    uint64_t pool = 0;  // Small-object blocks (RefCounted objects)
+
+    static AllocationCount now() {
+        return {heap_allocations.load(std::memory_order_relaxed),
+                core::SmallObjectAllocator::current().stats().blocks_allocated};
+    }
+    AllocationCount operator-(const AllocationCount& other) const {
+        return {heap - other.heap, pool - other.pool};
+    }
+};
+
+// === Corpus ===
+
+/**
+ * Module source of about target_bytes: numbered records of module-level
+ * assignments (literals, f-strings, comprehensions), then functions.
+ * Sticks to what the VM runs, so every stage sees the same input. The
+ * functions come last, since a def body runs to the next def.
+ */
+static std::string generate_corpus(size_t target_bytes) {
+    std::string source;
+    source.reserve(target_bytes + 512);
+    size_t records_end = target_bytes * 7 / 10;
+    for (size_t i = 0; source.size() < records_end || i == 0; ++i) {
+        std::string n = std::to_string(i);
+        source += "# record " + n + "\n";
+        source += "v_" + n + " = " + n + " * 3 + 11\n";
+        source += "t_" + n + " = (v_" + n + ", v_" + n + " + 1, 'name_" + n + "', 2.5 * v_" + n + ")\n";
+        source += "l_" + n + " = [v_" + n + ", v_" + n + " * 2, v_" + n + " % 5, -v_" + n + "]\n";
+        source += "d_" + n + " = {'key': v_" + n + ", 'name': 'record number " + n +
+                  " with a longer string payload', 'items': l_" + n + "}\n";
+        source += "s_" + n + " = {v_" + n + ", v_" + n + " + 2}\n";
+        source += "f_" + n + " = f'{v_" + n + ":>6}|{t_" + n + "}|{v_" + n + " / 3:.3f}'\n";
+        source += "c_" + n + " = [x * 2 for x in l_" + n + " if x > 0]\n";
+        source += "b_" + n + " = v_" + n + " > 10\n";
+        source += "n_" + n + " = len(d_" + n + ") + v_" + n + " - len(l_" + n + ") // 3\n";
+    }
+    for (size_t i = 0; source.size() < target_bytes; ++i) {
+        std::string n = std::to_string(i);
+        source += "def fn_" + n + "(a, b):\n";
+        source += "    c = a + b * " + n + "\n";
+        source += "    while c > 100:\n";
+        source += "        c = c - 7\n";
+        source += "    else:\n";
+        source += "        return c * 2\n";
+    }
+    return source;
+}
+
+// "10KB" -> 10240; plain numbers are bytes
+static size_t parse_size(const std::string& text) {
+    size_t value = std::stoull(text);
+    if (text.find("MB") != std::string::npos) return value * 1024 * 1024;
+    if (text.find("KB") != std::string::npos) return value * 1024;
+    return value;
+}
+
+static std::vector<std::string> split(const std::string& text) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    for (std::string part; std::getline(stream, part, ',');) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+// === Timing ===
+
+struct StageResult {
+    std::string stage;
+    std::string size;
+    size_t bytes = 0;
+    std::vector<double> samples_ms;
+    AllocationCount allocations;  // Per run
+    double baseline_median_ms = 0;
+
+    // Nearest-rank percentile of the sorted samples
+    double percentile(double p) const {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples_ms.size()));
+        return samples_ms[std::clamp<size_t>(rank, 1, samples_ms.size()) - 1];
+    }
+    double median() const { return percentile(50); }
+    double mean() const {
+        double total = 0;
+        for (double ms : samples_ms) total += ms;
+        return total / samples_ms.size();
+    }
+    double mb_per_s() const { return bytes / (median() / 1000.0) / (1024.0 * 1024.0); }
+};
+
+/**
+ * Run prepare() then the timed run() warmup + reps times. prepare()
+ * builds the inputs of one run outside the clock; run() is the stage.
+ */
+static StageResult measure(const std::string& stage, const std::string& size, size_t bytes,
+                           int warmup, int reps,
+                           const std::function<void()>& prepare, const std::function<void()>& run,
+                           const std::function<void()>& finish) {
+    StageResult result{stage, size, bytes, {}, {}, 0};
+    for (int i = 0; i < warmup + reps; ++i) {
+        prepare();
+        std::cerr.setstate(std::ios::badbit);  // The parser's debug trace
+        AllocationCount before = AllocationCount::now();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto stop = std::chrono::steady_clock::now();
+        AllocationCount used = AllocationCount::now() - before;
+        std::cerr.clear();
+        finish();
+        if (i >= warmup) {
+            result.samples_ms.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+            result.allocations = used;
+        }
+    }
+    std::sort(result.samples_ms.begin(), result.samples_ms.end());
+    return result;
+}
+
+static std::vector<StageResult> run_size(const std::string& size, const std::vector<std::string>& stages,
+                                        int warmup, int reps) {
+    std::string source = generate_corpus(parse_size(size));
+    auto wants = [&](const std::string& stage) {
+        return std::find(stages.begin(), stages.end(), stage) != stages.end();
+    };
+    std::vector<StageResult> results;
+    auto nothing = [] {};
+
+    if (wants("tokenize")) {
+        std::unique_ptr<parser::Tokenizer> tokenizer;
+        std::vector<parser::Token> tokens;
+        results.push_back(measure("tokenize", size, source.size(), warmup, reps,
+            [&] { tokens.clear(); tokenizer = std::make_unique<parser::Tokenizer>(source); },
+            [&] { tokens = tokenizer->tokenize(); },
+            nothing));
+    }
+
+    std::unique_ptr<parser::Parser> parser;
+    std::shared_ptr<ast::Module> module;
+    if (wants("parse")) {
+        results.push_back(measure("parse", size, source.size(), warmup, reps,
+            [&] { module.reset(); parser = std::make_unique<parser::Parser>(source); },
+            [&] { module = parser->parse(); },
+            nothing));
+    }
+    if (!module && (wants("compile") || wants("execute"))) {
+        std::cerr.setstate(std::ios::badbit);
+        parser = std::make_unique<parser::Parser>(source);
+        module = parser->parse();
+        std::cerr.clear();
+    }
+
+    std::shared_ptr<compiler::CodeObject> code;
+    if (wants("compile")) {
+        std::unique_ptr<compiler::BytecodeCompiler> compiler;
+        results.push_back(measure("compile", size, source.size(), warmup, reps,
+            [&] { code.reset(); compiler = std::make_unique<compiler::BytecodeCompiler>(); },
+            [&] { code = compiler->compile(*module, "<bench>"); },
+            nothing));
+    }
+    if (wants("execute")) {
+        if (!code) {
+            compiler::BytecodeCompiler compiler;
+            code = compiler.compile(*module, "<bench>");
+        }
+        std::unique_ptr<vm::VirtualMachine> machine;
+        results.push_back(measure("execute", size, source.size(), warmup, reps,
+            [&] { machine = std::make_unique<vm::VirtualMachine>(); },
+            [&] { machine->execute(code); },
+            // Module globals and its functions form cycles
+            [&] { machine.reset(); core::GarbageCollector::current().collect(); }));
+    }
+    return results;
+}
+
+// === Reporting ===
+
+/**
+ * Medians from a file written by --json, keyed by "stage/size". Reads one
+ * result object per line, as write_json() lays them out.
+ */
+static std::map<std::string, double> read_baseline(const std::string& path) {
+    std::map<std::string, double> medians;
+    std::ifstream in(path);
+    auto field = [](const std::string& line, const std::string& name) -> std::string {
+        size_t at = line.find("\"" + name + "\": ");
+        if (at == std::string::npos) return "";
+        at += name.size() + 4;
+        if (line[at] == '"') {
+            return line.substr(at + 1, line.find('"', at + 1) - at - 1);
+        }
+        return line.substr(at, line.find_first_of(",}", at) - at);
+    };
+    for (std::string line; std::getline(in, line);) {
+        std::string stage = field(line, "stage");
+        std::string median = field(line, "median_ms");
+        if (!stage.empty() && !median.empty()) {
+            medians[stage + "/" + field(line, "size")] = std::stod(median);
+        }
+    }
+    return medians;
+}
+
+static void write_json(const std::string& path, const std::vector<StageResult>& results, int warmup, int reps) {
+    std::ofstream out(path);
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"benchmark\": \"stages\",\n  \"warmup\": " << warmup << ",\n  \"repetitions\": " << reps
+        << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\"stage\": \"" << r.stage << "\", \"size\": \"" << r.size << "\", \"bytes\": " << r.bytes
+            << ", \"min_ms\": " << r.samples_ms.front() << ", \"median_ms\": " << r.median()
+            << ", \"p90_ms\": " << r.percentile(90) << ", \"p99_ms\": " << r.percentile(99)
+            << ", \"mean_ms\": " << r.mean() << ", \"mb_per_s\": " << r.mb_per_s()
+            << ", \"heap_allocations\": " << r.allocations.heap
+            << ", \"pool_allocations\": " << r.allocations.pool;
+        if (r.baseline_median_ms > 0) {
+            out << ", \"baseline_median_ms\": " << r.baseline_median_ms
+                << ", \"speedup\": " << r.baseline_median_ms / r.median();
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> sizes = {"1KB", "10KB", "100KB", "1MB", "10MB"};
+    std::vector<std::string> stages = {"tokenize", "parse", "compile", "execute"};
+    int warmup = 2;
+    int reps = 10;
+    std::string json_path;
+    std::string baseline_path;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string value = argv[i + 1];
+        if (flag == "--sizes") sizes = split(value);
+        else if (flag == "--stages") stages = split(value);
+        else if (flag == "--reps") reps = std::max(1, std::atoi(value.c_str()));
+        else if (flag == "--warmup") warmup = std::max(0, std::atoi(value.c_str()));
+        else if (flag == "--json") json_path = value;
+        else if (flag == "--baseline") baseline_path = value;
+        else {
+            std::cerr << "unknown option " << flag << "\n";
+            return 2;
+        }
+    }
+    auto baseline = baseline_path.empty() ? std::map<std::string, double>{} : read_baseline(baseline_path);
+
+    std::cout << "Pipeline stage benchmark (" << warmup << " warmup, " << reps << " timed runs)\n\n";
+    std::cout << std::left << std::setw(10) << "stage" << std::setw(8) << "size"
+              << std::right << std::setw(12) << "median ms" << std::setw(10) << "p90 ms"
+              << std::setw(10) << "MB/s" << std::setw(12) << "new/run" << std::setw(12) << "pool/run"
+              << (baseline.empty() ? "" : "   speedup") << "\n";
+    std::cout << std::string(baseline.empty() ? 74 : 84, '-') << "\n";
+
+    std::vector<StageResult> results;
+    for (const auto& size : sizes) {
+        for (auto& r : run_size(size, stages, warmup, reps)) {
+            auto it = baseline.find(r.stage + "/" + r.size);
+            if (it != baseline.end()) r.baseline_median_ms = it->second;
+            std::cout << std::left << std::setw(10) << r.stage << std::setw(8) << r.size
+                      << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(12) << r.median() << std::setw(10) << r.percentile(90)
+                      << std::setprecision(1) << std::setw(10) << r.mb_per_s()
+                      << std::setw(12) << r.allocations.heap << std::setw(12) << r.allocations.pool;
+            if (r.baseline_median_ms > 0) {
+                std::cout << std::setprecision(2) << std::setw(9) << r.baseline_median_ms / r.median() << "x";
+            }
+            std::cout << "\n";
+            results.push_back(std::move(r));
+        }
+    }
+
+    if (!json_path.empty()) {
+        write_json(json_path, results, warmup, reps);
+        std::cout << "\nResults written to " << json_path << "\n";
+    }
+    return 0;
+}
@@ -1,16 +1,74 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <iterator>
 #include "src/parser/parser.hpp"
 #include "src/compiler/compiler.hpp"
+#include "src/driver/batch_driver.hpp"
+#include <string>
+#include <vector>
+
+// --batch [-j N] [--cache] <file|dir>...: parse and compile many files in parallel
+static int run_batch(int argc, char* argv[]) {
+    size_t jobs = 0;
+    bool use_cache = false;
+    std::vector<std::string> paths;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            jobs = std::stoul(argv[++i]);
+        } else if (arg == "--cache") {
+            use_cache = true;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --batch [-j N] [--cache] <file|dir>..." << std::endl;
+        return 1;
+    }
+
+    auto files = cpython_cpp::driver::BatchDriver::collect_sources(paths);
+
+    // The parser's debug trace goes to std::cerr; mute it for the batch
+    std::streambuf* saved_cerr = std::cerr.rdbuf(nullptr);
+    cpython_cpp::driver::BatchDriver driver(jobs, use_cache);
+    auto report = driver.run(files);
+    std::cerr.rdbuf(saved_cerr);
+    std::cerr.clear();
+
+    for (const auto& result : report.files) {
+        if (!result.ok) {
+            std::cout << "FAIL " << result.path << "\n";
+            for (const auto& error : result.errors) {
+                std::cout << "  " << error << "\n";
+            }
+        }
+    }
+
+    std::cout << "=== Batch Summary ===\n";
+    std::cout << "Files: " << report.files.size() << " (" << report.succeeded << " ok, "
+              << report.failed << " failed, " << report.cached << " from cache)\n";
+    std::cout << "Threads: " << driver.thread_count() << "\n";
+    std::cout << "Total functions: " << report.totals.function_count << "\n";
+    std::cout << "Total statements: " << report.totals.statement_count << "\n";
+    std::cout << "Total expressions: " << report.totals.expression_count << "\n";
+    std::cout << "Time: " << report.seconds << " s\n";
+
+    return report.failed == 0 ? 0 : 1;
+}
 
 int main(int argc, char* argv[]) {
     std::cout << "CPython C++ Parser and Compiler\n";
     std::cout << "===============================\n\n";
 
+    if (argc >= 2 && std::string(argv[1]) == "--batch") {
+        return run_batch(argc, argv);
+    }
+
     if (argc < 2) {
         std::cerr << "Error: No file provided" << std::endl;
         std::cerr << "Usage: " << argv[0] << " <python_script.py>" << std::endl;
+        std::cerr << "       " << argv[0] << " --batch [-j N] [--cache] <file|dir>..." << std::endl;
         return 1;
     }
 
@@ -22,9 +80,8 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    std::ostringstream buffer;
-    buffer << file.rdbuf();
-    std::string source_code = buffer.str();
+    std::string source_code((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
     file.close();
 
     if (source_code.empty()) {
@@ -37,7 +94,8 @@ int main(int argc, char* argv[]) {
 
     try {
         // Parse the source code
-        cpython_cpp::parser::Parser parser(source_code);
+        // The parser takes ownership of the only copy of the source
+        cpython_cpp::parser::Parser parser(std::move(source_code));
         auto ast_module = parser.parse();
 
         std::cout << "=== AST Structure ===\n";
@@ -0,0 +1,143 @@
+#ifndef CPYTHON_CPP_AST_ARENA_HPP
+#define CPYTHON_CPP_AST_ARENA_HPP
+
+#include "node.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cpython_cpp {
+namespace ast {
+
+/**
+ * Arena - bump allocator that owns every node of one AST
+ * Reference: Python/pyarena.c
+ *
+ * Nodes are placement-constructed into large chunks and point at each
+ * other through plain non-owning pointers. Nothing is freed individually:
+ * the arena runs the nodes' destructors (newest first) and releases its
+ * chunks in one go when it is destroyed.
+ *
+ * Objects that need destroying must be AST nodes: each one is linked into
+ * a list through its header, which also lets for_each_node() revisit the
+ * nodes made between two mark()s (used by incremental re-parsing to
+ * move reused statements to their new lines).
+ */
+class Arena {
+public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    Arena() = default;
+    ~Arena();
+
+    // Nodes hold pointers into the chunks, so the arena never moves
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Construct a T in the arena; it lives as long as the arena does
+    template<typename T, typename... Args>
+    T* make(Args&&... args);
+
+    // Total bytes handed out so far (headers and padding included)
+    size_t bytes_used() const { return bytes_used_; }
+
+private:
+    // Prepended to every AST node; destroyed through its virtual destructor
+    struct Finalizer {
+        Finalizer* next;
+        ASTNodeBase* node;
+    };
+
+public:
+    // Allocation point, as returned by mark()
+    class Mark {
+        friend class Arena;
+        const Finalizer* top_ = nullptr;
+    };
+
+    Mark mark() const {
+        Mark m;
+        m.top_ = finalizers_;
+        return m;
+    }
+
+    // Call f(ASTNodeBase*) for each node made after from and up to to, newest first
+    template<typename F>
+    void for_each_node(Mark from, Mark to, F&& f) const {
+        for (const Finalizer* it = to.top_; it != nullptr && it != from.top_; it = it->next) {
+            f(it->node);
+        }
+    }
+
+private:
+
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    void* allocate(size_t size, size_t align);
+
+    std::vector<Chunk> chunks_;
+    std::byte* cursor_ = nullptr;
+    std::byte* limit_ = nullptr;
+    Finalizer* finalizers_ = nullptr;  // Most recent object first
+    size_t bytes_used_ = 0;
+};
+
+inline Arena::~Arena() {
+    for (Finalizer* f = finalizers_; f != nullptr;) {
+        Finalizer* next = f->next;
+        f->node->~ASTNodeBase();
+        f = next;
+    }
+}
+
+inline void* Arena::allocate(size_t size, size_t align) {
+    auto fits = [&](std::byte* at) {
+        size_t pad = (align - reinterpret_cast<uintptr_t>(at) % align) % align;
+        return at != nullptr && pad + size <= static_cast<size_t>(limit_ - at);
+    };
+    if (!fits(cursor_)) {
+        // Oversized requests get a chunk of their own
+        size_t chunk_size = size + align > kChunkSize ? size + align : kChunkSize;
+        chunks_.push_back({std::make_unique<std::byte[]>(chunk_size), chunk_size});
+        cursor_ = chunks_.back().data.get();
+        limit_ = cursor_ + chunk_size;
+    }
+    size_t pad = (align - reinterpret_cast<uintptr_t>(cursor_) % align) % align;
+    std::byte* result = cursor_ + pad;
+    cursor_ = result + size;
+    bytes_used_ += pad + size;
+    return result;
+}
+
+template<typename T, typename... Args>
+T* Arena::make(Args&&... args) {
+    if constexpr (std::is_trivially_destructible_v<T>) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    } else {
+        // Finalizer header directly followed by the object
+        static_assert(std::is_base_of_v<ASTNodeBase, T>,
+                      "only AST nodes may have a non-trivial destructor");
+        static_assert(alignof(T) <= alignof(Finalizer),
+                      "over-aligned AST nodes are not supported");
+        static_assert(sizeof(Finalizer) % alignof(T) == 0);
+        auto* header = static_cast<Finalizer*>(
+            allocate(sizeof(Finalizer) + sizeof(T), alignof(Finalizer)));
+        T* object = new (header + 1) T(std::forward<Args>(args)...);
+        header->node = object;
+        header->next = finalizers_;
+        finalizers_ = header;
+        return object;
+    }
+}
+
+} // namespace ast
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_AST_ARENA_HPP
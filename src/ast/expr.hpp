@@ -18,14 +18,18 @@ namespace ast {
 // Constant expression
 class Constant : public ASTNodeBase {
 public:
-    Constant(const std::string& value, int lineno, int col_offset)
-        : ASTNodeBase(lineno, col_offset), value_(value) {}
+    // value is the decoded text of a str literal when is_str, and the
+    // source spelling of a number, True, False or None otherwise
+    Constant(const std::string& value, int lineno, int col_offset, bool is_str = false)
+        : ASTNodeBase(lineno, col_offset), value_(value), is_str_(is_str) {}
 
     std::string value() const { return value_; }
+    bool is_str() const { return is_str_; }
     std::string to_string(int indent = 0) const override;
 
 private:
     std::string value_;
+    bool is_str_;
 };
 
 // Ellipsis expression (...)
@@ -55,69 +59,69 @@ private:
 // Binary operation
 class BinOp : public ASTNodeBase {
 public:
-    BinOp(std::shared_ptr<Expr> left, Operator op, std::shared_ptr<Expr> right,
+    BinOp(Expr* left, Operator op, Expr* right,
           int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), left_(left), op_(op), right_(right) {}
 
-    std::shared_ptr<Expr> left() const { return left_; }
+    Expr* left() const { return left_; }
     Operator op() const { return op_; }
-    std::shared_ptr<Expr> right() const { return right_; }
+    Expr* right() const { return right_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> left_;
+    Expr* left_;
     Operator op_;
-    std::shared_ptr<Expr> right_;
+    Expr* right_;
 };
 
 // Function call
 class Call : public ASTNodeBase {
 public:
-    Call(std::shared_ptr<Expr> func, std::vector<std::shared_ptr<Expr>> args,
+    Call(Expr* func, std::vector<Expr*> args,
          int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), func_(func), args_(args) {}
 
-    std::shared_ptr<Expr> func() const { return func_; }
-    const std::vector<std::shared_ptr<Expr>>& args() const { return args_; }
+    Expr* func() const { return func_; }
+    const std::vector<Expr*>& args() const { return args_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> func_;
-    std::vector<std::shared_ptr<Expr>> args_;
+    Expr* func_;
+    std::vector<Expr*> args_;
 };
 
 // Boolean operation (and/or)
 class BoolOpExpr : public ASTNodeBase {
 public:
-    BoolOpExpr(ast::BoolOp op, std::vector<std::shared_ptr<Expr>> values,
+    BoolOpExpr(ast::BoolOp op, std::vector<Expr*> values,
                int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), op_(op), values_(values) {}
 
     ast::BoolOp op() const { return op_; }
-    const std::vector<std::shared_ptr<Expr>>& values() const { return values_; }
+    const std::vector<Expr*>& values() const { return values_; }
     std::string to_string(int indent = 0) const override;
 
 private:
     ast::BoolOp op_;
-    std::vector<std::shared_ptr<Expr>> values_;
+    std::vector<Expr*> values_;
 };
 
 // Comparison operation
 class Compare : public ASTNodeBase {
 public:
-    Compare(std::shared_ptr<Expr> left, CompareOp op, std::shared_ptr<Expr> right,
+    Compare(Expr* left, CompareOp op, Expr* right,
             int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), left_(left), op_(op), right_(right) {}
 
-    std::shared_ptr<Expr> left() const { return left_; }
+    Expr* left() const { return left_; }
     CompareOp op() const { return op_; }
-    std::shared_ptr<Expr> right() const { return right_; }
+    Expr* right() const { return right_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> left_;
+    Expr* left_;
     CompareOp op_;
-    std::shared_ptr<Expr> right_;
+    Expr* right_;
 };
 
 // Unary operation
@@ -127,98 +131,98 @@ public:
         Not, UAdd, USub, Invert
     };
 
-    UnaryOp(UnaryOpType op, std::shared_ptr<Expr> operand,
+    UnaryOp(UnaryOpType op, Expr* operand,
             int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), op_(op), operand_(operand) {}
 
     UnaryOpType op() const { return op_; }
-    std::shared_ptr<Expr> operand() const { return operand_; }
+    Expr* operand() const { return operand_; }
     std::string to_string(int indent = 0) const override;
 
 private:
     UnaryOpType op_;
-    std::shared_ptr<Expr> operand_;
+    Expr* operand_;
 };
 
 // List literal
 class List : public ASTNodeBase {
 public:
-    List(std::vector<std::shared_ptr<Expr>> elts, ExprContext ctx,
+    List(std::vector<Expr*> elts, ExprContext ctx,
          int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), elts_(elts), ctx_(ctx) {}
 
-    const std::vector<std::shared_ptr<Expr>>& elts() const { return elts_; }
+    const std::vector<Expr*>& elts() const { return elts_; }
     ExprContext ctx() const { return ctx_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Expr>> elts_;
+    std::vector<Expr*> elts_;
     ExprContext ctx_;
 };
 
 // Dictionary literal
 class Dict : public ASTNodeBase {
 public:
-    Dict(std::vector<std::shared_ptr<Expr>> keys,
-         std::vector<std::shared_ptr<Expr>> values,
+    Dict(std::vector<Expr*> keys,
+         std::vector<Expr*> values,
          int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), keys_(keys), values_(values) {}
 
-    const std::vector<std::shared_ptr<Expr>>& keys() const { return keys_; }
-    const std::vector<std::shared_ptr<Expr>>& values() const { return values_; }
+    const std::vector<Expr*>& keys() const { return keys_; }
+    const std::vector<Expr*>& values() const { return values_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Expr>> keys_;
-    std::vector<std::shared_ptr<Expr>> values_;
+    std::vector<Expr*> keys_;
+    std::vector<Expr*> values_;
 };
 
 // Tuple literal
 class Tuple : public ASTNodeBase {
 public:
-    Tuple(std::vector<std::shared_ptr<Expr>> elts, ExprContext ctx,
+    Tuple(std::vector<Expr*> elts, ExprContext ctx,
           int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), elts_(elts), ctx_(ctx) {}
 
-    const std::vector<std::shared_ptr<Expr>>& elts() const { return elts_; }
+    const std::vector<Expr*>& elts() const { return elts_; }
     ExprContext ctx() const { return ctx_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Expr>> elts_;
+    std::vector<Expr*> elts_;
     ExprContext ctx_;
 };
 
 // Set literal: {1, 2, 3}
 class Set : public ASTNodeBase {
 public:
-    Set(std::vector<std::shared_ptr<Expr>> elts, ExprContext ctx,
+    Set(std::vector<Expr*> elts, ExprContext ctx,
         int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), elts_(elts), ctx_(ctx) {}
 
-    const std::vector<std::shared_ptr<Expr>>& elts() const { return elts_; }
+    const std::vector<Expr*>& elts() const { return elts_; }
     ExprContext ctx() const { return ctx_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Expr>> elts_;
+    std::vector<Expr*> elts_;
     ExprContext ctx_;
 };
 
 // Attribute access (obj.attr)
 class Attribute : public ASTNodeBase {
 public:
-    Attribute(std::shared_ptr<Expr> value, const std::string& attr, ExprContext ctx,
+    Attribute(Expr* value, const std::string& attr, ExprContext ctx,
               int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), value_(value), attr_(attr), ctx_(ctx) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* value() const { return value_; }
     std::string attr() const { return attr_; }
     ExprContext ctx() const { return ctx_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;
+    Expr* value_;
     std::string attr_;
     ExprContext ctx_;
 };
@@ -226,36 +230,36 @@ private:
 // Slice (start:end:step) - can only appear in Subscript
 class Slice : public ASTNodeBase {
 public:
-    Slice(std::shared_ptr<Expr> lower, std::shared_ptr<Expr> upper, std::shared_ptr<Expr> step,
+    Slice(Expr* lower, Expr* upper, Expr* step,
           int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), lower_(lower), upper_(upper), step_(step) {}
 
-    std::shared_ptr<Expr> lower() const { return lower_; }
-    std::shared_ptr<Expr> upper() const { return upper_; }
-    std::shared_ptr<Expr> step() const { return step_; }
+    Expr* lower() const { return lower_; }
+    Expr* upper() const { return upper_; }
+    Expr* step() const { return step_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> lower_;   // start (can be nullptr)
-    std::shared_ptr<Expr> upper_;   // end (can be nullptr)
-    std::shared_ptr<Expr> step_;    // step (can be nullptr)
+    Expr* lower_;                   // start (can be nullptr)
+    Expr* upper_;                   // end (can be nullptr)
+    Expr* step_;                    // step (can be nullptr)
 };
 
 // Subscript (obj[key] or obj[start:end:step])
 class Subscript : public ASTNodeBase {
 public:
-    Subscript(std::shared_ptr<Expr> value, std::shared_ptr<Expr> slice, ExprContext ctx,
+    Subscript(Expr* value, Expr* slice, ExprContext ctx,
               int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), value_(value), slice_(slice), ctx_(ctx) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }
-    std::shared_ptr<Expr> slice() const { return slice_; }
+    Expr* value() const { return value_; }
+    Expr* slice() const { return slice_; }
     ExprContext ctx() const { return ctx_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;
-    std::shared_ptr<Expr> slice_;  // Can be an expression (index) or Slice node
+    Expr* value_;
+    Expr* slice_;                  // Can be an expression (index) or Slice node
     ExprContext ctx_;
 };
 
@@ -263,16 +267,16 @@ private:
 // Reference: Python.asdl - Starred(expr value, expr_context ctx)
 class Starred : public ASTNodeBase {
 public:
-    Starred(std::shared_ptr<Expr> value, ExprContext ctx,
+    Starred(Expr* value, ExprContext ctx,
             int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), value_(value), ctx_(ctx) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* value() const { return value_; }
     ExprContext ctx() const { return ctx_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;  // The expression being starred
+    Expr* value_;                  // The expression being starred
     ExprContext ctx_;              // Load (reading) or Store (assignment)
 };
 
@@ -524,168 +528,168 @@ inline std::string Starred::to_string(int indent) const {
 class Lambda : public ASTNodeBase {
 public:
     Lambda(std::vector<std::string> args,
-           std::shared_ptr<Expr> body,
+           Expr* body,
            int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), args_(args), body_(body) {}
 
     const std::vector<std::string>& args() const { return args_; }
-    std::shared_ptr<Expr> body() const { return body_; }
+    Expr* body() const { return body_; }
     std::string to_string(int indent = 0) const override;
 
 private:
     std::vector<std::string> args_;
-    std::shared_ptr<Expr> body_;
+    Expr* body_;
 };
 
 // Yield expression (generator)
 class Yield : public ASTNodeBase {
 public:
-    Yield(std::shared_ptr<Expr> value, int lineno, int col_offset)
+    Yield(Expr* value, int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), value_(value) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }  // nullptr if no value
+    Expr* value() const { return value_; }                  // nullptr if no value
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;
+    Expr* value_;
 };
 
 // Yield from expression (generator delegation)
 class YieldFrom : public ASTNodeBase {
 public:
-    YieldFrom(std::shared_ptr<Expr> value, int lineno, int col_offset)
+    YieldFrom(Expr* value, int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), value_(value) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* value() const { return value_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;
+    Expr* value_;
 };
 
 // Await expression (Python 3.5+)
 class Await : public ASTNodeBase {
 public:
-    Await(std::shared_ptr<Expr> value, int lineno, int col_offset)
+    Await(Expr* value, int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), value_(value) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* value() const { return value_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;
+    Expr* value_;
 };
 
 // Named expression (walrus operator): name := value (Python 3.8+)
 class NamedExpr : public ASTNodeBase {
 public:
-    NamedExpr(std::shared_ptr<Expr> target, std::shared_ptr<Expr> value,
+    NamedExpr(Expr* target, Expr* value,
               int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), target_(target), value_(value) {}
 
-    std::shared_ptr<Expr> target() const { return target_; }
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* target() const { return target_; }
+    Expr* value() const { return value_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> target_;
-    std::shared_ptr<Expr> value_;
+    Expr* target_;
+    Expr* value_;
 };
 
 // Conditional expression (ternary operator): x if condition else y
 class IfExp : public ASTNodeBase {
 public:
-    IfExp(std::shared_ptr<Expr> test, std::shared_ptr<Expr> body, std::shared_ptr<Expr> orelse,
+    IfExp(Expr* test, Expr* body, Expr* orelse,
           int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), test_(test), body_(body), orelse_(orelse) {}
 
-    std::shared_ptr<Expr> test() const { return test_; }
-    std::shared_ptr<Expr> body() const { return body_; }
-    std::shared_ptr<Expr> orelse() const { return orelse_; }
+    Expr* test() const { return test_; }
+    Expr* body() const { return body_; }
+    Expr* orelse() const { return orelse_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> test_;
-    std::shared_ptr<Expr> body_;
-    std::shared_ptr<Expr> orelse_;
+    Expr* test_;
+    Expr* body_;
+    Expr* orelse_;
 };
 
 // Comprehension helper struct (for comprehensions and generator expressions)
 struct Comprehension {
-    std::shared_ptr<Expr> target;      // star_targets
-    std::shared_ptr<Expr> iter;        // disjunction (the iterable)
-    std::vector<std::shared_ptr<Expr>> ifs;  // Optional if conditions
+    Expr* target;                      // star_targets
+    Expr* iter;                        // disjunction (the iterable)
+    std::vector<Expr*> ifs;                  // Optional if conditions
     bool is_async;                     // True for 'async for' (Python 3.6+)
 
-    Comprehension(std::shared_ptr<Expr> t, std::shared_ptr<Expr> i,
-                  std::vector<std::shared_ptr<Expr>> conditions, bool async = false)
+    Comprehension(Expr* t, Expr* i,
+                  std::vector<Expr*> conditions, bool async = false)
         : target(t), iter(i), ifs(conditions), is_async(async) {}
 };
 
 // List comprehension: [x for x in range(10)]
 class ListComp : public ASTNodeBase {
 public:
-    ListComp(std::shared_ptr<Expr> elt, std::vector<Comprehension> generators,
+    ListComp(Expr* elt, std::vector<Comprehension> generators,
              int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), elt_(elt), generators_(generators) {}
 
-    std::shared_ptr<Expr> elt() const { return elt_; }
+    Expr* elt() const { return elt_; }
     const std::vector<Comprehension>& generators() const { return generators_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> elt_;
+    Expr* elt_;
     std::vector<Comprehension> generators_;
 };
 
 // Set comprehension: {x for x in range(10)}
 class SetComp : public ASTNodeBase {
 public:
-    SetComp(std::shared_ptr<Expr> elt, std::vector<Comprehension> generators,
+    SetComp(Expr* elt, std::vector<Comprehension> generators,
             int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), elt_(elt), generators_(generators) {}
 
-    std::shared_ptr<Expr> elt() const { return elt_; }
+    Expr* elt() const { return elt_; }
     const std::vector<Comprehension>& generators() const { return generators_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> elt_;
+    Expr* elt_;
     std::vector<Comprehension> generators_;
 };
 
 // Dictionary comprehension: {k: v for k, v in items}
 class DictComp : public ASTNodeBase {
 public:
-    DictComp(std::shared_ptr<Expr> key, std::shared_ptr<Expr> value,
+    DictComp(Expr* key, Expr* value,
              std::vector<Comprehension> generators,
              int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), key_(key), value_(value), generators_(generators) {}
 
-    std::shared_ptr<Expr> key() const { return key_; }
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* key() const { return key_; }
+    Expr* value() const { return value_; }
     const std::vector<Comprehension>& generators() const { return generators_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> key_;
-    std::shared_ptr<Expr> value_;
+    Expr* key_;
+    Expr* value_;
     std::vector<Comprehension> generators_;
 };
 
 // Generator expression: (x for x in range(10))
 class GeneratorExp : public ASTNodeBase {
 public:
-    GeneratorExp(std::shared_ptr<Expr> elt, std::vector<Comprehension> generators,
+    GeneratorExp(Expr* elt, std::vector<Comprehension> generators,
                 int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), elt_(elt), generators_(generators) {}
 
-    std::shared_ptr<Expr> elt() const { return elt_; }
+    Expr* elt() const { return elt_; }
     const std::vector<Comprehension>& generators() const { return generators_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> elt_;
+    Expr* elt_;
     std::vector<Comprehension> generators_;
 };
 
@@ -852,43 +856,43 @@ inline std::string GeneratorExp::to_string(int indent) const {
 // FormattedValue - represents {expr!conversion:format_spec} in f-strings
 class FormattedValue : public ASTNodeBase {
 public:
-    FormattedValue(std::shared_ptr<Expr> value, int conversion,
-                   std::shared_ptr<Expr> format_spec,
+    FormattedValue(Expr* value, int conversion,
+                   Expr* format_spec,
                    int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), value_(value),
           conversion_(conversion), format_spec_(format_spec) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* value() const { return value_; }
     int conversion() const { return conversion_; }  // -1 for none, 115='s', 114='r', 97='a'
-    std::shared_ptr<Expr> format_spec() const { return format_spec_; }
+    Expr* format_spec() const { return format_spec_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;
+    Expr* value_;
     int conversion_;  // -1 for none, 115='s', 114='r', 97='a'
-    std::shared_ptr<Expr> format_spec_;  // Can be nullptr or a JoinedStr for nested f-strings
+    Expr* format_spec_;                  // Can be nullptr or a JoinedStr for nested f-strings
 };
 
 // JoinedStr - represents an f-string with alternating string parts and FormattedValue nodes
 class JoinedStr : public ASTNodeBase {
 public:
-    JoinedStr(std::vector<std::shared_ptr<Expr>> values, int lineno, int col_offset)
+    JoinedStr(std::vector<Expr*> values, int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), values_(values) {}
 
-    const std::vector<std::shared_ptr<Expr>>& values() const { return values_; }
+    const std::vector<Expr*>& values() const { return values_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Expr>> values_;  // Alternating Constant (strings) and FormattedValue
+    std::vector<Expr*> values_;                  // Alternating Constant (strings) and FormattedValue
 };
 
 // Interpolation - represents an interpolated expression within a t-string (PEP 750)
 class Interpolation : public ASTNodeBase {
 public:
-    Interpolation(std::shared_ptr<Expr> value,
+    Interpolation(Expr* value,
                   const std::string& expr_str,
                   int conversion,
-                  std::shared_ptr<Expr> format_spec,
+                  Expr* format_spec,
                   int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset),
           value_(value),
@@ -896,31 +900,31 @@ public:
           conversion_(conversion),
           format_spec_(format_spec) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* value() const { return value_; }
     const std::string& expr_str() const { return expr_str_; }
     int conversion() const { return conversion_; }
-    std::shared_ptr<Expr> format_spec() const { return format_spec_; }
+    Expr* format_spec() const { return format_spec_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;
+    Expr* value_;
     std::string expr_str_;
     int conversion_;
-    std::shared_ptr<Expr> format_spec_;
+    Expr* format_spec_;
 };
 
 // TemplateStr - represents a template string literal (t-string, PEP 750)
 class TemplateStr : public ASTNodeBase {
 public:
-    TemplateStr(std::vector<std::shared_ptr<Expr>> values,
+    TemplateStr(std::vector<Expr*> values,
                 int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), values_(std::move(values)) {}
 
-    const std::vector<std::shared_ptr<Expr>>& values() const { return values_; }
+    const std::vector<Expr*>& values() const { return values_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Expr>> values_;
+    std::vector<Expr*> values_;
 };
 
 inline std::string FormattedValue::to_string(int indent) const {
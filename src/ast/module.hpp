@@ -3,6 +3,7 @@
 
 #include "node.hpp"
 #include "stmt.hpp"
+#include "arena.hpp"
 #include <vector>
 #include <memory>
 #include <string>
@@ -15,14 +16,22 @@ namespace ast {
 /**
  * Module AST node (top-level)
  * Reference: Parser/Python.asdl (mod definitions)
+ *
+ * The module owns the arenas its statements were allocated in, so the
+ * whole tree is freed together with the module. A module produced by an
+ * incremental re-parse shares the arenas of the statements it reused.
  */
 class Module : public ASTNodeBase {
 public:
-    Module(std::vector<std::shared_ptr<Stmt>> body)
+    Module(std::vector<Stmt*> body)
         : ASTNodeBase(1, 0), body_(body) {}
 
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    void add_stmt(std::shared_ptr<Stmt> stmt) { body_.push_back(stmt); }
+    const std::vector<Stmt*>& body() const { return body_; }
+    void add_stmt(Stmt* stmt) { body_.push_back(stmt); }
+
+    // Keep alive an arena holding some of this module's nodes
+    void adopt_arena(std::shared_ptr<Arena> arena) { arenas_.push_back(std::move(arena)); }
+    const std::vector<std::shared_ptr<Arena>>& arenas() const { return arenas_; }
 
     std::string to_string(int indent = 0) const override;
 
@@ -32,7 +41,8 @@ public:
     }
 
 private:
-    std::vector<std::shared_ptr<Stmt>> body_;
+    std::vector<std::shared_ptr<Arena>> arenas_;  // Declared first: destroyed after body_
+    std::vector<Stmt*> body_;
 };
 
 // Implementation
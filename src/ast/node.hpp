@@ -109,6 +109,13 @@ public:
         end_col_offset_ = end_col_offset;
     }
 
+    // Move the node by delta lines (an edit above it added or removed lines);
+    // placeholder nodes without a location (line 0) stay put
+    void shift_lines(int delta) {
+        if (lineno_ > 0) lineno_ += delta;
+        if (end_lineno_ > 0) end_lineno_ += delta;
+    }
+
     // Virtual method for pretty printing
     virtual std::string to_string(int indent = 0) const = 0;
 
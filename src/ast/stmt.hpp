@@ -22,9 +22,9 @@ class TypeParam;
 // Function argument with optional annotation (Python 3.5+)
 struct arg {
     std::string arg_name;                      // Parameter name
-    std::shared_ptr<Expr> annotation;          // Type annotation (optional, can be nullptr)
+    Expr* annotation;                          // Type annotation (optional, can be nullptr)
     
-    arg(const std::string& name, std::shared_ptr<Expr> ann = nullptr)
+    arg(const std::string& name, Expr* ann = nullptr)
         : arg_name(name), annotation(ann) {}
 };
 
@@ -33,29 +33,29 @@ class FunctionDef : public ASTNodeBase {
 public:
     FunctionDef(const std::string& name,
                 std::vector<arg> args,
-                std::vector<std::shared_ptr<Stmt>> body,
-                std::vector<std::shared_ptr<Expr>> decorator_list,
-                std::shared_ptr<Expr> returns,  // Return type annotation (optional)
-                std::vector<std::shared_ptr<TypeParam>> type_params,  // PEP 695: Generic type parameters
+                std::vector<Stmt*> body,
+                std::vector<Expr*> decorator_list,
+                Expr* returns,                  // Return type annotation (optional)
+                std::vector<TypeParam*> type_params,                  // PEP 695: Generic type parameters
                 int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), name_(name), args_(args), body_(body),
           decorator_list_(decorator_list), returns_(returns), type_params_(type_params) {}
 
     std::string name() const { return name_; }
     const std::vector<arg>& args() const { return args_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    const std::vector<std::shared_ptr<Expr>>& decorator_list() const { return decorator_list_; }
-    std::shared_ptr<Expr> returns() const { return returns_; }
-    const std::vector<std::shared_ptr<TypeParam>>& type_params() const { return type_params_; }  // PEP 695
+    const std::vector<Stmt*>& body() const { return body_; }
+    const std::vector<Expr*>& decorator_list() const { return decorator_list_; }
+    Expr* returns() const { return returns_; }
+    const std::vector<TypeParam*>& type_params() const { return type_params_; }                  // PEP 695
     std::string to_string(int indent = 0) const override;
 
 private:
     std::string name_;
     std::vector<arg> args_;
-    std::vector<std::shared_ptr<Stmt>> body_;
-    std::vector<std::shared_ptr<Expr>> decorator_list_;
-    std::shared_ptr<Expr> returns_;  // Return type annotation
-    std::vector<std::shared_ptr<TypeParam>> type_params_;  // PEP 695: Generic type parameters
+    std::vector<Stmt*> body_;
+    std::vector<Expr*> decorator_list_;
+    Expr* returns_;                  // Return type annotation
+    std::vector<TypeParam*> type_params_;                  // PEP 695: Generic type parameters
 };
 
 // Async function definition (Python 3.5+)
@@ -63,64 +63,64 @@ class AsyncFunctionDef : public ASTNodeBase {
 public:
     AsyncFunctionDef(const std::string& name,
                      std::vector<arg> args,
-                     std::vector<std::shared_ptr<Stmt>> body,
-                     std::vector<std::shared_ptr<Expr>> decorator_list,
-                     std::shared_ptr<Expr> returns,  // Return type annotation (optional)
+                     std::vector<Stmt*> body,
+                     std::vector<Expr*> decorator_list,
+                     Expr* returns,                  // Return type annotation (optional)
                      int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), name_(name), args_(args), body_(body),
           decorator_list_(decorator_list), returns_(returns) {}
 
     std::string name() const { return name_; }
     const std::vector<arg>& args() const { return args_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    const std::vector<std::shared_ptr<Expr>>& decorator_list() const { return decorator_list_; }
-    std::shared_ptr<Expr> returns() const { return returns_; }
+    const std::vector<Stmt*>& body() const { return body_; }
+    const std::vector<Expr*>& decorator_list() const { return decorator_list_; }
+    Expr* returns() const { return returns_; }
     std::string to_string(int indent = 0) const override;
 
 private:
     std::string name_;
     std::vector<arg> args_;
-    std::vector<std::shared_ptr<Stmt>> body_;
-    std::vector<std::shared_ptr<Expr>> decorator_list_;
-    std::shared_ptr<Expr> returns_;  // Return type annotation
+    std::vector<Stmt*> body_;
+    std::vector<Expr*> decorator_list_;
+    Expr* returns_;                  // Return type annotation
 };
 
 // Return statement
 class Return : public ASTNodeBase {
 public:
-    Return(std::shared_ptr<Expr> value, int lineno, int col_offset)
+    Return(Expr* value, int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), value_(value) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* value() const { return value_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;
+    Expr* value_;
 };
 
 // Assignment
 class Assign : public ASTNodeBase {
 public:
-    Assign(std::vector<std::shared_ptr<Expr>> targets,
-           std::shared_ptr<Expr> value,
+    Assign(std::vector<Expr*> targets,
+           Expr* value,
            int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), targets_(targets), value_(value) {}
 
-    const std::vector<std::shared_ptr<Expr>>& targets() const { return targets_; }
-    std::shared_ptr<Expr> value() const { return value_; }
+    const std::vector<Expr*>& targets() const { return targets_; }
+    Expr* value() const { return value_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Expr>> targets_;
-    std::shared_ptr<Expr> value_;
+    std::vector<Expr*> targets_;
+    Expr* value_;
 };
 
 // Annotated assignment: x: int = 5 or y: str (Python 3.6+)
 class AnnAssign : public ASTNodeBase {
 public:
-    AnnAssign(std::shared_ptr<Expr> target,
-              std::shared_ptr<Expr> annotation,
-              std::shared_ptr<Expr> value,  // optional, can be nullptr
+    AnnAssign(Expr* target,
+              Expr* annotation,
+              Expr* value,                  // optional, can be nullptr
               bool simple,
               int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset),
@@ -129,90 +129,90 @@ public:
           value_(value),
           simple_(simple) {}
 
-    std::shared_ptr<Expr> target() const { return target_; }
-    std::shared_ptr<Expr> annotation() const { return annotation_; }
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* target() const { return target_; }
+    Expr* annotation() const { return annotation_; }
+    Expr* value() const { return value_; }
     bool simple() const { return simple_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> target_;
-    std::shared_ptr<Expr> annotation_;
-    std::shared_ptr<Expr> value_;  // nullptr if no value (e.g., "y: str")
+    Expr* target_;
+    Expr* annotation_;
+    Expr* value_;                  // nullptr if no value (e.g., "y: str")
     bool simple_;  // True if target is a simple name
 };
 
 // Augmented assignment (+=, -=, etc.)
 class AugAssign : public ASTNodeBase {
 public:
-    AugAssign(std::shared_ptr<Expr> target,
+    AugAssign(Expr* target,
               Operator op,
-              std::shared_ptr<Expr> value,
+              Expr* value,
               int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), target_(target), op_(op), value_(value) {}
 
-    std::shared_ptr<Expr> target() const { return target_; }
+    Expr* target() const { return target_; }
     Operator op() const { return op_; }
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* value() const { return value_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> target_;
+    Expr* target_;
     Operator op_;
-    std::shared_ptr<Expr> value_;
+    Expr* value_;
 };
 
 // Expression statement
 class ExprStmt : public ASTNodeBase {
 public:
-    ExprStmt(std::shared_ptr<Expr> value, int lineno, int col_offset)
+    ExprStmt(Expr* value, int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), value_(value) {}
 
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* value() const { return value_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> value_;
+    Expr* value_;
 };
 
 // If statement
 class If : public ASTNodeBase {
 public:
-    If(std::shared_ptr<Expr> test,
-       std::vector<std::shared_ptr<Stmt>> body,
-       std::vector<std::shared_ptr<Stmt>> orelse,
+    If(Expr* test,
+       std::vector<Stmt*> body,
+       std::vector<Stmt*> orelse,
        int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), test_(test), body_(body), orelse_(orelse) {}
 
-    std::shared_ptr<Expr> test() const { return test_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    const std::vector<std::shared_ptr<Stmt>>& orelse() const { return orelse_; }
+    Expr* test() const { return test_; }
+    const std::vector<Stmt*>& body() const { return body_; }
+    const std::vector<Stmt*>& orelse() const { return orelse_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> test_;
-    std::vector<std::shared_ptr<Stmt>> body_;
-    std::vector<std::shared_ptr<Stmt>> orelse_;
+    Expr* test_;
+    std::vector<Stmt*> body_;
+    std::vector<Stmt*> orelse_;
 };
 
 // While loop
 class While : public ASTNodeBase {
 public:
-    While(std::shared_ptr<Expr> test,
-          std::vector<std::shared_ptr<Stmt>> body,
-          std::vector<std::shared_ptr<Stmt>> orelse,
+    While(Expr* test,
+          std::vector<Stmt*> body,
+          std::vector<Stmt*> orelse,
           int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), test_(test), body_(body), orelse_(orelse) {}
 
-    std::shared_ptr<Expr> test() const { return test_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    const std::vector<std::shared_ptr<Stmt>>& orelse() const { return orelse_; }
+    Expr* test() const { return test_; }
+    const std::vector<Stmt*>& body() const { return body_; }
+    const std::vector<Stmt*>& orelse() const { return orelse_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> test_;
-    std::vector<std::shared_ptr<Stmt>> body_;
-    std::vector<std::shared_ptr<Stmt>> orelse_;
+    Expr* test_;
+    std::vector<Stmt*> body_;
+    std::vector<Stmt*> orelse_;
 };
 
 // Break statement
@@ -236,47 +236,47 @@ public:
 // For loop
 class For : public ASTNodeBase {
 public:
-    For(std::shared_ptr<Expr> target,
-        std::shared_ptr<Expr> iter,
-        std::vector<std::shared_ptr<Stmt>> body,
-        std::vector<std::shared_ptr<Stmt>> orelse,
+    For(Expr* target,
+        Expr* iter,
+        std::vector<Stmt*> body,
+        std::vector<Stmt*> orelse,
         int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), target_(target), iter_(iter), body_(body), orelse_(orelse) {}
 
-    std::shared_ptr<Expr> target() const { return target_; }
-    std::shared_ptr<Expr> iter() const { return iter_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    const std::vector<std::shared_ptr<Stmt>>& orelse() const { return orelse_; }
+    Expr* target() const { return target_; }
+    Expr* iter() const { return iter_; }
+    const std::vector<Stmt*>& body() const { return body_; }
+    const std::vector<Stmt*>& orelse() const { return orelse_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> target_;
-    std::shared_ptr<Expr> iter_;
-    std::vector<std::shared_ptr<Stmt>> body_;
-    std::vector<std::shared_ptr<Stmt>> orelse_;
+    Expr* target_;
+    Expr* iter_;
+    std::vector<Stmt*> body_;
+    std::vector<Stmt*> orelse_;
 };
 
 // Async for loop (Python 3.5+)
 class AsyncFor : public ASTNodeBase {
 public:
-    AsyncFor(std::shared_ptr<Expr> target,
-             std::shared_ptr<Expr> iter,
-             std::vector<std::shared_ptr<Stmt>> body,
-             std::vector<std::shared_ptr<Stmt>> orelse,
+    AsyncFor(Expr* target,
+             Expr* iter,
+             std::vector<Stmt*> body,
+             std::vector<Stmt*> orelse,
              int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), target_(target), iter_(iter), body_(body), orelse_(orelse) {}
 
-    std::shared_ptr<Expr> target() const { return target_; }
-    std::shared_ptr<Expr> iter() const { return iter_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    const std::vector<std::shared_ptr<Stmt>>& orelse() const { return orelse_; }
+    Expr* target() const { return target_; }
+    Expr* iter() const { return iter_; }
+    const std::vector<Stmt*>& body() const { return body_; }
+    const std::vector<Stmt*>& orelse() const { return orelse_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> target_;
-    std::shared_ptr<Expr> iter_;
-    std::vector<std::shared_ptr<Stmt>> body_;
-    std::vector<std::shared_ptr<Stmt>> orelse_;
+    Expr* target_;
+    Expr* iter_;
+    std::vector<Stmt*> body_;
+    std::vector<Stmt*> orelse_;
 };
 
 // Stmt is already defined in node.hpp as ASTNode
@@ -525,48 +525,48 @@ public:
 // Raise statement
 class Raise : public ASTNodeBase {
 public:
-    Raise(std::shared_ptr<Expr> exc,
-          std::shared_ptr<Expr> cause,
+    Raise(Expr* exc,
+          Expr* cause,
           int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), exc_(exc), cause_(cause) {}
 
-    std::shared_ptr<Expr> exc() const { return exc_; }
-    std::shared_ptr<Expr> cause() const { return cause_; }
+    Expr* exc() const { return exc_; }
+    Expr* cause() const { return cause_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> exc_;  // Exception to raise (null if bare raise)
-    std::shared_ptr<Expr> cause_;  // Exception cause (null if no 'from')
+    Expr* exc_;                  // Exception to raise (null if bare raise)
+    Expr* cause_;                  // Exception cause (null if no 'from')
 };
 
 // Delete statement
 class Delete : public ASTNodeBase {
 public:
-    Delete(std::vector<std::shared_ptr<Expr>> targets, int lineno, int col_offset)
+    Delete(std::vector<Expr*> targets, int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), targets_(targets) {}
 
-    const std::vector<std::shared_ptr<Expr>>& targets() const { return targets_; }
+    const std::vector<Expr*>& targets() const { return targets_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Expr>> targets_;
+    std::vector<Expr*> targets_;
 };
 
 // Assert statement
 class Assert : public ASTNodeBase {
 public:
-    Assert(std::shared_ptr<Expr> test,
-           std::shared_ptr<Expr> msg,
+    Assert(Expr* test,
+           Expr* msg,
            int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), test_(test), msg_(msg) {}
 
-    std::shared_ptr<Expr> test() const { return test_; }
-    std::shared_ptr<Expr> msg() const { return msg_; }
+    Expr* test() const { return test_; }
+    Expr* msg() const { return msg_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> test_;
-    std::shared_ptr<Expr> msg_;  // Optional message
+    Expr* test_;
+    Expr* msg_;                  // Optional message
 };
 
 // Global statement
@@ -598,97 +598,97 @@ private:
 // Exception handler (for try/except)
 class ExceptHandler : public ASTNodeBase {
 public:
-    ExceptHandler(std::shared_ptr<Expr> type,
+    ExceptHandler(Expr* type,
                   const std::string& name,
-                  std::vector<std::shared_ptr<Stmt>> body,
+                  std::vector<Stmt*> body,
                   int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), type_(type), name_(name), body_(body) {}
 
-    std::shared_ptr<Expr> type() const { return type_; }
+    Expr* type() const { return type_; }
     std::string name() const { return name_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
+    const std::vector<Stmt*>& body() const { return body_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> type_;
+    Expr* type_;
     std::string name_;  // Empty if no 'as name'
-    std::vector<std::shared_ptr<Stmt>> body_;
+    std::vector<Stmt*> body_;
 };
 
 // Try statement
 class Try : public ASTNodeBase {
 public:
-    Try(std::vector<std::shared_ptr<Stmt>> body,
-        std::vector<std::shared_ptr<ExceptHandler>> handlers,
-        std::vector<std::shared_ptr<Stmt>> orelse,
-        std::vector<std::shared_ptr<Stmt>> finalbody,
+    Try(std::vector<Stmt*> body,
+        std::vector<ExceptHandler*> handlers,
+        std::vector<Stmt*> orelse,
+        std::vector<Stmt*> finalbody,
         int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), body_(body), handlers_(handlers),
           orelse_(orelse), finalbody_(finalbody) {}
 
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    const std::vector<std::shared_ptr<ExceptHandler>>& handlers() const { return handlers_; }
-    const std::vector<std::shared_ptr<Stmt>>& orelse() const { return orelse_; }
-    const std::vector<std::shared_ptr<Stmt>>& finalbody() const { return finalbody_; }
+    const std::vector<Stmt*>& body() const { return body_; }
+    const std::vector<ExceptHandler*>& handlers() const { return handlers_; }
+    const std::vector<Stmt*>& orelse() const { return orelse_; }
+    const std::vector<Stmt*>& finalbody() const { return finalbody_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Stmt>> body_;
-    std::vector<std::shared_ptr<ExceptHandler>> handlers_;
-    std::vector<std::shared_ptr<Stmt>> orelse_;
-    std::vector<std::shared_ptr<Stmt>> finalbody_;
+    std::vector<Stmt*> body_;
+    std::vector<ExceptHandler*> handlers_;
+    std::vector<Stmt*> orelse_;
+    std::vector<Stmt*> finalbody_;
 };
 
 // TryStar statement - try/except* for exception groups (Python 3.11+, PEP 654)
 // Reference: Python.asdl - TryStar(stmt* body, excepthandler* handlers, stmt* orelse, stmt* finalbody)
 class TryStar : public ASTNodeBase {
 public:
-    TryStar(std::vector<std::shared_ptr<Stmt>> body,
-            std::vector<std::shared_ptr<ExceptHandler>> handlers,
-            std::vector<std::shared_ptr<Stmt>> orelse,
-            std::vector<std::shared_ptr<Stmt>> finalbody,
+    TryStar(std::vector<Stmt*> body,
+            std::vector<ExceptHandler*> handlers,
+            std::vector<Stmt*> orelse,
+            std::vector<Stmt*> finalbody,
             int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), body_(std::move(body)), handlers_(std::move(handlers)),
           orelse_(std::move(orelse)), finalbody_(std::move(finalbody)) {}
 
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    const std::vector<std::shared_ptr<ExceptHandler>>& handlers() const { return handlers_; }
-    const std::vector<std::shared_ptr<Stmt>>& orelse() const { return orelse_; }
-    const std::vector<std::shared_ptr<Stmt>>& finalbody() const { return finalbody_; }
+    const std::vector<Stmt*>& body() const { return body_; }
+    const std::vector<ExceptHandler*>& handlers() const { return handlers_; }
+    const std::vector<Stmt*>& orelse() const { return orelse_; }
+    const std::vector<Stmt*>& finalbody() const { return finalbody_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Stmt>> body_;
-    std::vector<std::shared_ptr<ExceptHandler>> handlers_;
-    std::vector<std::shared_ptr<Stmt>> orelse_;
-    std::vector<std::shared_ptr<Stmt>> finalbody_;
+    std::vector<Stmt*> body_;
+    std::vector<ExceptHandler*> handlers_;
+    std::vector<Stmt*> orelse_;
+    std::vector<Stmt*> finalbody_;
 };
 
 // Class definition
 class ClassDef : public ASTNodeBase {
 public:
     ClassDef(const std::string& name,
-             std::vector<std::shared_ptr<Expr>> bases,
-             std::vector<std::shared_ptr<Stmt>> body,
-             std::vector<std::shared_ptr<Expr>> decorator_list,
-             std::vector<std::shared_ptr<TypeParam>> type_params,  // PEP 695: Generic type parameters
+             std::vector<Expr*> bases,
+             std::vector<Stmt*> body,
+             std::vector<Expr*> decorator_list,
+             std::vector<TypeParam*> type_params,                  // PEP 695: Generic type parameters
              int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), name_(name), bases_(bases), body_(body),
           decorator_list_(decorator_list), type_params_(type_params) {}
 
     std::string name() const { return name_; }
-    const std::vector<std::shared_ptr<Expr>>& bases() const { return bases_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
-    const std::vector<std::shared_ptr<Expr>>& decorator_list() const { return decorator_list_; }
-    const std::vector<std::shared_ptr<TypeParam>>& type_params() const { return type_params_; }  // PEP 695
+    const std::vector<Expr*>& bases() const { return bases_; }
+    const std::vector<Stmt*>& body() const { return body_; }
+    const std::vector<Expr*>& decorator_list() const { return decorator_list_; }
+    const std::vector<TypeParam*>& type_params() const { return type_params_; }                  // PEP 695
     std::string to_string(int indent = 0) const override;
 
 private:
     std::string name_;
-    std::vector<std::shared_ptr<Expr>> bases_;  // Empty if no inheritance
-    std::vector<std::shared_ptr<Stmt>> body_;
-    std::vector<std::shared_ptr<Expr>> decorator_list_;
-    std::vector<std::shared_ptr<TypeParam>> type_params_;  // PEP 695: Generic type parameters
+    std::vector<Expr*> bases_;                  // Empty if no inheritance
+    std::vector<Stmt*> body_;
+    std::vector<Expr*> decorator_list_;
+    std::vector<TypeParam*> type_params_;                  // PEP 695: Generic type parameters
 };
 
 // Import alias (name [as asname])
@@ -709,42 +709,42 @@ private:
 // Import statement
 class Import : public ASTNodeBase {
 public:
-    Import(std::vector<std::shared_ptr<Alias>> names, int lineno, int col_offset)
+    Import(std::vector<Alias*> names, int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), names_(names) {}
 
-    const std::vector<std::shared_ptr<Alias>>& names() const { return names_; }
+    const std::vector<Alias*>& names() const { return names_; }
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::vector<std::shared_ptr<Alias>> names_;
+    std::vector<Alias*> names_;
 };
 
 // Import from statement
 class ImportFrom : public ASTNodeBase {
 public:
     ImportFrom(const std::string& module,
-               std::vector<std::shared_ptr<Alias>> names,
+               std::vector<Alias*> names,
                int level,  // 0 = absolute import, >0 = relative import
                int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), module_(module), names_(names), level_(level) {}
 
     std::string module() const { return module_; }  // Empty if relative import
-    const std::vector<std::shared_ptr<Alias>>& names() const { return names_; }
+    const std::vector<Alias*>& names() const { return names_; }
     int level() const { return level_; }
     std::string to_string(int indent = 0) const override;
 
 private:
     std::string module_;
-    std::vector<std::shared_ptr<Alias>> names_;
+    std::vector<Alias*> names_;
     int level_;
 };
 
 // With item (context_expr, optional_vars)
 struct WithItem {
-    std::shared_ptr<Expr> context_expr;
-    std::shared_ptr<Expr> optional_vars;  // nullptr if no 'as' clause
+    Expr* context_expr;
+    Expr* optional_vars;                  // nullptr if no 'as' clause
 
-    WithItem(std::shared_ptr<Expr> context_expr, std::shared_ptr<Expr> optional_vars)
+    WithItem(Expr* context_expr, Expr* optional_vars)
         : context_expr(context_expr), optional_vars(optional_vars) {}
 };
 
@@ -752,34 +752,34 @@ struct WithItem {
 class With : public ASTNodeBase {
 public:
     With(std::vector<WithItem> items,
-         std::vector<std::shared_ptr<Stmt>> body,
+         std::vector<Stmt*> body,
          int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), items_(items), body_(body) {}
 
     const std::vector<WithItem>& items() const { return items_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
+    const std::vector<Stmt*>& body() const { return body_; }
     std::string to_string(int indent = 0) const override;
 
 private:
     std::vector<WithItem> items_;
-    std::vector<std::shared_ptr<Stmt>> body_;
+    std::vector<Stmt*> body_;
 };
 
 // Async with statement (Python 3.5+)
 class AsyncWith : public ASTNodeBase {
 public:
     AsyncWith(std::vector<WithItem> items,
-              std::vector<std::shared_ptr<Stmt>> body,
+              std::vector<Stmt*> body,
               int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), items_(items), body_(body) {}
 
     const std::vector<WithItem>& items() const { return items_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
+    const std::vector<Stmt*>& body() const { return body_; }
     std::string to_string(int indent = 0) const override;
 
 private:
     std::vector<WithItem> items_;
-    std::vector<std::shared_ptr<Stmt>> body_;
+    std::vector<Stmt*> body_;
 };
 
 // Match/Case Pattern Matching (Python 3.10+)
@@ -788,35 +788,35 @@ private:
 // match_case represents a single case block in a match statement
 class match_case {
 public:
-    match_case(std::shared_ptr<Expr> pattern,
-               std::shared_ptr<Expr> guard,
-               std::vector<std::shared_ptr<Stmt>> body)
+    match_case(Expr* pattern,
+               Expr* guard,
+               std::vector<Stmt*> body)
         : pattern_(pattern), guard_(guard), body_(body) {}
     
-    std::shared_ptr<Expr> pattern() const { return pattern_; }
-    std::shared_ptr<Expr> guard() const { return guard_; }
-    const std::vector<std::shared_ptr<Stmt>>& body() const { return body_; }
+    Expr* pattern() const { return pattern_; }
+    Expr* guard() const { return guard_; }
+    const std::vector<Stmt*>& body() const { return body_; }
     
 private:
-    std::shared_ptr<Expr> pattern_;  // Pattern to match (simplified as Expr)
-    std::shared_ptr<Expr> guard_;    // Optional guard condition (if clause)
-    std::vector<std::shared_ptr<Stmt>> body_;  // Statements to execute if matched
+    Expr* pattern_;                  // Pattern to match (simplified as Expr)
+    Expr* guard_;                    // Optional guard condition (if clause)
+    std::vector<Stmt*> body_;                  // Statements to execute if matched
 };
 
 // Match statement
 class Match : public ASTNodeBase {
 public:
-    Match(std::shared_ptr<Expr> subject,
+    Match(Expr* subject,
           std::vector<match_case> cases,
           int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset), subject_(subject), cases_(cases) {}
     
-    std::shared_ptr<Expr> subject() const { return subject_; }
+    Expr* subject() const { return subject_; }
     const std::vector<match_case>& cases() const { return cases_; }
     std::string to_string(int indent = 0) const override;
     
 private:
-    std::shared_ptr<Expr> subject_;  // Expression to match against
+    Expr* subject_;                  // Expression to match against
     std::vector<match_case> cases_;  // List of case blocks
 };
 
@@ -849,8 +849,8 @@ public:
 class TypeVar : public TypeParam {
 public:
     TypeVar(const std::string& name,
-            std::shared_ptr<Expr> bound,          // Optional bound constraint
-            std::shared_ptr<Expr> default_value,  // Optional default (Python 3.13+)
+            Expr* bound,                          // Optional bound constraint
+            Expr* default_value,                  // Optional default (Python 3.13+)
             int lineno, int col_offset)
         : TypeParam(lineno, col_offset),
           name_(name),
@@ -858,15 +858,15 @@ public:
           default_value_(default_value) {}
 
     const std::string& name() const { return name_; }
-    std::shared_ptr<Expr> bound() const { return bound_; }
-    std::shared_ptr<Expr> default_value() const { return default_value_; }
+    Expr* bound() const { return bound_; }
+    Expr* default_value() const { return default_value_; }
     
     std::string to_string(int indent = 0) const override;
 
 private:
     std::string name_;
-    std::shared_ptr<Expr> bound_;
-    std::shared_ptr<Expr> default_value_;
+    Expr* bound_;
+    Expr* default_value_;
 };
 
 /**
@@ -880,20 +880,20 @@ private:
 class ParamSpec : public TypeParam {
 public:
     ParamSpec(const std::string& name,
-              std::shared_ptr<Expr> default_value,  // Optional default (Python 3.13+)
+              Expr* default_value,                  // Optional default (Python 3.13+)
               int lineno, int col_offset)
         : TypeParam(lineno, col_offset),
           name_(name),
           default_value_(default_value) {}
 
     const std::string& name() const { return name_; }
-    std::shared_ptr<Expr> default_value() const { return default_value_; }
+    Expr* default_value() const { return default_value_; }
     
     std::string to_string(int indent = 0) const override;
 
 private:
     std::string name_;
-    std::shared_ptr<Expr> default_value_;
+    Expr* default_value_;
 };
 
 /**
@@ -907,20 +907,20 @@ private:
 class TypeVarTuple : public TypeParam {
 public:
     TypeVarTuple(const std::string& name,
-                 std::shared_ptr<Expr> default_value,  // Optional default (Python 3.13+)
+                 Expr* default_value,                  // Optional default (Python 3.13+)
                  int lineno, int col_offset)
         : TypeParam(lineno, col_offset),
           name_(name),
           default_value_(default_value) {}
 
     const std::string& name() const { return name_; }
-    std::shared_ptr<Expr> default_value() const { return default_value_; }
+    Expr* default_value() const { return default_value_; }
     
     std::string to_string(int indent = 0) const override;
 
 private:
     std::string name_;
-    std::shared_ptr<Expr> default_value_;
+    Expr* default_value_;
 };
 
 // ============================================================================
@@ -950,9 +950,9 @@ public:
      * @param lineno      Source line number
      * @param col_offset  Source column offset
      */
-    TypeAlias(std::shared_ptr<Expr> name,
-              std::vector<std::shared_ptr<TypeParam>> type_params,
-              std::shared_ptr<Expr> value,
+    TypeAlias(Expr* name,
+              std::vector<TypeParam*> type_params,
+              Expr* value,
               int lineno, int col_offset)
         : ASTNodeBase(lineno, col_offset),
           name_(name),
@@ -960,9 +960,9 @@ public:
           value_(value) {}
 
     // Accessors
-    std::shared_ptr<Expr> name() const { return name_; }
-    const std::vector<std::shared_ptr<TypeParam>>& type_params() const { return type_params_; }
-    std::shared_ptr<Expr> value() const { return value_; }
+    Expr* name() const { return name_; }
+    const std::vector<TypeParam*>& type_params() const { return type_params_; }
+    Expr* value() const { return value_; }
     
     // Check if this is a generic type alias
     bool is_generic() const { return !type_params_.empty(); }
@@ -970,9 +970,9 @@ public:
     std::string to_string(int indent = 0) const override;
 
 private:
-    std::shared_ptr<Expr> name_;                          // The alias name (as Name expr)
-    std::vector<std::shared_ptr<TypeParam>> type_params_; // Generic type parameters
-    std::shared_ptr<Expr> value_;                         // The aliased type expression
+    Expr* name_;                                          // The alias name (as Name expr)
+    std::vector<TypeParam*> type_params_; // Generic type parameters
+    Expr* value_;                                         // The aliased type expression
 };
 
 // Implementations
@@ -3,6 +3,8 @@
 
 #include "opcode.hpp"
 #include "code_object.hpp"
+#include "optimizer.hpp"
+#include "symtable.hpp"
 #include "../ast/node.hpp"
 #include "../ast/expr.hpp"
 #include "../ast/stmt.hpp"
@@ -18,16 +20,6 @@
 namespace cpython_cpp {
 namespace compiler {
 
-/**
- * Scope types for variable resolution
- */
-enum class ScopeType {
-    Module,
-    Function,
-    Class,
-    Comprehension
-};
-
 /**
  * Compiler scope - tracks variables and their locations
  */
@@ -37,13 +29,12 @@ struct CompilerScope {
     std::shared_ptr<CodeObject> code;
     
     // Variable tracking
-    std::unordered_map<std::string, int> locals;   // Local variables
-    std::unordered_map<std::string, int> globals;  // Global declarations
-    std::unordered_map<std::string, int> nonlocals; // Nonlocal declarations
+    const SymbolTableEntry* symbols = nullptr;     // Resolved names of this scope
+    std::unordered_map<std::string, int> locals;   // Fast local slots
     
     // Loop tracking for break/continue
     struct LoopInfo {
-        int start_offset;
+        int start;                        // Label of the loop head (continue target)
         std::vector<int> break_patches;   // Instruction indices to patch for break
         std::vector<int> continue_patches; // Instruction indices to patch for continue
     };
@@ -63,7 +54,7 @@ struct CompilerScope {
  */
 class BytecodeCompiler {
 public:
-    BytecodeCompiler() : current_lineno_(1) {}
+    BytecodeCompiler() : current_lineno_(1), optimize_(true) {}
     ~BytecodeCompiler() = default;
     
     /**
@@ -74,8 +65,14 @@ public:
         filename_ = filename;
         errors_.clear();
         
+        // Resolve every name before generating code
+        symtable_.build(module);
+        for (const auto& [lineno, msg] : symtable_.errors()) {
+            add_error(msg, lineno);
+        }
+        
         // Create module scope
-        push_scope(ScopeType::Module, "<module>");
+        push_scope(ScopeType::Module, "<module>", &module);
         code().co_filename = filename;
         
         // Add None to constants (always at index 0)
@@ -83,7 +80,7 @@ public:
         
         // Compile all statements in the module
         for (const auto& stmt : module.body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         // Return None at end of module
@@ -91,8 +88,7 @@ public:
         emit(Opcode::RETURN_VALUE);
         
         // Finalize code object
-        code().calculate_stacksize();
-        code().assemble();
+        finalize_code();
         
         return pop_scope();
     }
@@ -244,6 +240,11 @@ public:
      * Check if compilation had errors
      */
     bool has_errors() const { return !errors_.empty(); }
+    
+    /**
+     * Enable or disable the peephole optimizer (on by default)
+     */
+    void set_optimize(bool enabled) { optimize_ = enabled; }
 
 private:
     // === Scope Management ===
@@ -253,14 +254,42 @@ private:
     const CompilerScope& current_scope() const { return scopes_.top(); }
     CodeObject& code() { return *current_scope().code; }
     
-    void push_scope(ScopeType type, const std::string& name) {
+    /**
+     * Enter the scope the symbol table recorded for node. Function scopes
+     * get their fast local slots up front, parameters first.
+     */
+    void push_scope(ScopeType type, const std::string& name, const void* node = nullptr) {
         scopes_.push(CompilerScope(type, name));
+        current_scope().symbols = node ? symtable_.lookup(node) : nullptr;
         
         if (type == ScopeType::Function) {
             code().co_flags |= CodeFlags::CO_OPTIMIZED | CodeFlags::CO_NEWLOCALS;
+            if (const SymbolTableEntry* symbols = current_scope().symbols) {
+                for (const auto& id : symbols->varnames) {
+                    if (is_local(symbols->scope_of(id))) {
+                        current_scope().locals[id] = code().add_varname(id);
+                    }
+                }
+                if (symbols->coroutine) {
+                    code().co_flags |= symbols->generator ? CodeFlags::CO_ASYNC_GENERATOR
+                                                          : CodeFlags::CO_COROUTINE;
+                } else if (symbols->generator) {
+                    code().co_flags |= CodeFlags::CO_GENERATOR;
+                }
+            }
         }
     }
     
+    static bool is_local(SymbolScope scope) {
+        return scope == SymbolScope::Local || scope == SymbolScope::Cell;
+    }
+    
+    // Scope of a name in the current scope; unknown names are implicit globals
+    SymbolScope name_scope(const std::string& name) const {
+        const SymbolTableEntry* symbols = current_scope().symbols;
+        return symbols ? symbols->scope_of(name) : SymbolScope::GlobalImplicit;
+    }
+    
     std::shared_ptr<CodeObject> pop_scope() {
         auto code_obj = current_scope().code;
         scopes_.pop();
@@ -268,6 +297,19 @@ private:
     }
     
     // === Code Generation ===
+    
+    /**
+     * Optimize, size the stack and assemble the current code object
+     */
+    void finalize_code() {
+        code().resolve_jumps();
+        if (optimize_) {
+            optimize(code());
+        }
+        code().calculate_stacksize();
+        code().assemble();
+    }
+    
     void emit(Opcode op, int arg = -1) {
         code().emit(op, arg, current_lineno_);
     }
@@ -282,35 +324,42 @@ private:
         return index;
     }
     
+    // Point a forward jump at the next instruction to be emitted
     void patch_jump(int instr_index) {
-        int target = code().current_offset();
-        code().instructions[instr_index].arg = target;
+        patch_jump_to(instr_index, code().label());
     }
     
-    void patch_jump_to(int instr_index, int target) {
-        code().instructions[instr_index].arg = target;
+    /**
+     * Point a jump at a label (see CodeObject::label()). The argument is
+     * filled in by CodeObject::resolve_jumps() once the layout is known.
+     */
+    void patch_jump_to(int instr_index, int label) {
+        code().instructions[instr_index].target = label;
+    }
+    
+    void emit_jump_backward(Opcode op, int label) {
+        patch_jump_to(emit_jump(op), label);
     }
     
     // === Statement Compilation ===
     void compile_function_def(ast::FunctionDef* node) {
-        push_scope(ScopeType::Function, node->name());
+        push_scope(ScopeType::Function, node->name(), node);
         
         for (const auto& arg : node->args()) {
-            code().add_varname(arg.arg_name);
+            current_scope().locals[arg.arg_name] = code().add_varname(arg.arg_name);
         }
         code().co_argcount = static_cast<int>(node->args().size());
         
         code().add_const(std::monostate{});
         
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         emit(Opcode::LOAD_CONST, 0);
         emit(Opcode::RETURN_VALUE);
         
-        code().calculate_stacksize();
-        code().assemble();
+        finalize_code();
         
         auto func_code = pop_scope();
         
@@ -322,25 +371,23 @@ private:
     }
     
     void compile_async_function_def(ast::AsyncFunctionDef* node) {
-        push_scope(ScopeType::Function, node->name());
-        code().co_flags |= CodeFlags::CO_COROUTINE;
+        push_scope(ScopeType::Function, node->name(), node);
         
         for (const auto& arg : node->args()) {
-            code().add_varname(arg.arg_name);
+            current_scope().locals[arg.arg_name] = code().add_varname(arg.arg_name);
         }
         code().co_argcount = static_cast<int>(node->args().size());
         
         code().add_const(std::monostate{});
         
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         emit(Opcode::LOAD_CONST, 0);
         emit(Opcode::RETURN_VALUE);
         
-        code().calculate_stacksize();
-        code().assemble();
+        finalize_code();
         
         auto func_code = pop_scope();
         
@@ -354,7 +401,7 @@ private:
     void compile_class_def(ast::ClassDef* node) {
         emit(Opcode::LOAD_BUILD_CLASS);
         
-        push_scope(ScopeType::Class, node->name());
+        push_scope(ScopeType::Class, node->name(), node);
         code().co_flags |= CodeFlags::CO_NEWLOCALS;
         
         emit(Opcode::LOAD_NAME, code().add_name("__name__"));
@@ -365,14 +412,13 @@ private:
         emit(Opcode::STORE_NAME, code().add_name("__qualname__"));
         
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         emit(Opcode::LOAD_CONST, code().add_const(std::monostate{}));
         emit(Opcode::RETURN_VALUE);
         
-        code().calculate_stacksize();
-        code().assemble();
+        finalize_code();
         
         auto class_code = pop_scope();
         
@@ -384,7 +430,7 @@ private:
         emit(Opcode::LOAD_CONST, name_idx);
         
         for (const auto& base : node->bases()) {
-            compile_expr(base.get());
+            compile_expr(base);
         }
         
         emit(Opcode::CALL, 2 + static_cast<int>(node->bases().size()));
@@ -394,7 +440,7 @@ private:
     
     void compile_return(ast::Return* node) {
         if (node->value()) {
-            compile_expr(node->value().get());
+            compile_expr(node->value());
         } else {
             emit(Opcode::LOAD_CONST, 0);
         }
@@ -402,41 +448,41 @@ private:
     }
     
     void compile_assign(ast::Assign* node) {
-        compile_expr(node->value().get());
+        compile_expr(node->value());
         
         const auto& targets = node->targets();
         for (size_t i = 0; i < targets.size(); ++i) {
             if (i < targets.size() - 1) {
                 emit(Opcode::COPY, 1);
             }
-            compile_store_target(targets[i].get());
+            compile_store_target(targets[i]);
         }
     }
     
     void compile_ann_assign(ast::AnnAssign* node) {
         if (node->value()) {
-            compile_expr(node->value().get());
-            compile_store_target(node->target().get());
+            compile_expr(node->value());
+            compile_store_target(node->target());
         }
     }
     
     void compile_aug_assign(ast::AugAssign* node) {
-        compile_expr(node->target().get());
-        compile_expr(node->value().get());
+        compile_expr(node->target());
+        compile_expr(node->value());
         
         BinaryOpCode op_code = get_inplace_binop_code(node->op());
         emit(Opcode::BINARY_OP, static_cast<int>(op_code));
         
-        compile_store_target(node->target().get());
+        compile_store_target(node->target());
     }
     
     void compile_if(ast::If* node) {
-        compile_expr(node->test().get());
+        compile_expr(node->test());
         
         int jump_to_else = emit_jump(Opcode::POP_JUMP_IF_FALSE);
         
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         if (!node->orelse().empty()) {
@@ -445,7 +491,7 @@ private:
             patch_jump(jump_to_else);
             
             for (const auto& stmt : node->orelse()) {
-                compile_stmt(stmt.get());
+                compile_stmt(stmt);
             }
             
             patch_jump(jump_to_end);
@@ -455,25 +501,25 @@ private:
     }
     
     void compile_while(ast::While* node) {
-        int loop_start = code().current_offset();
+        int loop_start = code().label();
         
         current_scope().loops.push({loop_start, {}, {}});
         
-        compile_expr(node->test().get());
+        compile_expr(node->test());
         
         int jump_to_end = emit_jump(Opcode::POP_JUMP_IF_FALSE);
         
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
-        emit(Opcode::JUMP_BACKWARD, code().current_offset() - loop_start);
+        emit_jump_backward(Opcode::JUMP_BACKWARD, loop_start);
         
         patch_jump(jump_to_end);
         
         if (!node->orelse().empty()) {
             for (const auto& stmt : node->orelse()) {
-                compile_stmt(stmt.get());
+                compile_stmt(stmt);
             }
         }
         
@@ -486,23 +532,23 @@ private:
     }
     
     void compile_for(ast::For* node) {
-        compile_expr(node->iter().get());
+        compile_expr(node->iter());
         
         emit(Opcode::GET_ITER);
         
-        int loop_start = code().current_offset();
+        int loop_start = code().label();
         
         current_scope().loops.push({loop_start, {}, {}});
         
         int for_iter = emit_jump(Opcode::FOR_ITER);
         
-        compile_store_target(node->target().get());
+        compile_store_target(node->target());
         
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
-        emit(Opcode::JUMP_BACKWARD, code().current_offset() - loop_start);
+        emit_jump_backward(Opcode::JUMP_BACKWARD, loop_start);
         
         patch_jump(for_iter);
         
@@ -510,7 +556,7 @@ private:
         
         if (!node->orelse().empty()) {
             for (const auto& stmt : node->orelse()) {
-                compile_stmt(stmt.get());
+                compile_stmt(stmt);
             }
         }
         
@@ -541,6 +587,7 @@ private:
      *   RESUME 3
      *   JUMP_BACKWARD to SEND
      * to_store:
+     *   END_SEND                # Drop the awaitable, keep the value
      *   STORE TARGET            # Store the value
      *   BODY                    # Execute body
      *   JUMP_BACKWARD loop_start
@@ -550,13 +597,13 @@ private:
      */
     void compile_async_for(ast::AsyncFor* node) {
         // Evaluate the async iterable
-        compile_expr(node->iter().get());
+        compile_expr(node->iter());
         
         // GET_AITER: Get async iterator from the iterable
         emit(Opcode::GET_AITER);
         
         // Mark the start of the loop
-        int loop_start = code().current_offset();
+        int loop_start = code().label();
         
         // Push loop context for break/continue handling
         current_scope().loops.push({loop_start, {}, {}});
@@ -577,21 +624,22 @@ private:
         emit(Opcode::RESUME, 3);
         
         // Jump back to SEND to continue awaiting
-        emit(Opcode::JUMP_BACKWARD_NO_INTERRUPT, code().current_offset() - (send_jump - 2));
+        emit_jump_backward(Opcode::JUMP_BACKWARD_NO_INTERRUPT, send_jump);
         
         // Patch SEND to jump here when value is ready
         patch_jump(send_jump);
+        emit(Opcode::END_SEND);
         
         // Store the yielded value in the target
-        compile_store_target(node->target().get());
+        compile_store_target(node->target());
         
         // Compile the loop body
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         // Jump back to GET_ANEXT to get next value
-        emit(Opcode::JUMP_BACKWARD, code().current_offset() - loop_start);
+        emit_jump_backward(Opcode::JUMP_BACKWARD, loop_start);
         
         // END_ASYNC_FOR: Cleanup when StopAsyncIteration is raised
         emit(Opcode::END_ASYNC_FOR);
@@ -599,7 +647,7 @@ private:
         // Compile else clause (executed if loop completes normally)
         if (!node->orelse().empty()) {
             for (const auto& stmt : node->orelse()) {
-                compile_stmt(stmt.get());
+                compile_stmt(stmt);
             }
         }
         
@@ -616,14 +664,14 @@ private:
         emit(Opcode::PUSH_EXC_INFO);
         
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         int jump_to_end = emit_jump(Opcode::JUMP_FORWARD);
         
         for (const auto& handler : node->handlers()) {
             if (handler->type()) {
-                compile_expr(handler->type().get());
+                compile_expr(handler->type());
                 emit(Opcode::CHECK_EXC_MATCH);
                 int skip_handler = emit_jump(Opcode::POP_JUMP_IF_FALSE);
                 
@@ -634,14 +682,14 @@ private:
                 }
                 
                 for (const auto& stmt : handler->body()) {
-                    compile_stmt(stmt.get());
+                    compile_stmt(stmt);
                 }
                 
                 patch_jump(skip_handler);
             } else {
                 emit(Opcode::POP_TOP);
                 for (const auto& stmt : handler->body()) {
-                    compile_stmt(stmt.get());
+                    compile_stmt(stmt);
                 }
             }
         }
@@ -651,11 +699,11 @@ private:
         patch_jump(jump_to_end);
         
         for (const auto& stmt : node->orelse()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         for (const auto& stmt : node->finalbody()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
     }
     
@@ -663,14 +711,14 @@ private:
         emit(Opcode::PUSH_EXC_INFO);
         
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         int jump_to_end = emit_jump(Opcode::JUMP_FORWARD);
         
         for (const auto& handler : node->handlers()) {
             if (handler->type()) {
-                compile_expr(handler->type().get());
+                compile_expr(handler->type());
                 emit(Opcode::CHECK_EG_MATCH);
                 int skip_handler = emit_jump(Opcode::POP_JUMP_IF_FALSE);
                 
@@ -681,7 +729,7 @@ private:
                 }
                 
                 for (const auto& stmt : handler->body()) {
-                    compile_stmt(stmt.get());
+                    compile_stmt(stmt);
                 }
                 
                 patch_jump(skip_handler);
@@ -692,11 +740,11 @@ private:
         patch_jump(jump_to_end);
         
         for (const auto& stmt : node->orelse()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         for (const auto& stmt : node->finalbody()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
     }
     
@@ -733,20 +781,16 @@ private:
         emit(Opcode::POP_TOP);
     }
     
-    void compile_global(ast::Global* node) {
-        for (const auto& name : node->names()) {
-            current_scope().globals[name] = 1;
-        }
+    void compile_global(ast::Global*) {
+        // Resolved by the symbol table; emits no code
     }
     
-    void compile_nonlocal(ast::Nonlocal* node) {
-        for (const auto& name : node->names()) {
-            current_scope().nonlocals[name] = 1;
-        }
+    void compile_nonlocal(ast::Nonlocal*) {
+        // Resolved by the symbol table; emits no code
     }
     
     void compile_expr_stmt(ast::ExprStmt* node) {
-        compile_expr(node->value().get());
+        compile_expr(node->value());
         emit(Opcode::POP_TOP);
     }
     
@@ -771,16 +815,16 @@ private:
         }
         
         auto& loop = current_scope().loops.top();
-        emit(Opcode::JUMP_BACKWARD, code().current_offset() - loop.start_offset);
+        emit_jump_backward(Opcode::JUMP_BACKWARD, loop.start);
     }
     
     void compile_raise(ast::Raise* node) {
         int arg = 0;
         if (node->exc()) {
-            compile_expr(node->exc().get());
+            compile_expr(node->exc());
             arg = 1;
             if (node->cause()) {
-                compile_expr(node->cause().get());
+                compile_expr(node->cause());
                 arg = 2;
             }
         }
@@ -788,14 +832,14 @@ private:
     }
     
     void compile_assert(ast::Assert* node) {
-        compile_expr(node->test().get());
+        compile_expr(node->test());
         
         int jump_if_true = emit_jump(Opcode::POP_JUMP_IF_TRUE);
         
         emit(Opcode::LOAD_GLOBAL, code().add_name("AssertionError"));
         
         if (node->msg()) {
-            compile_expr(node->msg().get());
+            compile_expr(node->msg());
             emit(Opcode::CALL, 1);
         }
         
@@ -806,18 +850,18 @@ private:
     
     void compile_delete(ast::Delete* node) {
         for (const auto& target : node->targets()) {
-            compile_delete_target(target.get());
+            compile_delete_target(target);
         }
     }
     
     void compile_match(ast::Match* node) {
-        compile_expr(node->subject().get());
+        compile_expr(node->subject());
         
         for (const auto& case_ : node->cases()) {
             emit(Opcode::COPY, 1);
             
             for (const auto& stmt : case_.body()) {
-                compile_stmt(stmt.get());
+                compile_stmt(stmt);
             }
         }
         
@@ -859,14 +903,14 @@ private:
         
         for (const auto& item : node->items()) {
             // Evaluate context expression
-            compile_expr(item.context_expr.get());
+            compile_expr(item.context_expr);
             
             // BEFORE_WITH: calls __enter__ and pushes __exit__ for later
             emit(Opcode::BEFORE_WITH);
             
             // Store the result of __enter__ if there's an 'as' clause
             if (item.optional_vars) {
-                compile_store_target(item.optional_vars.get());
+                compile_store_target(item.optional_vars);
             } else {
                 emit(Opcode::POP_TOP);
             }
@@ -874,7 +918,7 @@ private:
         
         // Compile the body
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         // Normal exit: call __exit__(None, None, None) for each context manager (reverse order)
@@ -896,7 +940,7 @@ private:
     void compile_async_with(ast::AsyncWith* node) {
         for (const auto& item : node->items()) {
             // Evaluate context expression
-            compile_expr(item.context_expr.get());
+            compile_expr(item.context_expr);
             
             // BEFORE_ASYNC_WITH: calls __aenter__ and pushes __aexit__
             emit(Opcode::BEFORE_ASYNC_WITH);
@@ -907,7 +951,7 @@ private:
             
             // Store the result of __aenter__ if there's an 'as' clause
             if (item.optional_vars) {
-                compile_store_target(item.optional_vars.get());
+                compile_store_target(item.optional_vars);
             } else {
                 emit(Opcode::POP_TOP);
             }
@@ -915,7 +959,7 @@ private:
         
         // Compile the body
         for (const auto& stmt : node->body()) {
-            compile_stmt(stmt.get());
+            compile_stmt(stmt);
         }
         
         // Normal exit: call __aexit__(None, None, None) for each context manager
@@ -949,7 +993,7 @@ private:
     void compile_typealias(ast::TypeAlias* node) {
         // Get the alias name
         std::string alias_name;
-        if (auto* name_expr = dynamic_cast<ast::Name*>(node->name().get())) {
+        if (auto* name_expr = dynamic_cast<ast::Name*>(node->name())) {
             alias_name = name_expr->id();
         } else {
             add_error("TypeAlias name must be a simple identifier");
@@ -966,11 +1010,11 @@ private:
                 // Type parameters are TypeVar, ParamSpec, or TypeVarTuple
                 // Get the name from the concrete type
                 std::string param_name;
-                if (auto* tv = dynamic_cast<ast::TypeVar*>(param.get())) {
+                if (auto* tv = dynamic_cast<ast::TypeVar*>(param)) {
                     param_name = tv->name();
-                } else if (auto* ps = dynamic_cast<ast::ParamSpec*>(param.get())) {
+                } else if (auto* ps = dynamic_cast<ast::ParamSpec*>(param)) {
                     param_name = ps->name();
-                } else if (auto* tvt = dynamic_cast<ast::TypeVarTuple*>(param.get())) {
+                } else if (auto* tvt = dynamic_cast<ast::TypeVarTuple*>(param)) {
                     param_name = tvt->name();
                 }
                 emit(Opcode::LOAD_CONST, code().add_const(param_name));
@@ -990,12 +1034,12 @@ private:
         );
         
         // Save current scope and push new scope for value code
-        push_scope(ScopeType::Function, "<type alias value>");
+        push_scope(ScopeType::Function, "<type alias value>", node);
         // Replace the code object with our custom one
         current_scope().code = value_code;
         
         // Compile the value expression
-        compile_expr(node->value().get());
+        compile_expr(node->value());
         emit(Opcode::RETURN_VALUE);
         
         // Pop the value scope
@@ -1031,7 +1075,9 @@ private:
     void compile_constant(ast::Constant* node) {
         const std::string& val = node->value();
         
-        if (val.empty()) {
+        if (node->is_str()) {
+            emit(Opcode::LOAD_CONST, code().add_const(val));
+        } else if (val.empty()) {
             emit(Opcode::LOAD_CONST, code().add_const(std::monostate{}));
         } else if (val == "None") {
             emit(Opcode::LOAD_CONST, code().add_const(std::monostate{}));
@@ -1084,20 +1130,34 @@ private:
         }
     }
     
+    /**
+     * Load a name as the symbol table resolved it. Inside functions,
+     * locals are fast slots and globals skip the locals lookup. Free
+     * names stay LOAD_NAME: the VM has no cells yet, and LOAD_NAME
+     * still finds names that are also module globals.
+     */
     void compile_name(ast::Name* node) {
-        int idx = lookup_name(node->id());
+        const std::string& id = node->id();
         
         switch (node->ctx()) {
-            case ast::ExprContext::Load:
-                if (current_scope().type == ScopeType::Function &&
-                    current_scope().locals.count(node->id())) {
-                    emit(Opcode::LOAD_FAST, current_scope().locals[node->id()]);
-                } else if (current_scope().globals.count(node->id())) {
-                    emit(Opcode::LOAD_GLOBAL, code().add_name(node->id()));
+            case ast::ExprContext::Load: {
+                SymbolScope scope = name_scope(id);
+                if (current_scope().type == ScopeType::Function) {
+                    auto it = current_scope().locals.find(id);
+                    if (it != current_scope().locals.end()) {
+                        emit(Opcode::LOAD_FAST, it->second);
+                    } else if (scope == SymbolScope::Free) {
+                        emit(Opcode::LOAD_NAME, code().add_name(id));
+                    } else {
+                        emit(Opcode::LOAD_GLOBAL, code().add_name(id));
+                    }
+                } else if (scope == SymbolScope::GlobalExplicit) {
+                    emit(Opcode::LOAD_GLOBAL, code().add_name(id));
                 } else {
-                    emit(Opcode::LOAD_NAME, code().add_name(node->id()));
+                    emit(Opcode::LOAD_NAME, code().add_name(id));
                 }
                 break;
+            }
             case ast::ExprContext::Store:
                 store_name(node->id());
                 break;
@@ -1108,15 +1168,15 @@ private:
     }
     
     void compile_binop(ast::BinOp* node) {
-        compile_expr(node->left().get());
-        compile_expr(node->right().get());
+        compile_expr(node->left());
+        compile_expr(node->right());
         
         BinaryOpCode op_code = get_binop_code(node->op());
         emit(Opcode::BINARY_OP, static_cast<int>(op_code));
     }
     
     void compile_unaryop(ast::UnaryOp* node) {
-        compile_expr(node->operand().get());
+        compile_expr(node->operand());
         
         switch (node->op()) {
             case ast::UnaryOp::UnaryOpType::Not:
@@ -1140,13 +1200,13 @@ private:
             std::vector<int> jump_indices;
             
             for (size_t i = 0; i < values.size() - 1; ++i) {
-                compile_expr(values[i].get());
+                compile_expr(values[i]);
                 emit(Opcode::COPY, 1);
                 jump_indices.push_back(emit_jump(Opcode::POP_JUMP_IF_FALSE));
                 emit(Opcode::POP_TOP);
             }
             
-            compile_expr(values.back().get());
+            compile_expr(values.back());
             
             for (int idx : jump_indices) {
                 patch_jump(idx);
@@ -1155,13 +1215,13 @@ private:
             std::vector<int> jump_indices;
             
             for (size_t i = 0; i < values.size() - 1; ++i) {
-                compile_expr(values[i].get());
+                compile_expr(values[i]);
                 emit(Opcode::COPY, 1);
                 jump_indices.push_back(emit_jump(Opcode::POP_JUMP_IF_TRUE));
                 emit(Opcode::POP_TOP);
             }
             
-            compile_expr(values.back().get());
+            compile_expr(values.back());
             
             for (int idx : jump_indices) {
                 patch_jump(idx);
@@ -1170,25 +1230,42 @@ private:
     }
     
     void compile_compare(ast::Compare* node) {
-        compile_expr(node->left().get());
-        compile_expr(node->right().get());
+        compile_expr(node->left());
+        compile_expr(node->right());
+        
+        switch (node->op()) {
+            case ast::CompareOp::In:
+                emit(Opcode::CONTAINS_OP, 0);
+                return;
+            case ast::CompareOp::NotIn:
+                emit(Opcode::CONTAINS_OP, 1);
+                return;
+            case ast::CompareOp::Is:
+                emit(Opcode::IS_OP, 0);
+                return;
+            case ast::CompareOp::IsNot:
+                emit(Opcode::IS_OP, 1);
+                return;
+            default:
+                break;
+        }
         
         CompareOpCode op_code = get_compare_code(node->op());
         emit(Opcode::COMPARE_OP, static_cast<int>(op_code));
     }
     
     void compile_call(ast::Call* node) {
-        compile_expr(node->func().get());
+        compile_expr(node->func());
         
         for (const auto& arg : node->args()) {
-            compile_expr(arg.get());
+            compile_expr(arg);
         }
         
         emit(Opcode::CALL, static_cast<int>(node->args().size()));
     }
     
     void compile_attribute(ast::Attribute* node) {
-        compile_expr(node->value().get());
+        compile_expr(node->value());
         int attr_idx = code().add_name(node->attr());
         
         switch (node->ctx()) {
@@ -1205,8 +1282,8 @@ private:
     }
     
     void compile_subscript(ast::Subscript* node) {
-        compile_expr(node->value().get());
-        compile_expr(node->slice().get());
+        compile_expr(node->value());
+        compile_expr(node->slice());
         
         switch (node->ctx()) {
             case ast::ExprContext::Load:
@@ -1223,19 +1300,19 @@ private:
     
     void compile_slice(ast::Slice* node) {
         if (node->lower()) {
-            compile_expr(node->lower().get());
+            compile_expr(node->lower());
         } else {
             emit(Opcode::LOAD_CONST, 0);
         }
         
         if (node->upper()) {
-            compile_expr(node->upper().get());
+            compile_expr(node->upper());
         } else {
             emit(Opcode::LOAD_CONST, 0);
         }
         
         if (node->step()) {
-            compile_expr(node->step().get());
+            compile_expr(node->step());
             emit(Opcode::BUILD_SLICE, 3);
         } else {
             emit(Opcode::BUILD_SLICE, 2);
@@ -1244,14 +1321,14 @@ private:
     
     void compile_list(ast::List* node) {
         for (const auto& elt : node->elts()) {
-            compile_expr(elt.get());
+            compile_expr(elt);
         }
         emit(Opcode::BUILD_LIST, static_cast<int>(node->elts().size()));
     }
     
     void compile_tuple(ast::Tuple* node) {
         for (const auto& elt : node->elts()) {
-            compile_expr(elt.get());
+            compile_expr(elt);
         }
         emit(Opcode::BUILD_TUPLE, static_cast<int>(node->elts().size()));
     }
@@ -1261,46 +1338,45 @@ private:
         const auto& values = node->values();
         
         for (size_t i = 0; i < keys.size(); ++i) {
-            compile_expr(keys[i].get());
-            compile_expr(values[i].get());
+            compile_expr(keys[i]);
+            compile_expr(values[i]);
         }
         emit(Opcode::BUILD_MAP, static_cast<int>(keys.size()));
     }
     
     void compile_set(ast::Set* node) {
         for (const auto& elt : node->elts()) {
-            compile_expr(elt.get());
+            compile_expr(elt);
         }
         emit(Opcode::BUILD_SET, static_cast<int>(node->elts().size()));
     }
     
     void compile_ifexp(ast::IfExp* node) {
-        compile_expr(node->test().get());
+        compile_expr(node->test());
         
         int jump_to_else = emit_jump(Opcode::POP_JUMP_IF_FALSE);
         
-        compile_expr(node->body().get());
+        compile_expr(node->body());
         int jump_to_end = emit_jump(Opcode::JUMP_FORWARD);
         
         patch_jump(jump_to_else);
-        compile_expr(node->orelse().get());
+        compile_expr(node->orelse());
         
         patch_jump(jump_to_end);
     }
     
     void compile_lambda(ast::Lambda* node) {
-        push_scope(ScopeType::Function, "<lambda>");
+        push_scope(ScopeType::Function, "<lambda>", node);
         
         for (const auto& arg : node->args()) {
-            code().add_varname(arg);
+            current_scope().locals[arg] = code().add_varname(arg);
         }
         code().co_argcount = static_cast<int>(node->args().size());
         
-        compile_expr(node->body().get());
+        compile_expr(node->body());
         emit(Opcode::RETURN_VALUE);
         
-        code().calculate_stacksize();
-        code().assemble();
+        finalize_code();
         
         auto lambda_code = pop_scope();
         
@@ -1341,7 +1417,7 @@ private:
             node->generators(),
             [this, node]() {
                 // Compile the element expression
-                compile_expr(node->elt().get());
+                compile_expr(node->elt());
                 // Append to list (stack depth = 2: list, element)
                 emit(Opcode::LIST_APPEND, 2);
             }
@@ -1364,7 +1440,7 @@ private:
             node->generators(),
             [this, node]() {
                 // Compile the element expression
-                compile_expr(node->elt().get());
+                compile_expr(node->elt());
                 // Add to set (stack depth = 2: set, element)
                 emit(Opcode::SET_ADD, 2);
             }
@@ -1387,8 +1463,8 @@ private:
             node->generators(),
             [this, node]() {
                 // Compile key and value expressions
-                compile_expr(node->key().get());
-                compile_expr(node->value().get());
+                compile_expr(node->key());
+                compile_expr(node->value());
                 // Add to map (stack depth = 2: map, key, value)
                 emit(Opcode::MAP_ADD, 2);
             }
@@ -1400,31 +1476,63 @@ private:
      * 
      * Python: (expr for target in iter if cond)
      * 
-     * Generator expressions create a generator function that yields values.
-     * We compile it as a nested code object.
+     * Generator expressions are generator functions of one argument,
+     * .0, the iterator over the outermost iterable. That iterable is
+     * evaluated where the expression appears; everything else runs
+     * lazily inside the generator.
+     * 
+     * Bytecode pattern:
+     *   LOAD_CONST <genexpr>; MAKE_FUNCTION
+     *   ITER; GET_ITER; CALL 1
+     * 
+     * <genexpr>:
+     *   LOAD_FAST .0
+     * loop:
+     *   FOR_ITER end
+     *   STORE TARGET; [IF CONDITIONS]
+     *   EXPR; YIELD_VALUE; RESUME 1; POP_TOP
+     *   JUMP_BACKWARD loop
+     * end:
+     *   END_FOR; LOAD_CONST None; RETURN_VALUE
      */
     void compile_generatorexp(ast::GeneratorExp* node) {
-        // For now, compile as a simple inline generator
-        // A full implementation would create a nested code object
+        const auto& generators = node->generators();
+        if (generators.empty()) {
+            add_error("Generator expression without a for clause", node->lineno());
+            return;
+        }
         
-        // Create a code object for the generator
-        std::string gen_name = "<genexpr>";
-        auto gen_code = std::make_shared<CodeObject>(gen_name, code().co_filename, node->lineno());
-        gen_code->co_flags = 0x20;  // CO_GENERATOR
+        push_scope(ScopeType::Function, "<genexpr>", node);
+        code().co_flags |= CodeFlags::CO_GENERATOR;
+        current_scope().locals[".0"] = code().add_varname(".0");
+        code().co_argcount = 1;
+        
+        compile_comprehension_generators(
+            generators,
+            [this, node]() {
+                compile_expr(node->elt());
+                emit(Opcode::YIELD_VALUE);
+                emit(Opcode::RESUME, 1);
+                emit(Opcode::POP_TOP);
+            },
+            0,
+            true
+        );
+        
+        emit(Opcode::LOAD_CONST, code().add_const(std::monostate{}));
+        emit(Opcode::RETURN_VALUE);
+        
+        finalize_code();
+        
+        auto gen_code = pop_scope();
         
-        // Push the generator code object
         int code_idx = code().add_const(gen_code);
         emit(Opcode::LOAD_CONST, code_idx);
         emit(Opcode::MAKE_FUNCTION, 0);
         
-        // Evaluate the first iterator and pass it to the generator
-        if (!node->generators().empty()) {
-            compile_expr(node->generators()[0].iter.get());
-            emit(Opcode::GET_ITER);
-            emit(Opcode::CALL, 1);
-        } else {
-            emit(Opcode::CALL, 0);
-        }
+        compile_expr(generators[0].iter);
+        emit(generators[0].is_async ? Opcode::GET_AITER : Opcode::GET_ITER);
+        emit(Opcode::CALL, 1);
     }
     
     /**
@@ -1432,12 +1540,15 @@ private:
      * 
      * This handles nested for loops and if conditions in comprehensions.
      * The body_emitter is called when we're inside all the loops and conditions.
+     * With outermost_is_arg the first iterator is the .0 parameter of a
+     * generator expression rather than an expression to evaluate.
      */
     template<typename BodyEmitter>
     void compile_comprehension_generators(
         const std::vector<ast::Comprehension>& generators,
         BodyEmitter body_emitter,
-        size_t gen_index = 0
+        size_t gen_index = 0,
+        bool outermost_is_arg = false
     ) {
         if (gen_index >= generators.size()) {
             // All generators processed, emit the body
@@ -1447,17 +1558,11 @@ private:
         
         const auto& gen = generators[gen_index];
         
-        // Compile the iterable (only for first generator, others use outer scope)
-        if (gen_index == 0) {
-            compile_expr(gen.iter.get());
-            if (gen.is_async) {
-                emit(Opcode::GET_AITER);
-            } else {
-                emit(Opcode::GET_ITER);
-            }
+        // Compile the iterable (a generator expression gets the first one as .0)
+        if (gen_index == 0 && outermost_is_arg) {
+            emit(Opcode::LOAD_FAST, current_scope().locals[".0"]);
         } else {
-            // For nested generators, compile the iterable normally
-            compile_expr(gen.iter.get());
+            compile_expr(gen.iter);
             if (gen.is_async) {
                 emit(Opcode::GET_AITER);
             } else {
@@ -1466,7 +1571,7 @@ private:
         }
         
         // Mark loop start
-        int loop_start = code().current_offset();
+        int loop_start = code().label();
         
         // FOR_ITER: Get next item or jump to end
         int for_iter_jump;
@@ -1477,19 +1582,20 @@ private:
             for_iter_jump = emit_jump(Opcode::SEND);
             emit(Opcode::YIELD_VALUE);
             emit(Opcode::RESUME, 3);
-            emit(Opcode::JUMP_BACKWARD_NO_INTERRUPT, code().current_offset() - loop_start - 2);
+            emit_jump_backward(Opcode::JUMP_BACKWARD_NO_INTERRUPT, for_iter_jump);
             patch_jump(for_iter_jump);
+            emit(Opcode::END_SEND);
         } else {
             for_iter_jump = emit_jump(Opcode::FOR_ITER);
         }
         
         // Store the iteration variable
-        compile_store_target(gen.target.get());
+        compile_store_target(gen.target);
         
         // Compile if conditions
         std::vector<int> condition_jumps;
         for (const auto& cond : gen.ifs) {
-            compile_expr(cond.get());
+            compile_expr(cond);
             // Jump back to loop start if condition is false
             int cond_jump = emit_jump(Opcode::POP_JUMP_IF_FALSE);
             condition_jumps.push_back(cond_jump);
@@ -1505,11 +1611,12 @@ private:
         }
         
         // Jump back to loop start
-        emit(Opcode::JUMP_BACKWARD, code().current_offset() - loop_start);
+        emit_jump_backward(Opcode::JUMP_BACKWARD, loop_start);
         
-        // Patch FOR_ITER to jump here when exhausted
+        // Patch FOR_ITER to jump here when exhausted; END_FOR drops the iterator
         if (!gen.is_async) {
             patch_jump(for_iter_jump);
+            emit(Opcode::END_FOR);
         }
         
         // For async, emit END_ASYNC_FOR
@@ -1518,11 +1625,36 @@ private:
         }
     }
     
+    /**
+     * Compile an await expression
+     * 
+     * Python: await VALUE
+     * 
+     * Bytecode pattern (CPython 3.12+): the same send loop as yield from
+     *   VALUE
+     *   GET_AWAITABLE
+     *   LOAD_CONST None
+     * loop:
+     *   SEND end
+     *   YIELD_VALUE
+     *   RESUME 3
+     *   JUMP_BACKWARD_NO_INTERRUPT loop
+     * end:
+     *   END_SEND
+     */
     void compile_await(ast::Await* node) {
-        compile_expr(node->value().get());
+        compile_expr(node->value());
         emit(Opcode::GET_AWAITABLE);
-        emit(Opcode::LOAD_CONST, 0);
+        emit(Opcode::LOAD_CONST, code().add_const(std::monostate{}));
+        
+        int send_start = code().label();
+        int send_jump = emit_jump(Opcode::SEND);
         emit(Opcode::YIELD_VALUE);
+        emit(Opcode::RESUME, 3);
+        emit_jump_backward(Opcode::JUMP_BACKWARD_NO_INTERRUPT, send_start);
+        
+        patch_jump(send_jump);
+        emit(Opcode::END_SEND);
     }
     
     /**
@@ -1539,7 +1671,7 @@ private:
     void compile_yield(ast::Yield* node) {
         // Load the value to yield (or None if no value)
         if (node->value()) {
-            compile_expr(node->value().get());
+            compile_expr(node->value());
         } else {
             emit(Opcode::LOAD_CONST, code().add_const(std::monostate{}));
         }
@@ -1569,12 +1701,12 @@ private:
      *   RESUME 2                    # Resume (yield from context)
      *   JUMP_BACKWARD_NO_INTERRUPT loop
      * end:
-     *   POP_TOP                     # Pop the final result
+     *   END_SEND                    # Drop the sub-iterator
      *   (result of sub-generator is on stack)
      */
     void compile_yield_from(ast::YieldFrom* node) {
         // Evaluate the iterable to delegate to
-        compile_expr(node->value().get());
+        compile_expr(node->value());
         
         // GET_YIELD_FROM_ITER: Get an iterator suitable for yield from
         // This handles both generators and other iterables
@@ -1584,7 +1716,7 @@ private:
         emit(Opcode::LOAD_CONST, code().add_const(std::monostate{}));
         
         // Mark the start of the send loop
-        int send_start = code().current_offset();
+        int send_start = code().label();
         
         // SEND: Send value to sub-iterator, jump to end on StopIteration
         int send_jump = emit_jump(Opcode::SEND);
@@ -1596,19 +1728,20 @@ private:
         emit(Opcode::RESUME, 2);
         
         // Jump back to SEND to continue delegation
-        emit(Opcode::JUMP_BACKWARD_NO_INTERRUPT, code().current_offset() - send_start);
+        emit_jump_backward(Opcode::JUMP_BACKWARD_NO_INTERRUPT, send_start);
         
         // Patch SEND to jump here when sub-iterator is exhausted
         patch_jump(send_jump);
         
-        // The return value of the sub-generator is now on the stack
-        // (StopIteration.value)
+        // The return value of the sub-generator replaced the sent value;
+        // drop the sub-iterator below it
+        emit(Opcode::END_SEND);
     }
     
     void compile_namedexpr(ast::NamedExpr* node) {
-        compile_expr(node->value().get());
+        compile_expr(node->value());
         emit(Opcode::COPY, 1);
-        if (auto* name = dynamic_cast<ast::Name*>(node->target().get())) {
+        if (auto* name = dynamic_cast<ast::Name*>(node->target())) {
             store_name(name->id());
         } else {
             add_error("Invalid walrus operator target", node->lineno());
@@ -1616,25 +1749,25 @@ private:
     }
     
     void compile_starred(ast::Starred* node) {
-        compile_expr(node->value().get());
+        compile_expr(node->value());
     }
     
     void compile_joinedstr(ast::JoinedStr* node) {
         for (const auto& value : node->values()) {
-            compile_expr(value.get());
+            compile_expr(value);
         }
         emit(Opcode::BUILD_STRING, static_cast<int>(node->values().size()));
     }
     
     void compile_formattedvalue(ast::FormattedValue* node) {
-        compile_expr(node->value().get());
+        compile_expr(node->value());
         
         if (node->conversion() != -1) {
             emit(Opcode::CONVERT_VALUE, node->conversion());
         }
         
         if (node->format_spec()) {
-            compile_expr(node->format_spec().get());
+            compile_expr(node->format_spec());
             emit(Opcode::FORMAT_WITH_SPEC);
         } else {
             emit(Opcode::FORMAT_SIMPLE);
@@ -1646,24 +1779,24 @@ private:
         if (auto* name = dynamic_cast<ast::Name*>(target)) {
             store_name(name->id());
         } else if (auto* attr = dynamic_cast<ast::Attribute*>(target)) {
-            compile_expr(attr->value().get());
+            compile_expr(attr->value());
             emit(Opcode::STORE_ATTR, code().add_name(attr->attr()));
         } else if (auto* subscr = dynamic_cast<ast::Subscript*>(target)) {
-            compile_expr(subscr->value().get());
-            compile_expr(subscr->slice().get());
+            compile_expr(subscr->value());
+            compile_expr(subscr->slice());
             emit(Opcode::STORE_SUBSCR);
         } else if (auto* tuple = dynamic_cast<ast::Tuple*>(target)) {
             emit(Opcode::UNPACK_SEQUENCE, static_cast<int>(tuple->elts().size()));
             for (const auto& elt : tuple->elts()) {
-                compile_store_target(elt.get());
+                compile_store_target(elt);
             }
         } else if (auto* list = dynamic_cast<ast::List*>(target)) {
             emit(Opcode::UNPACK_SEQUENCE, static_cast<int>(list->elts().size()));
             for (const auto& elt : list->elts()) {
-                compile_store_target(elt.get());
+                compile_store_target(elt);
             }
         } else if (auto* starred = dynamic_cast<ast::Starred*>(target)) {
-            compile_store_target(starred->value().get());
+            compile_store_target(starred->value());
         } else {
             add_error("Invalid assignment target", target->lineno());
         }
@@ -1673,11 +1806,11 @@ private:
         if (auto* name = dynamic_cast<ast::Name*>(target)) {
             delete_name(name->id());
         } else if (auto* attr = dynamic_cast<ast::Attribute*>(target)) {
-            compile_expr(attr->value().get());
+            compile_expr(attr->value());
             emit(Opcode::DELETE_ATTR, code().add_name(attr->attr()));
         } else if (auto* subscr = dynamic_cast<ast::Subscript*>(target)) {
-            compile_expr(subscr->value().get());
-            compile_expr(subscr->slice().get());
+            compile_expr(subscr->value());
+            compile_expr(subscr->slice());
             emit(Opcode::DELETE_SUBSCR);
         } else {
             add_error("Invalid delete target", target->lineno());
@@ -1735,45 +1868,27 @@ private:
         }
     }
     
-    int lookup_name(const std::string& name) {
-        if (current_scope().type == ScopeType::Function) {
-            auto it = current_scope().locals.find(name);
-            if (it != current_scope().locals.end()) {
-                return it->second;
-            }
-        }
-        return -1;
-    }
-    
+    // Nonlocal names also get a fast slot: without cells this is as close as the VM gets
     void store_name(const std::string& name) {
-        if (current_scope().type == ScopeType::Function) {
-            if (current_scope().globals.count(name)) {
-                emit(Opcode::STORE_GLOBAL, code().add_name(name));
-            } else {
-                int idx = code().find_varname(name);
-                if (idx < 0) {
-                    idx = code().add_varname(name);
-                    current_scope().locals[name] = idx;
-                }
-                emit(Opcode::STORE_FAST, idx);
+        if (name_scope(name) == SymbolScope::GlobalExplicit) {
+            emit(Opcode::STORE_GLOBAL, code().add_name(name));
+        } else if (current_scope().type == ScopeType::Function) {
+            auto it = current_scope().locals.find(name);
+            if (it == current_scope().locals.end()) {
+                it = current_scope().locals.emplace(name, code().add_varname(name)).first;
             }
+            emit(Opcode::STORE_FAST, it->second);
         } else {
             emit(Opcode::STORE_NAME, code().add_name(name));
         }
     }
     
     void delete_name(const std::string& name) {
-        if (current_scope().type == ScopeType::Function) {
-            if (current_scope().globals.count(name)) {
-                emit(Opcode::DELETE_GLOBAL, code().add_name(name));
-            } else {
-                int idx = code().find_varname(name);
-                if (idx >= 0) {
-                    emit(Opcode::DELETE_FAST, idx);
-                } else {
-                    emit(Opcode::DELETE_NAME, code().add_name(name));
-                }
-            }
+        if (name_scope(name) == SymbolScope::GlobalExplicit) {
+            emit(Opcode::DELETE_GLOBAL, code().add_name(name));
+        } else if (current_scope().type == ScopeType::Function &&
+                   current_scope().locals.count(name)) {
+            emit(Opcode::DELETE_FAST, current_scope().locals[name]);
         } else {
             emit(Opcode::DELETE_NAME, code().add_name(name));
         }
@@ -1788,7 +1903,9 @@ private:
     // === State ===
     std::string filename_;
     int current_lineno_;
+    bool optimize_;
     std::vector<std::string> errors_;
+    SymbolTable symtable_;
 };
 
 } // namespace compiler
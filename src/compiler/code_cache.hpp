@@ -0,0 +1,776 @@
+#ifndef CPYTHON_CPP_COMPILER_CODE_CACHE_HPP
+#define CPYTHON_CPP_COMPILER_CODE_CACHE_HPP
+
+#include "code_object.hpp"
+#include "../core/mapped_file.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cpython_cpp {
+namespace compiler {
+
+/**
+ * Persistent bytecode cache (.pyc-style)
+ * Reference: Lib/importlib/_bootstrap_external.py, Python/marshal.c
+ *
+ * A cache file holds one module's CodeObject tree, keyed by the source
+ * file's mtime, size and content hash, plus the module's SourceStats.
+ * Layout (little-endian):
+ *
+ *   header        fixed 80 bytes, see CodeCacheHeader
+ *   string table  {u32 offset, u32 length} per pooled string
+ *   code table    u64 offset per code object; index 0 is the module
+ *   records       strings bytes and code object records
+ *
+ * Every name, identifier and string constant is stored once in the
+ * string pool. A CodeCacheFile maps the file and only decodes what is
+ * asked for: string(i) is a view into the mapping, record(i) reads code
+ * object i in place, and load(i) decodes it plus the code objects among
+ * its constants.
+ */
+inline constexpr char kCodeCacheMagic[4] = {'C', 'P', 'Y', 'C'};
+
+// Bump whenever the record layout, opcode numbering or compiler output changes
+inline constexpr uint32_t kCodeCacheVersion = 2;
+
+// CodeCacheHeader::flags
+inline constexpr uint32_t kCodeCacheOptimized = 0x1;  // Peephole optimizer ran
+
+/**
+ * SourceKey - identity of the source a cache file was compiled from
+ */
+struct SourceKey {
+    int64_t mtime_ns = 0;
+    uint64_t size = 0;
+    uint64_t hash = 0;  // FNV-1a over the source bytes
+};
+
+/**
+ * SourceStats - AST counts for the module, so a cache hit can report
+ * them without parsing the source again
+ */
+struct SourceStats {
+    uint32_t function_count = 0;
+    uint32_t statement_count = 0;
+    uint32_t expression_count = 0;
+};
+
+struct CodeCacheHeader {
+    uint32_t version = 0;
+    uint32_t flags = 0;
+    uint32_t code_count = 0;
+    uint32_t string_count = 0;
+    SourceKey source;
+    uint64_t string_table_offset = 0;
+    uint64_t code_table_offset = 0;
+    SourceStats stats;
+
+    static constexpr size_t kSize = 80;
+};
+
+inline uint64_t hash_source(std::string_view source) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : source) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// mtime and size of path, hash left at 0; nullopt if it cannot be stat'ed
+inline std::optional<SourceKey> stat_source(const std::string& path) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) return std::nullopt;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return std::nullopt;
+    SourceKey key;
+    key.size = size;
+    key.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        mtime.time_since_epoch()).count();
+    return key;
+}
+
+// dir/__pycache__/name.cpycpp-<version>.pyc for dir/name.py
+inline std::string code_cache_path(const std::string& source_path) {
+    std::filesystem::path source(source_path);
+    std::filesystem::path cache_dir = source.parent_path() / "__pycache__";
+    std::string file = source.stem().string() + ".cpycpp-" +
+                       std::to_string(kCodeCacheVersion) + ".pyc";
+    return (cache_dir / file).string();
+}
+
+// ============================================================================
+// Serialization
+// ============================================================================
+
+namespace cache_detail {
+
+enum class ConstTag : uint8_t {
+    None = 0, False = 1, True = 2, Int = 3, Float = 4, String = 5, Bytes = 6, Code = 7
+};
+
+class Writer {
+public:
+    std::vector<uint8_t> out;
+
+    void u8(uint8_t v) { out.push_back(v); }
+    void u32(uint32_t v) { for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i))); }
+    void u64(uint64_t v) { for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i))); }
+    void i32(int32_t v) { u32(static_cast<uint32_t>(v)); }
+    void i64(int64_t v) { u64(static_cast<uint64_t>(v)); }
+    void f64(double v) { uint64_t bits; std::memcpy(&bits, &v, sizeof bits); u64(bits); }
+    void bytes(const uint8_t* data, size_t size) { out.insert(out.end(), data, data + size); }
+
+    void patch_u32(size_t at, uint32_t v) { for (int i = 0; i < 4; ++i) out[at + i] = static_cast<uint8_t>(v >> (8 * i)); }
+    void patch_u64(size_t at, uint64_t v) { for (int i = 0; i < 8; ++i) out[at + i] = static_cast<uint8_t>(v >> (8 * i)); }
+};
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size, size_t pos = 0) : data_(data), size_(size), pos_(pos) {}
+
+    uint8_t u8() { need(1); return data_[pos_++]; }
+    uint32_t u32() { need(4); uint32_t v = 0; for (int i = 0; i < 4; ++i) v |= uint32_t(data_[pos_++]) << (8 * i); return v; }
+    uint64_t u64() { need(8); uint64_t v = 0; for (int i = 0; i < 8; ++i) v |= uint64_t(data_[pos_++]) << (8 * i); return v; }
+    int32_t i32() { return static_cast<int32_t>(u32()); }
+    int64_t i64() { return static_cast<int64_t>(u64()); }
+    double f64() { uint64_t bits = u64(); double v; std::memcpy(&v, &bits, sizeof v); return v; }
+    const uint8_t* bytes(size_t size) { need(size); const uint8_t* p = data_ + pos_; pos_ += size; return p; }
+    size_t pos() const { return pos_; }
+
+    // Element count that must fit in what is left of the file
+    uint32_t count(size_t element_size) {
+        uint32_t n = u32();
+        if (element_size != 0 && n > (size_ - pos_) / element_size) fail();
+        return n;
+    }
+
+    [[noreturn]] static void fail() { throw std::runtime_error("corrupt code cache"); }
+
+private:
+    void need(size_t n) { if (n > size_ - pos_) fail(); }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+};
+
+class Serializer {
+public:
+    std::vector<uint8_t> run(const CodeObject& root, const SourceKey& key,
+                             const SourceStats& stats, uint32_t flags) {
+        collect(root);
+
+        w_.out.resize(CodeCacheHeader::kSize, 0);
+        std::memcpy(w_.out.data(), kCodeCacheMagic, 4);
+
+        // Encode the records first so every string is pooled
+        std::vector<uint64_t> code_offsets;
+        std::vector<uint8_t> records;
+        {
+            Writer body;
+            for (const CodeObject* code : codes_) {
+                code_offsets.push_back(body.out.size());
+                write_code(body, *code);
+            }
+            records = std::move(body.out);
+        }
+
+        uint64_t string_table = w_.out.size();
+        for (size_t i = 0; i < strings_.size(); ++i) {
+            w_.u32(0);
+            w_.u32(static_cast<uint32_t>(strings_[i].size()));
+        }
+        uint64_t code_table = w_.out.size();
+        for (size_t i = 0; i < codes_.size(); ++i) {
+            w_.u64(0);
+        }
+        for (size_t i = 0; i < strings_.size(); ++i) {
+            w_.patch_u32(string_table + i * 8, static_cast<uint32_t>(w_.out.size()));
+            w_.bytes(reinterpret_cast<const uint8_t*>(strings_[i].data()), strings_[i].size());
+        }
+        uint64_t records_base = w_.out.size();
+        w_.bytes(records.data(), records.size());
+        for (size_t i = 0; i < codes_.size(); ++i) {
+            w_.patch_u64(code_table + i * 8, records_base + code_offsets[i]);
+        }
+
+        w_.patch_u32(4, kCodeCacheVersion);
+        w_.patch_u32(8, flags);
+        w_.patch_u32(12, static_cast<uint32_t>(codes_.size()));
+        w_.patch_u32(16, static_cast<uint32_t>(strings_.size()));
+        w_.patch_u64(24, static_cast<uint64_t>(key.mtime_ns));
+        w_.patch_u64(32, key.size);
+        w_.patch_u64(40, key.hash);
+        w_.patch_u64(48, string_table);
+        w_.patch_u64(56, code_table);
+        w_.patch_u32(64, stats.function_count);
+        w_.patch_u32(68, stats.statement_count);
+        w_.patch_u32(72, stats.expression_count);
+        return std::move(w_.out);
+    }
+
+private:
+    // Number code objects depth-first, root first
+    void collect(const CodeObject& code) {
+        if (code_index_.count(&code)) return;
+        code_index_[&code] = static_cast<uint32_t>(codes_.size());
+        codes_.push_back(&code);
+        for (const auto& c : code.co_consts) {
+            if (auto* nested = std::get_if<std::shared_ptr<CodeObject>>(&c)) {
+                collect(**nested);
+            }
+        }
+    }
+
+    uint32_t intern(const std::string& s) {
+        auto [it, inserted] = string_index_.try_emplace(s, static_cast<uint32_t>(strings_.size()));
+        if (inserted) strings_.push_back(s);
+        return it->second;
+    }
+
+    void write_names(Writer& w, const std::vector<std::string>& names) {
+        w.u32(static_cast<uint32_t>(names.size()));
+        for (const auto& name : names) w.u32(intern(name));
+    }
+
+    void write_code(Writer& w, const CodeObject& code) {
+        w.u32(intern(code.co_name));
+        w.u32(intern(code.co_qualname));
+        w.u32(intern(code.co_filename));
+        w.i32(code.co_firstlineno);
+        w.i32(code.co_argcount);
+        w.i32(code.co_posonlyargcount);
+        w.i32(code.co_kwonlyargcount);
+        w.i32(code.co_nlocals);
+        w.i32(code.co_stacksize);
+        w.u32(code.co_flags);
+
+        w.u32(static_cast<uint32_t>(code.co_code.size()));
+        w.bytes(code.co_code.data(), code.co_code.size());
+
+        w.u32(static_cast<uint32_t>(code.instructions.size()));
+        for (const auto& instr : code.instructions) {
+            w.u8(static_cast<uint8_t>(instr.opcode));
+            w.i32(instr.arg);
+            w.i32(instr.lineno);
+            w.i32(instr.offset);
+        }
+
+        w.u32(static_cast<uint32_t>(code.co_consts.size()));
+        for (const auto& c : code.co_consts) {
+            std::visit([&](auto&& value) {
+                using T = std::decay_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, std::monostate>) {
+                    w.u8(static_cast<uint8_t>(ConstTag::None));
+                } else if constexpr (std::is_same_v<T, bool>) {
+                    w.u8(static_cast<uint8_t>(value ? ConstTag::True : ConstTag::False));
+                } else if constexpr (std::is_same_v<T, int64_t>) {
+                    w.u8(static_cast<uint8_t>(ConstTag::Int));
+                    w.i64(value);
+                } else if constexpr (std::is_same_v<T, double>) {
+                    w.u8(static_cast<uint8_t>(ConstTag::Float));
+                    w.f64(value);
+                } else if constexpr (std::is_same_v<T, std::string>) {
+                    w.u8(static_cast<uint8_t>(ConstTag::String));
+                    w.u32(intern(value));
+                } else if constexpr (std::is_same_v<T, std::vector<uint8_t>>) {
+                    w.u8(static_cast<uint8_t>(ConstTag::Bytes));
+                    w.u32(static_cast<uint32_t>(value.size()));
+                    w.bytes(value.data(), value.size());
+                } else {
+                    w.u8(static_cast<uint8_t>(ConstTag::Code));
+                    w.u32(code_index_.at(value.get()));
+                }
+            }, c);
+        }
+
+        write_names(w, code.co_names);
+        write_names(w, code.co_varnames);
+        write_names(w, code.co_freevars);
+        write_names(w, code.co_cellvars);
+
+        w.u32(static_cast<uint32_t>(code.co_linetable.size()));
+        for (const auto& [offset, lineno] : code.co_linetable) {
+            w.i32(offset);
+            w.i32(lineno);
+        }
+    }
+
+    Writer w_;
+    std::vector<const CodeObject*> codes_;
+    std::unordered_map<const CodeObject*, uint32_t> code_index_;
+    std::vector<std::string> strings_;
+    std::unordered_map<std::string, uint32_t> string_index_;
+};
+
+} // namespace cache_detail
+
+// Encode a module's code tree as a cache image
+inline std::vector<uint8_t> serialize_code(const CodeObject& root, const SourceKey& key,
+                                           const SourceStats& stats = {},
+                                           uint32_t flags = kCodeCacheOptimized) {
+    return cache_detail::Serializer().run(root, key, stats, flags);
+}
+
+// Write atomically (temp file + rename), creating __pycache__ if needed
+inline bool write_code_cache(const std::string& cache_path, const CodeObject& root,
+                             const SourceKey& key, const SourceStats& stats = {},
+                             uint32_t flags = kCodeCacheOptimized) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path target(cache_path);
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path(), ec);
+        if (ec) return false;
+    }
+
+    std::vector<uint8_t> image = serialize_code(root, key, stats, flags);
+    std::string temp = cache_path + ".tmp" +
+                       std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        if (!out) {
+            out.close();
+            fs::remove(temp, ec);
+            return false;
+        }
+    }
+    fs::rename(temp, target, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+class CodeRecord;
+
+/**
+ * CodeCacheFile - mapped cache file with on-demand decoding
+ *
+ * open() maps the file and checks the header and tables only. record()
+ * reads one code object in place. load() decodes a code object into an
+ * owned CodeObject and memoizes it, so a nested code object shared by
+ * several constants is decoded once. Both throw std::runtime_error on a
+ * corrupt file.
+ */
+class CodeCacheFile {
+public:
+    bool open(const std::string& path);
+
+    const CodeCacheHeader& header() const { return header_; }
+    size_t code_count() const { return header_.code_count; }
+
+    // Pooled string i as a view into the mapping
+    std::string_view string(uint32_t index) const;
+
+    // Code object i (0 is the module), read in place without decoding
+    CodeRecord record(uint32_t index = 0);
+
+    // Code object i as a CodeObject, decoded on first request
+    std::shared_ptr<CodeObject> load(uint32_t index = 0);
+
+private:
+    friend class CodeRecord;
+
+    cache_detail::Reader reader(size_t pos) const { return cache_detail::Reader(file_.data(), file_.size(), pos); }
+
+    core::MappedFile file_;
+    CodeCacheHeader header_;
+    std::vector<std::shared_ptr<CodeObject>> decoded_;
+    std::vector<bool> loading_;  // Code objects whose constants are being decoded
+};
+
+/**
+ * CodeRecord - one code object record, read in place
+ *
+ * The constructor reads the fixed fields and skips over the variable
+ * sections to find where each starts; nothing is copied. Names are
+ * views into the mapping, and constants are decoded one at a time when
+ * asked for. constant(i) and nested(i) walk the constants before i.
+ */
+class CodeRecord {
+public:
+    // co_names, co_varnames, co_freevars or co_cellvars as pooled strings
+    class Names {
+    public:
+        size_t size() const { return count_; }
+        std::string_view operator[](size_t i) const;
+
+    private:
+        friend class CodeRecord;
+
+        const CodeCacheFile* file_ = nullptr;
+        size_t pos_ = 0;
+        uint32_t count_ = 0;
+    };
+
+    CodeRecord(CodeCacheFile& file, uint32_t index);
+
+    uint32_t index() const { return index_; }
+    std::string_view name() const { return file_->string(name_); }
+    std::string_view qualname() const { return file_->string(qualname_); }
+    std::string_view filename() const { return file_->string(filename_); }
+    int firstlineno() const { return firstlineno_; }
+    int argcount() const { return argcount_; }
+    int posonlyargcount() const { return posonlyargcount_; }
+    int kwonlyargcount() const { return kwonlyargcount_; }
+    int nlocals() const { return nlocals_; }
+    int stacksize() const { return stacksize_; }
+    uint32_t flags() const { return flags_; }
+
+    std::span<const uint8_t> bytecode() const { return bytecode_; }
+
+    size_t instruction_count() const { return instr_count_; }
+    Instruction instruction(size_t i) const;
+
+    size_t const_count() const { return const_count_; }
+    // Constant i; a code object constant is decoded through CodeCacheFile::load()
+    PyConstant constant(size_t i) const;
+    // Record of constant i if it is a code object
+    std::optional<CodeRecord> nested(size_t i) const;
+
+    const Names& names() const { return names_; }
+    const Names& varnames() const { return varnames_; }
+    const Names& freevars() const { return freevars_; }
+    const Names& cellvars() const { return cellvars_; }
+
+    size_t line_count() const { return line_count_; }
+    std::pair<int, int> line(size_t i) const;  // (offset, lineno)
+
+private:
+    friend class CodeCacheFile;
+
+    // Reader positioned at constant i
+    cache_detail::Reader const_reader(size_t i) const;
+    PyConstant read_constant(cache_detail::Reader& r) const;
+    static void skip_constant(cache_detail::Reader& r);
+    Names read_names(cache_detail::Reader& r) const;
+
+    CodeCacheFile* file_;
+    uint32_t index_;
+    uint32_t name_ = 0;
+    uint32_t qualname_ = 0;
+    uint32_t filename_ = 0;
+    int firstlineno_ = 0;
+    int argcount_ = 0;
+    int posonlyargcount_ = 0;
+    int kwonlyargcount_ = 0;
+    int nlocals_ = 0;
+    int stacksize_ = 0;
+    uint32_t flags_ = 0;
+    std::span<const uint8_t> bytecode_;
+    size_t instr_pos_ = 0;
+    uint32_t instr_count_ = 0;
+    size_t consts_pos_ = 0;
+    uint32_t const_count_ = 0;
+    Names names_;
+    Names varnames_;
+    Names freevars_;
+    Names cellvars_;
+    size_t lines_pos_ = 0;
+    uint32_t line_count_ = 0;
+};
+
+inline bool CodeCacheFile::open(const std::string& path) {
+    decoded_.clear();
+    loading_.clear();
+    if (!file_.open(path) || file_.size() < CodeCacheHeader::kSize ||
+        std::memcmp(file_.data(), kCodeCacheMagic, 4) != 0) {
+        return false;
+    }
+    cache_detail::Reader r(file_.data(), file_.size(), 4);
+    header_.version = r.u32();
+    header_.flags = r.u32();
+    header_.code_count = r.u32();
+    header_.string_count = r.u32();
+    r.u32();  // reserved
+    header_.source.mtime_ns = r.i64();
+    header_.source.size = r.u64();
+    header_.source.hash = r.u64();
+    header_.string_table_offset = r.u64();
+    header_.code_table_offset = r.u64();
+    header_.stats.function_count = r.u32();
+    header_.stats.statement_count = r.u32();
+    header_.stats.expression_count = r.u32();
+
+    if (header_.version != kCodeCacheVersion || header_.code_count == 0) {
+        return false;
+    }
+    uint64_t size = file_.size();
+    if (header_.string_table_offset > size ||
+        header_.string_count > (size - header_.string_table_offset) / 8 ||
+        header_.code_table_offset > size ||
+        header_.code_count > (size - header_.code_table_offset) / 8) {
+        return false;
+    }
+    decoded_.resize(header_.code_count);
+    loading_.assign(header_.code_count, false);
+    return true;
+}
+
+inline std::string_view CodeCacheFile::string(uint32_t index) const {
+    if (index >= header_.string_count) cache_detail::Reader::fail();
+    cache_detail::Reader r(file_.data(), file_.size(), header_.string_table_offset + size_t(index) * 8);
+    uint32_t offset = r.u32();
+    uint32_t length = r.u32();
+    cache_detail::Reader body(file_.data(), file_.size(), offset);
+    return std::string_view(reinterpret_cast<const char*>(body.bytes(length)), length);
+}
+
+inline CodeRecord CodeCacheFile::record(uint32_t index) {
+    return CodeRecord(*this, index);
+}
+
+inline std::shared_ptr<CodeObject> CodeCacheFile::load(uint32_t index) {
+    if (index >= decoded_.size()) cache_detail::Reader::fail();
+    if (decoded_[index]) return decoded_[index];
+    if (loading_[index]) cache_detail::Reader::fail();  // A code object cannot contain itself
+    loading_[index] = true;
+
+    CodeRecord record(*this, index);
+    auto code = std::make_shared<CodeObject>();
+    code->co_name = std::string(record.name());
+    code->co_qualname = std::string(record.qualname());
+    code->co_filename = std::string(record.filename());
+    code->co_firstlineno = record.firstlineno();
+    code->co_argcount = record.argcount();
+    code->co_posonlyargcount = record.posonlyargcount();
+    code->co_kwonlyargcount = record.kwonlyargcount();
+    code->co_nlocals = record.nlocals();
+    code->co_stacksize = record.stacksize();
+    code->co_flags = record.flags();
+    code->co_code.assign(record.bytecode().begin(), record.bytecode().end());
+
+    code->instructions.reserve(record.instruction_count());
+    for (size_t i = 0; i < record.instruction_count(); ++i) {
+        code->instructions.push_back(record.instruction(i));
+    }
+
+    code->co_consts.reserve(record.const_count());
+    cache_detail::Reader consts = record.const_reader(0);
+    for (size_t i = 0; i < record.const_count(); ++i) {
+        code->co_consts.push_back(record.read_constant(consts));
+    }
+
+    auto copy_names = [](const CodeRecord::Names& names) {
+        std::vector<std::string> out;
+        out.reserve(names.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            out.emplace_back(names[i]);
+        }
+        return out;
+    };
+    code->co_names = copy_names(record.names());
+    code->co_varnames = copy_names(record.varnames());
+    code->co_freevars = copy_names(record.freevars());
+    code->co_cellvars = copy_names(record.cellvars());
+    code->reindex();
+
+    code->co_linetable.reserve(record.line_count());
+    for (size_t i = 0; i < record.line_count(); ++i) {
+        code->co_linetable.push_back(record.line(i));
+    }
+
+    loading_[index] = false;
+    decoded_[index] = code;
+    return code;
+}
+
+inline std::string_view CodeRecord::Names::operator[](size_t i) const {
+    if (i >= count_) cache_detail::Reader::fail();
+    return file_->string(file_->reader(pos_ + i * 4).u32());
+}
+
+inline CodeRecord::CodeRecord(CodeCacheFile& file, uint32_t index) : file_(&file), index_(index) {
+    if (index >= file.header_.code_count) cache_detail::Reader::fail();
+    uint64_t offset = file.reader(file.header_.code_table_offset + size_t(index) * 8).u64();
+    if (offset > file.file_.size()) cache_detail::Reader::fail();
+    cache_detail::Reader r = file.reader(offset);
+
+    name_ = r.u32();
+    qualname_ = r.u32();
+    filename_ = r.u32();
+    firstlineno_ = r.i32();
+    argcount_ = r.i32();
+    posonlyargcount_ = r.i32();
+    kwonlyargcount_ = r.i32();
+    nlocals_ = r.i32();
+    stacksize_ = r.i32();
+    flags_ = r.u32();
+
+    uint32_t code_len = r.count(1);
+    bytecode_ = std::span<const uint8_t>(r.bytes(code_len), code_len);
+
+    instr_count_ = r.count(13);
+    instr_pos_ = r.pos();
+    r.bytes(size_t(instr_count_) * 13);
+
+    const_count_ = r.count(1);
+    consts_pos_ = r.pos();
+    for (uint32_t i = 0; i < const_count_; ++i) {
+        skip_constant(r);
+    }
+
+    names_ = read_names(r);
+    varnames_ = read_names(r);
+    freevars_ = read_names(r);
+    cellvars_ = read_names(r);
+
+    line_count_ = r.count(8);
+    lines_pos_ = r.pos();
+    r.bytes(size_t(line_count_) * 8);
+}
+
+inline Instruction CodeRecord::instruction(size_t i) const {
+    if (i >= instr_count_) cache_detail::Reader::fail();
+    cache_detail::Reader r = file_->reader(instr_pos_ + i * 13);
+    auto op = static_cast<Opcode>(r.u8());
+    int32_t arg = r.i32();
+    int lineno = r.i32();
+    Instruction instr(op, arg, lineno);
+    instr.offset = r.i32();
+    return instr;
+}
+
+inline PyConstant CodeRecord::constant(size_t i) const {
+    if (i >= const_count_) cache_detail::Reader::fail();
+    cache_detail::Reader r = const_reader(i);
+    return read_constant(r);
+}
+
+inline std::optional<CodeRecord> CodeRecord::nested(size_t i) const {
+    if (i >= const_count_) cache_detail::Reader::fail();
+    cache_detail::Reader r = const_reader(i);
+    if (static_cast<cache_detail::ConstTag>(r.u8()) != cache_detail::ConstTag::Code) {
+        return std::nullopt;
+    }
+    return CodeRecord(*file_, r.u32());
+}
+
+inline std::pair<int, int> CodeRecord::line(size_t i) const {
+    if (i >= line_count_) cache_detail::Reader::fail();
+    cache_detail::Reader r = file_->reader(lines_pos_ + i * 8);
+    int offset = r.i32();
+    int lineno = r.i32();
+    return {offset, lineno};
+}
+
+inline cache_detail::Reader CodeRecord::const_reader(size_t i) const {
+    cache_detail::Reader r = file_->reader(consts_pos_);
+    for (size_t skipped = 0; skipped < i; ++skipped) {
+        skip_constant(r);
+    }
+    return r;
+}
+
+inline PyConstant CodeRecord::read_constant(cache_detail::Reader& r) const {
+    using cache_detail::ConstTag;
+    switch (static_cast<ConstTag>(r.u8())) {
+        case ConstTag::None: return std::monostate{};
+        case ConstTag::False: return false;
+        case ConstTag::True: return true;
+        case ConstTag::Int: return r.i64();
+        case ConstTag::Float: return r.f64();
+        case ConstTag::String: return std::string(file_->string(r.u32()));
+        case ConstTag::Bytes: {
+            uint32_t n = r.count(1);
+            const uint8_t* data = r.bytes(n);
+            return std::vector<uint8_t>(data, data + n);
+        }
+        case ConstTag::Code: return file_->load(r.u32());
+        default: cache_detail::Reader::fail();
+    }
+}
+
+inline void CodeRecord::skip_constant(cache_detail::Reader& r) {
+    using cache_detail::ConstTag;
+    switch (static_cast<ConstTag>(r.u8())) {
+        case ConstTag::None:
+        case ConstTag::False:
+        case ConstTag::True: break;
+        case ConstTag::Int:
+        case ConstTag::Float: r.bytes(8); break;
+        case ConstTag::String:
+        case ConstTag::Code: r.bytes(4); break;
+        case ConstTag::Bytes: r.bytes(r.count(1)); break;
+        default: cache_detail::Reader::fail();
+    }
+}
+
+inline CodeRecord::Names CodeRecord::read_names(cache_detail::Reader& r) const {
+    Names names;
+    names.file_ = file_;
+    names.count_ = r.count(4);
+    names.pos_ = r.pos();
+    r.bytes(size_t(names.count_) * 4);
+    return names;
+}
+
+/**
+ * Open the cache file for source_path and check it is still fresh:
+ * false if it is missing, corrupt, built with other flags, or stale. A
+ * matching size and mtime is trusted as-is. If only the mtime differs,
+ * the source is hashed, so a touched but unchanged file still hits.
+ * Only the header is read; nothing is decoded.
+ */
+inline bool open_code_cache(CodeCacheFile& file, const std::string& cache_path,
+                            const std::string& source_path,
+                            uint32_t flags = kCodeCacheOptimized) {
+    auto current = stat_source(source_path);
+    if (!current || !file.open(cache_path)) {
+        return false;
+    }
+    const CodeCacheHeader& header = file.header();
+    if (header.flags != flags || header.source.size != current->size) {
+        return false;
+    }
+    if (header.source.mtime_ns != current->mtime_ns) {
+        core::MappedFile source(source_path);
+        std::string_view text(reinterpret_cast<const char*>(source.data()), source.size());
+        if (hash_source(text) != header.source.hash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decoded module for source_path, or nullptr if open_code_cache fails or the records are corrupt
+inline std::shared_ptr<CodeObject> load_code_cache(const std::string& cache_path,
+                                                   const std::string& source_path,
+                                                   uint32_t flags = kCodeCacheOptimized) {
+    CodeCacheFile file;
+    if (!open_code_cache(file, cache_path, source_path, flags)) {
+        return nullptr;
+    }
+    try {
+        return file.load(0);
+    } catch (const std::runtime_error&) {
+        return nullptr;
+    }
+}
+
+} // namespace compiler
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_COMPILER_CODE_CACHE_HPP
@@ -10,6 +10,10 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
 
 namespace cpython_cpp {
 namespace compiler {
@@ -70,6 +74,92 @@ inline std::string constant_to_string(const PyConstant& c) {
     }, c);
 }
 
+/**
+ * Constant identity for co_consts deduplication
+ *
+ * Values of different types never match (1, 1.0 and True stay apart),
+ * floats compare by bit pattern so 0.0 and -0.0 stay apart, and code
+ * objects compare by identity: two lambdas are two constants.
+ */
+inline bool constants_equal(const PyConstant& a, const PyConstant& b) {
+    if (a.index() != b.index()) return false;
+    return std::visit([&b](auto&& arg) -> bool {
+        using T = std::decay_t<decltype(arg)>;
+        const T& other = std::get<T>(b);
+        if constexpr (std::is_same_v<T, double>) {
+            return std::memcmp(&arg, &other, sizeof(double)) == 0;
+        } else {
+            return arg == other;  // shared_ptr compares the pointer
+        }
+    }, a);
+}
+
+inline size_t constant_hash(const PyConstant& c) {
+    size_t h = std::visit([](auto&& arg) -> size_t {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+            return 0;
+        } else if constexpr (std::is_same_v<T, double>) {
+            uint64_t bits;
+            std::memcpy(&bits, &arg, sizeof(bits));
+            return std::hash<uint64_t>{}(bits);
+        } else if constexpr (std::is_same_v<T, std::vector<uint8_t>>) {
+            return std::hash<std::string_view>{}(
+                std::string_view(reinterpret_cast<const char*>(arg.data()), arg.size()));
+        } else {
+            return std::hash<T>{}(arg);
+        }
+    }, c);
+    return h ^ (c.index() * 0x9e3779b97f4a7c15ULL);
+}
+
+struct ConstantHash {
+    size_t operator()(const PyConstant& c) const { return constant_hash(c); }
+};
+
+struct ConstantEqual {
+    bool operator()(const PyConstant& a, const PyConstant& b) const { return constants_equal(a, b); }
+};
+
+/**
+ * TableIndex - hash index over one of a code object's tables
+ *
+ * Maps each entry to its first position so add_name(), add_const() and
+ * friends don't scan the table. Only add() and rebuild() change the
+ * index; find() is read-only, so threads may query a shared CodeObject.
+ * Code that writes a table directly (the bytecode cache loader does)
+ * must call CodeObject::reindex() before the next lookup.
+ */
+template<typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+class TableIndex {
+public:
+    int find(const T& value) const {
+        auto it = positions_.find(value);
+        return it == positions_.end() ? -1 : it->second;
+    }
+
+    // Index of value, appending it to table first if it is not there
+    int add(std::vector<T>& table, const T& value) {
+        int index = find(value);
+        if (index >= 0) return index;
+        table.push_back(value);
+        index = static_cast<int>(table.size() - 1);
+        positions_.emplace(value, index);
+        return index;
+    }
+
+    // Index table from scratch
+    void rebuild(const std::vector<T>& table) {
+        positions_.clear();
+        for (size_t i = 0; i < table.size(); ++i) {
+            positions_.emplace(table[i], static_cast<int>(i));  // Keeps the first
+        }
+    }
+
+private:
+    std::unordered_map<T, int, Hash, Equal> positions_;
+};
+
 /**
  * Code flags (co_flags)
  * Reference: Include/cpython/code.h
@@ -93,6 +183,23 @@ namespace CodeFlags {
     constexpr uint32_t CO_FUTURE_ANNOTATIONS = 0x1000000;
 }
 
+/**
+ * Inline cache slot for one instruction
+ * Reference: Include/internal/pycore_code.h (_PyLoadGlobalCache)
+ * 
+ * CPython stores these in CACHE words after the instruction; here they
+ * live in a side table the VM keeps per interpreter, with one slot per
+ * code unit, indexed by instruction offset / 2, so a CodeObject stays
+ * read-only while it runs. Only the VM interprets them.
+ */
+struct InlineCache {
+    uint64_t version = 0;        // Dict keys version the slot was resolved in
+    uint64_t guard_version = 0;  // Keys version of a dict that must still miss
+    int32_t index = -1;          // Entry index in the resolved dict
+    uint8_t kind = 0;            // VM-defined; 0 = empty
+    uint16_t counter = 0;        // Adaptive warm-up counter (PEP 659)
+};
+
 /**
  * CodeObject - Python code object structure
  * Reference: Include/cpython/code.h (PyCodeObject)
@@ -128,7 +235,14 @@ struct CodeObject {
     uint32_t co_flags;      // Code flags (see below)
     
     // === Line Number Table ===
-    std::vector<std::pair<int, int>> co_linetable;  // (offset, lineno) pairs
+    std::vector<std::pair<int, int>> co_linetable;  // (offset, lineno) at each line change
+    
+    // === Lookup indexes over the tables above (see TableIndex) ===
+    TableIndex<PyConstant, ConstantHash, ConstantEqual> const_index_;
+    TableIndex<std::string> name_index_;
+    TableIndex<std::string> varname_index_;
+    TableIndex<std::string> freevar_index_;
+    TableIndex<std::string> cellvar_index_;
     
     CodeObject()
         : co_firstlineno(1)
@@ -156,74 +270,62 @@ struct CodeObject {
      * Add a constant and return its index
      */
     int add_const(const PyConstant& value) {
-        // Check if constant already exists
-        for (size_t i = 0; i < co_consts.size(); ++i) {
-            if (constant_to_string(co_consts[i]) == constant_to_string(value)) {
-                return static_cast<int>(i);
-            }
-        }
-        co_consts.push_back(value);
-        return static_cast<int>(co_consts.size() - 1);
+        return const_index_.add(co_consts, value);
+    }
+    
+    /**
+     * Find index of a constant (-1 if not found)
+     */
+    int find_const(const PyConstant& value) const {
+        return const_index_.find(value);
     }
     
     /**
      * Add a name and return its index
      */
     int add_name(const std::string& name) {
-        auto it = std::find(co_names.begin(), co_names.end(), name);
-        if (it != co_names.end()) {
-            return static_cast<int>(it - co_names.begin());
-        }
-        co_names.push_back(name);
-        return static_cast<int>(co_names.size() - 1);
+        return name_index_.add(co_names, name);
     }
     
     /**
      * Add a local variable and return its index
      */
     int add_varname(const std::string& name) {
-        auto it = std::find(co_varnames.begin(), co_varnames.end(), name);
-        if (it != co_varnames.end()) {
-            return static_cast<int>(it - co_varnames.begin());
-        }
-        co_varnames.push_back(name);
+        int index = varname_index_.add(co_varnames, name);
         co_nlocals = static_cast<int>(co_varnames.size());
-        return static_cast<int>(co_varnames.size() - 1);
+        return index;
     }
     
     /**
      * Find index of a local variable (-1 if not found)
      */
     int find_varname(const std::string& name) const {
-        auto it = std::find(co_varnames.begin(), co_varnames.end(), name);
-        if (it != co_varnames.end()) {
-            return static_cast<int>(it - co_varnames.begin());
-        }
-        return -1;
+        return varname_index_.find(name);
     }
     
     /**
      * Add a free variable and return its index
      */
     int add_freevar(const std::string& name) {
-        auto it = std::find(co_freevars.begin(), co_freevars.end(), name);
-        if (it != co_freevars.end()) {
-            return static_cast<int>(it - co_freevars.begin());
-        }
-        co_freevars.push_back(name);
-        return static_cast<int>(co_freevars.size() - 1);
+        return freevar_index_.add(co_freevars, name);
     }
     
     /**
      * Add a cell variable and return its index
      */
     int add_cellvar(const std::string& name) {
-        auto it = std::find(co_cellvars.begin(), co_cellvars.end(), name);
-        if (it != co_cellvars.end()) {
-            return static_cast<int>(it - co_cellvars.begin());
-        }
-        co_cellvars.push_back(name);
-        return static_cast<int>(co_cellvars.size() - 1);
+        return cellvar_index_.add(co_cellvars, name);
+    }
+    
+    /**
+     * Rebuild the lookup indexes after writing the tables directly
+     */
+    void reindex() {
+        const_index_.rebuild(co_consts);
+        name_index_.rebuild(co_names);
+        varname_index_.rebuild(co_varnames);
+        freevar_index_.rebuild(co_freevars);
+        cellvar_index_.rebuild(co_cellvars);
     }
     
     /**
@@ -236,32 +338,161 @@ struct CodeObject {
     }
     
     /**
-     * Get current instruction offset
+     * Label of the next instruction to be emitted. Jumps name their
+     * target by label (Instruction::target); resolve_jumps() turns
+     * labels into byte offsets once the code is complete.
+     */
+    int label() const {
+        return static_cast<int>(instructions.size());
+    }
+    
+    /**
+     * Size in bytes of an instruction with the given argument,
+     * including any EXTENDED_ARG prefixes
+     */
+    static int instruction_size(int arg) {
+        int size = 2;  // Base instruction size
+        if (arg > 0xFF) {
+            size += 2;
+            if (arg > 0xFFFF) {
+                size += 2;
+                if (arg > 0xFFFFFF) {
+                    size += 2;
+                }
+            }
+        }
+        return size;
+    }
+    
+    /**
+     * Byte offset just past the last instruction. Provisional until
+     * resolve_jumps() has settled the size of every jump.
      */
     int current_offset() const {
-        int offset = 0;
-        for (const auto& instr : instructions) {
-            offset += 2;  // Base instruction size
-            if (instr.arg > 0xFF) {
-                offset += 2;
-                if (instr.arg > 0xFFFF) {
-                    offset += 2;
-                    if (instr.arg > 0xFFFFFF) {
-                        offset += 2;
-                    }
+        if (instructions.empty()) return 0;
+        const Instruction& last = instructions.back();
+        return last.offset + instruction_size(last.arg);
+    }
+    
+    /**
+     * Absolute byte offset a jump instruction transfers control to.
+     * Relative jumps are measured from the end of the instruction.
+     */
+    static int jump_target(const Instruction& instr) {
+        if (!opcode_is_relative_jump(instr.opcode)) {
+            return instr.arg;
+        }
+        int next = instr.offset + instruction_size(instr.arg);
+        switch (instr.opcode) {
+            case Opcode::JUMP_BACKWARD:
+            case Opcode::JUMP_BACKWARD_NO_INTERRUPT:
+                return next - instr.arg;
+            default:
+                return next + instr.arg;
+        }
+    }
+    
+    /**
+     * Set a jump's argument for a target byte offset, given where the
+     * jump starts and how large it currently is. Relative jumps count
+     * from the end of the instruction; a JUMP_FORWARD/JUMP_BACKWARD
+     * whose target is on the other side flips direction.
+     */
+    static void set_jump_arg(Instruction& instr, int offset, int size, int target) {
+        int next = offset + size;
+        switch (instr.opcode) {
+            case Opcode::JUMP_FORWARD:
+            case Opcode::JUMP_BACKWARD:
+                if (target >= next) {
+                    instr.opcode = Opcode::JUMP_FORWARD;
+                    instr.arg = target - next;
+                } else {
+                    instr.opcode = Opcode::JUMP_BACKWARD;
+                    instr.arg = next - target;
+                }
+                break;
+            case Opcode::JUMP_BACKWARD_NO_INTERRUPT:
+                instr.arg = next - target;
+                break;
+            case Opcode::FOR_ITER:
+            case Opcode::SEND:
+                instr.arg = target - next;
+                break;
+            default:
+                instr.arg = target;
+                break;
+        }
+    }
+    
+    /**
+     * Lay out the instructions and turn jump labels into arguments
+     * Reference: Python/assemble.c (resolve_jump_offsets)
+     * 
+     * A jump whose argument passes 0xFF needs EXTENDED_ARG, which moves
+     * everything after it and can push other jumps over the edge, so
+     * the layout is repeated until no instruction changes size. Jumps
+     * start from their smallest encoding and distances only grow as
+     * sizes grow, so this terminates. Afterwards every offset is final.
+     */
+    void resolve_jumps() {
+        const int count = static_cast<int>(instructions.size());
+        std::vector<int> offsets(instructions.size() + 1, 0);
+        for (auto& instr : instructions) {
+            if (instr.target >= 0) instr.arg = 0;
+        }
+        
+        for (bool stable = false; !stable;) {
+            int offset = 0;
+            for (int i = 0; i < count; ++i) {
+                offsets[i] = offset;
+                offset += instruction_size(instructions[i].arg);
+            }
+            offsets[count] = offset;
+            
+            stable = true;
+            for (int i = 0; i < count; ++i) {
+                Instruction& instr = instructions[i];
+                if (instr.target < 0) continue;
+                int size = instruction_size(instr.arg);
+                set_jump_arg(instr, offsets[i], size, offsets[std::min(instr.target, count)]);
+                if (instruction_size(instr.arg) != size) {
+                    stable = false;
                 }
             }
         }
-        return offset;
+        
+        for (int i = 0; i < count; ++i) {
+            instructions[i].offset = offsets[i];
+        }
+    }
+    
+    /**
+     * Source line of the instruction at a byte offset (0 if unknown)
+     */
+    int line_for_offset(int offset) const {
+        auto it = std::upper_bound(co_linetable.begin(), co_linetable.end(), offset,
+                                   [](int value, const std::pair<int, int>& entry) {
+                                       return value < entry.first;
+                                   });
+        return it == co_linetable.begin() ? 0 : std::prev(it)->second;
     }
     
     /**
-     * Assemble instructions into raw bytecode
+     * Assemble instructions into raw bytecode and the line table.
+     * The line table gets an entry only where the line changes;
+     * instructions without a line (0) belong to the line before them.
      */
     void assemble() {
+        resolve_jumps();
         co_code.clear();
+        co_linetable.clear();
         
         for (const auto& instr : instructions) {
+            if (instr.lineno > 0 &&
+                (co_linetable.empty() || co_linetable.back().second != instr.lineno)) {
+                co_linetable.emplace_back(static_cast<int>(co_code.size()), instr.lineno);
+            }
+
             int arg = instr.arg >= 0 ? instr.arg : 0;
             
             // Handle EXTENDED_ARG for large arguments
@@ -285,24 +516,98 @@ struct CodeObject {
     }
     
     /**
-     * Calculate required stack size
+     * Calculate the maximum stack depth by following control flow
+     * Reference: Python/flowgraph.c (calculate_stackdepth)
+     * 
+     * Every instruction is reached with some entry depth, starting at 0
+     * for the first one; control flows to the next instruction unless
+     * the instruction is an unconditional jump or ends the frame, and to
+     * the jump target if it has one. Each instruction is sized from the
+     * first depth it is reached with, like a basic block in CPython.
+     * 
+     * Exception handlers are entered through the exception table, which
+     * is not emitted yet, so they look unreachable; code no path reaches
+     * is sized from the depth the code before it leaves behind.
+     * Jumps must be resolved (see resolve_jumps()).
      */
     void calculate_stacksize() {
-        int depth = 0;
+        const int count = static_cast<int>(instructions.size());
+        if (count == 0) {
+            co_stacksize = 0;
+            return;
+        }
+        
+        std::vector<int> offsets(instructions.size() + 1);
+        for (int i = 0; i < count; ++i) {
+            offsets[i] = instructions[i].offset;
+        }
+        offsets[count] = current_offset();
+        
+        const int UNSEEN = -1;
+        std::vector<int> entry(instructions.size(), UNSEEN);
+        std::vector<int> worklist;
         int max_depth = 0;
         
-        for (const auto& instr : instructions) {
-            int effect = opcode_stack_effect(instr.opcode, instr.arg >= 0 ? instr.arg : 0);
-            depth += effect;
-            if (depth > max_depth) {
-                max_depth = depth;
+        auto reach = [&](int index, int depth) {
+            if (index < count && entry[index] == UNSEEN) {
+                entry[index] = depth < 0 ? 0 : depth;  // Tolerate unbalanced code
+                worklist.push_back(index);
             }
-            if (depth < 0) {
-                depth = 0;
+        };
+        auto exit_depth = [&](int index) {
+            const Instruction& instr = instructions[index];
+            return entry[index] + opcode_stack_effect(instr.opcode, instr.arg >= 0 ? instr.arg : 0);
+        };
+        
+        reach(0, 0);
+        for (int next_unseen = 0; ; ) {
+            while (!worklist.empty()) {
+                int index = worklist.back();
+                worklist.pop_back();
+                const Instruction& instr = instructions[index];
+                int depth = exit_depth(index);
+                max_depth = std::max({max_depth, entry[index], depth});
+                
+                if (opcode_is_jump(instr.opcode)) {
+                    int target = instr.target >= 0 ? instr.target : -1;
+                    if (target < 0) {
+                        auto it = std::lower_bound(offsets.begin(), offsets.end(), jump_target(instr));
+                        if (it != offsets.end() && *it == jump_target(instr)) {
+                            target = static_cast<int>(it - offsets.begin());
+                        }
+                    }
+                    if (target >= 0) {
+                        reach(target, entry[index] + opcode_jump_stack_effect(
+                                          instr.opcode, instr.arg >= 0 ? instr.arg : 0));
+                    }
+                }
+                if (!ends_flow(instr.opcode)) {
+                    reach(index + 1, depth);
+                }
             }
+            
+            while (next_unseen < count && entry[next_unseen] != UNSEEN) ++next_unseen;
+            if (next_unseen == count) break;
+            reach(next_unseen, next_unseen > 0 && entry[next_unseen - 1] != UNSEEN
+                                   ? exit_depth(next_unseen - 1) : 0);
         }
         
-        co_stacksize = max_depth + 1;
+        co_stacksize = max_depth;
+    }
+    
+    // Control never falls through to the next instruction
+    static bool ends_flow(Opcode op) {
+        switch (op) {
+            case Opcode::RETURN_VALUE:
+            case Opcode::RAISE_VARARGS:
+            case Opcode::RERAISE:
+            case Opcode::JUMP_FORWARD:
+            case Opcode::JUMP_BACKWARD:
+            case Opcode::JUMP_BACKWARD_NO_INTERRUPT:
+                return true;
+            default:
+                return false;
+        }
     }
     
     /**
@@ -348,7 +653,6 @@ struct CodeObject {
         
         // Instructions
         int last_lineno = -1;
-        int offset = 0;
         
         for (const auto& instr : instructions) {
             // Line number
@@ -363,10 +667,12 @@ struct CodeObject {
             }
             
             // Offset
-            oss << std::setw(4) << offset << " ";
+            oss << std::setw(4) << instr.offset << " ";
             
             // Opcode name
-            oss << std::left << std::setw(24) << opcode_name(instr.opcode);
+            std::string name = opcode_name(instr.opcode);
+            oss << std::left << std::setw(24) << name;
+            if (name.size() >= 24) oss << " ";  // Keep long names apart from the arg
             
             // Argument
             if (instr.has_arg()) {
@@ -375,7 +681,6 @@ struct CodeObject {
                 // Argument annotation
                 switch (instr.opcode) {
                     case Opcode::LOAD_CONST:
-                    case Opcode::LOAD_SMALL_INT:
                         if (instr.arg >= 0 && static_cast<size_t>(instr.arg) < co_consts.size()) {
                             oss << " (" << constant_to_string(co_consts[instr.arg]) << ")";
                         }
@@ -420,6 +725,7 @@ struct CodeObject {
                         break;
                         
                     case Opcode::COMPARE_OP:
+                    case Opcode::COMPARE_OP_POP_JUMP_IF_FALSE:
                         {
                             const char* cmp_names[] = {"<", "<=", "==", "!=", ">", ">="};
                             if (instr.arg >= 0 && instr.arg < 6) {
@@ -430,10 +736,29 @@ struct CodeObject {
                         
                     case Opcode::JUMP_FORWARD:
                     case Opcode::JUMP_BACKWARD:
+                    case Opcode::JUMP_BACKWARD_NO_INTERRUPT:
                     case Opcode::POP_JUMP_IF_FALSE:
                     case Opcode::POP_JUMP_IF_TRUE:
                     case Opcode::FOR_ITER:
-                        oss << " (to " << instr.arg << ")";
+                    case Opcode::SEND:
+                        oss << " (to " << jump_target(instr) << ")";
+                        break;
+                        
+                    case Opcode::LOAD_FAST_LOAD_FAST:
+                    case Opcode::LOAD_FAST_LOAD_CONST:
+                        {
+                            size_t local = static_cast<size_t>(instr.arg >> 4);
+                            size_t second = static_cast<size_t>(instr.arg & 15);
+                            if (local < co_varnames.size()) {
+                                oss << " (" << co_varnames[local] << ", ";
+                                if (instr.opcode == Opcode::LOAD_FAST_LOAD_FAST) {
+                                    oss << (second < co_varnames.size() ? co_varnames[second] : "?");
+                                } else {
+                                    oss << (second < co_consts.size() ? constant_to_string(co_consts[second]) : "?");
+                                }
+                                oss << ")";
+                            }
+                        }
                         break;
                         
                     default:
@@ -442,7 +767,6 @@ struct CodeObject {
             }
             
             oss << "\n";
-            offset += 2;
         }
         
         return oss.str();
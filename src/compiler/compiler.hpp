@@ -39,12 +39,12 @@ public:
 
 private:
     void visit_module(std::shared_ptr<ast::Module> module, int indent, std::ostringstream& oss);
-    void visit_stmt(std::shared_ptr<ast::Stmt> stmt, int indent, std::ostringstream& oss);
-    void visit_expr(std::shared_ptr<ast::Expr> expr, int indent, std::ostringstream& oss);
+    void visit_stmt(ast::Stmt* stmt, int indent, std::ostringstream& oss);
+    void visit_expr(ast::Expr* expr, int indent, std::ostringstream& oss);
 
     Breakdown breakdown_;
     void collect_stats(std::shared_ptr<ast::Module> module);
-    void collect_stmt_stats(std::shared_ptr<ast::Stmt> stmt);
+    void collect_stmt_stats(ast::Stmt* stmt);
 };
 
 // Implementations
@@ -88,11 +88,11 @@ inline void Compiler::collect_stats(std::shared_ptr<ast::Module> module) {
     }
 }
 
-inline void Compiler::collect_stmt_stats(std::shared_ptr<ast::Stmt> stmt) {
+inline void Compiler::collect_stmt_stats(ast::Stmt* stmt) {
     breakdown_.statement_count++;
 
     // Check if it's a FunctionDef
-    auto func_def = std::dynamic_pointer_cast<ast::FunctionDef>(stmt);
+    auto func_def = dynamic_cast<ast::FunctionDef*>(stmt);
     if (func_def) {
         breakdown_.function_count++;
         breakdown_.function_names.push_back(func_def->name());
@@ -104,7 +104,7 @@ inline void Compiler::collect_stmt_stats(std::shared_ptr<ast::Stmt> stmt) {
     }
 
     // Check if it's an If statement
-    auto if_stmt = std::dynamic_pointer_cast<ast::If>(stmt);
+    auto if_stmt = dynamic_cast<ast::If*>(stmt);
     if (if_stmt) {
         for (const auto& body_stmt : if_stmt->body()) {
             collect_stmt_stats(body_stmt);
@@ -122,8 +122,8 @@ inline void Compiler::visit_module(std::shared_ptr<ast::Module> module, int inde
     }
 }
 
-inline void Compiler::visit_stmt(std::shared_ptr<ast::Stmt> stmt, int indent, std::ostringstream& oss) {
-    auto func_def = std::dynamic_pointer_cast<ast::FunctionDef>(stmt);
+inline void Compiler::visit_stmt(ast::Stmt* stmt, int indent, std::ostringstream& oss) {
+    auto func_def = dynamic_cast<ast::FunctionDef*>(stmt);
     if (func_def) {
         oss << std::string(indent * 2, ' ') << "FunctionDef: " << func_def->name() << "\n";
         oss << std::string(indent * 2, ' ') << "  Args: ";
@@ -139,7 +139,7 @@ inline void Compiler::visit_stmt(std::shared_ptr<ast::Stmt> stmt, int indent, st
         return;
     }
 
-    auto return_stmt = std::dynamic_pointer_cast<ast::Return>(stmt);
+    auto return_stmt = dynamic_cast<ast::Return*>(stmt);
     if (return_stmt) {
         oss << std::string(indent * 2, ' ') << "Return\n";
         if (return_stmt->value()) {
@@ -148,7 +148,7 @@ inline void Compiler::visit_stmt(std::shared_ptr<ast::Stmt> stmt, int indent, st
         return;
     }
 
-    auto assign = std::dynamic_pointer_cast<ast::Assign>(stmt);
+    auto assign = dynamic_cast<ast::Assign*>(stmt);
     if (assign) {
         oss << std::string(indent * 2, ' ') << "Assign\n";
         oss << std::string(indent * 2, ' ') << "  Targets:\n";
@@ -160,7 +160,7 @@ inline void Compiler::visit_stmt(std::shared_ptr<ast::Stmt> stmt, int indent, st
         return;
     }
 
-    auto if_stmt = std::dynamic_pointer_cast<ast::If>(stmt);
+    auto if_stmt = dynamic_cast<ast::If*>(stmt);
     if (if_stmt) {
         oss << std::string(indent * 2, ' ') << "If\n";
         oss << std::string(indent * 2, ' ') << "  Test:\n";
@@ -178,7 +178,7 @@ inline void Compiler::visit_stmt(std::shared_ptr<ast::Stmt> stmt, int indent, st
         return;
     }
 
-    auto expr_stmt = std::dynamic_pointer_cast<ast::ExprStmt>(stmt);
+    auto expr_stmt = dynamic_cast<ast::ExprStmt*>(stmt);
     if (expr_stmt) {
         oss << std::string(indent * 2, ' ') << "Expr\n";
         visit_expr(expr_stmt->value(), indent + 1, oss);
@@ -188,20 +188,20 @@ inline void Compiler::visit_stmt(std::shared_ptr<ast::Stmt> stmt, int indent, st
     oss << std::string(indent * 2, ' ') << "Statement\n";
 }
 
-inline void Compiler::visit_expr(std::shared_ptr<ast::Expr> expr, int indent, std::ostringstream& oss) {
-    auto constant = std::dynamic_pointer_cast<ast::Constant>(expr);
+inline void Compiler::visit_expr(ast::Expr* expr, int indent, std::ostringstream& oss) {
+    auto constant = dynamic_cast<ast::Constant*>(expr);
     if (constant) {
         oss << std::string(indent * 2, ' ') << "Constant: " << constant->value() << "\n";
         return;
     }
 
-    auto name = std::dynamic_pointer_cast<ast::Name>(expr);
+    auto name = dynamic_cast<ast::Name*>(expr);
     if (name) {
         oss << std::string(indent * 2, ' ') << "Name: " << name->id() << "\n";
         return;
     }
 
-    auto binop = std::dynamic_pointer_cast<ast::BinOp>(expr);
+    auto binop = dynamic_cast<ast::BinOp*>(expr);
     if (binop) {
         oss << std::string(indent * 2, ' ') << "BinOp\n";
         visit_expr(binop->left(), indent + 1, oss);
@@ -210,7 +210,7 @@ inline void Compiler::visit_expr(std::shared_ptr<ast::Expr> expr, int indent, st
         return;
     }
 
-    auto call = std::dynamic_pointer_cast<ast::Call>(expr);
+    auto call = dynamic_cast<ast::Call*>(expr);
     if (call) {
         oss << std::string(indent * 2, ' ') << "Call\n";
         visit_expr(call->func(), indent + 1, oss);
@@ -184,6 +184,36 @@ enum class Opcode : uint8_t {
     CALL_INTRINSIC_2        = 54,   // Call intrinsic (2 args)
     INTERPRETER_EXIT        = 20,   // Exit interpreter
     EXIT_INIT_CHECK         = 11,   // Check __init__ exit
+    
+    // === Specialized Instructions (PEP 659) ===
+    // Never emitted by the compiler: the VM rewrites BINARY_OP, COMPARE_OP
+    // and FOR_ITER in its own copy of co_code once it has seen the operand
+    // types, and rewrites them back when a type guard fails. Same arg and
+    // stack effect as the generic instruction.
+    BINARY_OP_ADD_INT       = 150,  // int + int
+    BINARY_OP_SUBTRACT_INT  = 151,  // int - int
+    BINARY_OP_MULTIPLY_INT  = 152,  // int * int
+    BINARY_OP_ADD_FLOAT     = 153,  // float + float
+    BINARY_OP_SUBTRACT_FLOAT = 154, // float - float
+    BINARY_OP_MULTIPLY_FLOAT = 155, // float * float
+    BINARY_OP_ADD_UNICODE   = 156,  // str + str
+    COMPARE_OP_INT          = 157,  // int <op> int
+    COMPARE_OP_FLOAT        = 158,  // float <op> float
+    COMPARE_OP_STR          = 159,  // str <op> str
+    FOR_ITER_LIST           = 162,  // list_iterator
+    FOR_ITER_TUPLE          = 163,  // tuple_iterator
+    FOR_ITER_RANGE          = 164,  // range_iterator
+    
+    // === Superinstructions ===
+    // Emitted only by the peephole optimizer (optimizer.hpp) in place of
+    // a common instruction pair, so the VM dispatches once for both.
+    // LOAD_FAST_LOAD_FAST (above) shares the nibble-packed arg format.
+    // COMPARE_OP_POP_JUMP_IF_FALSE keeps the compare's arg and leaves the
+    // POP_JUMP_IF_FALSE in place after it (like CPython 3.12's
+    // COMPARE_AND_BRANCH); the VM reads the jump's arg and skips it, so
+    // the target never has to share an arg byte with the comparison.
+    LOAD_FAST_LOAD_CONST    = 160,  // LOAD_FAST; LOAD_CONST (arg: local << 4 | const)
+    COMPARE_OP_POP_JUMP_IF_FALSE = 161, // COMPARE_OP whose POP_JUMP_IF_FALSE is consumed with it
 };
 
 /**
@@ -247,9 +277,10 @@ struct Instruction {
     int32_t arg;        // Argument (if any), -1 if no argument
     int lineno;         // Source line number
     int offset;         // Byte offset in bytecode
+    int target;         // Jumps: index of the instruction jumped to, -1 if arg is final
     
     Instruction(Opcode op, int32_t a = -1, int line = 0)
-        : opcode(op), arg(a), lineno(line), offset(0) {}
+        : opcode(op), arg(a), lineno(line), offset(0), target(-1) {}
     
     bool has_arg() const {
         return arg >= 0;
@@ -332,6 +363,18 @@ inline const char* opcode_name(Opcode op) {
         
         // Comparison
         case Opcode::COMPARE_OP: return "COMPARE_OP";
+        case Opcode::BINARY_OP_ADD_INT: return "BINARY_OP_ADD_INT";
+        case Opcode::BINARY_OP_SUBTRACT_INT: return "BINARY_OP_SUBTRACT_INT";
+        case Opcode::BINARY_OP_MULTIPLY_INT: return "BINARY_OP_MULTIPLY_INT";
+        case Opcode::BINARY_OP_ADD_FLOAT: return "BINARY_OP_ADD_FLOAT";
+        case Opcode::BINARY_OP_SUBTRACT_FLOAT: return "BINARY_OP_SUBTRACT_FLOAT";
+        case Opcode::BINARY_OP_MULTIPLY_FLOAT: return "BINARY_OP_MULTIPLY_FLOAT";
+        case Opcode::BINARY_OP_ADD_UNICODE: return "BINARY_OP_ADD_UNICODE";
+        case Opcode::COMPARE_OP_INT: return "COMPARE_OP_INT";
+        case Opcode::COMPARE_OP_FLOAT: return "COMPARE_OP_FLOAT";
+        case Opcode::COMPARE_OP_STR: return "COMPARE_OP_STR";
+        case Opcode::LOAD_FAST_LOAD_CONST: return "LOAD_FAST_LOAD_CONST";
+        case Opcode::COMPARE_OP_POP_JUMP_IF_FALSE: return "COMPARE_OP_POP_JUMP_IF_FALSE";
         case Opcode::IS_OP: return "IS_OP";
         case Opcode::CONTAINS_OP: return "CONTAINS_OP";
         
@@ -350,6 +393,9 @@ inline const char* opcode_name(Opcode op) {
         case Opcode::GET_AITER: return "GET_AITER";
         case Opcode::GET_ANEXT: return "GET_ANEXT";
         case Opcode::FOR_ITER: return "FOR_ITER";
+        case Opcode::FOR_ITER_LIST: return "FOR_ITER_LIST";
+        case Opcode::FOR_ITER_TUPLE: return "FOR_ITER_TUPLE";
+        case Opcode::FOR_ITER_RANGE: return "FOR_ITER_RANGE";
         case Opcode::END_FOR: return "END_FOR";
         case Opcode::POP_ITER: return "POP_ITER";
         case Opcode::GET_YIELD_FROM_ITER: return "GET_YIELD_FROM_ITER";
@@ -486,6 +532,9 @@ inline bool opcode_is_jump(Opcode op) {
         case Opcode::POP_JUMP_IF_NONE:
         case Opcode::POP_JUMP_IF_NOT_NONE:
         case Opcode::FOR_ITER:
+        case Opcode::FOR_ITER_LIST:
+        case Opcode::FOR_ITER_TUPLE:
+        case Opcode::FOR_ITER_RANGE:
         case Opcode::SEND:
             return true;
         default:
@@ -502,6 +551,9 @@ inline bool opcode_is_relative_jump(Opcode op) {
         case Opcode::JUMP_BACKWARD:
         case Opcode::JUMP_BACKWARD_NO_INTERRUPT:
         case Opcode::FOR_ITER:
+        case Opcode::FOR_ITER_LIST:
+        case Opcode::FOR_ITER_TUPLE:
+        case Opcode::FOR_ITER_RANGE:
         case Opcode::SEND:
             return true;
         default:
@@ -573,6 +625,19 @@ inline int opcode_stack_effect(Opcode op, int arg) {
         
         // Comparison
         case Opcode::COMPARE_OP: return -1;
+        case Opcode::BINARY_OP_ADD_INT:
+        case Opcode::BINARY_OP_SUBTRACT_INT:
+        case Opcode::BINARY_OP_MULTIPLY_INT:
+        case Opcode::BINARY_OP_ADD_FLOAT:
+        case Opcode::BINARY_OP_SUBTRACT_FLOAT:
+        case Opcode::BINARY_OP_MULTIPLY_FLOAT:
+        case Opcode::BINARY_OP_ADD_UNICODE:
+        case Opcode::COMPARE_OP_INT:
+        case Opcode::COMPARE_OP_FLOAT:
+        case Opcode::COMPARE_OP_STR:
+            return -1;
+        case Opcode::LOAD_FAST_LOAD_CONST: return 2;
+        case Opcode::COMPARE_OP_POP_JUMP_IF_FALSE: return -1;  // Its jump pops the bool
         case Opcode::IS_OP: return -1;
         case Opcode::CONTAINS_OP: return -1;
         
@@ -588,7 +653,11 @@ inline int opcode_stack_effect(Opcode op, int arg) {
         
         // Iteration
         case Opcode::GET_ITER: return 0;
-        case Opcode::FOR_ITER: return 1;
+        case Opcode::FOR_ITER:
+        case Opcode::FOR_ITER_LIST:
+        case Opcode::FOR_ITER_TUPLE:
+        case Opcode::FOR_ITER_RANGE:
+            return 1;
         case Opcode::END_FOR: return -1;
         case Opcode::POP_ITER: return -1;
         
@@ -605,6 +674,9 @@ inline int opcode_stack_effect(Opcode op, int arg) {
         case Opcode::BUILD_MAP: return 1 - 2 * arg;
         case Opcode::BUILD_STRING: return 1 - arg;
         case Opcode::BUILD_SLICE: return -1;
+        case Opcode::FORMAT_SIMPLE: return 0;
+        case Opcode::FORMAT_WITH_SPEC: return -1;  // Spec and value formatted to one str
+        case Opcode::CONVERT_VALUE: return 0;
         
         // List/Set/Dict Operations
         case Opcode::LIST_APPEND: return -1;
@@ -630,8 +702,14 @@ inline int opcode_stack_effect(Opcode op, int arg) {
         case Opcode::IMPORT_NAME: return -1;
         case Opcode::IMPORT_FROM: return 1;
         
-        // Async/Await
-        case Opcode::YIELD_VALUE: return 0;
+        // Generators and Async/Await
+        case Opcode::YIELD_VALUE: return 0;       // Yielded value out, sent value in
+        case Opcode::SEND: return 0;              // Sent value replaced by the result
+        case Opcode::END_SEND: return -1;
+        case Opcode::GET_YIELD_FROM_ITER: return 0;
+        case Opcode::GET_AWAITABLE: return 0;
+        case Opcode::GET_AITER: return 0;
+        case Opcode::GET_ANEXT: return 1;
         
         // Misc
         case Opcode::NOP: return 0;
@@ -642,6 +720,24 @@ inline int opcode_stack_effect(Opcode op, int arg) {
     }
 }
 
+/**
+ * Stack effect of a jump instruction along its jump edge
+ * 
+ * Differs from opcode_stack_effect() only for FOR_ITER (and its
+ * specializations): an exhausted iterator pushes nothing and stays on
+ * the stack for END_FOR.
+ */
+inline int opcode_jump_stack_effect(Opcode op, int arg) {
+    switch (op) {
+        case Opcode::FOR_ITER:
+        case Opcode::FOR_ITER_LIST:
+        case Opcode::FOR_ITER_TUPLE:
+        case Opcode::FOR_ITER_RANGE:
+            return 0;
+        default: return opcode_stack_effect(op, arg);
+    }
+}
+
 } // namespace compiler
 } // namespace cpython_cpp
 
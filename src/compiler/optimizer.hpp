@@ -0,0 +1,653 @@
+#ifndef CPYTHON_CPP_COMPILER_OPTIMIZER_HPP
+#define CPYTHON_CPP_COMPILER_OPTIMIZER_HPP
+
+#include "opcode.hpp"
+#include "code_object.hpp"
+#include <vector>
+#include <optional>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace cpython_cpp {
+namespace compiler {
+
+/**
+ * PeepholeOptimizer - rewrites CodeObject::instructions before assembly
+ * Reference: Python/flowgraph.c (optimize_basic_block, fold_tuple_on_constants)
+ *
+ * Jumps are decoded to instruction indices first, so the passes can
+ * insert, merge and delete instructions freely; offsets and jump
+ * arguments (including EXTENDED_ARG growth) are recomputed at the end.
+ *
+ * Passes, repeated until nothing changes:
+ *   1. Constant folding of unary/binary ops on literal operands, and of
+ *      conditional jumps on a literal (`while True:`)
+ *   2. Jump threading (a jump to an unconditional jump goes straight on)
+ *   3. Removal of jumps to the next instruction
+ *   4. Removal of unreachable code after RETURN/RAISE/unconditional jumps
+ * followed by one superinstruction pass:
+ *   LOAD_FAST + LOAD_FAST        -> LOAD_FAST_LOAD_FAST
+ *   LOAD_FAST + LOAD_CONST       -> LOAD_FAST_LOAD_CONST
+ *   COMPARE_OP + POP_JUMP_IF_FALSE -> COMPARE_OP_POP_JUMP_IF_FALSE (+ the jump)
+ */
+class PeepholeOptimizer {
+public:
+    explicit PeepholeOptimizer(CodeObject& code) : code_(code) {}
+
+    void run() {
+        if (!decode()) {
+            return;  // Leave code we cannot map as-is
+        }
+
+        bool changed = true;
+        for (int round = 0; changed && round < MAX_ROUNDS; ++round) {
+            changed = false;
+            changed |= fold_constants();
+            changed |= thread_jumps();
+            changed |= remove_redundant_jumps();
+            changed |= remove_unreachable();
+        }
+        fuse_superinstructions();
+
+        encode();
+    }
+
+private:
+    static constexpr int MAX_ROUNDS = 8;
+    static constexpr size_t MAX_FOLDED_STR = 4096;  // Don't bloat co_consts
+    static constexpr int NO_TARGET = -1;
+
+    // Instruction plus the index of its jump target (NO_TARGET if none)
+    struct Node {
+        Instruction instr;
+        int target;
+    };
+
+    CodeObject& code_;
+    std::vector<Node> nodes_;
+
+    // ------------------------------------------------------------------
+    // Decoding / encoding
+    // ------------------------------------------------------------------
+
+    /**
+     * Map every jump to the index of its target: the label it was
+     * emitted with, or else the instruction at its byte target.
+     * The index nodes_.size() means "falls off the end".
+     */
+    bool decode() {
+        const auto& instrs = code_.instructions;
+        std::vector<int> offsets(instrs.size() + 1);
+        int offset = 0;
+        for (size_t i = 0; i < instrs.size(); ++i) {
+            offsets[i] = offset;
+            offset += CodeObject::instruction_size(instrs[i].arg);
+        }
+        offsets[instrs.size()] = offset;
+
+        nodes_.clear();
+        nodes_.reserve(instrs.size());
+        for (size_t i = 0; i < instrs.size(); ++i) {
+            Node node{instrs[i], NO_TARGET};
+            if (opcode_is_jump(instrs[i].opcode) && instrs[i].target >= 0) {
+                node.target = instrs[i].target;
+            } else if (opcode_is_jump(instrs[i].opcode)) {
+                int target = absolute_target(instrs[i], offsets[i]);
+                auto it = std::lower_bound(offsets.begin(), offsets.end(), target);
+                if (it == offsets.end() || *it != target) {
+                    return false;
+                }
+                node.target = static_cast<int>(it - offsets.begin());
+            }
+            nodes_.push_back(node);
+        }
+        return true;
+    }
+
+    static int absolute_target(const Instruction& instr, int offset) {
+        Instruction at = instr;
+        at.offset = offset;
+        return CodeObject::jump_target(at);
+    }
+
+    /**
+     * Write the instructions back with their targets as labels and let
+     * the assembler lay them out (see CodeObject::resolve_jumps()).
+     */
+    void encode() {
+        code_.instructions.clear();
+        code_.instructions.reserve(nodes_.size());
+        for (const auto& node : nodes_) {
+            code_.instructions.push_back(node.instr);
+            code_.instructions.back().target = node.target;
+        }
+        code_.resolve_jumps();
+    }
+
+    // ------------------------------------------------------------------
+    // Helpers
+    // ------------------------------------------------------------------
+
+    static bool is_unconditional_jump(Opcode op) {
+        return op == Opcode::JUMP_FORWARD || op == Opcode::JUMP_BACKWARD;
+    }
+
+    static bool is_conditional_jump(Opcode op) {
+        switch (op) {
+            case Opcode::POP_JUMP_IF_FALSE:
+            case Opcode::POP_JUMP_IF_TRUE:
+            case Opcode::POP_JUMP_IF_NONE:
+            case Opcode::POP_JUMP_IF_NOT_NONE:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * Exception handlers are entered through the exception table, which
+     * the compiler does not emit yet, so they look unreachable here.
+     * Code that has any must keep everything.
+     */
+    bool has_exception_handlers() const {
+        for (const auto& node : nodes_) {
+            switch (node.instr.opcode) {
+                case Opcode::PUSH_EXC_INFO:
+                case Opcode::CHECK_EXC_MATCH:
+                case Opcode::CHECK_EG_MATCH:
+                case Opcode::BEFORE_WITH:
+                case Opcode::BEFORE_ASYNC_WITH:
+                case Opcode::WITH_EXCEPT_START:
+                case Opcode::CLEANUP_THROW:
+                    return true;
+                default:
+                    break;
+            }
+        }
+        return false;
+    }
+
+    std::vector<bool> jump_targets() const {
+        std::vector<bool> targets(nodes_.size() + 1, false);
+        for (const auto& node : nodes_) {
+            if (node.target != NO_TARGET) {
+                targets[node.target] = true;
+            }
+        }
+        return targets;
+    }
+
+    /**
+     * Drop the marked nodes. Jumps into a removed run land on the first
+     * surviving instruction after it.
+     */
+    void erase(const std::vector<bool>& removed) {
+        std::vector<int> remap(nodes_.size() + 1);
+        int kept = 0;
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            remap[i] = kept;
+            if (!removed[i]) ++kept;
+        }
+        remap[nodes_.size()] = kept;
+
+        std::vector<Node> result;
+        result.reserve(kept);
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            if (removed[i]) continue;
+            Node node = nodes_[i];
+            if (node.target != NO_TARGET) {
+                node.target = remap[node.target];
+            }
+            result.push_back(node);
+        }
+        nodes_ = std::move(result);
+    }
+
+    // ------------------------------------------------------------------
+    // Constant folding
+    // ------------------------------------------------------------------
+
+    std::optional<PyConstant> literal(const Instruction& instr) const {
+        if (instr.opcode == Opcode::LOAD_SMALL_INT) {
+            return PyConstant{static_cast<int64_t>(instr.arg)};
+        }
+        if (instr.opcode == Opcode::LOAD_CONST &&
+            instr.arg >= 0 && static_cast<size_t>(instr.arg) < code_.co_consts.size()) {
+            const PyConstant& c = code_.co_consts[instr.arg];
+            // bool arithmetic is not modelled by the VM yet; leave it alone
+            if (std::holds_alternative<int64_t>(c) ||
+                std::holds_alternative<double>(c) ||
+                std::holds_alternative<std::string>(c)) {
+                return c;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<bool> literal_truth(const Instruction& instr) const {
+        if (instr.opcode == Opcode::LOAD_SMALL_INT) {
+            return instr.arg != 0;
+        }
+        if (instr.opcode != Opcode::LOAD_CONST ||
+            instr.arg < 0 || static_cast<size_t>(instr.arg) >= code_.co_consts.size()) {
+            return std::nullopt;
+        }
+        return std::visit([](auto&& c) -> std::optional<bool> {
+            using T = std::decay_t<decltype(c)>;
+            if constexpr (std::is_same_v<T, std::monostate>) return false;
+            else if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, int64_t>) return c != 0;
+            else if constexpr (std::is_same_v<T, double>) return c != 0.0;
+            else if constexpr (std::is_same_v<T, std::string>) return !c.empty();
+            else return std::nullopt;
+        }, code_.co_consts[instr.arg]);
+    }
+
+    Instruction load_literal(const PyConstant& value, int lineno) {
+        if (auto* i = std::get_if<int64_t>(&value); i && *i >= 0 && *i <= 255) {
+            return Instruction(Opcode::LOAD_SMALL_INT, static_cast<int32_t>(*i), lineno);
+        }
+        return Instruction(Opcode::LOAD_CONST, code_.add_const(value), lineno);
+    }
+
+    bool fold_constants() {
+        bool changed = false;
+        auto targets = jump_targets();
+        std::vector<bool> removed(nodes_.size(), false);
+
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            if (removed[i]) continue;
+            Opcode op = nodes_[i].instr.opcode;
+            std::optional<PyConstant> result;
+            std::vector<size_t> operands;
+
+            if (op == Opcode::UNARY_NEGATIVE || op == Opcode::UNARY_INVERT) {
+                size_t a = previous_live(removed, i);
+                if (a == i || targets[i]) continue;
+                auto value = literal(nodes_[a].instr);
+                if (!value) continue;
+                result = fold_unary(op, *value);
+                operands = {a};
+            } else if (op == Opcode::POP_JUMP_IF_FALSE || op == Opcode::POP_JUMP_IF_TRUE) {
+                size_t a = previous_live(removed, i);
+                if (a == i || targets[i]) continue;
+                auto truth = literal_truth(nodes_[a].instr);
+                if (!truth) continue;
+                // Taken: an unconditional jump. Not taken: nothing at all.
+                if (*truth == (op == Opcode::POP_JUMP_IF_TRUE)) {
+                    nodes_[a] = Node{Instruction(Opcode::JUMP_FORWARD, 0, nodes_[i].instr.lineno),
+                                     nodes_[i].target};
+                } else {
+                    nodes_[a] = Node{Instruction(Opcode::NOP, -1, nodes_[i].instr.lineno), NO_TARGET};
+                    removed[a] = true;
+                }
+                removed[i] = true;
+                changed = true;
+                continue;
+            } else if (op == Opcode::BINARY_OP) {
+                size_t b = previous_live(removed, i);
+                if (b == i) continue;
+                size_t a = previous_live(removed, b);
+                if (a == b || targets[b] || targets[i]) continue;
+                auto lhs = literal(nodes_[a].instr);
+                auto rhs = literal(nodes_[b].instr);
+                if (!lhs || !rhs) continue;
+                result = fold_binary(nodes_[i].instr.arg, *lhs, *rhs);
+                operands = {a, b};
+            } else {
+                continue;
+            }
+
+            if (!result) continue;
+
+            // The folded load replaces the first operand, which may be a
+            // jump target; the rest of the pattern goes away
+            size_t first = operands.front();
+            nodes_[first] = Node{load_literal(*result, nodes_[first].instr.lineno), NO_TARGET};
+            for (size_t k = 1; k < operands.size(); ++k) removed[operands[k]] = true;
+            removed[i] = true;
+            changed = true;
+        }
+
+        if (changed) erase(removed);
+        return changed;
+    }
+
+    static size_t previous_live(const std::vector<bool>& removed, size_t i) {
+        size_t j = i;
+        while (j > 0) {
+            --j;
+            if (!removed[j]) return j;
+        }
+        return i;
+    }
+
+    static std::optional<PyConstant> fold_unary(Opcode op, const PyConstant& value) {
+        if (auto* i = std::get_if<int64_t>(&value)) {
+            if (op == Opcode::UNARY_INVERT) return PyConstant{~*i};
+            if (*i == std::numeric_limits<int64_t>::min()) return std::nullopt;
+            return PyConstant{-*i};
+        }
+        if (auto* d = std::get_if<double>(&value); d && op == Opcode::UNARY_NEGATIVE) {
+            return PyConstant{-*d};
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * Evaluate a BINARY_OP at compile time, matching the VM's semantics.
+     * Anything that would raise or overflow int64 is left for runtime.
+     */
+    static std::optional<PyConstant> fold_binary(int op, const PyConstant& lhs, const PyConstant& rhs) {
+        if (op >= static_cast<int>(BinaryOpCode::NB_INPLACE_ADD)) {
+            return std::nullopt;  // Augmented assignment targets are never literals
+        }
+        auto code = static_cast<BinaryOpCode>(op);
+
+        auto* li = std::get_if<int64_t>(&lhs);
+        auto* ri = std::get_if<int64_t>(&rhs);
+        if (li && ri) {
+            return fold_int(code, *li, *ri);
+        }
+
+        auto* ld = std::get_if<double>(&lhs);
+        auto* rd = std::get_if<double>(&rhs);
+        if ((li || ld) && (ri || rd)) {
+            double l = li ? static_cast<double>(*li) : *ld;
+            double r = ri ? static_cast<double>(*ri) : *rd;
+            return fold_float(code, l, r);
+        }
+
+        auto* ls = std::get_if<std::string>(&lhs);
+        auto* rs = std::get_if<std::string>(&rhs);
+        if (ls && rs && code == BinaryOpCode::NB_ADD &&
+            ls->size() + rs->size() <= MAX_FOLDED_STR) {
+            return PyConstant{*ls + *rs};
+        }
+        return std::nullopt;
+    }
+
+    // out = l op r; false on int64 overflow (the builtins are GCC/Clang only)
+    static bool checked_add(int64_t l, int64_t r, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return !__builtin_add_overflow(l, r, &out);
+#else
+        using limits = std::numeric_limits<int64_t>;
+        if ((r > 0 && l > limits::max() - r) || (r < 0 && l < limits::min() - r)) return false;
+        out = l + r;
+        return true;
+#endif
+    }
+    
+    static bool checked_sub(int64_t l, int64_t r, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return !__builtin_sub_overflow(l, r, &out);
+#else
+        using limits = std::numeric_limits<int64_t>;
+        if ((r < 0 && l > limits::max() + r) || (r > 0 && l < limits::min() + r)) return false;
+        out = l - r;
+        return true;
+#endif
+    }
+    
+    static bool checked_mul(int64_t l, int64_t r, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return !__builtin_mul_overflow(l, r, &out);
+#else
+        using limits = std::numeric_limits<int64_t>;
+        if (l != 0 && r != 0) {
+            if ((l == -1 && r == limits::min()) || (r == -1 && l == limits::min())) return false;
+            if (l != -1 && r != -1) {
+                bool positive = (l > 0) == (r > 0);
+                if (positive && (l > 0 ? l > limits::max() / r : l < limits::max() / r)) return false;
+                if (!positive && (l > 0 ? r < limits::min() / l : l < limits::min() / r)) return false;
+            }
+        }
+        out = l * r;
+        return true;
+#endif
+    }
+    
+    static std::optional<PyConstant> fold_int(BinaryOpCode code, int64_t l, int64_t r) {
+        int64_t out;
+        switch (code) {
+            case BinaryOpCode::NB_ADD:
+                if (!checked_add(l, r, out)) return std::nullopt;
+                return PyConstant{out};
+            case BinaryOpCode::NB_SUBTRACT:
+                if (!checked_sub(l, r, out)) return std::nullopt;
+                return PyConstant{out};
+            case BinaryOpCode::NB_MULTIPLY:
+                if (!checked_mul(l, r, out)) return std::nullopt;
+                return PyConstant{out};
+            case BinaryOpCode::NB_AND: return PyConstant{l & r};
+            case BinaryOpCode::NB_OR: return PyConstant{l | r};
+            case BinaryOpCode::NB_XOR: return PyConstant{l ^ r};
+            case BinaryOpCode::NB_LSHIFT:
+                if (r < 0 || r >= 63 || l < 0 || (l >> (62 - r)) != 0) return std::nullopt;
+                return PyConstant{l << r};
+            case BinaryOpCode::NB_RSHIFT:
+                if (r < 0) return std::nullopt;
+                return PyConstant{r >= 64 ? (l < 0 ? -1 : 0) : (l >> r)};
+            case BinaryOpCode::NB_FLOOR_DIVIDE:
+            case BinaryOpCode::NB_REMAINDER: {
+                if (r == 0 || (l == std::numeric_limits<int64_t>::min() && r == -1)) {
+                    return std::nullopt;
+                }
+                int64_t q = l / r;
+                int64_t m = l % r;
+                if (m != 0 && ((m < 0) != (r < 0))) {
+                    --q;
+                    m += r;
+                }
+                return PyConstant{code == BinaryOpCode::NB_FLOOR_DIVIDE ? q : m};
+            }
+            case BinaryOpCode::NB_TRUE_DIVIDE:
+                if (r == 0) return std::nullopt;
+                return PyConstant{static_cast<double>(l) / static_cast<double>(r)};
+            case BinaryOpCode::NB_POWER: {
+                if (r < 0) return std::nullopt;
+                int64_t result = 1;
+                int64_t base = l;
+                for (int64_t e = r; e > 0; e >>= 1) {
+                    if ((e & 1) && !checked_mul(result, base, result)) return std::nullopt;
+                    if (e > 1 && !checked_mul(base, base, base)) return std::nullopt;
+                }
+                return PyConstant{result};
+            }
+            default:
+                return std::nullopt;
+        }
+    }
+
+    static std::optional<PyConstant> fold_float(BinaryOpCode code, double l, double r) {
+        switch (code) {
+            case BinaryOpCode::NB_ADD: return PyConstant{l + r};
+            case BinaryOpCode::NB_SUBTRACT: return PyConstant{l - r};
+            case BinaryOpCode::NB_MULTIPLY: return PyConstant{l * r};
+            case BinaryOpCode::NB_TRUE_DIVIDE:
+                if (r == 0.0) return std::nullopt;
+                return PyConstant{l / r};
+            case BinaryOpCode::NB_FLOOR_DIVIDE:
+                if (r == 0.0) return std::nullopt;
+                return PyConstant{std::floor(l / r)};
+            case BinaryOpCode::NB_REMAINDER: {
+                if (r == 0.0) return std::nullopt;
+                double m = std::fmod(l, r);
+                if (m != 0.0 && ((m < 0) != (r < 0))) m += r;
+                return PyConstant{m};
+            }
+            case BinaryOpCode::NB_POWER:
+                // Negative base with a fractional exponent is complex in Python
+                if (l < 0 && std::floor(r) != r) return std::nullopt;
+                return PyConstant{std::pow(l, r)};
+            default:
+                return std::nullopt;
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // Control flow
+    // ------------------------------------------------------------------
+
+    /**
+     * Follow chains of unconditional jumps. A conditional jump may skip
+     * through them too; FOR_ITER/SEND and the NO_INTERRUPT backward
+     * jumps of generated loops keep their exact targets.
+     */
+    bool thread_jumps() {
+        bool changed = false;
+        int n = static_cast<int>(nodes_.size());
+
+        for (auto& node : nodes_) {
+            Opcode op = node.instr.opcode;
+            if (!is_unconditional_jump(op) && !is_conditional_jump(op)) continue;
+
+            int target = node.target;
+            for (int hops = 0; hops < n && target < n &&
+                 is_unconditional_jump(nodes_[target].instr.opcode); ++hops) {
+                if (nodes_[target].target == target) break;  // `while True: pass`
+                target = nodes_[target].target;
+            }
+            if (target != node.target) {
+                node.target = target;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    /**
+     * A jump to the very next instruction does nothing (unconditional)
+     * or only discards its condition (conditional).
+     */
+    bool remove_redundant_jumps() {
+        bool changed = false;
+        std::vector<bool> removed(nodes_.size(), false);
+
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            Node& node = nodes_[i];
+            if (node.target != static_cast<int>(i + 1)) continue;
+
+            if (is_unconditional_jump(node.instr.opcode)) {
+                removed[i] = true;
+                changed = true;
+            } else if (is_conditional_jump(node.instr.opcode)) {
+                node = Node{Instruction(Opcode::POP_TOP, -1, node.instr.lineno), NO_TARGET};
+                changed = true;
+            }
+        }
+
+        if (changed) erase(removed);
+        return changed;
+    }
+
+    /**
+     * Delete instructions that can only be reached by falling through a
+     * terminator. Reachability is flow-based from the entry, so dead code
+     * that merely jumps to itself goes too.
+     */
+    bool remove_unreachable() {
+        if (nodes_.empty() || has_exception_handlers()) return false;
+
+        size_t n = nodes_.size();
+        std::vector<bool> reachable(n, false);
+        std::vector<size_t> worklist{0};
+
+        while (!worklist.empty()) {
+            size_t i = worklist.back();
+            worklist.pop_back();
+            if (i >= n || reachable[i]) continue;
+            reachable[i] = true;
+
+            const Node& node = nodes_[i];
+            if (node.target != NO_TARGET) {
+                worklist.push_back(static_cast<size_t>(node.target));
+            }
+            if (!CodeObject::ends_flow(node.instr.opcode)) {
+                worklist.push_back(i + 1);
+            }
+        }
+
+        std::vector<bool> removed(n);
+        bool changed = false;
+        for (size_t i = 0; i < n; ++i) {
+            removed[i] = !reachable[i];
+            changed |= removed[i];
+        }
+
+        if (changed) erase(removed);
+        return changed;
+    }
+
+    // ------------------------------------------------------------------
+    // Superinstructions
+    // ------------------------------------------------------------------
+
+    /**
+     * Index of a constant below 16 (to fit a nibble), adding it if there
+     * is room. -1 if it would not fit.
+     */
+    int small_const_index(const PyConstant& value) {
+        int index = code_.find_const(value);
+        if (index >= 0) return index < 16 ? index : -1;
+        if (code_.co_consts.size() >= 16) return -1;
+        return code_.add_const(value);
+    }
+
+    void fuse_superinstructions() {
+        auto targets = jump_targets();
+        std::vector<bool> removed(nodes_.size(), false);
+        bool changed = false;
+
+        for (size_t i = 0; i + 1 < nodes_.size(); ++i) {
+            // The second instruction is absorbed, so nothing may jump to it
+            if (targets[i + 1]) continue;
+            Instruction& first = nodes_[i].instr;
+            const Instruction& second = nodes_[i + 1].instr;
+
+            if (first.opcode == Opcode::LOAD_FAST && first.arg < 16) {
+                int operand = -1;
+                Opcode fused = Opcode::NOP;
+                if (second.opcode == Opcode::LOAD_FAST && second.arg < 16) {
+                    fused = Opcode::LOAD_FAST_LOAD_FAST;
+                    operand = second.arg;
+                } else if (second.opcode == Opcode::LOAD_CONST && second.arg < 16) {
+                    fused = Opcode::LOAD_FAST_LOAD_CONST;
+                    operand = second.arg;
+                } else if (second.opcode == Opcode::LOAD_SMALL_INT) {
+                    // `i + 1`: route the small int through co_consts
+                    fused = Opcode::LOAD_FAST_LOAD_CONST;
+                    operand = small_const_index(PyConstant{static_cast<int64_t>(second.arg)});
+                }
+                if (operand < 0) continue;
+
+                first = Instruction(fused, (first.arg << 4) | operand, first.lineno);
+                removed[i + 1] = true;
+            } else if (first.opcode == Opcode::COMPARE_OP &&
+                       second.opcode == Opcode::POP_JUMP_IF_FALSE) {
+                // The jump stays behind to carry the target (see opcode.hpp)
+                first.opcode = Opcode::COMPARE_OP_POP_JUMP_IF_FALSE;
+            } else {
+                continue;
+            }
+
+            changed = true;
+            ++i;  // Don't fuse the consumed instruction again
+        }
+
+        if (changed) erase(removed);
+    }
+};
+
+/**
+ * Run the peephole optimizer over a code object's instructions
+ */
+inline void optimize(CodeObject& code) {
+    PeepholeOptimizer(code).run();
+}
+
+} // namespace compiler
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_COMPILER_OPTIMIZER_HPP
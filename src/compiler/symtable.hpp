@@ -0,0 +1,546 @@
+#ifndef CPYTHON_CPP_COMPILER_SYMTABLE_HPP
+#define CPYTHON_CPP_COMPILER_SYMTABLE_HPP
+
+#include "../ast/node.hpp"
+#include "../ast/expr.hpp"
+#include "../ast/stmt.hpp"
+#include "../ast/module.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace cpython_cpp {
+namespace compiler {
+
+/**
+ * Scope types for variable resolution
+ */
+enum class ScopeType {
+    Module,
+    Function,
+    Class,
+    Comprehension
+};
+
+/**
+ * Where a name lives, once resolved
+ * Reference: Include/internal/pycore_symtable.h (LOCAL, GLOBAL_EXPLICIT, ...)
+ */
+enum class SymbolScope {
+    Local,           // Bound in this scope
+    GlobalExplicit,  // Declared `global`
+    GlobalImplicit,  // Not bound anywhere enclosing: module global or builtin
+    Free,            // Bound in an enclosing function (or declared `nonlocal`)
+    Cell             // Local that a nested scope refers to
+};
+
+/**
+ * How a name is used inside one scope (DEF_* flags in CPython)
+ */
+namespace SymbolFlags {
+    constexpr uint32_t DEF_LOCAL    = 0x01;  // Assigned, imported, def/class name, del target
+    constexpr uint32_t DEF_PARAM    = 0x02;  // Parameter
+    constexpr uint32_t DEF_GLOBAL   = 0x04;  // `global` statement
+    constexpr uint32_t DEF_NONLOCAL = 0x08;  // `nonlocal` statement
+    constexpr uint32_t USE          = 0x10;  // Read
+}
+
+struct Symbol {
+    uint32_t flags = 0;
+    SymbolScope scope = SymbolScope::GlobalImplicit;
+    int lineno = 0;  // Line of the global/nonlocal declaration, if any
+};
+
+/**
+ * SymbolTableEntry - the names of one scope
+ * Reference: Include/internal/pycore_symtable.h (PySTEntryObject)
+ *
+ * varnames lists the parameters and then every other bound name in the
+ * order it was first bound, which is the co_varnames order of a function.
+ */
+struct SymbolTableEntry {
+    ScopeType type;
+    std::string name;
+    SymbolTableEntry* parent = nullptr;
+    std::vector<SymbolTableEntry*> children;
+    std::unordered_map<std::string, Symbol> symbols;
+    std::vector<std::string> varnames;
+    bool generator = false;  // Contains yield or yield from (ste_generator)
+    bool coroutine = false;  // async def (ste_coroutine)
+
+    SymbolTableEntry(ScopeType t, const std::string& n, SymbolTableEntry* p)
+        : type(t), name(n), parent(p) {}
+
+    const Symbol* lookup(const std::string& id) const {
+        auto it = symbols.find(id);
+        return it == symbols.end() ? nullptr : &it->second;
+    }
+
+    // Names never seen in this scope are implicit globals
+    SymbolScope scope_of(const std::string& id) const {
+        const Symbol* symbol = lookup(id);
+        return symbol ? symbol->scope : SymbolScope::GlobalImplicit;
+    }
+};
+
+/**
+ * SymbolTable - resolves the scope of every name before code generation
+ * Reference: Python/symtable.c
+ *
+ * The first pass walks the AST and records, per scope, how each name is
+ * used. The second pass (analyze) resolves each name once: a name bound
+ * in a function is local unless declared global/nonlocal, a name a
+ * function reads without binding is free if an enclosing function binds
+ * it and an implicit global otherwise. Class bodies are skipped when
+ * resolving names of functions nested in them, as in CPython.
+ *
+ * Lambdas, generator expressions and type alias values get scopes of
+ * their own. List, set and dict comprehensions are inlined by the
+ * compiler, so their targets are bound in the enclosing scope.
+ * Scopes are looked up by the AST node that opens them.
+ */
+class SymbolTable {
+public:
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    // Build the table for a whole module; earlier contents are dropped
+    void build(const ast::Module& module);
+
+    // Scope opened by node (module, def, class, lambda, ...), or nullptr
+    const SymbolTableEntry* lookup(const void* node) const {
+        auto it = by_node_.find(node);
+        return it == by_node_.end() ? nullptr : it->second;
+    }
+
+    const SymbolTableEntry* module() const { return entries_.empty() ? nullptr : entries_.front().get(); }
+
+    // Misplaced global/nonlocal declarations, as "line: message"
+    const std::vector<std::pair<int, std::string>>& errors() const { return errors_; }
+
+private:
+    SymbolTableEntry* enter(ScopeType type, const std::string& name, const void* node);
+    void leave() { current_ = current_->parent; }
+
+    void add_def(const std::string& id, uint32_t flag, int lineno = 0);
+
+    void visit_stmts(const std::vector<ast::Stmt*>& body);
+    void visit_stmt(ast::Stmt* stmt);
+    void visit_expr(ast::Expr* expr);
+    void visit_exprs(const std::vector<ast::Expr*>& exprs);
+    void visit_target(ast::Expr* target, uint32_t flag);
+    void visit_comprehensions(const std::vector<ast::Comprehension>& generators);
+    template<typename FunctionNode>
+    void visit_function(FunctionNode* node);
+
+    void analyze(SymbolTableEntry* entry,
+                 const std::unordered_map<std::string, SymbolTableEntry*>& enclosing);
+
+    std::vector<std::unique_ptr<SymbolTableEntry>> entries_;  // entries_[0] is the module
+    std::unordered_map<const void*, SymbolTableEntry*> by_node_;
+    SymbolTableEntry* current_ = nullptr;
+    std::vector<std::pair<int, std::string>> errors_;
+};
+
+inline void SymbolTable::build(const ast::Module& module) {
+    entries_.clear();
+    by_node_.clear();
+    errors_.clear();
+    current_ = nullptr;
+
+    enter(ScopeType::Module, "<module>", &module);
+    visit_stmts(module.body());
+    leave();
+
+    analyze(entries_.front().get(), {});
+}
+
+inline SymbolTableEntry* SymbolTable::enter(ScopeType type, const std::string& name, const void* node) {
+    entries_.push_back(std::make_unique<SymbolTableEntry>(type, name, current_));
+    SymbolTableEntry* entry = entries_.back().get();
+    if (current_) {
+        current_->children.push_back(entry);
+    }
+    by_node_[node] = entry;
+    current_ = entry;
+    return entry;
+}
+
+inline void SymbolTable::add_def(const std::string& id, uint32_t flag, int lineno) {
+    Symbol& symbol = current_->symbols[id];
+    if ((flag & (SymbolFlags::DEF_GLOBAL | SymbolFlags::DEF_NONLOCAL)) &&
+        (symbol.flags & (SymbolFlags::DEF_LOCAL | SymbolFlags::USE))) {
+        errors_.emplace_back(lineno, "name '" + id + "' is used prior to " +
+                             (flag == SymbolFlags::DEF_GLOBAL ? "global" : "nonlocal") +
+                             " declaration");
+    }
+    if ((flag & (SymbolFlags::DEF_LOCAL | SymbolFlags::DEF_PARAM)) &&
+        !(symbol.flags & (SymbolFlags::DEF_LOCAL | SymbolFlags::DEF_PARAM))) {
+        current_->varnames.push_back(id);
+    }
+    if (flag & (SymbolFlags::DEF_GLOBAL | SymbolFlags::DEF_NONLOCAL)) {
+        symbol.lineno = lineno;
+    }
+    symbol.flags |= flag;
+}
+
+inline void SymbolTable::visit_stmts(const std::vector<ast::Stmt*>& body) {
+    for (auto* stmt : body) {
+        visit_stmt(stmt);
+    }
+}
+
+inline void SymbolTable::visit_exprs(const std::vector<ast::Expr*>& exprs) {
+    for (auto* expr : exprs) {
+        visit_expr(expr);
+    }
+}
+
+template<typename FunctionNode>
+void SymbolTable::visit_function(FunctionNode* node) {
+    // Decorators and annotations are evaluated in the enclosing scope
+    visit_exprs(node->decorator_list());
+    for (const auto& arg : node->args()) {
+        visit_expr(arg.annotation);
+    }
+    visit_expr(node->returns());
+    add_def(node->name(), SymbolFlags::DEF_LOCAL);
+
+    SymbolTableEntry* entry = enter(ScopeType::Function, node->name(), node);
+    entry->coroutine = std::is_same_v<FunctionNode, ast::AsyncFunctionDef>;
+    for (const auto& arg : node->args()) {
+        add_def(arg.arg_name, SymbolFlags::DEF_PARAM);
+    }
+    visit_stmts(node->body());
+    leave();
+}
+
+inline void SymbolTable::visit_stmt(ast::Stmt* stmt) {
+    if (!stmt) return;
+
+    if (auto* node = dynamic_cast<ast::FunctionDef*>(stmt)) {
+        visit_function(node);
+    } else if (auto* node = dynamic_cast<ast::AsyncFunctionDef*>(stmt)) {
+        visit_function(node);
+    } else if (auto* node = dynamic_cast<ast::ClassDef*>(stmt)) {
+        visit_exprs(node->decorator_list());
+        visit_exprs(node->bases());
+        add_def(node->name(), SymbolFlags::DEF_LOCAL);
+        enter(ScopeType::Class, node->name(), node);
+        visit_stmts(node->body());
+        leave();
+    } else if (auto* node = dynamic_cast<ast::Return*>(stmt)) {
+        visit_expr(node->value());
+    } else if (auto* node = dynamic_cast<ast::Assign*>(stmt)) {
+        visit_expr(node->value());
+        for (auto* target : node->targets()) {
+            visit_target(target, SymbolFlags::DEF_LOCAL);
+        }
+    } else if (auto* node = dynamic_cast<ast::AnnAssign*>(stmt)) {
+        visit_expr(node->annotation());
+        visit_expr(node->value());
+        visit_target(node->target(), SymbolFlags::DEF_LOCAL);
+    } else if (auto* node = dynamic_cast<ast::AugAssign*>(stmt)) {
+        visit_target(node->target(), SymbolFlags::USE);
+        visit_expr(node->value());
+        visit_target(node->target(), SymbolFlags::DEF_LOCAL);
+    } else if (auto* node = dynamic_cast<ast::ExprStmt*>(stmt)) {
+        visit_expr(node->value());
+    } else if (auto* node = dynamic_cast<ast::If*>(stmt)) {
+        visit_expr(node->test());
+        visit_stmts(node->body());
+        visit_stmts(node->orelse());
+    } else if (auto* node = dynamic_cast<ast::While*>(stmt)) {
+        visit_expr(node->test());
+        visit_stmts(node->body());
+        visit_stmts(node->orelse());
+    } else if (auto* node = dynamic_cast<ast::For*>(stmt)) {
+        visit_expr(node->iter());
+        visit_target(node->target(), SymbolFlags::DEF_LOCAL);
+        visit_stmts(node->body());
+        visit_stmts(node->orelse());
+    } else if (auto* node = dynamic_cast<ast::AsyncFor*>(stmt)) {
+        visit_expr(node->iter());
+        visit_target(node->target(), SymbolFlags::DEF_LOCAL);
+        visit_stmts(node->body());
+        visit_stmts(node->orelse());
+    } else if (auto* node = dynamic_cast<ast::Raise*>(stmt)) {
+        visit_expr(node->exc());
+        visit_expr(node->cause());
+    } else if (auto* node = dynamic_cast<ast::Delete*>(stmt)) {
+        for (auto* target : node->targets()) {
+            visit_target(target, SymbolFlags::DEF_LOCAL);
+        }
+    } else if (auto* node = dynamic_cast<ast::Assert*>(stmt)) {
+        visit_expr(node->test());
+        visit_expr(node->msg());
+    } else if (auto* node = dynamic_cast<ast::Global*>(stmt)) {
+        for (const auto& id : node->names()) {
+            if (current_->type == ScopeType::Module) continue;  // Already global
+            add_def(id, SymbolFlags::DEF_GLOBAL, node->lineno());
+        }
+    } else if (auto* node = dynamic_cast<ast::Nonlocal*>(stmt)) {
+        for (const auto& id : node->names()) {
+            if (current_->type == ScopeType::Module) {
+                errors_.emplace_back(node->lineno(), "nonlocal declaration not allowed at module level");
+                continue;
+            }
+            add_def(id, SymbolFlags::DEF_NONLOCAL, node->lineno());
+        }
+    } else if (auto* node = dynamic_cast<ast::Try*>(stmt)) {
+        visit_stmts(node->body());
+        for (auto* handler : node->handlers()) {
+            visit_expr(handler->type());
+            if (!handler->name().empty()) add_def(handler->name(), SymbolFlags::DEF_LOCAL);
+            visit_stmts(handler->body());
+        }
+        visit_stmts(node->orelse());
+        visit_stmts(node->finalbody());
+    } else if (auto* node = dynamic_cast<ast::TryStar*>(stmt)) {
+        visit_stmts(node->body());
+        for (auto* handler : node->handlers()) {
+            visit_expr(handler->type());
+            if (!handler->name().empty()) add_def(handler->name(), SymbolFlags::DEF_LOCAL);
+            visit_stmts(handler->body());
+        }
+        visit_stmts(node->orelse());
+        visit_stmts(node->finalbody());
+    } else if (auto* node = dynamic_cast<ast::Import*>(stmt)) {
+        for (auto* alias : node->names()) {
+            // `import a.b` binds `a`
+            std::string bound = alias->asname().empty() ? alias->name() : alias->asname();
+            add_def(bound.substr(0, bound.find('.')), SymbolFlags::DEF_LOCAL);
+        }
+    } else if (auto* node = dynamic_cast<ast::ImportFrom*>(stmt)) {
+        for (auto* alias : node->names()) {
+            if (alias->name() == "*") continue;
+            add_def(alias->asname().empty() ? alias->name() : alias->asname(), SymbolFlags::DEF_LOCAL);
+        }
+    } else if (auto* node = dynamic_cast<ast::With*>(stmt)) {
+        for (const auto& item : node->items()) {
+            visit_expr(item.context_expr);
+            if (item.optional_vars) visit_target(item.optional_vars, SymbolFlags::DEF_LOCAL);
+        }
+        visit_stmts(node->body());
+    } else if (auto* node = dynamic_cast<ast::AsyncWith*>(stmt)) {
+        for (const auto& item : node->items()) {
+            visit_expr(item.context_expr);
+            if (item.optional_vars) visit_target(item.optional_vars, SymbolFlags::DEF_LOCAL);
+        }
+        visit_stmts(node->body());
+    } else if (auto* node = dynamic_cast<ast::Match*>(stmt)) {
+        // Patterns are not compiled yet, so they bind nothing
+        visit_expr(node->subject());
+        for (const auto& case_ : node->cases()) {
+            visit_expr(case_.guard());
+            visit_stmts(case_.body());
+        }
+    } else if (auto* node = dynamic_cast<ast::TypeAlias*>(stmt)) {
+        visit_target(node->name(), SymbolFlags::DEF_LOCAL);
+        enter(ScopeType::Function, "<type alias value>", node);
+        visit_expr(node->value());
+        leave();
+    }
+    // Pass, Break, Continue: no names
+}
+
+inline void SymbolTable::visit_target(ast::Expr* target, uint32_t flag) {
+    if (!target) return;
+
+    if (auto* name = dynamic_cast<ast::Name*>(target)) {
+        if (flag == SymbolFlags::USE) {
+            current_->symbols[name->id()].flags |= SymbolFlags::USE;
+        } else {
+            add_def(name->id(), flag);
+        }
+    } else if (auto* tuple = dynamic_cast<ast::Tuple*>(target)) {
+        for (auto* elt : tuple->elts()) visit_target(elt, flag);
+    } else if (auto* list = dynamic_cast<ast::List*>(target)) {
+        for (auto* elt : list->elts()) visit_target(elt, flag);
+    } else if (auto* starred = dynamic_cast<ast::Starred*>(target)) {
+        visit_target(starred->value(), flag);
+    } else if (auto* attr = dynamic_cast<ast::Attribute*>(target)) {
+        visit_expr(attr->value());
+    } else if (auto* subscr = dynamic_cast<ast::Subscript*>(target)) {
+        visit_expr(subscr->value());
+        visit_expr(subscr->slice());
+    } else {
+        visit_expr(target);
+    }
+}
+
+inline void SymbolTable::visit_comprehensions(const std::vector<ast::Comprehension>& generators) {
+    for (const auto& gen : generators) {
+        visit_expr(gen.iter);
+        visit_target(gen.target, SymbolFlags::DEF_LOCAL);
+        visit_exprs(gen.ifs);
+    }
+}
+
+inline void SymbolTable::visit_expr(ast::Expr* expr) {
+    if (!expr) return;
+
+    if (auto* node = dynamic_cast<ast::Name*>(expr)) {
+        if (node->ctx() == ast::ExprContext::Load) {
+            current_->symbols[node->id()].flags |= SymbolFlags::USE;
+        } else {
+            add_def(node->id(), SymbolFlags::DEF_LOCAL);
+        }
+    } else if (auto* node = dynamic_cast<ast::BinOp*>(expr)) {
+        visit_expr(node->left());
+        visit_expr(node->right());
+    } else if (auto* node = dynamic_cast<ast::UnaryOp*>(expr)) {
+        visit_expr(node->operand());
+    } else if (auto* node = dynamic_cast<ast::BoolOpExpr*>(expr)) {
+        visit_exprs(node->values());
+    } else if (auto* node = dynamic_cast<ast::Compare*>(expr)) {
+        visit_expr(node->left());
+        visit_expr(node->right());
+    } else if (auto* node = dynamic_cast<ast::Call*>(expr)) {
+        visit_expr(node->func());
+        visit_exprs(node->args());
+    } else if (auto* node = dynamic_cast<ast::Attribute*>(expr)) {
+        visit_expr(node->value());
+    } else if (auto* node = dynamic_cast<ast::Subscript*>(expr)) {
+        visit_expr(node->value());
+        visit_expr(node->slice());
+    } else if (auto* node = dynamic_cast<ast::Slice*>(expr)) {
+        visit_expr(node->lower());
+        visit_expr(node->upper());
+        visit_expr(node->step());
+    } else if (auto* node = dynamic_cast<ast::List*>(expr)) {
+        visit_exprs(node->elts());
+    } else if (auto* node = dynamic_cast<ast::Tuple*>(expr)) {
+        visit_exprs(node->elts());
+    } else if (auto* node = dynamic_cast<ast::Set*>(expr)) {
+        visit_exprs(node->elts());
+    } else if (auto* node = dynamic_cast<ast::Dict*>(expr)) {
+        visit_exprs(node->keys());
+        visit_exprs(node->values());
+    } else if (auto* node = dynamic_cast<ast::Starred*>(expr)) {
+        visit_expr(node->value());
+    } else if (auto* node = dynamic_cast<ast::IfExp*>(expr)) {
+        visit_expr(node->test());
+        visit_expr(node->body());
+        visit_expr(node->orelse());
+    } else if (auto* node = dynamic_cast<ast::Lambda*>(expr)) {
+        enter(ScopeType::Function, "<lambda>", node);
+        for (const auto& arg : node->args()) {
+            add_def(arg, SymbolFlags::DEF_PARAM);
+        }
+        visit_expr(node->body());
+        leave();
+    } else if (auto* node = dynamic_cast<ast::ListComp*>(expr)) {
+        visit_comprehensions(node->generators());
+        visit_expr(node->elt());
+    } else if (auto* node = dynamic_cast<ast::SetComp*>(expr)) {
+        visit_comprehensions(node->generators());
+        visit_expr(node->elt());
+    } else if (auto* node = dynamic_cast<ast::DictComp*>(expr)) {
+        visit_comprehensions(node->generators());
+        visit_expr(node->key());
+        visit_expr(node->value());
+    } else if (auto* node = dynamic_cast<ast::GeneratorExp*>(expr)) {
+        // The first iterable is evaluated outside and passed in as the
+        // implicit parameter .0; the rest is a scope of its own
+        const auto& generators = node->generators();
+        if (!generators.empty()) visit_expr(generators[0].iter);
+        enter(ScopeType::Comprehension, "<genexpr>", node)->generator = true;
+        add_def(".0", SymbolFlags::DEF_PARAM);
+        for (size_t i = 0; i < generators.size(); ++i) {
+            if (i > 0) visit_expr(generators[i].iter);
+            visit_target(generators[i].target, SymbolFlags::DEF_LOCAL);
+            visit_exprs(generators[i].ifs);
+        }
+        visit_expr(node->elt());
+        leave();
+    } else if (auto* node = dynamic_cast<ast::Yield*>(expr)) {
+        current_->generator = true;
+        visit_expr(node->value());
+    } else if (auto* node = dynamic_cast<ast::YieldFrom*>(expr)) {
+        current_->generator = true;
+        visit_expr(node->value());
+    } else if (auto* node = dynamic_cast<ast::Await*>(expr)) {
+        visit_expr(node->value());
+    } else if (auto* node = dynamic_cast<ast::NamedExpr*>(expr)) {
+        visit_expr(node->value());
+        visit_target(node->target(), SymbolFlags::DEF_LOCAL);
+    } else if (auto* node = dynamic_cast<ast::JoinedStr*>(expr)) {
+        visit_exprs(node->values());
+    } else if (auto* node = dynamic_cast<ast::FormattedValue*>(expr)) {
+        visit_expr(node->value());
+        visit_expr(node->format_spec());
+    } else if (auto* node = dynamic_cast<ast::TemplateStr*>(expr)) {
+        visit_exprs(node->values());
+    } else if (auto* node = dynamic_cast<ast::Interpolation*>(expr)) {
+        visit_expr(node->value());
+        visit_expr(node->format_spec());
+    }
+    // Constant, Ellipsis: no names
+}
+
+inline void SymbolTable::analyze(SymbolTableEntry* entry,
+                                 const std::unordered_map<std::string, SymbolTableEntry*>& enclosing) {
+    bool is_function = entry->type == ScopeType::Function || entry->type == ScopeType::Comprehension;
+
+    for (auto& [id, symbol] : entry->symbols) {
+        if (symbol.flags & SymbolFlags::DEF_GLOBAL) {
+            symbol.scope = SymbolScope::GlobalExplicit;
+        } else if (symbol.flags & SymbolFlags::DEF_NONLOCAL) {
+            symbol.scope = SymbolScope::Free;
+            if (!enclosing.count(id)) {
+                errors_.emplace_back(symbol.lineno, "no binding for nonlocal '" + id + "' found");
+            }
+        } else if (symbol.flags & (SymbolFlags::DEF_LOCAL | SymbolFlags::DEF_PARAM)) {
+            symbol.scope = SymbolScope::Local;
+        } else if (is_function && enclosing.count(id)) {
+            symbol.scope = SymbolScope::Free;
+        } else {
+            symbol.scope = SymbolScope::GlobalImplicit;
+        }
+    }
+
+    // A free name makes the binding it refers to a cell, and passes
+    // through the functions in between as free there too
+    if (is_function) {
+        for (const auto& [id, symbol] : entry->symbols) {
+            if (symbol.scope != SymbolScope::Free) continue;
+            auto it = enclosing.find(id);
+            if (it == enclosing.end()) continue;
+            for (SymbolTableEntry* between = entry->parent; between && between != it->second;
+                 between = between->parent) {
+                if (between->type != ScopeType::Class && !between->lookup(id)) {
+                    between->symbols[id].scope = SymbolScope::Free;
+                }
+            }
+            Symbol& binding = it->second->symbols[id];
+            if (binding.scope == SymbolScope::Local) {
+                binding.scope = SymbolScope::Cell;
+            }
+        }
+    }
+
+    // Functions see what enclosing functions bind; class bodies are skipped
+    std::unordered_map<std::string, SymbolTableEntry*> visible = enclosing;
+    if (is_function) {
+        for (const auto& [id, symbol] : entry->symbols) {
+            if (symbol.scope == SymbolScope::Local) {
+                visible[id] = entry;
+            } else if (symbol.scope == SymbolScope::GlobalExplicit) {
+                visible.erase(id);
+            }
+        }
+    }
+    for (SymbolTableEntry* child : entry->children) {
+        analyze(child, visible);
+    }
+}
+
+} // namespace compiler
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_COMPILER_SYMTABLE_HPP
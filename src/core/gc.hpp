@@ -0,0 +1,400 @@
+#ifndef CPYTHON_CPP_GC_HPP
+#define CPYTHON_CPP_GC_HPP
+
+#include "refcount.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cpython_cpp {
+namespace core {
+
+class GCObject;
+class GarbageCollector;
+struct GCList;
+
+/**
+ * GCVisitor - called with each container a GCObject refers to (visitproc)
+ */
+class GCVisitor {
+public:
+    virtual void visit(GCObject* child) = 0;
+
+protected:
+    ~GCVisitor() = default;
+};
+
+/**
+ * GCObject - a RefCounted container seen by the cycle collector
+ * Reference: Include/internal/pycore_gc.h (PyGC_Head), Modules/gcmodule.c
+ *
+ * Construction links the object into the youngest generation of the
+ * calling thread's collector; destruction unlinks it. Subclasses report
+ * every container they hold a reference to from traverse() (tp_traverse)
+ * and drop all their references in clear() (tp_clear). Atomic objects
+ * (str, int, range, ...) never hold references and stay plain
+ * RefCounted.
+ */
+class GCObject : public RefCounted {
+public:
+    GCObject();
+    // A copy is a new object and is tracked on its own
+    GCObject(const GCObject& other);
+    GCObject& operator=(const GCObject&) { return *this; }
+    ~GCObject() override;
+
+    virtual void traverse(GCVisitor& visitor) const = 0;
+    virtual void clear() = 0;
+
+    bool is_tracked() const noexcept { return list_ != nullptr; }
+
+private:
+    friend class GarbageCollector;
+
+    enum class State : uint8_t {
+        Idle,
+        Collecting,  // In the generation being collected
+        Reachable,   // ... and referenced from outside it
+    };
+
+    GCObject* gc_prev_ = nullptr;  // Links of the list the object is in
+    GCObject* gc_next_ = nullptr;
+    GCList* list_ = nullptr;       // Generation (or garbage) list holding the object
+    int64_t gc_refs_ = 0;          // References from outside the collected generation
+    State state_ = State::Idle;
+};
+
+// A doubly linked list of tracked objects, with its collector
+struct GCList {
+    GCObject* first = nullptr;
+    GCObject* last = nullptr;
+    size_t size = 0;
+    GarbageCollector* owner = nullptr;
+
+    GCList() = default;
+    GCList(const GCList&) = delete;
+    GCList& operator=(const GCList&) = delete;
+
+    bool empty() const { return first == nullptr; }
+};
+
+/**
+ * GarbageCollector - generational cycle collector for GCObjects
+ * Reference: Modules/gcmodule.c (gc_collect_main, update_refs,
+ * subtract_refs, move_unreachable, delete_garbage)
+ *
+ * Reference counting frees everything except cycles; this finds them.
+ * A collection of generation g takes generations 0..g and computes, for
+ * each object, its reference count minus the references held by other
+ * objects in the set. Objects still referenced from outside (the VM's
+ * frames and namespaces, C++ locals) are reachable, as is everything
+ * they reach; the rest is garbage, which is freed by clear()-ing each
+ * object so the cycles fall apart under reference counting. Survivors
+ * move to the next older generation. No root set is needed, so
+ * embedders holding PyObjects need not register anything.
+ *
+ * Collections run on allocation: creating a container when more than
+ * threshold(0) have been created (net of frees) since the last young
+ * collection collects generation 0, and every threshold(g)-th collection
+ * of generation g-1 also collects generation g. As in CPython, a full
+ * collection additionally waits until the objects promoted into the
+ * oldest generation since the last one reach a quarter of its size, so
+ * the cost of full collections stays linear in the allocation rate.
+ * Lower thresholds give shorter, more frequent pauses; stats() reports
+ * the pauses per generation.
+ *
+ * Each thread has its own collector (current()), like an interpreter
+ * only ever touches its own objects from one thread: a container is
+ * tracked by the collector of the thread that created it and must be
+ * released on that thread. Objects still tracked when a thread exits
+ * become untracked and live on under reference counting alone.
+ */
+class GarbageCollector {
+public:
+    static constexpr int GENERATIONS = 3;
+
+    struct Stats {
+        uint64_t collections = 0;
+        uint64_t collected = 0;     // Unreachable objects freed
+        uint64_t pause_us = 0;      // Total time spent collecting
+        uint64_t max_pause_us = 0;  // Longest single collection
+    };
+
+    GarbageCollector();
+    ~GarbageCollector();
+
+    GarbageCollector(const GarbageCollector&) = delete;
+    GarbageCollector& operator=(const GarbageCollector&) = delete;
+
+    // The calling thread's collector
+    static GarbageCollector& current();
+
+    // Automatic collection; collect() works either way (gc.enable/disable)
+    void enable() { enabled_ = true; }
+    void disable() { enabled_ = false; }
+    bool is_enabled() const { return enabled_; }
+
+    // gc.set_threshold: threshold 0 turns automatic collection off
+    void set_threshold(size_t threshold0, size_t threshold1, size_t threshold2) {
+        thresholds_ = {threshold0, threshold1, threshold2};
+    }
+    size_t threshold(int generation) const { return thresholds_[generation]; }
+
+    // gc.get_count: net allocations since the last young collection,
+    // then collections of the next younger generation
+    size_t count(int generation) const { return counts_[generation]; }
+
+    // Objects currently tracked in a generation
+    size_t tracked(int generation) const { return generations_[generation].size; }
+
+    // gc.collect: collect generations 0..generation; returns the number
+    // of unreachable objects found
+    size_t collect(int generation = GENERATIONS - 1);
+
+    const Stats& stats(int generation) const { return stats_[generation]; }
+
+private:
+    friend class GCObject;
+
+    void track(GCObject* obj);
+    static void untrack(GCObject* obj);
+
+    static void link(GCObject* obj, GCList& list);
+    static void unlink(GCObject* obj);
+    static void splice(GCList& from, GCList& to);
+
+    void collect_generations();
+    size_t collect_generation(int generation);
+
+    std::array<GCList, GENERATIONS> generations_;
+    std::array<size_t, GENERATIONS> thresholds_{700, 10, 10};
+    std::array<size_t, GENERATIONS> counts_{};
+    std::array<Stats, GENERATIONS> stats_{};
+    size_t long_lived_total_ = 0;    // Oldest generation after the last full collection
+    size_t long_lived_pending_ = 0;  // Promoted into it since
+    bool enabled_ = true;
+    bool collecting_ = false;
+};
+
+inline GarbageCollector::GarbageCollector() {
+    for (auto& generation : generations_) {
+        generation.owner = this;
+    }
+}
+
+inline GarbageCollector::~GarbageCollector() {
+    // Thread exit: whatever is left is no longer tracked
+    for (auto& generation : generations_) {
+        while (!generation.empty()) {
+            GCObject* obj = generation.first;
+            unlink(obj);
+            obj->list_ = nullptr;
+        }
+    }
+}
+
+inline GarbageCollector& GarbageCollector::current() {
+    static thread_local GarbageCollector collector;
+    return collector;
+}
+
+// Append obj to list
+inline void GarbageCollector::link(GCObject* obj, GCList& list) {
+    obj->gc_prev_ = list.last;
+    obj->gc_next_ = nullptr;
+    if (list.last) list.last->gc_next_ = obj; else list.first = obj;
+    list.last = obj;
+    list.size++;
+    obj->list_ = &list;
+}
+
+// Remove obj from its list
+inline void GarbageCollector::unlink(GCObject* obj) {
+    GCList& list = *obj->list_;
+    if (obj->gc_prev_) obj->gc_prev_->gc_next_ = obj->gc_next_; else list.first = obj->gc_next_;
+    if (obj->gc_next_) obj->gc_next_->gc_prev_ = obj->gc_prev_; else list.last = obj->gc_prev_;
+    obj->gc_prev_ = obj->gc_next_ = nullptr;
+    list.size--;
+}
+
+// Move every object of from to the end of to
+inline void GarbageCollector::splice(GCList& from, GCList& to) {
+    if (from.empty()) return;
+    for (GCObject* obj = from.first; obj; obj = obj->gc_next_) {
+        obj->list_ = &to;
+    }
+    from.first->gc_prev_ = to.last;
+    if (to.last) to.last->gc_next_ = from.first; else to.first = from.first;
+    to.last = from.last;
+    to.size += from.size;
+    from.first = from.last = nullptr;
+    from.size = 0;
+}
+
+// Allocation fast path: a counter bump and a list append
+inline void GarbageCollector::track(GCObject* obj) {
+    if (++counts_[0] > thresholds_[0] && thresholds_[0] != 0 && enabled_ && !collecting_) {
+        collect_generations();
+    }
+    link(obj, generations_[0]);
+}
+
+inline void GarbageCollector::untrack(GCObject* obj) {
+    GarbageCollector* owner = obj->list_->owner;
+    unlink(obj);
+    obj->list_ = nullptr;
+    if (owner->counts_[0] > 0) {
+        owner->counts_[0]--;
+    }
+}
+
+inline void GarbageCollector::collect_generations() {
+    // The oldest generation over its threshold, as in gcmodule.c
+    for (int generation = GENERATIONS - 1; generation >= 0; --generation) {
+        if (counts_[generation] > thresholds_[generation]) {
+            if (generation == GENERATIONS - 1 && long_lived_pending_ < long_lived_total_ / 4) {
+                continue;
+            }
+            collect_generation(generation);
+            return;
+        }
+    }
+}
+
+inline size_t GarbageCollector::collect(int generation) {
+    if (generation < 0 || generation >= GENERATIONS || collecting_) {
+        return 0;
+    }
+    return collect_generation(generation);
+}
+
+inline size_t GarbageCollector::collect_generation(int generation) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    collecting_ = true;
+
+    GCList& young = generations_[generation];
+    for (int i = 0; i < generation; ++i) {
+        splice(generations_[i], young);
+    }
+    bool oldest = generation == GENERATIONS - 1;
+    GCList& older = oldest ? young : generations_[generation + 1];
+
+    // update_refs: start from the real reference counts
+    for (GCObject* obj = young.first; obj; obj = obj->gc_next_) {
+        obj->gc_refs_ = obj->get_ref_count();
+        obj->state_ = GCObject::State::Collecting;
+    }
+
+    // subtract_refs: drop the references held inside the generation
+    struct SubtractRefs final : GCVisitor {
+        void visit(GCObject* child) override {
+            if (child && child->state_ == GCObject::State::Collecting) {
+                child->gc_refs_--;
+            }
+        }
+    } subtract;
+    for (GCObject* obj = young.first; obj; obj = obj->gc_next_) {
+        obj->traverse(subtract);
+    }
+
+    // move_unreachable: what is left is referenced from outside, and
+    // keeps alive everything it reaches
+    struct MarkReachable final : GCVisitor {
+        std::vector<GCObject*> pending;
+        void visit(GCObject* child) override {
+            if (child && child->state_ == GCObject::State::Collecting) {
+                child->state_ = GCObject::State::Reachable;
+                pending.push_back(child);
+            }
+        }
+    } mark;
+    for (GCObject* obj = young.first; obj; obj = obj->gc_next_) {
+        if (obj->gc_refs_ > 0 && obj->state_ == GCObject::State::Collecting) {
+            obj->state_ = GCObject::State::Reachable;
+            mark.pending.push_back(obj);
+        }
+    }
+    while (!mark.pending.empty()) {
+        GCObject* obj = mark.pending.back();
+        mark.pending.pop_back();
+        obj->traverse(mark);
+    }
+
+    // Survivors are promoted; the rest is garbage
+    GCList unreachable;
+    unreachable.owner = this;
+    size_t survivors = 0;
+    for (GCObject* obj = young.first, *next; obj; obj = next) {
+        next = obj->gc_next_;
+        bool reachable = obj->state_ == GCObject::State::Reachable;
+        obj->state_ = GCObject::State::Idle;
+        if (!reachable) {
+            unlink(obj);
+            link(obj, unreachable);
+        } else if (!oldest) {
+            unlink(obj);
+            link(obj, older);
+            survivors++;
+        }
+    }
+    size_t collected = unreachable.size;
+
+    // delete_garbage: clearing breaks the cycles, and reference counting
+    // frees the objects, which unlink themselves from `unreachable`
+    while (!unreachable.empty()) {
+        GCObject* obj = unreachable.first;
+        obj->incref();
+        obj->clear();
+        if (unreachable.first == obj) {
+            // Still alive after clearing itself: let the others go first
+            unlink(obj);
+            link(obj, older);
+        }
+        obj->release();
+    }
+
+    if (!oldest) {
+        counts_[generation + 1]++;
+    }
+    for (int i = 0; i <= generation; ++i) {
+        counts_[i] = 0;
+    }
+    if (generation == GENERATIONS - 2) {
+        long_lived_pending_ += survivors;
+    } else if (oldest) {
+        long_lived_pending_ = 0;
+        long_lived_total_ = young.size;
+    }
+    collecting_ = false;
+
+    auto pause = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    Stats& stats = stats_[generation];
+    stats.collections++;
+    stats.collected += collected;
+    stats.pause_us += pause;
+    if (pause > stats.max_pause_us) stats.max_pause_us = pause;
+    return collected;
+}
+
+inline GCObject::GCObject() {
+    GarbageCollector::current().track(this);
+}
+
+inline GCObject::GCObject(const GCObject& other) : RefCounted(other) {
+    GarbageCollector::current().track(this);
+}
+
+inline GCObject::~GCObject() {
+    if (list_) {
+        GarbageCollector::untrack(this);
+    }
+}
+
+} // namespace core
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_GC_HPP
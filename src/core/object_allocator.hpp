@@ -0,0 +1,407 @@
+#ifndef CPYTHON_CPP_OBJECT_ALLOCATOR_HPP
+#define CPYTHON_CPP_OBJECT_ALLOCATOR_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/**
+ * RefCounted objects come from the small-object allocator below. Build
+ * with -DCPYTHON_CPP_SMALL_OBJECT_ALLOCATOR=0 to send them straight to
+ * operator new instead (PYTHONMALLOC=malloc), e.g. for memory checkers.
+ */
+#ifndef CPYTHON_CPP_SMALL_OBJECT_ALLOCATOR
+#define CPYTHON_CPP_SMALL_OBJECT_ALLOCATOR 1
+#endif
+
+namespace cpython_cpp {
+namespace core {
+
+/**
+ * SmallObjectAllocator - pymalloc-style allocator for VM objects
+ * Reference: Objects/obmalloc.c
+ *
+ * Requests up to MAX_SMALL bytes are rounded up to a multiple of
+ * ALIGNMENT, giving one size class per multiple. Memory comes from the
+ * system in ARENA_SIZE arenas. An arena is carved into POOL_SIZE pools,
+ * and each pool serves blocks of a single size class. The pool header
+ * sits at the start of the pool, found from any block by masking its
+ * address. Freed blocks go on the front of their pool's free list, so
+ * the next allocation of that size reuses the block just freed; that is
+ * all a tuple or list freelist would give. An arena whose pools are all
+ * empty goes back to the system, apart from one spare kept to absorb
+ * churn. Larger requests go to operator new.
+ *
+ * Each thread allocates from its own heap (current()), with no locking.
+ * A block freed on another thread is pushed onto its pool's atomic
+ * remote list, and the owning heap takes those blocks back when it runs
+ * out of free blocks for that size class. When a thread exits, its heap
+ * takes back what other threads freed and, once its last block is freed,
+ * returns its spare arena and is deleted. Objects may outlive the thread
+ * that created them; until they are gone the heap stays, and blocks
+ * freed into it from other threads are no longer reused.
+ */
+class SmallObjectAllocator {
+public:
+    static constexpr size_t ALIGNMENT = 16;
+    static constexpr size_t MAX_SMALL = 512;
+    static constexpr size_t SIZE_CLASSES = MAX_SMALL / ALIGNMENT;
+    static constexpr size_t POOL_SIZE = 16 * 1024;
+    static constexpr size_t ARENA_SIZE = 256 * 1024;
+    static constexpr size_t POOLS_PER_ARENA = ARENA_SIZE / POOL_SIZE;
+
+    struct Stats {
+        size_t arenas = 0;              // Currently held from the system
+        size_t max_arenas = 0;          // High-water mark
+        size_t arenas_allocated = 0;    // Ever requested from the system
+        size_t arenas_freed = 0;        // Ever returned to the system
+        size_t pools_in_use = 0;        // Pools serving some size class
+        size_t blocks_in_use = 0;
+        size_t blocks_allocated = 0;    // Ever handed out
+        size_t bytes_in_use = 0;        // Block bytes handed out (rounded sizes)
+        size_t remote_frees = 0;        // Blocks taken back from other threads
+        size_t large_in_use = 0;        // Live requests above MAX_SMALL, all threads
+        std::array<size_t, SIZE_CLASSES> blocks_by_class{};
+    };
+
+    SmallObjectAllocator(const SmallObjectAllocator&) = delete;
+    SmallObjectAllocator& operator=(const SmallObjectAllocator&) = delete;
+
+    // The calling thread's heap
+    static SmallObjectAllocator& current();
+
+    void* allocate(size_t size);
+
+    // size must be the size passed to allocate()
+    static void deallocate(void* ptr, size_t size);
+
+    Stats stats() const {
+        Stats stats = stats_;
+        stats.large_in_use = large_in_use_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    struct Arena;
+
+    struct Pool {
+        SmallObjectAllocator* owner;
+        Arena* arena;
+        Pool* prev;                       // Usable or full list of the size class,
+        Pool* next;                       // or the arena's free pools
+        Block* free;                      // Freed blocks, most recent first
+        std::atomic<Block*> remote_free;  // Blocks freed by other threads
+        uint32_t size_class;
+        uint32_t used;                    // Blocks handed out
+        uint32_t fresh;                   // Offset of the first never-used block
+        uint32_t capacity;
+    };
+
+    struct Arena {
+        char* base;
+        Pool* free_pools;        // Emptied pools, ready for any size class
+        size_t untouched;        // Pools past the last one ever used
+        size_t pools_in_use;
+        Arena* prev;
+        Arena* next;
+    };
+
+    static constexpr size_t POOL_HEADER_SIZE = (sizeof(Pool) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    SmallObjectAllocator() = default;
+
+    static size_t size_class_of(size_t size) { return (size - 1) / ALIGNMENT; }
+    static size_t block_size_of(size_t size_class) { return (size_class + 1) * ALIGNMENT; }
+    static Pool* pool_of(void* ptr) {
+        return reinterpret_cast<Pool*>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t(POOL_SIZE) - 1));
+    }
+
+    static void push(Pool*& list, Pool* pool);
+    static void remove(Pool*& list, Pool* pool);
+
+    void* allocate_slow(size_t size_class);
+    void reclaim_remote();
+    Pool* new_pool(size_t size_class);
+    void free_local(Pool* pool, Block* block);
+    void release_pool(Pool* pool);
+    Arena* new_arena();
+    void release_arena(Arena* arena);
+    void release_if_unused();
+
+    // Runs the exiting thread's heap down (see above)
+    struct ThreadExit {
+        ~ThreadExit();
+    };
+
+    std::array<Pool*, SIZE_CLASSES> usable_{};  // Pools with a free block, per size class
+    std::array<Pool*, SIZE_CLASSES> full_{};    // Pools without one
+    Arena* arenas_ = nullptr;                   // Arenas with a pool to spare
+    Arena* full_arenas_ = nullptr;
+    Arena* spare_ = nullptr;                    // An empty arena kept back
+    std::atomic<size_t> remote_pending_{0};     // Remote frees not yet taken back
+    bool exiting_ = false;                      // Owning thread has exited
+    Stats stats_;
+
+    static inline thread_local SmallObjectAllocator* current_ = nullptr;
+    static inline thread_local bool thread_exited_ = false;
+    static inline std::atomic<size_t> large_in_use_{0};
+};
+
+inline SmallObjectAllocator& SmallObjectAllocator::current() {
+    if (!current_) {
+        current_ = new SmallObjectAllocator();
+        if (!thread_exited_) {
+            // Allocations made while the thread exits get a heap that is kept
+            static thread_local ThreadExit exit_hook;
+            (void)exit_hook;
+        }
+    }
+    return *current_;
+}
+
+inline void SmallObjectAllocator::push(Pool*& list, Pool* pool) {
+    pool->prev = nullptr;
+    pool->next = list;
+    if (list) list->prev = pool;
+    list = pool;
+}
+
+inline void SmallObjectAllocator::remove(Pool*& list, Pool* pool) {
+    if (pool->prev) pool->prev->next = pool->next; else list = pool->next;
+    if (pool->next) pool->next->prev = pool->prev;
+    pool->prev = pool->next = nullptr;
+}
+
+// Fast path: pop the newest free block of the first usable pool
+inline void* SmallObjectAllocator::allocate(size_t size) {
+    if (size > MAX_SMALL || size == 0) {
+        large_in_use_.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size == 0 ? 1 : size);
+    }
+    size_t size_class = size_class_of(size);
+    Pool* pool = usable_[size_class];
+    if (pool && pool->free) {
+        Block* block = pool->free;
+        pool->free = block->next;
+        if (++pool->used == pool->capacity) {
+            remove(usable_[size_class], pool);
+            push(full_[size_class], pool);
+        }
+        stats_.blocks_in_use++;
+        stats_.blocks_allocated++;
+        stats_.bytes_in_use += block_size_of(size_class);
+        stats_.blocks_by_class[size_class]++;
+        return block;
+    }
+    return allocate_slow(size_class);
+}
+
+inline void* SmallObjectAllocator::allocate_slow(size_t size_class) {
+    if (!usable_[size_class]) {
+        reclaim_remote();
+        if (!usable_[size_class]) new_pool(size_class);
+    }
+    Pool* pool = usable_[size_class];
+
+    // Free list empty: carve the next never-used block
+    Block* block = pool->free;
+    if (block) {
+        pool->free = block->next;
+    } else {
+        block = reinterpret_cast<Block*>(reinterpret_cast<char*>(pool) + pool->fresh);
+        pool->fresh += static_cast<uint32_t>(block_size_of(size_class));
+    }
+    if (++pool->used == pool->capacity) {
+        remove(usable_[size_class], pool);
+        push(full_[size_class], pool);
+    }
+    stats_.blocks_in_use++;
+    stats_.blocks_allocated++;
+    stats_.bytes_in_use += block_size_of(size_class);
+    stats_.blocks_by_class[size_class]++;
+    return block;
+}
+
+// Take back every block other threads have freed into this heap's pools
+inline void SmallObjectAllocator::reclaim_remote() {
+    if (remote_pending_.load(std::memory_order_relaxed) == 0) return;
+    for (size_t cls = 0; cls < SIZE_CLASSES; cls++) {
+        for (Pool* list : {full_[cls], usable_[cls]}) {
+            // free_local may move or release the pool; next is read first
+            for (Pool* pool = list; pool;) {
+                Pool* next = pool->next;
+                Block* block = pool->remote_free.exchange(nullptr, std::memory_order_acquire);
+                while (block) {
+                    Block* following = block->next;
+                    remote_pending_.fetch_sub(1, std::memory_order_relaxed);
+                    stats_.remote_frees++;
+                    free_local(pool, block);
+                    block = following;
+                }
+                pool = next;
+            }
+        }
+    }
+}
+
+inline SmallObjectAllocator::Pool* SmallObjectAllocator::new_pool(size_t size_class) {
+    Arena* arena = arenas_ ? arenas_ : new_arena();
+    Pool* pool;
+    if (arena->free_pools) {
+        pool = arena->free_pools;
+        arena->free_pools = pool->next;
+    } else {
+        pool = reinterpret_cast<Pool*>(arena->base + (POOLS_PER_ARENA - arena->untouched) * POOL_SIZE);
+        arena->untouched--;
+        new (pool) Pool{};
+    }
+    if (++arena->pools_in_use == POOLS_PER_ARENA) {
+        // Unlink from arenas_ into full_arenas_
+        if (arena->prev) arena->prev->next = arena->next; else arenas_ = arena->next;
+        if (arena->next) arena->next->prev = arena->prev;
+        arena->prev = nullptr;
+        arena->next = full_arenas_;
+        if (full_arenas_) full_arenas_->prev = arena;
+        full_arenas_ = arena;
+    }
+
+    pool->owner = this;
+    pool->arena = arena;
+    pool->free = nullptr;
+    pool->remote_free.store(nullptr, std::memory_order_relaxed);
+    pool->size_class = static_cast<uint32_t>(size_class);
+    pool->used = 0;
+    pool->fresh = static_cast<uint32_t>(POOL_HEADER_SIZE);
+    pool->capacity = static_cast<uint32_t>((POOL_SIZE - POOL_HEADER_SIZE) / block_size_of(size_class));
+    push(usable_[size_class], pool);
+    stats_.pools_in_use++;
+    return pool;
+}
+
+inline void SmallObjectAllocator::deallocate(void* ptr, size_t size) {
+    if (!ptr) return;
+    if (size > MAX_SMALL || size == 0) {
+        large_in_use_.fetch_sub(1, std::memory_order_relaxed);
+        ::operator delete(ptr);
+        return;
+    }
+    Pool* pool = pool_of(ptr);
+    Block* block = static_cast<Block*>(ptr);
+    SmallObjectAllocator* heap = current_;
+    if (pool->owner == heap) {
+        heap->free_local(pool, block);  // May return the pool's arena
+        if (heap->exiting_) heap->release_if_unused();
+        return;
+    }
+    // Another thread's pool: hand the block back through its remote list
+    Block* head = pool->remote_free.load(std::memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!pool->remote_free.compare_exchange_weak(head, block, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+    pool->owner->remote_pending_.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void SmallObjectAllocator::free_local(Pool* pool, Block* block) {
+    size_t size_class = pool->size_class;
+    stats_.blocks_in_use--;
+    stats_.bytes_in_use -= block_size_of(size_class);
+    stats_.blocks_by_class[size_class]--;
+
+    bool was_full = pool->used == pool->capacity;
+    block->next = pool->free;
+    pool->free = block;
+    if (was_full) {
+        remove(full_[size_class], pool);
+        push(usable_[size_class], pool);
+    }
+    if (--pool->used == 0) {
+        release_pool(pool);
+    }
+}
+
+// An empty pool returns to its arena, for any size class
+inline void SmallObjectAllocator::release_pool(Pool* pool) {
+    remove(usable_[pool->size_class], pool);
+    stats_.pools_in_use--;
+
+    Arena* arena = pool->arena;
+    pool->next = arena->free_pools;
+    arena->free_pools = pool;
+    if (arena->pools_in_use-- == POOLS_PER_ARENA) {
+        if (arena->prev) arena->prev->next = arena->next; else full_arenas_ = arena->next;
+        if (arena->next) arena->next->prev = arena->prev;
+        arena->prev = nullptr;
+        arena->next = arenas_;
+        if (arenas_) arenas_->prev = arena;
+        arenas_ = arena;
+    }
+    if (arena->pools_in_use == 0) {
+        release_arena(arena);
+    }
+}
+
+inline SmallObjectAllocator::Arena* SmallObjectAllocator::new_arena() {
+    Arena* arena = spare_;
+    if (arena) {
+        spare_ = nullptr;
+    } else {
+        arena = new Arena{};
+        arena->base = static_cast<char*>(::operator new(ARENA_SIZE, std::align_val_t(POOL_SIZE)));
+        arena->untouched = POOLS_PER_ARENA;
+        stats_.arenas_allocated++;
+        stats_.arenas++;
+        if (stats_.arenas > stats_.max_arenas) stats_.max_arenas = stats_.arenas;
+    }
+    arena->prev = nullptr;
+    arena->next = arenas_;
+    if (arenas_) arenas_->prev = arena;
+    arenas_ = arena;
+    return arena;
+}
+
+// Keep one empty arena for the next burst; give the rest back
+inline void SmallObjectAllocator::release_arena(Arena* arena) {
+    if (arena->prev) arena->prev->next = arena->next; else arenas_ = arena->next;
+    if (arena->next) arena->next->prev = arena->prev;
+    arena->prev = arena->next = nullptr;
+    if (!spare_) {
+        spare_ = arena;
+        return;
+    }
+    ::operator delete(arena->base, std::align_val_t(POOL_SIZE));
+    delete arena;
+    stats_.arenas--;
+    stats_.arenas_freed++;
+}
+
+// An exited thread's heap goes once nothing is allocated from it
+inline void SmallObjectAllocator::release_if_unused() {
+    if (stats_.blocks_in_use > 0) return;
+    if (spare_) {
+        ::operator delete(spare_->base, std::align_val_t(POOL_SIZE));
+        delete spare_;
+    }
+    if (current_ == this) current_ = nullptr;
+    delete this;
+}
+
+inline SmallObjectAllocator::ThreadExit::~ThreadExit() {
+    thread_exited_ = true;
+    if (SmallObjectAllocator* heap = current_) {
+        heap->exiting_ = true;
+        heap->reclaim_remote();
+        heap->release_if_unused();
+    }
+}
+
+} // namespace core
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_OBJECT_ALLOCATOR_HPP
@@ -3,6 +3,21 @@
 
 #include <atomic>
 #include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "object_allocator.hpp"
+
+/**
+ * Reference counts are atomic by default so objects may be handed
+ * between threads. An interpreter only touches its own objects from one
+ * thread, so embedders that keep each VM on a single thread can build
+ * with -DCPYTHON_CPP_ATOMIC_REFCOUNT=0 for plain increments.
+ */
+#ifndef CPYTHON_CPP_ATOMIC_REFCOUNT
+#define CPYTHON_CPP_ATOMIC_REFCOUNT 1
+#endif
 
 namespace cpython_cpp {
 namespace core {
@@ -20,21 +35,55 @@ public:
     RefCounted() : ref_count_(1) {}
     virtual ~RefCounted() = default;
 
+    // A copy is a new object with its own single reference
+    RefCounted(const RefCounted&) : ref_count_(1) {}
+    RefCounted& operator=(const RefCounted&) { return *this; }
+
+#if CPYTHON_CPP_SMALL_OBJECT_ALLOCATOR
+    // Objects live in size-class pools (PyObject_Malloc); the virtual
+    // destructor hands the dynamic type's size back to the sized delete
+    static void* operator new(size_t size) {
+        return SmallObjectAllocator::current().allocate(size);
+    }
+    static void operator delete(void* ptr, size_t size) {
+        SmallObjectAllocator::deallocate(ptr, size);
+    }
+#endif
+
     // Increment reference count
     void incref() {
+#if CPYTHON_CPP_ATOMIC_REFCOUNT
         ref_count_.fetch_add(1, std::memory_order_relaxed);
+#else
+        ++ref_count_;
+#endif
     }
 
     // Decrement reference count
     // Returns true if object should be deallocated
     bool decref() {
+#if CPYTHON_CPP_ATOMIC_REFCOUNT
         auto old_count = ref_count_.fetch_sub(1, std::memory_order_acq_rel);
         return old_count == 1;
+#else
+        return --ref_count_ == 0;
+#endif
+    }
+
+    // Drop a reference and deallocate on the last one (Py_DECREF)
+    void release() {
+        if (decref()) {
+            dealloc();
+        }
     }
 
     // Get current reference count
     int64_t get_ref_count() const {
+#if CPYTHON_CPP_ATOMIC_REFCOUNT
         return ref_count_.load(std::memory_order_acquire);
+#else
+        return ref_count_;
+#endif
     }
 
 protected:
@@ -44,9 +93,81 @@ protected:
     }
 
 private:
+#if CPYTHON_CPP_ATOMIC_REFCOUNT
     std::atomic<int64_t> ref_count_;
+#else
+    int64_t ref_count_;
+#endif
+};
+
+/**
+ * Ref - owning handle to a RefCounted object
+ *
+ * The intrusive counterpart of std::shared_ptr: one pointer wide, no
+ * separate control block. Objects start with a count of one, which
+ * make_ref() adopts.
+ */
+template<typename T>
+class Ref {
+public:
+    Ref() noexcept = default;
+    Ref(std::nullptr_t) noexcept {}
+
+    // Take a new reference to an object owned elsewhere (Py_INCREF)
+    explicit Ref(T* ptr) noexcept : ptr_(ptr) {
+        if (ptr_) ptr_->incref();
+    }
+
+    // Take over a reference the caller already owns
+    static Ref adopt(T* ptr) noexcept {
+        Ref ref;
+        ref.ptr_ = ptr;
+        return ref;
+    }
+
+    Ref(const Ref& other) noexcept : Ref(other.ptr_) {}
+    Ref(Ref&& other) noexcept : ptr_(std::exchange(other.ptr_, nullptr)) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    Ref(const Ref<U>& other) noexcept : Ref(static_cast<T*>(other.get())) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    Ref(Ref<U>&& other) noexcept : ptr_(other.detach()) {}
+
+    ~Ref() {
+        if (ptr_) ptr_->release();
+    }
+
+    Ref& operator=(Ref other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        return *this;
+    }
+
+    T* get() const noexcept { return ptr_; }
+    T& operator*() const noexcept { return *ptr_; }
+    T* operator->() const noexcept { return ptr_; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+    // Give up ownership without touching the count
+    T* detach() noexcept { return std::exchange(ptr_, nullptr); }
+
+    void reset() noexcept { Ref().swap(*this); }
+    void swap(Ref& other) noexcept { std::swap(ptr_, other.ptr_); }
+
+    friend bool operator==(const Ref& a, const Ref& b) noexcept { return a.ptr_ == b.ptr_; }
+    friend bool operator!=(const Ref& a, const Ref& b) noexcept { return a.ptr_ != b.ptr_; }
+    friend bool operator==(const Ref& a, std::nullptr_t) noexcept { return a.ptr_ == nullptr; }
+    friend bool operator!=(const Ref& a, std::nullptr_t) noexcept { return a.ptr_ != nullptr; }
+
+private:
+    T* ptr_ = nullptr;
 };
 
+template<typename T, typename... Args>
+Ref<T> make_ref(Args&&... args) {
+    return Ref<T>::adopt(new T(std::forward<Args>(args)...));
+}
+
 } // namespace core
 } // namespace cpython_cpp
 
@@ -0,0 +1,187 @@
+#ifndef CPYTHON_CPP_THREAD_POOL_HPP
+#define CPYTHON_CPP_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cpython_cpp {
+namespace core {
+
+/**
+ * ThreadPool - fixed set of workers with per-worker work-stealing queues
+ *
+ * Each worker takes tasks from the back of its own queue and, when that
+ * runs dry, steals from the front of the others. submit() called from a
+ * worker pushes onto that worker's queue; from any other thread it
+ * deals tasks round-robin. wait() blocks until every submitted task has
+ * finished and rethrows the first exception a task let escape.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Task task);
+    void wait();
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool pop_local(size_t self, Task& task);
+    bool steal(size_t self, Task& task);
+    void worker_loop(size_t self);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_{0};
+
+    std::mutex state_mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    size_t queued_ = 0;    // Tasks sitting in some queue
+    size_t pending_ = 0;   // Tasks submitted but not yet finished
+    bool stopping_ = false;
+    std::exception_ptr first_error_;
+
+    // Index of the calling worker in the pool it belongs to, if any
+    static thread_local const ThreadPool* current_pool_;
+    static thread_local size_t current_index_;
+};
+
+inline thread_local const ThreadPool* ThreadPool::current_pool_ = nullptr;
+inline thread_local size_t ThreadPool::current_index_ = 0;
+
+inline ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+    }
+    queues_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+inline void ThreadPool::submit(Task task) {
+    size_t target = current_pool_ == this
+        ? current_index_
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        queued_++;
+        pending_++;
+    }
+    work_available_.notify_one();
+}
+
+inline void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    all_done_.wait(lock, [this] { return pending_ == 0; });
+    if (first_error_) {
+        std::exception_ptr error = first_error_;
+        first_error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+inline bool ThreadPool::pop_local(size_t self, Task& task) {
+    WorkQueue& queue = *queues_[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+inline bool ThreadPool::steal(size_t self, Task& task) {
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        WorkQueue& queue = *queues_[(self + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void ThreadPool::worker_loop(size_t self) {
+    current_pool_ = this;
+    current_index_ = self;
+
+    while (true) {
+        Task task;
+        if (pop_local(self, task) || steal(self, task)) {
+            {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                queued_--;
+            }
+            std::exception_ptr error;
+            try {
+                task();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            if (error && !first_error_) {
+                first_error_ = error;
+            }
+            if (--pending_ == 0) {
+                all_done_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        work_available_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+        if (stopping_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+} // namespace core
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_THREAD_POOL_HPP
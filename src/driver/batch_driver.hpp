@@ -0,0 +1,177 @@
+#ifndef CPYTHON_CPP_BATCH_DRIVER_HPP
+#define CPYTHON_CPP_BATCH_DRIVER_HPP
+
+#include "../parser/parser.hpp"
+#include "../compiler/compiler.hpp"
+#include "../compiler/bytecode_compiler.hpp"
+#include "../compiler/code_cache.hpp"
+#include "../core/thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace cpython_cpp {
+namespace driver {
+
+/**
+ * FileResult - outcome of parsing and compiling one source file
+ */
+struct FileResult {
+    std::string path;
+    bool ok = false;
+    bool cached = false;              // Fresh bytecode cache entry; breakdown has counts only
+    std::vector<std::string> errors;  // Read/parse failure or compiler errors
+    compiler::Compiler::Breakdown breakdown{0, 0, 0, {}};
+};
+
+/**
+ * BatchReport - per-file results (in input order) plus aggregate totals
+ */
+struct BatchReport {
+    std::vector<FileResult> files;
+    size_t succeeded = 0;
+    size_t failed = 0;
+    size_t cached = 0;
+    compiler::Compiler::Breakdown totals{0, 0, 0, {}};
+    double seconds = 0.0;
+};
+
+/**
+ * BatchDriver - parses and compiles many files on a work-stealing pool
+ *
+ * Every file gets its own Tokenizer, Parser, Compiler and BytecodeCompiler,
+ * and results land in a slot reserved for that file, so workers share
+ * nothing but the pool itself.
+ *
+ * With the bytecode cache enabled, a file whose __pycache__ entry is
+ * still fresh skips parsing and compiling and takes its counts from the
+ * entry's header; misses write a new entry.
+ */
+class BatchDriver {
+public:
+    // 0 threads means one per hardware thread
+    explicit BatchDriver(size_t threads = 0, bool use_cache = false)
+        : pool_(threads), use_cache_(use_cache) {}
+
+    // Expand directories to the .py files below them; sorted, files kept as given
+    static std::vector<std::string> collect_sources(const std::vector<std::string>& paths);
+
+    BatchReport run(const std::vector<std::string>& files);
+
+    size_t thread_count() const { return pool_.size(); }
+
+private:
+    static void process_file(FileResult& result, bool use_cache);
+
+    core::ThreadPool pool_;
+    bool use_cache_;
+};
+
+inline std::vector<std::string> BatchDriver::collect_sources(const std::vector<std::string>& paths) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    for (const auto& path : paths) {
+        std::error_code ec;
+        if (!fs::is_directory(path, ec)) {
+            files.push_back(path);
+            continue;
+        }
+        std::vector<std::string> found;
+        for (fs::recursive_directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().extension() == ".py") {
+                found.push_back(it->path().string());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    return files;
+}
+
+inline BatchReport BatchDriver::run(const std::vector<std::string>& files) {
+    auto start = std::chrono::steady_clock::now();
+
+    BatchReport report;
+    report.files.resize(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        FileResult& result = report.files[i];
+        result.path = files[i];
+        pool_.submit([&result, use_cache = use_cache_] { process_file(result, use_cache); });
+    }
+    pool_.wait();
+
+    for (const auto& result : report.files) {
+        if (result.ok) {
+            report.succeeded++;
+        } else {
+            report.failed++;
+        }
+        if (result.cached) {
+            report.cached++;
+        }
+        report.totals.function_count += result.breakdown.function_count;
+        report.totals.statement_count += result.breakdown.statement_count;
+        report.totals.expression_count += result.breakdown.expression_count;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    report.seconds = elapsed.count();
+    return report;
+}
+
+inline void BatchDriver::process_file(FileResult& result, bool use_cache) {
+    std::string cache_path = use_cache ? compiler::code_cache_path(result.path) : std::string();
+    compiler::CodeCacheFile cache;
+    if (use_cache && compiler::open_code_cache(cache, cache_path, result.path)) {
+        const compiler::SourceStats& stats = cache.header().stats;
+        result.breakdown.function_count = static_cast<int>(stats.function_count);
+        result.breakdown.statement_count = static_cast<int>(stats.statement_count);
+        result.breakdown.expression_count = static_cast<int>(stats.expression_count);
+        result.ok = true;
+        result.cached = true;
+        return;
+    }
+    auto key = compiler::stat_source(result.path);
+
+    std::ifstream file(result.path, std::ios::binary);
+    if (!file.is_open()) {
+        result.errors.push_back("Could not open file");
+        return;
+    }
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    if (key) {
+        key->hash = compiler::hash_source(source);
+    }
+
+    try {
+        parser::Parser parser(std::move(source));
+        auto module = parser.parse();
+
+        compiler::Compiler breakdown_compiler;
+        result.breakdown = breakdown_compiler.get_breakdown(module);
+
+        compiler::BytecodeCompiler bytecode_compiler;
+        auto code = bytecode_compiler.compile(*module, result.path);
+        result.errors = bytecode_compiler.errors();
+        result.ok = !bytecode_compiler.has_errors();
+        if (use_cache && result.ok && key) {
+            compiler::SourceStats stats;
+            stats.function_count = static_cast<uint32_t>(result.breakdown.function_count);
+            stats.statement_count = static_cast<uint32_t>(result.breakdown.statement_count);
+            stats.expression_count = static_cast<uint32_t>(result.breakdown.expression_count);
+            compiler::write_code_cache(cache_path, *code, *key, stats);
+        }
+    } catch (const std::exception& e) {
+        result.errors.push_back(e.what());
+    }
+}
+
+} // namespace driver
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_BATCH_DRIVER_HPP
@@ -0,0 +1,205 @@
+#ifndef CPYTHON_CPP_CHAR_SCAN_HPP
+#define CPYTHON_CPP_CHAR_SCAN_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The tokenizer's run scanners test 16 or 32 bytes at a time with SSE2,
+ * AVX2 or NEON, whichever the target enables. Define
+ * CPYTHON_CPP_SIMD_SCAN=0 to force the scalar loops.
+ */
+#ifndef CPYTHON_CPP_SIMD_SCAN
+#define CPYTHON_CPP_SIMD_SCAN 1
+#endif
+
+#if CPYTHON_CPP_SIMD_SCAN && (defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64))
+#include <immintrin.h>
+#elif CPYTHON_CPP_SIMD_SCAN && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace cpython_cpp {
+namespace parser {
+namespace scan {
+
+/**
+ * Character classes for the scalar loops (ASCII only, as before: bytes
+ * of multi-byte UTF-8 sequences are in no class)
+ */
+enum CharClass : uint8_t {
+    IDENT = 1,   // [A-Za-z0-9_]
+    DIGIT = 2,   // [0-9]
+    BLANK = 4,   // space, tab, newline
+};
+
+inline constexpr std::array<uint8_t, 256> CHAR_CLASS = [] {
+    std::array<uint8_t, 256> table{};
+    for (int c = 'a'; c <= 'z'; ++c) table[c] |= IDENT;
+    for (int c = 'A'; c <= 'Z'; ++c) table[c] |= IDENT;
+    for (int c = '0'; c <= '9'; ++c) table[c] |= IDENT | DIGIT;
+    table['_'] |= IDENT;
+    table[' '] |= BLANK;
+    table['\t'] |= BLANK;
+    table['\n'] |= BLANK;
+    return table;
+}();
+
+inline bool has_class(char c, uint8_t cls) {
+    return (CHAR_CLASS[static_cast<uint8_t>(c)] & cls) != 0;
+}
+
+/**
+ * Simd - one vector of source bytes and the handful of tests the
+ * scanners need. bitmask() yields LANE_BITS bits per byte, lowest byte
+ * first, so countr_zero / LANE_BITS is the index of the first set lane.
+ */
+#if CPYTHON_CPP_SIMD_SCAN && defined(__AVX2__)
+#define CPYTHON_CPP_SIMD_WIDTH 32
+struct Simd {
+    using Vec = __m256i;
+    static constexpr int WIDTH = 32;
+    static constexpr int LANE_BITS = 1;
+    static Vec load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static Vec splat(char c) { return _mm256_set1_epi8(c); }
+    static Vec eq(Vec v, char c) { return _mm256_cmpeq_epi8(v, splat(c)); }
+    static Vec either(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+    // lo <= v < lo + n, unsigned: shift lo to -128 and compare signed
+    static Vec in_range(Vec v, char lo, int n) {
+        Vec shifted = _mm256_add_epi8(v, splat(static_cast<char>(0x80 - lo)));
+        return _mm256_cmpgt_epi8(splat(static_cast<char>(-128 + n)), shifted);
+    }
+    static uint64_t bitmask(Vec v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+};
+#elif CPYTHON_CPP_SIMD_SCAN && (defined(__SSE2__) || defined(_M_X64))
+#define CPYTHON_CPP_SIMD_WIDTH 16
+struct Simd {
+    using Vec = __m128i;
+    static constexpr int WIDTH = 16;
+    static constexpr int LANE_BITS = 1;
+    static Vec load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static Vec splat(char c) { return _mm_set1_epi8(c); }
+    static Vec eq(Vec v, char c) { return _mm_cmpeq_epi8(v, splat(c)); }
+    static Vec either(Vec a, Vec b) { return _mm_or_si128(a, b); }
+    static Vec in_range(Vec v, char lo, int n) {
+        Vec shifted = _mm_add_epi8(v, splat(static_cast<char>(0x80 - lo)));
+        return _mm_cmplt_epi8(shifted, splat(static_cast<char>(-128 + n)));
+    }
+    static uint64_t bitmask(Vec v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+};
+#elif CPYTHON_CPP_SIMD_SCAN && defined(__ARM_NEON)
+#define CPYTHON_CPP_SIMD_WIDTH 16
+struct Simd {
+    using Vec = uint8x16_t;
+    static constexpr int WIDTH = 16;
+    static constexpr int LANE_BITS = 4;
+    static Vec load(const char* p) { return vld1q_u8(reinterpret_cast<const uint8_t*>(p)); }
+    static Vec splat(char c) { return vdupq_n_u8(static_cast<uint8_t>(c)); }
+    static Vec eq(Vec v, char c) { return vceqq_u8(v, splat(c)); }
+    static Vec either(Vec a, Vec b) { return vorrq_u8(a, b); }
+    static Vec in_range(Vec v, char lo, int n) {
+        return vcltq_u8(vsubq_u8(v, splat(lo)), vdupq_n_u8(static_cast<uint8_t>(n)));
+    }
+    // Narrow each 0x00/0xFF lane to a nibble (there is no movemask)
+    static uint64_t bitmask(Vec v) {
+        return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+    }
+};
+#endif
+
+#ifdef CPYTHON_CPP_SIMD_WIDTH
+// Lane bits of a whole vector, for inverting a bitmask
+inline constexpr uint64_t SIMD_ALL_LANES =
+    Simd::WIDTH * Simd::LANE_BITS == 64 ? ~uint64_t(0) : (uint64_t(1) << (Simd::WIDTH * Simd::LANE_BITS)) - 1;
+
+/**
+ * Advance over whole vectors until one has a lane stops() flags; returns
+ * that lane, or where fewer than WIDTH bytes remain
+ */
+template <typename Stops>
+inline const char* find_stop(const char* p, const char* end, Stops stops) {
+    while (end - p >= Simd::WIDTH) {
+        uint64_t mask = stops(Simd::load(p));
+        if (mask) {
+            return p + std::countr_zero(mask) / Simd::LANE_BITS;
+        }
+        p += Simd::WIDTH;
+    }
+    return p;
+}
+
+inline Simd::Vec ident_lanes(Simd::Vec v) {
+    // Setting 0x20 folds A-Z onto a-z and leaves digits and '_' alone
+    Simd::Vec letters = Simd::in_range(Simd::either(v, Simd::splat(0x20)), 'a', 26);
+    return Simd::either(Simd::either(letters, Simd::in_range(v, '0', 10)), Simd::eq(v, '_'));
+}
+#endif
+
+// End of the run of class cls starting at p (scalar, and the vector tail)
+inline const char* scalar_run(const char* p, const char* end, uint8_t cls) {
+    while (p < end && has_class(*p, cls)) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * scan_identifier - end of the [A-Za-z0-9_] run starting at p
+ */
+inline const char* scan_identifier(const char* p, const char* end) {
+#ifdef CPYTHON_CPP_SIMD_WIDTH
+    p = find_stop(p, end, [](Simd::Vec v) { return ~Simd::bitmask(ident_lanes(v)) & SIMD_ALL_LANES; });
+#endif
+    return scalar_run(p, end, IDENT);
+}
+
+/**
+ * scan_digits - end of the [0-9] run starting at p
+ */
+inline const char* scan_digits(const char* p, const char* end) {
+#ifdef CPYTHON_CPP_SIMD_WIDTH
+    p = find_stop(p, end, [](Simd::Vec v) { return ~Simd::bitmask(Simd::in_range(v, '0', 10)) & SIMD_ALL_LANES; });
+#endif
+    return scalar_run(p, end, DIGIT);
+}
+
+/**
+ * scan_blanks - end of the run of spaces, tabs and newlines starting at p
+ */
+inline const char* scan_blanks(const char* p, const char* end) {
+#ifdef CPYTHON_CPP_SIMD_WIDTH
+    // Indentation is mostly shorter than a vector: test the first byte alone
+    if (p < end && !has_class(*p, BLANK)) {
+        return p;
+    }
+    p = find_stop(p, end, [](Simd::Vec v) {
+        Simd::Vec blank = Simd::either(Simd::either(Simd::eq(v, ' '), Simd::eq(v, '\t')), Simd::eq(v, '\n'));
+        return ~Simd::bitmask(blank) & SIMD_ALL_LANES;
+    });
+#endif
+    return scalar_run(p, end, BLANK);
+}
+
+/**
+ * scan_string_body - first quote, backslash or newline at or after p:
+ * the bytes before it are string contents taken as they are
+ */
+inline const char* scan_string_body(const char* p, const char* end, char quote) {
+#ifdef CPYTHON_CPP_SIMD_WIDTH
+    p = find_stop(p, end, [quote](Simd::Vec v) {
+        return Simd::bitmask(Simd::either(Simd::either(Simd::eq(v, quote), Simd::eq(v, '\\')), Simd::eq(v, '\n')));
+    });
+#endif
+    while (p < end && *p != quote && *p != '\\' && *p != '\n') {
+        ++p;
+    }
+    return p;
+}
+
+} // namespace scan
+} // namespace parser
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_CHAR_SCAN_HPP
@@ -2,17 +2,19 @@
 #define CPYTHON_CPP_PARSER_HPP
 
 #include "tokenizer.hpp"
+#include "token_stream.hpp"
 #include "combinators.hpp"
+#include "../ast/arena.hpp"
 #include "../ast/module.hpp"
 #include "../ast/stmt.hpp"
 #include "../ast/expr.hpp"
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <vector>
 #include <stdexcept>
 #include <sstream>
-#include <unordered_map>
 #include <functional>
-#include <any>
 
 namespace cpython_cpp {
 namespace parser {
@@ -22,44 +24,119 @@ namespace parser {
 // ============================================================================
 
 /**
- * MemoKey - Key for memoization table
- * Combines rule identifier and position for unique cache lookup
+ * RuleMemo - packrat memo for one backtracking-prone rule
+ * Reference: Parser/pegen.h (Memo), Parser/pegen.c (_PyPegen_is_memoized)
+ *
+ * Entries are stored in a flat array indexed by token position relative
+ * to base_, typed with the rule's own result (no std::any, no per-entry
+ * allocation). Failed attempts are memoized too. reset() drops every
+ * entry when the parser commits to a top-level statement, so the array
+ * only spans the statement being parsed and every node a statement's
+ * tree uses was allocated while that statement was parsed.
  */
-struct MemoKey {
-    size_t rule_id;
-    size_t position;
-    
-    bool operator==(const MemoKey& other) const {
-        return rule_id == other.rule_id && position == other.position;
+template<typename Result>
+class RuleMemo {
+public:
+    struct Entry {
+        Result result;
+        size_t end_position;
+    };
+
+    explicit RuleMemo(const char* name) : name_(name) {}
+
+    // Entry for a parse that started at position, or nullptr on a miss
+    const Entry* find(size_t position) {
+        if (position >= base_ && position - base_ < entries_.size() &&
+            entries_[position - base_].end_position != kUnset) {
+            hits_++;
+            return &entries_[position - base_];
+        }
+        misses_++;
+        return nullptr;
     }
+
+    void store(size_t position, Result result, size_t end_position) {
+        if (position < base_) {
+            return; // Behind the committed position - never looked up again
+        }
+        size_t index = position - base_;
+        if (index >= entries_.size()) {
+            entries_.resize(index + 1, Entry{Result{}, kUnset});
+        }
+        entries_[index] = Entry{result, end_position};
+    }
+
+    // Forget every entry; positions before position are never looked up again
+    void reset(size_t position) {
+        entries_.clear();
+        base_ = position;
+    }
+
+    const char* name() const { return name_; }
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    static constexpr size_t kUnset = static_cast<size_t>(-1);
+
+    const char* name_;
+    std::vector<Entry> entries_;
+    size_t base_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
 };
 
-struct MemoKeyHash {
-    size_t operator()(const MemoKey& key) const {
-        return std::hash<size_t>()(key.rule_id) ^ (std::hash<size_t>()(key.position) << 1);
+/**
+ * MemoStats - hit/miss counters of one memoized rule
+ */
+struct MemoStats {
+    const char* rule;
+    size_t hits;
+    size_t misses;
+
+    double hit_rate() const {
+        size_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
     }
 };
 
 /**
- * MemoEntry - Entry in memoization table
- * Stores the result of a parse attempt and the end position
+ * TextEdit - replace `removed` bytes at `offset` with `text`
  */
-struct MemoEntry {
-    std::any result;
-    size_t end_position;
-    bool success;
+struct TextEdit {
+    size_t offset;
+    size_t removed;
+    std::string text;
 };
 
 /**
- * Template helper for rule identification
- * Each parsing rule gets a unique compile-time ID
+ * StmtSpan - where a top-level statement came from and what it depended on
+ *
+ * begin/line/column locate the statement's first token. extent is one past
+ * the last source byte the parser examined while parsing it, lookahead
+ * included, so an edit at or after extent cannot change the statement.
+ * The nodes built for it are the ones made in arena between nodes_begin
+ * and nodes_end.
  */
-template<auto RuleFunc>
-struct RuleId {
-    static size_t get() {
-        static const size_t id = reinterpret_cast<size_t>(&RuleFunc);
-        return id;
-    }
+struct StmtSpan {
+    ast::Stmt* stmt;  // nullptr when the statement produced no node
+    size_t begin;
+    size_t extent;
+    size_t line;
+    size_t column;
+    bool resumable;   // Lexing can restart at begin (no open f/t-string)
+    std::shared_ptr<ast::Arena> arena;
+    ast::Arena::Mark nodes_begin;
+    ast::Arena::Mark nodes_end;
+};
+
+/**
+ * ParseTree - a module plus what Parser::reparse() needs to update it
+ */
+struct ParseTree {
+    std::string source;
+    std::shared_ptr<ast::Module> module;
+    std::vector<StmtSpan> statements;  // Source order; the module body is their stmts
 };
 
 /**
@@ -73,215 +150,203 @@ struct RuleId {
  */
 class Parser {
 public:
-    explicit Parser(const std::string& source);
+    explicit Parser(std::string source);
 
     // Parse the source code and return an AST Module
     std::shared_ptr<ast::Module> parse();
 
+    // Parse and keep the statement spans reparse() works from. Takes the
+    // source back from the tokenizer, so the parser is spent afterwards.
+    ParseTree parse_tree();
+
+    // Re-parse previous with edit applied, giving the tree parse_tree() would.
+    // Statements the edit cannot reach are reused: those before it as they
+    // are, those after it once the new parse lines up with one of them again
+    // (only their line numbers are updated). previous is consumed, since its
+    // nodes move into the result.
+    static ParseTree reparse(ParseTree previous, const TextEdit& edit);
+
+    // Per-rule packrat memo counters, for checking the memo pays off
+    std::vector<MemoStats> memo_stats() const;
+
 private:
     Tokenizer tokenizer_;
-    std::vector<Token> tokens_;
+    std::shared_ptr<ast::Arena> arena_;  // Every node is allocated here; handed to the Module
+    mutable TokenStream tokens_;  // Filled lazily as current()/peek() look ahead
     size_t current_token_;
     
-    // Memoization table for packrat parsing
-    mutable std::unordered_map<MemoKey, MemoEntry, MemoKeyHash> memo_table_;
-    
-    // Template-based memoization helper
-    template<typename ResultType, typename ParseFunc>
-    ResultType memoize(size_t rule_id, ParseFunc&& parse_func) {
-        MemoKey key{rule_id, current_token_};
-        
-        auto it = memo_table_.find(key);
-        if (it != memo_table_.end()) {
-            // Cache hit - restore position and return cached result
-            current_token_ = it->second.end_position;
-            if (it->second.success) {
-                return std::any_cast<ResultType>(it->second.result);
-            }
-            return nullptr;
+    // Packrat memos, one per backtracking-prone rule (see memo_stats())
+    RuleMemo<ast::Expr*> disjunction_memo_{"disjunction"};
+
+    // Replay a memoized result at current_token_, or run and record the rule
+    template<typename Result, typename ParseFunc>
+    Result memoize(RuleMemo<Result>& memo, ParseFunc&& parse_func) {
+        if (const auto* entry = memo.find(current_token_)) {
+            current_token_ = entry->end_position;
+            return entry->result;
         }
-        
-        // Cache miss - parse and store result
         size_t start_pos = current_token_;
-        ResultType result = parse_func();
-        
-        MemoEntry entry;
-        entry.end_position = current_token_;
-        entry.success = (result != nullptr);
-        if (entry.success) {
-            entry.result = result;
-        }
-        memo_table_[key] = entry;
-        
+        Result result = parse_func();
+        memo.store(start_pos, result, current_token_);
         return result;
     }
-    
+
     // Mark/reset for backtracking (PEG-style)
     size_t mark() const { return current_token_; }
     void reset(size_t pos) { current_token_ = pos; }
 
-    // Current token helpers
-    Token current() const;
-    Token peek() const;
+    // Current token helpers (references into tokens_, valid until released)
+    const Token& current() const;
+    const Token& peek() const;
     void advance();
     bool match(TokenType type);
     bool is_at_end() const;
 
     // Parsing methods (recursive descent)
-    std::shared_ptr<ast::Module> parse_module();
-    std::shared_ptr<ast::Stmt> parse_stmt();
+    std::shared_ptr<ast::Module> parse_module(std::vector<StmtSpan>& spans);
+
+    // Parse top-level statements into spans until END_OF_FILE, or until
+    // stop_before accepts the span of the next statement (begin fields only)
+    void parse_statements(std::vector<StmtSpan>& spans,
+                          const std::function<bool(const StmtSpan&)>& stop_before);
+    static std::shared_ptr<ast::Module> build_module(const std::vector<StmtSpan>& spans);
+    ast::Stmt* parse_stmt();
     
     // Helper to check if current token is an augmented assignment operator
     bool is_augmented_assign() const;
     
     // Helper to convert augmented assignment token to Operator
     ast::Operator token_to_operator(TokenType type) const;
-    std::shared_ptr<ast::Stmt> parse_function_def();
-    std::shared_ptr<ast::Stmt> parse_function_def_raw();
-    std::vector<std::shared_ptr<ast::Expr>> parse_decorators();
-    std::shared_ptr<ast::Stmt> parse_return();
-    std::shared_ptr<ast::Stmt> parse_assign();
-    std::shared_ptr<ast::Stmt> parse_if();
-    std::shared_ptr<ast::Stmt> parse_elif_stmt();
-    std::vector<std::shared_ptr<ast::Stmt>> parse_else_block();
-    std::shared_ptr<ast::Stmt> parse_while();
-    std::shared_ptr<ast::Stmt> parse_for();
-    std::shared_ptr<ast::Stmt> parse_async_function_def();  // Python 3.5+
-    std::shared_ptr<ast::Stmt> parse_async_for();           // Python 3.5+
-    std::shared_ptr<ast::Stmt> parse_async_with();          // Python 3.5+
-    std::shared_ptr<ast::Stmt> parse_match_stmt();          // Python 3.10+
-    std::shared_ptr<ast::Stmt> parse_type_alias();           // Python 3.12+
-    std::vector<std::shared_ptr<ast::TypeParam>> parse_type_params();  // Python 3.12+
-    std::shared_ptr<ast::TypeParam> parse_type_param();      // Python 3.12+
-    std::shared_ptr<ast::Stmt> parse_break();
-    std::shared_ptr<ast::Stmt> parse_continue();
-    std::shared_ptr<ast::Stmt> parse_expr_stmt();
+    ast::Stmt* parse_function_def();
+    ast::Stmt* parse_function_def_raw();
+    std::vector<ast::Expr*> parse_decorators();
+    ast::Stmt* parse_return();
+    ast::Stmt* parse_assign();
+    ast::Stmt* parse_if();
+    ast::Stmt* parse_elif_stmt();
+    std::vector<ast::Stmt*> parse_else_block();
+    ast::Stmt* parse_while();
+    ast::Stmt* parse_for();
+    ast::Stmt* parse_async_function_def();                  // Python 3.5+
+    ast::Stmt* parse_async_for();                           // Python 3.5+
+    ast::Stmt* parse_async_with();                          // Python 3.5+
+    ast::Stmt* parse_match_stmt();                          // Python 3.10+
+    ast::Stmt* parse_type_alias();                           // Python 3.12+
+    std::vector<ast::TypeParam*> parse_type_params();                  // Python 3.12+
+    ast::TypeParam* parse_type_param();                      // Python 3.12+
+    ast::Stmt* parse_break();
+    ast::Stmt* parse_continue();
+    ast::Stmt* parse_expr_stmt();
 
     // Simple statements (matches CPython's pass_stmt_rule, raise_stmt_rule, etc.)
-    std::shared_ptr<ast::Stmt> parse_pass_stmt();
-    std::shared_ptr<ast::Stmt> parse_raise_stmt();
-    std::shared_ptr<ast::Stmt> parse_del_stmt();
-    std::shared_ptr<ast::Stmt> parse_assert_stmt();
-    std::shared_ptr<ast::Stmt> parse_global_stmt();
-    std::shared_ptr<ast::Stmt> parse_nonlocal_stmt();
-
-    std::shared_ptr<ast::Expr> parse_expr();
-    std::shared_ptr<ast::Expr> parse_disjunction();  // or (lowest precedence)
-    std::shared_ptr<ast::Expr> parse_conjunction(); // and
-    std::shared_ptr<ast::Expr> parse_inversion();   // not
-    std::shared_ptr<ast::Expr> parse_comparison();   // <, >, ==, etc.
-    std::shared_ptr<ast::Expr> parse_bitwise_or();   // |
-    std::shared_ptr<ast::Expr> parse_bitwise_xor();  // ^
-    std::shared_ptr<ast::Expr> parse_bitwise_and();  // &
-    std::shared_ptr<ast::Expr> parse_shift_expr();    // <<, >>
-    std::shared_ptr<ast::Expr> parse_sum();           // +, -
-    std::shared_ptr<ast::Expr> parse_term();         // *, /, %, //
-    std::shared_ptr<ast::Expr> parse_factor();       // **, unary +, -, ~
-    std::shared_ptr<ast::Expr> parse_primary();
-    std::shared_ptr<ast::Expr> parse_atom();
-    std::shared_ptr<ast::Expr> parse_call();
-    std::shared_ptr<ast::Expr> parse_list();
-    std::shared_ptr<ast::Expr> parse_dict();
+    ast::Stmt* parse_pass_stmt();
+    ast::Stmt* parse_raise_stmt();
+    ast::Stmt* parse_del_stmt();
+    ast::Stmt* parse_assert_stmt();
+    ast::Stmt* parse_global_stmt();
+    ast::Stmt* parse_nonlocal_stmt();
+
+    ast::Expr* parse_expr();
+    ast::Expr* parse_disjunction();                  // or (lowest precedence), memoized
+    ast::Expr* parse_disjunction_raw();
+    ast::Expr* parse_conjunction(); // and
+    ast::Expr* parse_inversion();                   // not
+    ast::Expr* parse_comparison();                   // <, >, ==, etc.
+    ast::Expr* parse_bitwise_or();                   // |
+    ast::Expr* parse_bitwise_xor();                  // ^
+    ast::Expr* parse_bitwise_and();                  // &
+    ast::Expr* parse_shift_expr();                    // <<, >>
+    ast::Expr* parse_sum();                           // +, -
+    ast::Expr* parse_term();                         // *, /, %, //
+    ast::Expr* parse_factor();                       // **, unary +, -, ~
+    ast::Expr* parse_primary();
+    ast::Expr* parse_atom();
+    ast::Expr* parse_call();
+    ast::Expr* parse_list();
+    ast::Expr* parse_dict();
 
     // CPython-style parsing for for loops (star_targets and star_expressions)
-    std::shared_ptr<ast::Expr> parse_star_targets();
-    std::shared_ptr<ast::Expr> parse_star_target();
-    std::shared_ptr<ast::Expr> parse_star_expressions();
-    std::shared_ptr<ast::Expr> parse_star_expression();
+    ast::Expr* parse_star_targets();
+    ast::Expr* parse_star_target();
+    ast::Expr* parse_star_expressions();
+    ast::Expr* parse_star_expression();
 
     // Helper for parsing argument lists
     std::vector<ast::arg> parse_arg_list();
-    std::vector<std::shared_ptr<ast::Expr>> parse_expr_list();
+    std::vector<ast::Expr*> parse_expr_list();
 
     // CPython-style arguments parsing (matches arguments_rule and args_rule)
-    std::shared_ptr<ast::Call> parse_arguments();  // Returns Call node with args (matches arguments_rule)
-    std::shared_ptr<ast::Call> parse_args();      // Returns Call node (matches args_rule)
+    ast::Call* parse_arguments();                  // Returns Call node with args (matches arguments_rule)
+    ast::Call* parse_args();                      // Returns Call node (matches args_rule)
 
     // Try/except/finally (matches try_stmt_rule, except_block_rule, finally_block_rule)
-    std::shared_ptr<ast::Stmt> parse_try_stmt();
-    std::shared_ptr<ast::ExceptHandler> parse_except_block();
-    std::shared_ptr<ast::ExceptHandler> parse_except_star_block();  // Python 3.11+ except*
-    std::vector<std::shared_ptr<ast::Stmt>> parse_finally_block();
+    ast::Stmt* parse_try_stmt();
+    ast::ExceptHandler* parse_except_block();
+    ast::ExceptHandler* parse_except_star_block();                  // Python 3.11+ except*
+    std::vector<ast::Stmt*> parse_finally_block();
 
     // Class definition (matches class_def_rule, class_def_raw_rule)
-    std::shared_ptr<ast::Stmt> parse_class_def();
-    std::shared_ptr<ast::Stmt> parse_class_def_raw();
+    ast::Stmt* parse_class_def();
+    ast::Stmt* parse_class_def_raw();
 
     // Import statements (matches import_stmt_rule, import_name_rule, import_from_rule)
-    std::shared_ptr<ast::Stmt> parse_import_stmt();
-    std::shared_ptr<ast::Stmt> parse_import_name();
-    std::shared_ptr<ast::Stmt> parse_import_from();
-    std::shared_ptr<ast::Expr> parse_dotted_name();
-    std::shared_ptr<ast::Alias> parse_dotted_as_name();
-    std::vector<std::shared_ptr<ast::Alias>> parse_dotted_as_names();
-    std::shared_ptr<ast::Alias> parse_import_from_as_name();
-    std::vector<std::shared_ptr<ast::Alias>> parse_import_from_as_names();
-    std::vector<std::shared_ptr<ast::Alias>> parse_import_from_targets();
+    ast::Stmt* parse_import_stmt();
+    ast::Stmt* parse_import_name();
+    ast::Stmt* parse_import_from();
+    ast::Expr* parse_dotted_name();
+    ast::Alias* parse_dotted_as_name();
+    std::vector<ast::Alias*> parse_dotted_as_names();
+    ast::Alias* parse_import_from_as_name();
+    std::vector<ast::Alias*> parse_import_from_as_names();
+    std::vector<ast::Alias*> parse_import_from_targets();
 
     // With statement (matches with_stmt_rule, with_item_rule)
-    std::shared_ptr<ast::Stmt> parse_with_stmt();
+    ast::Stmt* parse_with_stmt();
     ast::WithItem parse_with_item();
 
     // Lambda and yield expressions
-    std::shared_ptr<ast::Expr> parse_lambda();
-    std::shared_ptr<ast::Expr> parse_yield_expr();
+    ast::Expr* parse_lambda();
+    ast::Expr* parse_yield_expr();
 
     // Conditional expression (ternary operator): x if condition else y
-    std::shared_ptr<ast::Expr> parse_conditional();
+    ast::Expr* parse_conditional();
 
     // Comprehensions
-    std::shared_ptr<ast::Expr> parse_comprehension();
+    ast::Expr* parse_comprehension();
     ast::Comprehension parse_for_if_clause();
     std::vector<ast::Comprehension> parse_for_if_clauses();
 
     // Slicing: [start:end:step]
     // Matches CPython's slice_rule: returns nullptr if not a slice (allows fallback to named_expression)
-    std::shared_ptr<ast::Expr> parse_slice();
+    ast::Expr* parse_slice();
     
     // Multi-parameter subscript parsing: [expr1, expr2, ...]
     // Handles single expr, multiple exprs (tuple), or slice notation
-    std::shared_ptr<ast::Expr> parse_subscript_slice();
+    ast::Expr* parse_subscript_slice();
 
     // F-string parsing
-    std::shared_ptr<ast::Expr> parse_fstring();
-    std::shared_ptr<ast::Expr> parse_formatted_value();
-    std::shared_ptr<ast::Expr> parse_fstring_format_spec();
+    ast::Expr* parse_fstring();
+    ast::Expr* parse_formatted_value();
+    ast::Expr* parse_fstring_format_spec();
 
     // T-string parsing (PEP 750)
-    std::shared_ptr<ast::Expr> parse_tstring();
-    std::shared_ptr<ast::Expr> parse_interpolation();
+    ast::Expr* parse_tstring();
+    ast::Expr* parse_interpolation();
 
     // Error handling
     void error(const std::string& message);
 };
 
 // Implementations
-inline Parser::Parser(const std::string& source)
-    : tokenizer_(source), current_token_(0) {
-    tokens_ = tokenizer_.tokenize();
-
-    // Print full token stream for debugging
-    std::cerr << "\n[DEBUG Parser] Full token stream (" << tokens_.size() << " tokens):" << std::endl;
-    for (size_t i = 0; i < tokens_.size(); i++) {
-        std::cerr << "  Token[" << i << "] = type=" << static_cast<int>(tokens_[i].type)
-                  << ", value='" << tokens_[i].value << "'"
-                  << ", line=" << tokens_[i].line << ", col=" << tokens_[i].column << std::endl;
-    }
-    std::cerr << std::endl;
-    std::cerr.flush();
+inline Parser::Parser(std::string source)
+    : tokenizer_(std::move(source)), tokens_(tokenizer_), current_token_(0) {
 }
 
-inline Token Parser::current() const {
-    if (current_token_ >= tokens_.size()) {
-        return tokens_.back(); // Return END_OF_FILE
-    }
-    return tokens_[current_token_];
+inline const Token& Parser::current() const {
+    return tokens_[current_token_]; // END_OF_FILE once past the end
 }
 
-inline Token Parser::peek() const {
-    if (current_token_ + 1 >= tokens_.size()) {
-        return tokens_.back(); // Return END_OF_FILE
-    }
+inline const Token& Parser::peek() const {
     return tokens_[current_token_ + 1];
 }
 
@@ -347,36 +412,152 @@ inline void Parser::error(const std::string& message) {
 }
 
 inline std::shared_ptr<ast::Module> Parser::parse() {
-    return parse_module();
+    std::vector<StmtSpan> spans;
+    return parse_module(spans);
 }
 
-inline std::shared_ptr<ast::Module> Parser::parse_module() {
+inline ParseTree Parser::parse_tree() {
+    ParseTree tree;
+    tree.module = parse_module(tree.statements);
+    tree.source = tokenizer_.release_source();
+    return tree;
+}
+
+inline std::vector<MemoStats> Parser::memo_stats() const {
+    return {
+        {disjunction_memo_.name(), disjunction_memo_.hits(), disjunction_memo_.misses()},
+    };
+}
+
+inline std::shared_ptr<ast::Module> Parser::parse_module(std::vector<StmtSpan>& spans) {
     std::cerr << "[DEBUG parse_module] Starting, token=" << current_token_ << std::endl;
     std::cerr.flush();
-    auto module = std::make_shared<ast::Module>(std::vector<std::shared_ptr<ast::Stmt>>());
+    arena_ = std::make_shared<ast::Arena>();
+    parse_statements(spans, nullptr);
+    return build_module(spans);
+}
 
+inline void Parser::parse_statements(std::vector<StmtSpan>& spans,
+                                     const std::function<bool(const StmtSpan&)>& stop_before) {
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
             continue;
         }
+        // No saved position outlives a top-level statement, so everything
+        // before it can be dropped from the token window and the memos
+        tokens_.release_before(current_token_);
+        disjunction_memo_.reset(current_token_);
+
+        const TokenSpan& first = tokens_.span(current_token_);
+        StmtSpan span{nullptr, first.begin, 0, current().line, current().column,
+                      first.resumable, arena_, arena_->mark(), {}};
+        if (stop_before && stop_before(span)) {
+            break;
+        }
         std::cerr << "[DEBUG parse_module] Parsing statement, token=" << current_token_
                   << ", type=" << static_cast<int>(current().type)
                   << ", value='" << current().value << "'" << std::endl;
         std::cerr.flush();
-        auto stmt = parse_stmt();
-        if (stmt) {
-            module->add_stmt(stmt);
+        span.stmt = parse_stmt();
+        span.nodes_end = arena_->mark();
+        span.extent = tokens_.span(tokens_.furthest()).end + 1;
+        spans.push_back(std::move(span));
+        if (spans.back().stmt) {
             std::cerr << "[DEBUG parse_module] Statement parsed, token=" << current_token_ << std::endl;
             std::cerr.flush();
         }
     }
-    std::cerr << "[DEBUG parse_module] Complete, " << module->body().size() << " statements" << std::endl;
+    std::cerr << "[DEBUG parse_module] Complete, " << spans.size() << " statements" << std::endl;
     std::cerr.flush();
+}
+
+inline std::shared_ptr<ast::Module> Parser::build_module(const std::vector<StmtSpan>& spans) {
+    auto module = std::make_shared<ast::Module>(std::vector<ast::Stmt*>());
+    for (const auto& span : spans) {
+        if (span.stmt) {
+            module->add_stmt(span.stmt);
+        }
+        const auto& arenas = module->arenas();
+        if (std::find(arenas.begin(), arenas.end(), span.arena) == arenas.end()) {
+            module->adopt_arena(span.arena);
+        }
+    }
     return module;
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_stmt() {
+inline ParseTree Parser::reparse(ParseTree previous, const TextEdit& edit) {
+    std::vector<StmtSpan>& old = previous.statements;
+    if (edit.offset > previous.source.size() ||
+        edit.removed > previous.source.size() - edit.offset) {
+        throw std::out_of_range("TextEdit lies outside the source");
+    }
+
+    // Statements that never looked as far as the edit parse the same again.
+    // Resume at the first one re-parsed, which must start before the edit.
+    size_t keep = 0;
+    while (keep < old.size() && old[keep].extent <= edit.offset) {
+        keep++;
+    }
+    while (keep > 0 && (keep == old.size() || old[keep].begin >= edit.offset ||
+                        !old[keep].resumable)) {
+        keep--;
+    }
+
+    std::string source = std::move(previous.source);
+    source.replace(edit.offset, edit.removed, edit.text);
+    size_t edit_end = edit.offset + edit.text.size();
+    ptrdiff_t delta = static_cast<ptrdiff_t>(edit.text.size()) - static_cast<ptrdiff_t>(edit.removed);
+
+    ParseTree tree;
+    Parser parser(std::move(source));
+    if (keep > 0) {
+        parser.tokenizer_.resume_at(old[keep].begin, old[keep].line, old[keep].column);
+    }
+    tree.statements.assign(std::make_move_iterator(old.begin()),
+                           std::make_move_iterator(old.begin() + keep));
+
+    // Past the edit, the bytes are the old ones shifted by delta. A new
+    // statement starting where an old one did, in the same column and with
+    // the tokenizer outside any string, sees the same tokens from there on,
+    // so it and everything after it parse exactly as before.
+    size_t resync = old.size();
+    ptrdiff_t line_delta = 0;
+    parser.arena_ = std::make_shared<ast::Arena>();
+    parser.parse_statements(tree.statements, [&](const StmtSpan& next) {
+        if (!next.resumable || next.begin < edit_end) {
+            return false;
+        }
+        size_t old_begin = static_cast<size_t>(static_cast<ptrdiff_t>(next.begin) - delta);
+        auto it = std::lower_bound(old.begin() + keep, old.end(), old_begin,
+                                   [](const StmtSpan& span, size_t begin) { return span.begin < begin; });
+        if (it == old.end() || it->begin != old_begin || !it->resumable || it->column != next.column) {
+            return false;
+        }
+        resync = static_cast<size_t>(it - old.begin());
+        line_delta = static_cast<ptrdiff_t>(next.line) - static_cast<ptrdiff_t>(it->line);
+        return true;
+    });
+
+    for (size_t i = resync; i < old.size(); ++i) {
+        StmtSpan& span = old[i];
+        span.begin = static_cast<size_t>(static_cast<ptrdiff_t>(span.begin) + delta);
+        span.extent = static_cast<size_t>(static_cast<ptrdiff_t>(span.extent) + delta);
+        if (line_delta != 0) {
+            span.line = static_cast<size_t>(static_cast<ptrdiff_t>(span.line) + line_delta);
+            span.arena->for_each_node(span.nodes_begin, span.nodes_end, [&](ast::ASTNodeBase* node) {
+                node->shift_lines(static_cast<int>(line_delta));
+            });
+        }
+        tree.statements.push_back(std::move(span));
+    }
+
+    tree.module = build_module(tree.statements);
+    tree.source = parser.tokenizer_.release_source();
+    return tree;
+}
+
+inline ast::Stmt* Parser::parse_stmt() {
     std::cerr << "[DEBUG parse_stmt] Entry, token=" << current_token_
               << ", type=" << static_cast<int>(current().type)
               << ", value='" << current().value << "'" << std::endl;
@@ -391,10 +572,10 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_stmt() {
         std::cerr.flush();
         // Peek ahead to find the next non-decorator token
         size_t lookahead = current_token_;
-        while (lookahead < tokens_.size() && tokens_[lookahead].type == TokenType::AT) {
+        while (tokens_[lookahead].type == TokenType::AT) {
             lookahead++;  // skip @
             // Skip the decorator expression (everything until NEWLINE, DEF, or CLASS)
-            while (lookahead < tokens_.size() &&
+            while (tokens_[lookahead].type != TokenType::END_OF_FILE &&
                    tokens_[lookahead].type != TokenType::NEWLINE &&
                    tokens_[lookahead].type != TokenType::DEF &&
                    tokens_[lookahead].type != TokenType::CLASS &&
@@ -402,20 +583,20 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_stmt() {
                 lookahead++;
             }
             // Skip NEWLINE if present (decorators are typically on separate lines)
-            if (lookahead < tokens_.size() && tokens_[lookahead].type == TokenType::NEWLINE) {
+            if (tokens_[lookahead].type == TokenType::NEWLINE) {
                 lookahead++;
             }
         }
         // Check what comes after decorators
         std::cerr << "[DEBUG parse_stmt] After lookahead, lookahead=" << lookahead
-                  << ", token type=" << (lookahead < tokens_.size() ? static_cast<int>(tokens_[lookahead].type) : -1)
-                  << ", value='" << (lookahead < tokens_.size() ? tokens_[lookahead].value : "") << "'" << std::endl;
+                  << ", token type=" << static_cast<int>(tokens_[lookahead].type)
+                  << ", value='" << tokens_[lookahead].value << "'" << std::endl;
         std::cerr.flush();
-        if (lookahead < tokens_.size() && tokens_[lookahead].type == TokenType::DEF) {
+        if (tokens_[lookahead].type == TokenType::DEF) {
             std::cerr << "[DEBUG parse_stmt] Calling parse_function_def()" << std::endl;
             std::cerr.flush();
             return parse_function_def();
-        } else if (lookahead < tokens_.size() && tokens_[lookahead].type == TokenType::CLASS) {
+        } else if (tokens_[lookahead].type == TokenType::CLASS) {
             std::cerr << "[DEBUG parse_stmt] Calling parse_class_def()" << std::endl;
             std::cerr.flush();
             return parse_class_def();
@@ -502,8 +683,8 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_stmt() {
             if (current().type == TokenType::EQUAL) {
                 advance();  // consume '='
                 auto value = parse_star_expressions();
-                std::vector<std::shared_ptr<ast::Expr>> target_list = {targets};
-                return std::make_shared<ast::Assign>(target_list, value,
+                std::vector<ast::Expr*> target_list = {targets};
+                return arena_->make<ast::Assign>(target_list, value,
                                                     targets->lineno(), targets->col_offset());
             } else {
                 // Not an assignment, restore position and parse as expression
@@ -522,12 +703,12 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_stmt() {
             auto annotation = parse_expr();
             
             // Check if target is a simple name
-            auto name_expr = std::dynamic_pointer_cast<ast::Name>(expr);
+            auto name_expr = dynamic_cast<ast::Name*>(expr);
             bool simple = (name_expr != nullptr);
             
             // Change target context to Store
             if (simple) {
-                expr = std::make_shared<ast::Name>(
+                expr = arena_->make<ast::Name>(
                     name_expr->id(),
                     ast::ExprContext::Store,
                     name_expr->lineno(),
@@ -536,12 +717,12 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_stmt() {
             }
             
             // Check for optional value: x: int = 5
-            std::shared_ptr<ast::Expr> value = nullptr;
+            ast::Expr* value = nullptr;
             if (match(TokenType::EQUAL)) {
                 value = parse_expr();
             }
             
-            return std::make_shared<ast::AnnAssign>(
+            return arena_->make<ast::AnnAssign>(
                 expr, annotation, value, simple,
                 expr->lineno(), expr->col_offset()
             );
@@ -551,29 +732,29 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_stmt() {
             ast::Operator op = token_to_operator(op_token);
             advance(); // consume the augmented assignment operator
             auto value = parse_expr();
-            return std::make_shared<ast::AugAssign>(expr, op, value,
+            return arena_->make<ast::AugAssign>(expr, op, value,
                                                     expr->lineno(), expr->col_offset());
         } else if (match(TokenType::EQUAL)) {
             // This is a regular assignment
             auto value = parse_expr();
-            std::vector<std::shared_ptr<ast::Expr>> targets = {expr};
-            return std::make_shared<ast::Assign>(targets, value,
+            std::vector<ast::Expr*> targets = {expr};
+            return arena_->make<ast::Assign>(targets, value,
                                                 expr->lineno(), expr->col_offset());
         } else {
             // Expression statement
-            return std::make_shared<ast::ExprStmt>(expr,
+            return arena_->make<ast::ExprStmt>(expr,
                                                   expr->lineno(), expr->col_offset());
         }
     }
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_function_def() {
+inline ast::Stmt* Parser::parse_function_def() {
     std::cerr << "[DEBUG parse_function_def] Entry, token=" << current_token_
               << ", type=" << static_cast<int>(current().type)
               << ", value='" << current().value << "'" << std::endl;
     std::cerr.flush();
     // Check for decorators first
-    std::vector<std::shared_ptr<ast::Expr>> decorators;
+    std::vector<ast::Expr*> decorators;
     if (current().type == TokenType::AT) {
         std::cerr << "[DEBUG parse_function_def] Found decorators, parsing..." << std::endl;
         std::cerr.flush();
@@ -583,8 +764,8 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_function_def() {
     }
     auto func_def = parse_function_def_raw();
     // Apply decorators if any
-    if (auto func = std::dynamic_pointer_cast<ast::FunctionDef>(func_def)) {
-        return std::make_shared<ast::FunctionDef>(
+    if (auto func = dynamic_cast<ast::FunctionDef*>(func_def)) {
+        return arena_->make<ast::FunctionDef>(
             func->name(), func->args(), func->body(), decorators,
             func->returns(),  // preserve returns annotation
             func->type_params(),  // PEP 695: preserve type params
@@ -593,7 +774,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_function_def() {
     return func_def;
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_function_def_raw() {
+inline ast::Stmt* Parser::parse_function_def_raw() {
     if (!match(TokenType::DEF)) {
         error("Expected 'def'");
     }
@@ -602,11 +783,11 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_function_def_raw() {
     if (name_token.type != TokenType::IDENTIFIER) {
         error("Expected function name");
     }
-    std::string name = name_token.value;
+    std::string name = name_token.text();
     advance();
 
     // PEP 695: Parse optional type parameters: [T], [T, U], [T: int], etc.
-    std::vector<std::shared_ptr<ast::TypeParam>> type_params;
+    std::vector<ast::TypeParam*> type_params;
     if (current().type == TokenType::LBRACKET) {
         std::cerr << "[DEBUG parse_function_def_raw] Found type params, parsing..." << std::endl;
         type_params = parse_type_params();
@@ -624,7 +805,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_function_def_raw() {
     }
 
     // Check for return annotation: -> type
-    std::shared_ptr<ast::Expr> returns = nullptr;
+    ast::Expr* returns = nullptr;
     if (current().type == TokenType::ARROW) {
         advance();  // consume '->'
         returns = parse_expr();
@@ -635,7 +816,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_function_def_raw() {
     }
 
     // Parse function body (simplified - just parse statements until dedent)
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -652,28 +833,28 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_function_def_raw() {
         }
     }
 
-    return std::make_shared<ast::FunctionDef>(name, args, body, std::vector<std::shared_ptr<ast::Expr>>(),
+    return arena_->make<ast::FunctionDef>(name, args, body, std::vector<ast::Expr*>(),
                                              returns,  // return annotation
                                              type_params,  // PEP 695: Generic type parameters
                                              name_token.line, name_token.column);
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_return() {
+inline ast::Stmt* Parser::parse_return() {
     Token return_token = current();
     if (!match(TokenType::RETURN)) {
         error("Expected 'return'");
     }
 
-    std::shared_ptr<ast::Expr> value = nullptr;
+    ast::Expr* value = nullptr;
     if (current().type != TokenType::NEWLINE && current().type != TokenType::END_OF_FILE) {
         value = parse_expr();
     }
 
-    return std::make_shared<ast::Return>(value, return_token.line, return_token.column);
+    return arena_->make<ast::Return>(value, return_token.line, return_token.column);
 }
 
-inline std::vector<std::shared_ptr<ast::Stmt>> Parser::parse_else_block() {
-    std::vector<std::shared_ptr<ast::Stmt>> orelse;
+inline std::vector<ast::Stmt*> Parser::parse_else_block() {
+    std::vector<ast::Stmt*> orelse;
     if (match(TokenType::ELSE)) {
         if (!match(TokenType::COLON)) {
             error("Expected ':' after else");
@@ -698,7 +879,7 @@ inline std::vector<std::shared_ptr<ast::Stmt>> Parser::parse_else_block() {
     return orelse;
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_if() {
+inline ast::Stmt* Parser::parse_if() {
     Token if_token = current();
     if (!match(TokenType::IF)) {
         error("Expected 'if'");
@@ -711,7 +892,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_if() {
     }
 
     // Parse block (body) - matches CPython's block_rule
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -730,7 +911,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_if() {
     // CPython tries this alternative first, and only if it fails, tries else_block
     // Save position before trying (like CPython's _mark)
     size_t saved_pos = current_token_;
-    std::vector<std::shared_ptr<ast::Stmt>> orelse;
+    std::vector<ast::Stmt*> orelse;
     auto elif_stmt = parse_elif_stmt();
     if (elif_stmt) {
         // elif_stmt returns an If node, wrap it in orelse (like _PyPegen_singleton_seq)
@@ -741,10 +922,10 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_if() {
         orelse = parse_else_block();
     }
 
-    return std::make_shared<ast::If>(test, body, orelse, if_token.line, if_token.column);
+    return arena_->make<ast::If>(test, body, orelse, if_token.line, if_token.column);
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_elif_stmt() {
+inline ast::Stmt* Parser::parse_elif_stmt() {
     // Save position to restore if parsing fails (matches CPython's _mark)
     size_t saved_pos = current_token_;
 
@@ -766,7 +947,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_elif_stmt() {
     }
 
     // Parse block (body) - matches CPython's block_rule
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -786,7 +967,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_elif_stmt() {
     // Try elif_stmt first (recursive - matches CPython: 'elif' named_expression ':' block elif_stmt)
     size_t saved_pos2 = current_token_; // Save position before trying nested elif
     auto nested_elif = parse_elif_stmt();
-    std::vector<std::shared_ptr<ast::Stmt>> orelse;
+    std::vector<ast::Stmt*> orelse;
     if (nested_elif) {
         // Recursively parsed nested elif_stmt, wrap it in orelse (like _PyPegen_singleton_seq)
         orelse.push_back(nested_elif);
@@ -797,10 +978,10 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_elif_stmt() {
     }
 
     // Create If node for this elif (matches CPython's _PyAST_If)
-    return std::make_shared<ast::If>(test, body, orelse, elif_token.line, elif_token.column);
+    return arena_->make<ast::If>(test, body, orelse, elif_token.line, elif_token.column);
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_while() {
+inline ast::Stmt* Parser::parse_while() {
     Token while_token = current();
     if (!match(TokenType::WHILE)) {
         error("Expected 'while'");
@@ -813,7 +994,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_while() {
     }
 
     // Parse block (body)
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -829,12 +1010,12 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_while() {
     }
 
     // Parse else clause if present
-    std::vector<std::shared_ptr<ast::Stmt>> orelse = parse_else_block();
+    std::vector<ast::Stmt*> orelse = parse_else_block();
 
-    return std::make_shared<ast::While>(test, body, orelse, while_token.line, while_token.column);
+    return arena_->make<ast::While>(test, body, orelse, while_token.line, while_token.column);
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_for() {
+inline ast::Stmt* Parser::parse_for() {
     Token for_token = current();
     if (!match(TokenType::FOR)) {
         error("Expected 'for'");
@@ -856,7 +1037,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_for() {
     }
 
     // Parse block (body)
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -872,14 +1053,14 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_for() {
     }
 
     // Parse else clause if present
-    std::vector<std::shared_ptr<ast::Stmt>> orelse = parse_else_block();
+    std::vector<ast::Stmt*> orelse = parse_else_block();
 
-    return std::make_shared<ast::For>(target, iter, body, orelse, for_token.line, for_token.column);
+    return arena_->make<ast::For>(target, iter, body, orelse, for_token.line, for_token.column);
 }
 
 // Parse match statement (Python 3.10+)
 // Simplified implementation: match subject: case pattern: body
-inline std::shared_ptr<ast::Stmt> Parser::parse_match_stmt() {
+inline ast::Stmt* Parser::parse_match_stmt() {
     Token match_token = current();
     if (!match(TokenType::MATCH)) {
         error("Expected 'match'");
@@ -913,7 +1094,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_match_stmt() {
         auto pattern = parse_expr();
         
         // Check for guard (if clause)
-        std::shared_ptr<ast::Expr> guard = nullptr;
+        ast::Expr* guard = nullptr;
         if (current().type == TokenType::IF) {
             advance();  // consume 'if'
             guard = parse_expr();
@@ -924,7 +1105,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_match_stmt() {
         }
         
         // Parse case body
-        std::vector<std::shared_ptr<ast::Stmt>> body;
+        std::vector<ast::Stmt*> body;
         while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
             if (current().type == TokenType::NEWLINE) {
                 advance();
@@ -945,12 +1126,12 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_match_stmt() {
         cases.push_back(ast::match_case(pattern, guard, body));
     }
 
-    return std::make_shared<ast::Match>(subject, cases, match_token.line, match_token.column);
+    return arena_->make<ast::Match>(subject, cases, match_token.line, match_token.column);
 }
 
 
 // Parse async function definition (Python 3.5+)
-inline std::shared_ptr<ast::Stmt> Parser::parse_async_function_def() {
+inline ast::Stmt* Parser::parse_async_function_def() {
     Token async_token = tokens_[current_token_ - 1]; // 'async' was already consumed
     if (!match(TokenType::DEF)) {
         error("Expected 'def' after 'async'");
@@ -960,7 +1141,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_async_function_def() {
     if (name_token.type != TokenType::IDENTIFIER) {
         error("Expected function name");
     }
-    std::string name = name_token.value;
+    std::string name = name_token.text();
     advance();
 
     if (!match(TokenType::LPAREN)) {
@@ -974,7 +1155,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_async_function_def() {
     }
 
     // Check for return annotation: -> type
-    std::shared_ptr<ast::Expr> returns = nullptr;
+    ast::Expr* returns = nullptr;
     if (current().type == TokenType::ARROW) {
         advance();  // consume '->'
         returns = parse_expr();
@@ -985,7 +1166,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_async_function_def() {
     }
 
     // Parse function body
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -1000,13 +1181,13 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_async_function_def() {
         }
     }
 
-    return std::make_shared<ast::AsyncFunctionDef>(name, args, body, std::vector<std::shared_ptr<ast::Expr>>(),
+    return arena_->make<ast::AsyncFunctionDef>(name, args, body, std::vector<ast::Expr*>(),
                                                     returns,  // return annotation
                                                     async_token.line, async_token.column);
 }
 
 // Parse async for loop (Python 3.5+)
-inline std::shared_ptr<ast::Stmt> Parser::parse_async_for() {
+inline ast::Stmt* Parser::parse_async_for() {
     Token async_token = tokens_[current_token_ - 1]; // 'async' was already consumed
     if (!match(TokenType::FOR)) {
         error("Expected 'for' after 'async'");
@@ -1025,7 +1206,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_async_for() {
     }
 
     // Parse block (body)
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -1041,46 +1222,46 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_async_for() {
     }
 
     // Parse else clause if present
-    std::vector<std::shared_ptr<ast::Stmt>> orelse = parse_else_block();
+    std::vector<ast::Stmt*> orelse = parse_else_block();
 
-    return std::make_shared<ast::AsyncFor>(target, iter, body, orelse, async_token.line, async_token.column);
+    return arena_->make<ast::AsyncFor>(target, iter, body, orelse, async_token.line, async_token.column);
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_break() {
+inline ast::Stmt* Parser::parse_break() {
     Token break_token = current();
     if (!match(TokenType::BREAK)) {
         error("Expected 'break'");
     }
-    return std::make_shared<ast::Break>(break_token.line, break_token.column);
+    return arena_->make<ast::Break>(break_token.line, break_token.column);
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_continue() {
+inline ast::Stmt* Parser::parse_continue() {
     Token continue_token = current();
     if (!match(TokenType::CONTINUE)) {
         error("Expected 'continue'");
     }
-    return std::make_shared<ast::Continue>(continue_token.line, continue_token.column);
+    return arena_->make<ast::Continue>(continue_token.line, continue_token.column);
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_assign() {
+inline ast::Stmt* Parser::parse_assign() {
     auto target = parse_expr();
     if (!match(TokenType::EQUAL)) {
         error("Expected '=' in assignment");
     }
     auto value = parse_expr();
-    std::vector<std::shared_ptr<ast::Expr>> targets = {target};
-    return std::make_shared<ast::Assign>(targets, value,
+    std::vector<ast::Expr*> targets = {target};
+    return arena_->make<ast::Assign>(targets, value,
                                        target->lineno(), target->col_offset());
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_expr_stmt() {
+inline ast::Stmt* Parser::parse_expr_stmt() {
     auto expr = parse_expr();
-    return std::make_shared<ast::ExprStmt>(expr, expr->lineno(), expr->col_offset());
+    return arena_->make<ast::ExprStmt>(expr, expr->lineno(), expr->col_offset());
 }
 
 // Expression parsing with proper precedence (lowest to highest)
 // Reference: Python grammar precedence
-inline std::shared_ptr<ast::Expr> Parser::parse_expr() {
+inline ast::Expr* Parser::parse_expr() {
     std::cerr << "[DEBUG parse_expr] Entry, token=" << current_token_
               << ", type=" << static_cast<int>(current().type)
               << ", value='" << current().value << "'" << std::endl;
@@ -1094,13 +1275,13 @@ inline std::shared_ptr<ast::Expr> Parser::parse_expr() {
         advance();  // consume :=
         
         // Validate that target is a simple Name
-        auto name_expr = std::dynamic_pointer_cast<ast::Name>(result);
+        auto name_expr = dynamic_cast<ast::Name*>(result);
         if (!name_expr) {
             error("Assignment expression target must be a simple name");
         }
         
         // Create target with Store context
-        auto target = std::make_shared<ast::Name>(
+        auto target = arena_->make<ast::Name>(
             name_expr->id(),
             ast::ExprContext::Store,
             name_expr->lineno(),
@@ -1110,7 +1291,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_expr() {
         // Parse value (recursive for right-associativity)
         auto value = parse_expr();
         
-        result = std::make_shared<ast::NamedExpr>(
+        result = arena_->make<ast::NamedExpr>(
             target, value, walrus_token.line, walrus_token.column
         );
     }
@@ -1122,21 +1303,27 @@ inline std::shared_ptr<ast::Expr> Parser::parse_expr() {
 }
 
 // or (lowest precedence)
+// Memoized: slices re-parse their lower bound as a plain expression, and
+// comprehension conditions re-parse the test of a rejected conditional
+inline ast::Expr* Parser::parse_disjunction() {
+    return memoize(disjunction_memo_, [this] { return parse_disjunction_raw(); });
+}
+
 // Also handles conditional expressions: disjunction 'if' disjunction 'else' conditional
-inline std::shared_ptr<ast::Expr> Parser::parse_disjunction() {
+inline ast::Expr* Parser::parse_disjunction_raw() {
     auto left = parse_conjunction();
-    std::vector<std::shared_ptr<ast::Expr>> values = {left};
+    std::vector<ast::Expr*> values = {left};
 
     while (match(TokenType::OR)) {
         values.push_back(parse_conjunction());
     }
 
-    std::shared_ptr<ast::Expr> result;
+    ast::Expr* result;
     if (values.size() == 1) {
         result = values[0];
     } else {
         Token token = tokens_[current_token_ - 1];
-        result = std::make_shared<ast::BoolOpExpr>(ast::BoolOp::Or, values, token.line, token.column);
+        result = arena_->make<ast::BoolOpExpr>(ast::BoolOp::Or, values, token.line, token.column);
     }
 
     // Check for conditional expression: result 'if' test 'else' orelse
@@ -1157,7 +1344,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_disjunction() {
             advance();  // consume 'else'
             auto orelse = parse_conditional();  // Parse orelse (recursive, right-associative)
             Token if_token = tokens_[saved_pos];  // Get the 'if' token
-            return std::make_shared<ast::IfExp>(test, result, orelse, if_token.line, if_token.column);
+            return arena_->make<ast::IfExp>(test, result, orelse, if_token.line, if_token.column);
         } else {
             // This is not a conditional expression (probably part of a comprehension)
             // Restore position and return the result without conditional
@@ -1170,14 +1357,14 @@ inline std::shared_ptr<ast::Expr> Parser::parse_disjunction() {
 
 // Conditional expression (right-associative)
 // conditional: disjunction 'if' disjunction 'else' conditional
-inline std::shared_ptr<ast::Expr> Parser::parse_conditional() {
+inline ast::Expr* Parser::parse_conditional() {
     return parse_disjunction();  // Delegate to parse_disjunction which handles conditionals
 }
 
 // and
-inline std::shared_ptr<ast::Expr> Parser::parse_conjunction() {
+inline ast::Expr* Parser::parse_conjunction() {
     auto left = parse_inversion();
-    std::vector<std::shared_ptr<ast::Expr>> values = {left};
+    std::vector<ast::Expr*> values = {left};
 
     while (match(TokenType::AND)) {
         values.push_back(parse_inversion());
@@ -1188,15 +1375,15 @@ inline std::shared_ptr<ast::Expr> Parser::parse_conjunction() {
     }
 
     Token token = tokens_[current_token_ - 1];
-    return std::make_shared<ast::BoolOpExpr>(ast::BoolOp::And, values, token.line, token.column);
+    return arena_->make<ast::BoolOpExpr>(ast::BoolOp::And, values, token.line, token.column);
 }
 
 // not
-inline std::shared_ptr<ast::Expr> Parser::parse_inversion() {
+inline ast::Expr* Parser::parse_inversion() {
     if (match(TokenType::NOT)) {
         Token token = tokens_[current_token_ - 1];
         auto operand = parse_inversion();
-        return std::make_shared<ast::UnaryOp>(ast::UnaryOp::UnaryOpType::Not, operand, token.line, token.column);
+        return arena_->make<ast::UnaryOp>(ast::UnaryOp::UnaryOpType::Not, operand, token.line, token.column);
     }
     return parse_comparison();
 }
@@ -1204,97 +1391,97 @@ inline std::shared_ptr<ast::Expr> Parser::parse_inversion() {
 // <, >, ==, !=, <=, >=, is, is not, in, not in
 // Note: Python supports chained comparisons like "0 < x < 10"
 // For now, we only parse single comparisons
-inline std::shared_ptr<ast::Expr> Parser::parse_comparison() {
+inline ast::Expr* Parser::parse_comparison() {
     auto left = parse_bitwise_or();
 
     // Try to parse a comparison operator
     if (match(TokenType::LESS)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_bitwise_or();
-        return std::make_shared<ast::Compare>(left, ast::CompareOp::Lt, right, token.line, token.column);
+        return arena_->make<ast::Compare>(left, ast::CompareOp::Lt, right, token.line, token.column);
     } else if (match(TokenType::GREATER)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_bitwise_or();
-        return std::make_shared<ast::Compare>(left, ast::CompareOp::Gt, right, token.line, token.column);
+        return arena_->make<ast::Compare>(left, ast::CompareOp::Gt, right, token.line, token.column);
     } else if (match(TokenType::LESS_EQUAL)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_bitwise_or();
-        return std::make_shared<ast::Compare>(left, ast::CompareOp::LtE, right, token.line, token.column);
+        return arena_->make<ast::Compare>(left, ast::CompareOp::LtE, right, token.line, token.column);
     } else if (match(TokenType::GREATER_EQUAL)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_bitwise_or();
-        return std::make_shared<ast::Compare>(left, ast::CompareOp::GtE, right, token.line, token.column);
+        return arena_->make<ast::Compare>(left, ast::CompareOp::GtE, right, token.line, token.column);
     } else if (match(TokenType::EQUAL_EQUAL)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_bitwise_or();
-        return std::make_shared<ast::Compare>(left, ast::CompareOp::Eq, right, token.line, token.column);
+        return arena_->make<ast::Compare>(left, ast::CompareOp::Eq, right, token.line, token.column);
     } else if (match(TokenType::NOT_EQUAL)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_bitwise_or();
-        return std::make_shared<ast::Compare>(left, ast::CompareOp::NotEq, right, token.line, token.column);
+        return arena_->make<ast::Compare>(left, ast::CompareOp::NotEq, right, token.line, token.column);
     } else if (match(TokenType::IS)) {
         Token token = tokens_[current_token_ - 1];
         if (match(TokenType::NOT)) {
             auto right = parse_bitwise_or();
-            return std::make_shared<ast::Compare>(left, ast::CompareOp::IsNot, right, token.line, token.column);
+            return arena_->make<ast::Compare>(left, ast::CompareOp::IsNot, right, token.line, token.column);
         }
         auto right = parse_bitwise_or();
-        return std::make_shared<ast::Compare>(left, ast::CompareOp::Is, right, token.line, token.column);
+        return arena_->make<ast::Compare>(left, ast::CompareOp::Is, right, token.line, token.column);
     } else if (match(TokenType::IN)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_bitwise_or();
-        return std::make_shared<ast::Compare>(left, ast::CompareOp::In, right, token.line, token.column);
+        return arena_->make<ast::Compare>(left, ast::CompareOp::In, right, token.line, token.column);
     } else if (match(TokenType::NOT) && current().type == TokenType::IN) {
         Token token = tokens_[current_token_ - 1];
         advance(); // consume IN
         auto right = parse_bitwise_or();
-        return std::make_shared<ast::Compare>(left, ast::CompareOp::NotIn, right, token.line, token.column);
+        return arena_->make<ast::Compare>(left, ast::CompareOp::NotIn, right, token.line, token.column);
     }
 
     return left;
 }
 
 // |
-inline std::shared_ptr<ast::Expr> Parser::parse_bitwise_or() {
+inline ast::Expr* Parser::parse_bitwise_or() {
     auto left = parse_bitwise_xor();
 
     while (match(TokenType::BIT_OR)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_bitwise_xor();
-        left = std::make_shared<ast::BinOp>(left, ast::Operator::BitOr, right, token.line, token.column);
+        left = arena_->make<ast::BinOp>(left, ast::Operator::BitOr, right, token.line, token.column);
     }
 
     return left;
 }
 
 // ^
-inline std::shared_ptr<ast::Expr> Parser::parse_bitwise_xor() {
+inline ast::Expr* Parser::parse_bitwise_xor() {
     auto left = parse_bitwise_and();
 
     while (match(TokenType::BIT_XOR)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_bitwise_and();
-        left = std::make_shared<ast::BinOp>(left, ast::Operator::BitXor, right, token.line, token.column);
+        left = arena_->make<ast::BinOp>(left, ast::Operator::BitXor, right, token.line, token.column);
     }
 
     return left;
 }
 
 // &
-inline std::shared_ptr<ast::Expr> Parser::parse_bitwise_and() {
+inline ast::Expr* Parser::parse_bitwise_and() {
     auto left = parse_shift_expr();
 
     while (match(TokenType::BIT_AND)) {
         Token token = tokens_[current_token_ - 1];
         auto right = parse_shift_expr();
-        left = std::make_shared<ast::BinOp>(left, ast::Operator::BitAnd, right, token.line, token.column);
+        left = arena_->make<ast::BinOp>(left, ast::Operator::BitAnd, right, token.line, token.column);
     }
 
     return left;
 }
 
 // <<, >>
-inline std::shared_ptr<ast::Expr> Parser::parse_shift_expr() {
+inline ast::Expr* Parser::parse_shift_expr() {
     auto left = parse_sum();
 
     while (true) {
@@ -1308,14 +1495,14 @@ inline std::shared_ptr<ast::Expr> Parser::parse_shift_expr() {
             break;
         }
         auto right = parse_sum();
-        left = std::make_shared<ast::BinOp>(left, op, right, token.line, token.column);
+        left = arena_->make<ast::BinOp>(left, op, right, token.line, token.column);
     }
 
     return left;
 }
 
 // +, -
-inline std::shared_ptr<ast::Expr> Parser::parse_sum() {
+inline ast::Expr* Parser::parse_sum() {
     auto left = parse_term();
 
     while (true) {
@@ -1329,14 +1516,14 @@ inline std::shared_ptr<ast::Expr> Parser::parse_sum() {
             break;
         }
         auto right = parse_term();
-        left = std::make_shared<ast::BinOp>(left, op, right, token.line, token.column);
+        left = arena_->make<ast::BinOp>(left, op, right, token.line, token.column);
     }
 
     return left;
 }
 
 // *, /, %, //
-inline std::shared_ptr<ast::Expr> Parser::parse_term() {
+inline ast::Expr* Parser::parse_term() {
     auto left = parse_factor();
 
     while (true) {
@@ -1356,26 +1543,26 @@ inline std::shared_ptr<ast::Expr> Parser::parse_term() {
             break;
         }
         auto right = parse_factor();
-        left = std::make_shared<ast::BinOp>(left, op, right, token.line, token.column);
+        left = arena_->make<ast::BinOp>(left, op, right, token.line, token.column);
     }
 
     return left;
 }
 
 // **, unary +, -, ~
-inline std::shared_ptr<ast::Expr> Parser::parse_factor() {
+inline ast::Expr* Parser::parse_factor() {
     Token token = current();
 
     // Unary operators
     if (match(TokenType::PLUS)) {
         auto operand = parse_factor();
-        return std::make_shared<ast::UnaryOp>(ast::UnaryOp::UnaryOpType::UAdd, operand, token.line, token.column);
+        return arena_->make<ast::UnaryOp>(ast::UnaryOp::UnaryOpType::UAdd, operand, token.line, token.column);
     } else if (match(TokenType::MINUS)) {
         auto operand = parse_factor();
-        return std::make_shared<ast::UnaryOp>(ast::UnaryOp::UnaryOpType::USub, operand, token.line, token.column);
+        return arena_->make<ast::UnaryOp>(ast::UnaryOp::UnaryOpType::USub, operand, token.line, token.column);
     } else if (match(TokenType::BIT_NOT)) {
         auto operand = parse_factor();
-        return std::make_shared<ast::UnaryOp>(ast::UnaryOp::UnaryOpType::Invert, operand, token.line, token.column);
+        return arena_->make<ast::UnaryOp>(ast::UnaryOp::UnaryOpType::Invert, operand, token.line, token.column);
     }
 
     // Power operator (right-associative)
@@ -1384,20 +1571,20 @@ inline std::shared_ptr<ast::Expr> Parser::parse_factor() {
     if (match(TokenType::POWER)) {
         Token pow_token = tokens_[current_token_ - 1];
         auto right = parse_factor(); // Right-associative
-        return std::make_shared<ast::BinOp>(left, ast::Operator::Pow, right, pow_token.line, pow_token.column);
+        return arena_->make<ast::BinOp>(left, ast::Operator::Pow, right, pow_token.line, pow_token.column);
     }
 
     return left;
 }
 
 // Parse atom (lowest level of primary)
-inline std::shared_ptr<ast::Expr> Parser::parse_atom() {
+inline ast::Expr* Parser::parse_atom() {
     Token token = current();
 
     if (match(TokenType::NUMBER)) {
-        return std::make_shared<ast::Constant>(token.value, token.line, token.column);
+        return arena_->make<ast::Constant>(token.text(), token.line, token.column);
     } else if (match(TokenType::STRING)) {
-        return std::make_shared<ast::Constant>(token.value, token.line, token.column);
+        return arena_->make<ast::Constant>(token.text(), token.line, token.column, true);
     } else if (current().type == TokenType::FSTRING_START) {
         // F-string - don't use match() because parse_fstring() expects to see FSTRING_START
         return parse_fstring();
@@ -1405,11 +1592,11 @@ inline std::shared_ptr<ast::Expr> Parser::parse_atom() {
         // T-string (PEP 750) - don't use match() because parse_tstring() expects to see TSTRING_START
         return parse_tstring();
     } else if (match(TokenType::TRUE)) {
-        return std::make_shared<ast::Constant>("True", token.line, token.column);
+        return arena_->make<ast::Constant>("True", token.line, token.column);
     } else if (match(TokenType::FALSE)) {
-        return std::make_shared<ast::Constant>("False", token.line, token.column);
+        return arena_->make<ast::Constant>("False", token.line, token.column);
     } else if (match(TokenType::NONE)) {
-        return std::make_shared<ast::Constant>("None", token.line, token.column);
+        return arena_->make<ast::Constant>("None", token.line, token.column);
     } else if (match(TokenType::LBRACKET)) {
         std::cerr << "[DEBUG parse_atom] Matched LBRACKET, calling parse_list(), token=" << current_token_
                   << ", type=" << static_cast<int>(current().type) << std::endl;
@@ -1426,27 +1613,27 @@ inline std::shared_ptr<ast::Expr> Parser::parse_atom() {
     } else if (match(TokenType::AWAIT)) {
         // Await expression (Python 3.5+)
         auto value = parse_primary();
-        return std::make_shared<ast::Await>(value, token.line, token.column);
+        return arena_->make<ast::Await>(value, token.line, token.column);
     } else if (current().type == TokenType::ELLIPSIS) {
         // Ellipsis expression - token already matched, just create the node
         Token ellipsis_token = current();
         advance();  // consume ELLIPSIS token
-        return std::make_shared<ast::Ellipsis>(ellipsis_token.line, ellipsis_token.column);
+        return arena_->make<ast::Ellipsis>(ellipsis_token.line, ellipsis_token.column);
     } else if (match(TokenType::IDENTIFIER)) {
         // Create name, but don't handle call here - let parse_primary handle it
-        return std::make_shared<ast::Name>(token.value, ast::ExprContext::Load,
+        return arena_->make<ast::Name>(token.text(), ast::ExprContext::Load,
                                            token.line, token.column);
     } else if (match(TokenType::MATCH) || match(TokenType::CASE)) {
         // Soft keywords: match and case can be used as identifiers in expressions
         // This allows code like: if (match := find()) or case = 1
-        return std::make_shared<ast::Name>(token.value, ast::ExprContext::Load,
+        return arena_->make<ast::Name>(token.text(), ast::ExprContext::Load,
                                            token.line, token.column);
     } else if (match(TokenType::LPAREN)) {
         // Check if it's a tuple, generator expression, or parenthesized expression
         if (current().type == TokenType::RPAREN) {
             // Empty tuple
             advance();
-            return std::make_shared<ast::Tuple>(std::vector<std::shared_ptr<ast::Expr>>(),
+            return arena_->make<ast::Tuple>(std::vector<ast::Expr*>(),
                                                 ast::ExprContext::Load, token.line, token.column);
         }
 
@@ -1458,12 +1645,12 @@ inline std::shared_ptr<ast::Expr> Parser::parse_atom() {
             if (!match(TokenType::RPAREN)) {
                 error("Expected ')' after generator expression");
             }
-            return std::make_shared<ast::GeneratorExp>(expr, generators, token.line, token.column);
+            return arena_->make<ast::GeneratorExp>(expr, generators, token.line, token.column);
         }
 
         // Check if it's a tuple (comma after expression)
         if (match(TokenType::COMMA)) {
-            std::vector<std::shared_ptr<ast::Expr>> elts = {expr};
+            std::vector<ast::Expr*> elts = {expr};
             while (current().type != TokenType::RPAREN) {
                 elts.push_back(parse_expr());
                 if (!match(TokenType::COMMA)) {
@@ -1473,7 +1660,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_atom() {
             if (!match(TokenType::RPAREN)) {
                 error("Expected ')'");
             }
-            return std::make_shared<ast::Tuple>(elts, ast::ExprContext::Load, token.line, token.column);
+            return arena_->make<ast::Tuple>(elts, ast::ExprContext::Load, token.line, token.column);
         }
 
         if (!match(TokenType::RPAREN)) {
@@ -1487,7 +1674,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_atom() {
 }
 
 // Parse f-string: FSTRING_START (FSTRING_MIDDLE | formatted_value)* FSTRING_END
-inline std::shared_ptr<ast::Expr> Parser::parse_fstring() {
+inline ast::Expr* Parser::parse_fstring() {
     Token start_token = current();
     if (start_token.type != TokenType::FSTRING_START) {
         error("Expected FSTRING_START");
@@ -1495,12 +1682,12 @@ inline std::shared_ptr<ast::Expr> Parser::parse_fstring() {
     }
     advance();  // consume FSTRING_START
 
-    std::vector<std::shared_ptr<ast::Expr>> values;
+    std::vector<ast::Expr*> values;
 
     // Add initial string part if present
     if (!start_token.value.empty()) {
-        values.push_back(std::make_shared<ast::Constant>(
-            start_token.value, start_token.line, start_token.column));
+        values.push_back(arena_->make<ast::Constant>(
+            start_token.text(), start_token.line, start_token.column, true));
     }
 
     // Parse alternating FSTRING_MIDDLE and formatted_value until FSTRING_END
@@ -1510,8 +1697,8 @@ inline std::shared_ptr<ast::Expr> Parser::parse_fstring() {
             Token middle = current();
             advance();
             if (!middle.value.empty()) {
-                values.push_back(std::make_shared<ast::Constant>(
-                    middle.value, middle.line, middle.column));
+                values.push_back(arena_->make<ast::Constant>(
+                    middle.text(), middle.line, middle.column, true));
             }
         } else if (current().type == TokenType::LBRACE) {
             // Expression part: {expr!conversion:format_spec}
@@ -1523,21 +1710,20 @@ inline std::shared_ptr<ast::Expr> Parser::parse_fstring() {
     }
 
     // Parse FSTRING_END
-    Token end_token = current();
     advance();  // consume FSTRING_END
 
     // If we only have one constant value, return it directly (optimization)
     // Otherwise, return JoinedStr
     if (values.size() == 1 &&
-        std::dynamic_pointer_cast<ast::Constant>(values[0])) {
+        dynamic_cast<ast::Constant*>(values[0])) {
         return values[0];
     }
 
-    return std::make_shared<ast::JoinedStr>(values, start_token.line, start_token.column);
+    return arena_->make<ast::JoinedStr>(values, start_token.line, start_token.column);
 }
 
 // Parse formatted value: {expr [!conversion] [:format_spec]}
-inline std::shared_ptr<ast::Expr> Parser::parse_formatted_value() {
+inline ast::Expr* Parser::parse_formatted_value() {
     // Parse '{'
     Token lbrace = current();
     if (lbrace.type != TokenType::LBRACE) {
@@ -1549,13 +1735,13 @@ inline std::shared_ptr<ast::Expr> Parser::parse_formatted_value() {
     // Parse expression (can be any expression, including nested f-strings)
     // Now that we use EXCLAIM token for !, we can safely use parse_expr()
     // which supports full Python expressions including comparisons, and, or, not
-    std::shared_ptr<ast::Expr> value = parse_expr();
+    ast::Expr* value = parse_expr();
 
     // Parse optional conversion: !s, !r, !a
     int conversion = -1;
     if (match(TokenType::EXCLAIM)) {
         if (current().type == TokenType::IDENTIFIER) {
-            std::string conv_char = current().value;
+            std::string conv_char = current().text();
             if (conv_char == "s") {
                 conversion = 115;
             } else if (conv_char == "r") {
@@ -1574,7 +1760,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_formatted_value() {
     }
 
     // Parse optional format specifier: :format_spec
-    std::shared_ptr<ast::Expr> format_spec = nullptr;
+    ast::Expr* format_spec = nullptr;
     if (match(TokenType::COLON)) {
         format_spec = parse_fstring_format_spec();
     }
@@ -1585,13 +1771,13 @@ inline std::shared_ptr<ast::Expr> Parser::parse_formatted_value() {
         return nullptr;
     }
 
-    return std::make_shared<ast::FormattedValue>(
+    return arena_->make<ast::FormattedValue>(
         value, conversion, format_spec, lbrace.line, lbrace.column);
 }
 
 // Parse format specifier: can contain FSTRING_MIDDLE/TSTRING_MIDDLE tokens and nested formatted_value/interpolation
-inline std::shared_ptr<ast::Expr> Parser::parse_fstring_format_spec() {
-    std::vector<std::shared_ptr<ast::Expr>> values;
+inline ast::Expr* Parser::parse_fstring_format_spec() {
+    std::vector<ast::Expr*> values;
 
     // Parse format spec parts until we see } (end of formatted value)
     // We need to track when we're done - the } will be consumed by parse_formatted_value/parse_interpolation
@@ -1602,8 +1788,8 @@ inline std::shared_ptr<ast::Expr> Parser::parse_fstring_format_spec() {
             Token middle = current();
             advance();
             if (!middle.value.empty()) {
-                values.push_back(std::make_shared<ast::Constant>(
-                    middle.value, middle.line, middle.column));
+                values.push_back(arena_->make<ast::Constant>(
+                    middle.text(), middle.line, middle.column, true));
             }
         } else if (current().type == TokenType::LBRACE) {
             // Nested f-string/t-string replacement field in format spec
@@ -1616,7 +1802,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_fstring_format_spec() {
 
     // If we only have one constant value, return it directly
     if (values.size() == 1 &&
-        std::dynamic_pointer_cast<ast::Constant>(values[0])) {
+        dynamic_cast<ast::Constant*>(values[0])) {
         return values[0];
     }
 
@@ -1626,12 +1812,12 @@ inline std::shared_ptr<ast::Expr> Parser::parse_fstring_format_spec() {
     }
 
     // Otherwise return JoinedStr
-    return std::make_shared<ast::JoinedStr>(values, current().line, current().column);
+    return arena_->make<ast::JoinedStr>(values, current().line, current().column);
 }
 
 // Parse t-string (PEP 750): TSTRING_START (TSTRING_MIDDLE | interpolation)* TSTRING_END
 // T-strings are similar to f-strings but produce Template objects with Interpolation nodes
-inline std::shared_ptr<ast::Expr> Parser::parse_tstring() {
+inline ast::Expr* Parser::parse_tstring() {
     Token start_token = current();
     if (start_token.type != TokenType::TSTRING_START) {
         error("Expected TSTRING_START");
@@ -1639,12 +1825,12 @@ inline std::shared_ptr<ast::Expr> Parser::parse_tstring() {
     }
     advance();  // consume TSTRING_START
 
-    std::vector<std::shared_ptr<ast::Expr>> values;
+    std::vector<ast::Expr*> values;
 
     // Add initial string part if present
     if (!start_token.value.empty()) {
-        values.push_back(std::make_shared<ast::Constant>(
-            start_token.value, start_token.line, start_token.column));
+        values.push_back(arena_->make<ast::Constant>(
+            start_token.text(), start_token.line, start_token.column, true));
     }
 
     // Parse alternating TSTRING_MIDDLE and interpolation until TSTRING_END
@@ -1654,8 +1840,8 @@ inline std::shared_ptr<ast::Expr> Parser::parse_tstring() {
             Token middle = current();
             advance();
             if (!middle.value.empty()) {
-                values.push_back(std::make_shared<ast::Constant>(
-                    middle.value, middle.line, middle.column));
+                values.push_back(arena_->make<ast::Constant>(
+                    middle.text(), middle.line, middle.column, true));
             }
         } else if (current().type == TokenType::LBRACE) {
             // Interpolation part: {expr!conversion:format_spec}
@@ -1667,22 +1853,21 @@ inline std::shared_ptr<ast::Expr> Parser::parse_tstring() {
     }
 
     // Parse TSTRING_END
-    Token end_token = current();
     advance();  // consume TSTRING_END
 
     // If we only have one constant value, return it directly (optimization)
     // Otherwise, return TemplateStr
     if (values.size() == 1 &&
-        std::dynamic_pointer_cast<ast::Constant>(values[0])) {
+        dynamic_cast<ast::Constant*>(values[0])) {
         return values[0];
     }
 
-    return std::make_shared<ast::TemplateStr>(values, start_token.line, start_token.column);
+    return arena_->make<ast::TemplateStr>(values, start_token.line, start_token.column);
 }
 
 // Parse interpolation: {expr [!conversion] [:format_spec]}
 // Similar to FormattedValue but includes the original expression text
-inline std::shared_ptr<ast::Expr> Parser::parse_interpolation() {
+inline ast::Expr* Parser::parse_interpolation() {
     // Parse '{'
     Token lbrace = current();
     if (lbrace.type != TokenType::LBRACE) {
@@ -1695,7 +1880,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_interpolation() {
     advance();
 
     // Parse expression (can be any expression, including nested t-strings)
-    std::shared_ptr<ast::Expr> value = parse_expr();
+    ast::Expr* value = parse_expr();
     
     // Capture the expression text from tokens
     // We need to reconstruct the expression text from the tokens between { and !/:/ }
@@ -1725,7 +1910,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_interpolation() {
     int conversion = -1;
     if (match(TokenType::EXCLAIM)) {
         if (current().type == TokenType::IDENTIFIER) {
-            std::string conv_char = current().value;
+            std::string conv_char = current().text();
             if (conv_char == "s") {
                 conversion = 115;
             } else if (conv_char == "r") {
@@ -1745,7 +1930,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_interpolation() {
 
     // Parse optional format specifier: :format_spec
     // For t-strings, format_spec can be a JoinedStr (same as f-strings)
-    std::shared_ptr<ast::Expr> format_spec = nullptr;
+    ast::Expr* format_spec = nullptr;
     if (match(TokenType::COLON)) {
         // Reuse f-string format spec parsing for t-strings
         format_spec = parse_fstring_format_spec();
@@ -1757,13 +1942,13 @@ inline std::shared_ptr<ast::Expr> Parser::parse_interpolation() {
         return nullptr;
     }
 
-    return std::make_shared<ast::Interpolation>(
+    return arena_->make<ast::Interpolation>(
         value, expr_str, conversion, format_spec, lbrace.line, lbrace.column);
 }
 
 // Parse primary expression (handles left-recursive attribute, subscript, call)
 // primary: atom | primary '.' NAME | primary '[' expr ']' | primary '(' arguments ')'
-inline std::shared_ptr<ast::Expr> Parser::parse_primary() {
+inline ast::Expr* Parser::parse_primary() {
     // Start with atom
     auto expr = parse_atom();
 
@@ -1776,7 +1961,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_primary() {
             }
             Token attr_token = current();
             advance();
-            expr = std::make_shared<ast::Attribute>(expr, attr_token.value, ast::ExprContext::Load,
+            expr = arena_->make<ast::Attribute>(expr, attr_token.text(), ast::ExprContext::Load,
                                                     attr_token.line, attr_token.column);
         } else if (match(TokenType::LBRACKET)) {
             // Subscript: obj[key] or obj[start:end:step] or obj[type1, type2, ...]
@@ -1788,7 +1973,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_primary() {
             
             // Parse the subscript slice (single expr, tuple, or slice notation)
             // This new helper function handles all three cases
-            std::shared_ptr<ast::Expr> slice = parse_subscript_slice();
+            ast::Expr* slice = parse_subscript_slice();
             
             // Expect closing bracket
             if (!match(TokenType::RBRACKET)) {
@@ -1800,14 +1985,14 @@ inline std::shared_ptr<ast::Expr> Parser::parse_primary() {
             
             std::cerr << "[DEBUG parse_primary] Successfully parsed subscript" << std::endl;
             std::cerr.flush();
-            expr = std::make_shared<ast::Subscript>(expr, slice, ast::ExprContext::Load,
+            expr = arena_->make<ast::Subscript>(expr, slice, ast::ExprContext::Load,
                                                     expr->lineno(), expr->col_offset());
         } else if (current().type == TokenType::LPAREN) {
             // Function call: func(args) - matches CPython: primary '(' [arguments] ')'
             advance(); // consume '('
 
             // Parse arguments (optional) - matches CPython's arguments_rule
-            std::shared_ptr<ast::Call> call_args = nullptr;
+            ast::Call* call_args = nullptr;
             if (current().type != TokenType::RPAREN) {
                 call_args = parse_arguments();
             }
@@ -1818,11 +2003,11 @@ inline std::shared_ptr<ast::Expr> Parser::parse_primary() {
 
             // Create Call with the current expression as function
             // If call_args is null, use empty args; otherwise extract args from Call node
-            std::vector<std::shared_ptr<ast::Expr>> args;
+            std::vector<ast::Expr*> args;
             if (call_args) {
                 args = call_args->args();
             }
-            expr = std::make_shared<ast::Call>(expr, args, expr->lineno(), expr->col_offset());
+            expr = arena_->make<ast::Call>(expr, args, expr->lineno(), expr->col_offset());
         } else {
             // No more primary suffixes - exit the loop
             // This happens when we encounter a token that's not '.', '[', or '('
@@ -1835,7 +2020,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_primary() {
     return expr;
 }
 
-inline std::shared_ptr<ast::Expr> Parser::parse_list() {
+inline ast::Expr* Parser::parse_list() {
     Token token = tokens_[current_token_ - 1]; // LBRACKET token
 
     std::cerr << "[DEBUG parse_list] Starting at token " << current_token_
@@ -1848,7 +2033,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_list() {
         std::cerr << "[DEBUG parse_list] Empty list detected" << std::endl;
         std::cerr.flush();
         advance();
-        return std::make_shared<ast::List>(std::vector<std::shared_ptr<ast::Expr>>(),
+        return arena_->make<ast::List>(std::vector<ast::Expr*>(),
                                           ast::ExprContext::Load, token.line, token.column);
     }
 
@@ -1859,7 +2044,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_list() {
     std::cerr.flush();
 
     // Show next few tokens for context
-    for (size_t i = 0; i < 5 && (current_token_ + i) < tokens_.size(); i++) {
+    for (size_t i = 0; i < 5; i++) {
         std::cerr << "  [DEBUG parse_list] Token[" << (current_token_ + i) << "] = type="
                   << static_cast<int>(tokens_[current_token_ + i].type)
                   << ", value='" << tokens_[current_token_ + i].value << "'" << std::endl;
@@ -1872,7 +2057,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_list() {
               << ", value='" << current().value << "'" << std::endl;
 
     // Show next few tokens after parsing
-    for (size_t i = 0; i < 5 && (current_token_ + i) < tokens_.size(); i++) {
+    for (size_t i = 0; i < 5; i++) {
         std::cerr << "  [DEBUG parse_list] Token[" << (current_token_ + i) << "] = type="
                   << static_cast<int>(tokens_[current_token_ + i].type)
                   << ", value='" << tokens_[current_token_ + i].value << "'" << std::endl;
@@ -1888,13 +2073,13 @@ inline std::shared_ptr<ast::Expr> Parser::parse_list() {
         if (!match(TokenType::RBRACKET)) {
             error("Expected ']' after list comprehension");
         }
-        return std::make_shared<ast::ListComp>(elt, generators, token.line, token.column);
+        return arena_->make<ast::ListComp>(elt, generators, token.line, token.column);
     }
 
     // Regular list literal - we already have first element
     std::cerr << "[DEBUG parse_list] Regular list literal, checking for comma or ']'" << std::endl;
     std::cerr.flush();
-    std::vector<std::shared_ptr<ast::Expr>> elts = {elt};
+    std::vector<ast::Expr*> elts = {elt};
     while (match(TokenType::COMMA)) {
         std::cerr << "[DEBUG parse_list] Found comma, token=" << current_token_
                   << ", type=" << static_cast<int>(current().type) << std::endl;
@@ -1933,17 +2118,17 @@ inline std::shared_ptr<ast::Expr> Parser::parse_list() {
     std::cerr << "[DEBUG parse_list] Successfully matched ']'" << std::endl;
     std::cerr.flush();
 
-    return std::make_shared<ast::List>(elts, ast::ExprContext::Load, token.line, token.column);
+    return arena_->make<ast::List>(elts, ast::ExprContext::Load, token.line, token.column);
 }
 
-inline std::shared_ptr<ast::Expr> Parser::parse_dict() {
+inline ast::Expr* Parser::parse_dict() {
     Token token = tokens_[current_token_ - 1]; // LBRACE token
 
     // Check for empty dict/set
     if (current().type == TokenType::RBRACE) {
         advance();
-        return std::make_shared<ast::Dict>(std::vector<std::shared_ptr<ast::Expr>>(),
-                                          std::vector<std::shared_ptr<ast::Expr>>(),
+        return arena_->make<ast::Dict>(std::vector<ast::Expr*>(),
+                                          std::vector<ast::Expr*>(),
                                           token.line, token.column);
     }
 
@@ -1956,7 +2141,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_dict() {
         if (!match(TokenType::RBRACE)) {
             error("Expected '}' after set comprehension");
         }
-        return std::make_shared<ast::SetComp>(first_expr, generators, token.line, token.column);
+        return arena_->make<ast::SetComp>(first_expr, generators, token.line, token.column);
     }
 
     // Check if this is a dict (has colon) or set (has comma/rbrace)
@@ -1973,12 +2158,12 @@ inline std::shared_ptr<ast::Expr> Parser::parse_dict() {
             if (!match(TokenType::RBRACE)) {
                 error("Expected '}' after dict comprehension");
             }
-            return std::make_shared<ast::DictComp>(first_expr, value, generators, token.line, token.column);
+            return arena_->make<ast::DictComp>(first_expr, value, generators, token.line, token.column);
         }
         
         // Regular dict literal
-        std::vector<std::shared_ptr<ast::Expr>> keys = {first_expr};
-        std::vector<std::shared_ptr<ast::Expr>> values = {value};
+        std::vector<ast::Expr*> keys = {first_expr};
+        std::vector<ast::Expr*> values = {value};
         
         while (match(TokenType::COMMA)) {
             if (current().type == TokenType::RBRACE) {
@@ -1995,11 +2180,11 @@ inline std::shared_ptr<ast::Expr> Parser::parse_dict() {
             error("Expected '}'");
         }
         
-        return std::make_shared<ast::Dict>(keys, values, token.line, token.column);
+        return arena_->make<ast::Dict>(keys, values, token.line, token.column);
         
     } else if (current().type == TokenType::COMMA || current().type == TokenType::RBRACE) {
         // This is a set literal: {1, 2, 3} or {1}
-        std::vector<std::shared_ptr<ast::Expr>> elts = {first_expr};
+        std::vector<ast::Expr*> elts = {first_expr};
         
         while (match(TokenType::COMMA)) {
             if (current().type == TokenType::RBRACE) {
@@ -2012,7 +2197,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_dict() {
             error("Expected '}'");
         }
         
-        return std::make_shared<ast::Set>(elts, ast::ExprContext::Load, token.line, token.column);
+        return arena_->make<ast::Set>(elts, ast::ExprContext::Load, token.line, token.column);
         
     } else {
         error("Expected ':', ',' or '}' after expression in braces");
@@ -2020,23 +2205,23 @@ inline std::shared_ptr<ast::Expr> Parser::parse_dict() {
     }
 }
 
-inline std::shared_ptr<ast::Expr> Parser::parse_call() {
+inline ast::Expr* Parser::parse_call() {
     // We've already consumed the identifier, now parse the call
     Token func_token = tokens_[current_token_ - 1]; // Previous token was the function name
-    auto func = std::make_shared<ast::Name>(func_token.value, ast::ExprContext::Load,
+    auto func = arena_->make<ast::Name>(func_token.text(), ast::ExprContext::Load,
                                            func_token.line, func_token.column);
 
     if (!match(TokenType::LPAREN)) {
         error("Expected '(' in function call");
     }
 
-    std::vector<std::shared_ptr<ast::Expr>> args = parse_expr_list();
+    std::vector<ast::Expr*> args = parse_expr_list();
 
     if (!match(TokenType::RPAREN)) {
         error("Expected ')' in function call");
     }
 
-    return std::make_shared<ast::Call>(func, args, func_token.line, func_token.column);
+    return arena_->make<ast::Call>(func, args, func_token.line, func_token.column);
 }
 
 inline std::vector<ast::arg> Parser::parse_arg_list() {
@@ -2065,11 +2250,11 @@ inline std::vector<ast::arg> Parser::parse_arg_list() {
         if (current().type != TokenType::IDENTIFIER) {
             error("Expected argument name");
         }
-        std::string arg_name = current().value;
+        std::string arg_name = current().text();
         advance();
         
         // Check for type annotation: arg: type
-        std::shared_ptr<ast::Expr> annotation = nullptr;
+        ast::Expr* annotation = nullptr;
         if (current().type == TokenType::COLON) {
             advance();  // consume ':'
             annotation = parse_expr();
@@ -2090,7 +2275,7 @@ inline std::vector<ast::arg> Parser::parse_arg_list() {
 // CPython-style arguments parsing
 // arguments: args [','] &')' | invalid_arguments
 // This matches CPython's arguments_rule exactly
-inline std::shared_ptr<ast::Call> Parser::parse_arguments() {
+inline ast::Call* Parser::parse_arguments() {
     // Try to parse args [','] &')'
     size_t saved_pos = current_token_;
 
@@ -2116,14 +2301,14 @@ inline std::shared_ptr<ast::Call> Parser::parse_arguments() {
 
 // args: ','.(starred_expression | (assignment_expression | expression !':=') !'=')+ [',' kwargs] | kwargs
 // Simplified version matching CPython's args_rule
-inline std::shared_ptr<ast::Call> Parser::parse_args() {
-    std::vector<std::shared_ptr<ast::Expr>> exprs;
+inline ast::Call* Parser::parse_args() {
+    std::vector<ast::Expr*> exprs;
 
     // Parse comma-separated expressions (gather pattern: ','.expr+)
     if (current().type == TokenType::RPAREN) {
         // Empty args - return Call with empty args
-        return std::make_shared<ast::Call>(
-            std::make_shared<ast::Name>("", ast::ExprContext::Load, 0, 0),
+        return arena_->make<ast::Call>(
+            arena_->make<ast::Name>("", ast::ExprContext::Load, 0, 0),
             exprs, 0, 0);
     }
 
@@ -2138,7 +2323,7 @@ inline std::shared_ptr<ast::Call> Parser::parse_args() {
             // Parse as generator expression
             auto generators = parse_for_if_clauses();
             Token gen_token = tokens_[current_token_ - 1];
-            expr = std::make_shared<ast::GeneratorExp>(expr, generators, gen_token.line, gen_token.column);
+            expr = arena_->make<ast::GeneratorExp>(expr, generators, gen_token.line, gen_token.column);
         }
 
         exprs.push_back(expr);
@@ -2158,13 +2343,13 @@ inline std::shared_ptr<ast::Call> Parser::parse_args() {
     }
 
     // Return Call node with args (matches CPython's structure)
-    return std::make_shared<ast::Call>(
-        std::make_shared<ast::Name>("", ast::ExprContext::Load, 0, 0),
+    return arena_->make<ast::Call>(
+        arena_->make<ast::Name>("", ast::ExprContext::Load, 0, 0),
         exprs, 0, 0);
 }
 
 // Legacy function for backward compatibility
-inline std::vector<std::shared_ptr<ast::Expr>> Parser::parse_expr_list() {
+inline std::vector<ast::Expr*> Parser::parse_expr_list() {
     auto call_result = parse_args();
     if (call_result) {
         return call_result->args();
@@ -2177,12 +2362,12 @@ inline std::vector<std::shared_ptr<ast::Expr>> Parser::parse_expr_list() {
 
 // star_targets: star_target | star_target (',' star_target)* [',']
 // Returns a single target or a Tuple of targets
-inline std::shared_ptr<ast::Expr> Parser::parse_star_targets() {
+inline ast::Expr* Parser::parse_star_targets() {
     auto first = parse_star_target();
 
     if (current().type == TokenType::COMMA) {
         // Multiple targets - create a tuple
-        std::vector<std::shared_ptr<ast::Expr>> targets = {first};
+        std::vector<ast::Expr*> targets = {first};
         advance(); // consume comma
 
         while (current().type != TokenType::IN && current().type != TokenType::END_OF_FILE) {
@@ -2201,7 +2386,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_star_targets() {
 
         // Create Tuple node for multiple targets
         Token tuple_token = tokens_[current_token_ - 1]; // Use first target's token
-        return std::make_shared<ast::Tuple>(targets, ast::ExprContext::Store,
+        return arena_->make<ast::Tuple>(targets, ast::ExprContext::Store,
                                             tuple_token.line, tuple_token.column);
     }
 
@@ -2211,7 +2396,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_star_targets() {
 // star_target: '*' star_target | target_with_star_atom
 // Parses assignment targets including starred expressions (*rest)
 // Key: This must NOT parse 'in' as a comparison operator
-inline std::shared_ptr<ast::Expr> Parser::parse_star_target() {
+inline ast::Expr* Parser::parse_star_target() {
     Token token = current();
 
     // Check for '*' (starred target) - e.g., *rest in "a, *rest, b = items"
@@ -2223,15 +2408,15 @@ inline std::shared_ptr<ast::Expr> Parser::parse_star_target() {
         }
         Token name_token = current();
         advance();  // consume identifier
-        auto name = std::make_shared<ast::Name>(name_token.value, ast::ExprContext::Store,
+        auto name = arena_->make<ast::Name>(name_token.text(), ast::ExprContext::Store,
                                                name_token.line, name_token.column);
-        return std::make_shared<ast::Starred>(name, ast::ExprContext::Store,
+        return arena_->make<ast::Starred>(name, ast::ExprContext::Store,
                                               star_token.line, star_token.column);
     }
 
     // Parse as simple name (most common case: for x in ...)
     if (token.type == TokenType::IDENTIFIER) {
-        auto name = std::make_shared<ast::Name>(token.value, ast::ExprContext::Store,
+        auto name = arena_->make<ast::Name>(token.text(), ast::ExprContext::Store,
                                                token.line, token.column);
         advance();
         return name;
@@ -2244,12 +2429,12 @@ inline std::shared_ptr<ast::Expr> Parser::parse_star_target() {
 }
 
 // star_expressions: star_expression | star_expression (',' star_expression)+ [',']
-inline std::shared_ptr<ast::Expr> Parser::parse_star_expressions() {
+inline ast::Expr* Parser::parse_star_expressions() {
     auto first = parse_star_expression();
 
     if (current().type == TokenType::COMMA) {
         // Multiple expressions - create a tuple
-        std::vector<std::shared_ptr<ast::Expr>> exprs = {first};
+        std::vector<ast::Expr*> exprs = {first};
         advance(); // consume comma
 
         while (current().type != TokenType::COLON && current().type != TokenType::END_OF_FILE) {
@@ -2268,7 +2453,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_star_expressions() {
 
         // Create Tuple node for multiple expressions
         Token tuple_token = tokens_[current_token_ - 1]; // Use first expression's token
-        return std::make_shared<ast::Tuple>(exprs, ast::ExprContext::Load,
+        return arena_->make<ast::Tuple>(exprs, ast::ExprContext::Load,
                                             tuple_token.line, tuple_token.column);
     }
 
@@ -2280,14 +2465,14 @@ inline std::shared_ptr<ast::Expr> Parser::parse_star_expressions() {
 // In for loops, we use star_expressions which calls star_expression, which can be expression
 // The key is that expression will parse comparisons, but in the context of 'for x in y',
 // the 'in' is already consumed as a keyword, so expression parsing won't see it as comparison
-inline std::shared_ptr<ast::Expr> Parser::parse_star_expression() {
+inline ast::Expr* Parser::parse_star_expression() {
     // Check for '*' (starred expression) - e.g., *items in "[*items, extra]"
     if (current().type == TokenType::STAR) {
         Token star_token = current();
         advance();  // consume '*'
         // Parse the expression after the star (bitwise_or level, not full expression)
         auto value = parse_bitwise_or();
-        return std::make_shared<ast::Starred>(value, ast::ExprContext::Load,
+        return arena_->make<ast::Starred>(value, ast::ExprContext::Load,
                                               star_token.line, star_token.column);
     }
 
@@ -2298,7 +2483,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_star_expression() {
 
 // Try/except/finally parsing (matches CPython's try_stmt_rule, except_block_rule, finally_block_rule)
 // try_stmt: 'try' ':' block except_block+ else_block? finally_block? | 'try' ':' block finally_block
-inline std::shared_ptr<ast::Stmt> Parser::parse_try_stmt() {
+inline ast::Stmt* Parser::parse_try_stmt() {
     Token try_token = current();
     if (!match(TokenType::TRY)) {
         error("Expected 'try'");
@@ -2309,7 +2494,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_try_stmt() {
     }
 
     // Parse try block
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -2330,9 +2515,9 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_try_stmt() {
 
     // Determine if this is a regular try/except or try/except* (TryStar)
     size_t saved_pos = current_token_;
-    std::vector<std::shared_ptr<ast::ExceptHandler>> handlers;
-    std::vector<std::shared_ptr<ast::Stmt>> orelse;
-    std::vector<std::shared_ptr<ast::Stmt>> finalbody;
+    std::vector<ast::ExceptHandler*> handlers;
+    std::vector<ast::Stmt*> orelse;
+    std::vector<ast::Stmt*> finalbody;
     bool is_except_star = false;
 
     // Check if we have except* (look for EXCEPT followed by STAR)
@@ -2367,7 +2552,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_try_stmt() {
             error("Expected 'except*' block after try");
         }
 
-        return std::make_shared<ast::TryStar>(body, handlers, orelse, finalbody,
+        return arena_->make<ast::TryStar>(body, handlers, orelse, finalbody,
                                               try_token.line, try_token.column);
     } else {
         // Parse regular except blocks (Try)
@@ -2400,13 +2585,13 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_try_stmt() {
             }
         }
 
-        return std::make_shared<ast::Try>(body, handlers, orelse, finalbody,
+        return arena_->make<ast::Try>(body, handlers, orelse, finalbody,
                                           try_token.line, try_token.column);
     }
 }
 
 // except_block: 'except' expression? 'as' NAME? ':' block
-inline std::shared_ptr<ast::ExceptHandler> Parser::parse_except_block() {
+inline ast::ExceptHandler* Parser::parse_except_block() {
     size_t saved_pos = current_token_;
 
     if (!match(TokenType::EXCEPT)) {
@@ -2415,7 +2600,7 @@ inline std::shared_ptr<ast::ExceptHandler> Parser::parse_except_block() {
     }
 
     Token except_token = tokens_[saved_pos];
-    std::shared_ptr<ast::Expr> type = nullptr;
+    ast::Expr* type = nullptr;
     std::string name;
 
     // Parse exception type (optional)
@@ -2437,7 +2622,7 @@ inline std::shared_ptr<ast::ExceptHandler> Parser::parse_except_block() {
     }
 
     // Parse except block body
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -2456,14 +2641,14 @@ inline std::shared_ptr<ast::ExceptHandler> Parser::parse_except_block() {
         }
     }
 
-    return std::make_shared<ast::ExceptHandler>(type, name, body,
+    return arena_->make<ast::ExceptHandler>(type, name, body,
                                                  except_token.line, except_token.column);
 }
 
 // except_star_block: 'except' '*' expression ['as' NAME] ':' block
 // Python 3.11+ exception groups (PEP 654)
 // Note: Unlike regular except, except* REQUIRES an exception type
-inline std::shared_ptr<ast::ExceptHandler> Parser::parse_except_star_block() {
+inline ast::ExceptHandler* Parser::parse_except_star_block() {
     size_t saved_pos = current_token_;
 
     if (!match(TokenType::EXCEPT)) {
@@ -2479,7 +2664,7 @@ inline std::shared_ptr<ast::ExceptHandler> Parser::parse_except_star_block() {
         return nullptr;
     }
 
-    std::shared_ptr<ast::Expr> type = nullptr;
+    ast::Expr* type = nullptr;
     std::string name;
 
     // Parse exception type (REQUIRED for except*)
@@ -2503,7 +2688,7 @@ inline std::shared_ptr<ast::ExceptHandler> Parser::parse_except_star_block() {
     }
 
     // Parse except* block body
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -2522,13 +2707,13 @@ inline std::shared_ptr<ast::ExceptHandler> Parser::parse_except_star_block() {
         }
     }
 
-    return std::make_shared<ast::ExceptHandler>(type, name, body,
+    return arena_->make<ast::ExceptHandler>(type, name, body,
                                                  except_token.line, except_token.column);
 }
 
 // finally_block: 'finally' ':' block
-inline std::vector<std::shared_ptr<ast::Stmt>> Parser::parse_finally_block() {
-    std::vector<std::shared_ptr<ast::Stmt>> finalbody;
+inline std::vector<ast::Stmt*> Parser::parse_finally_block() {
+    std::vector<ast::Stmt*> finalbody;
 
     if (!match(TokenType::FINALLY)) {
         return finalbody;
@@ -2558,16 +2743,16 @@ inline std::vector<std::shared_ptr<ast::Stmt>> Parser::parse_finally_block() {
 
 // Class definition parsing (matches CPython's class_def_rule, class_def_raw_rule)
 // class_def_raw: 'class' NAME ['(' [arguments] ')'] ':' block
-inline std::shared_ptr<ast::Stmt> Parser::parse_class_def() {
+inline ast::Stmt* Parser::parse_class_def() {
     // Check for decorators first
-    std::vector<std::shared_ptr<ast::Expr>> decorators;
+    std::vector<ast::Expr*> decorators;
     if (current().type == TokenType::AT) {
         decorators = parse_decorators();
     }
     auto class_def = parse_class_def_raw();
     // Apply decorators if any
-    if (auto cls = std::dynamic_pointer_cast<ast::ClassDef>(class_def)) {
-        return std::make_shared<ast::ClassDef>(
+    if (auto cls = dynamic_cast<ast::ClassDef*>(class_def)) {
+        return arena_->make<ast::ClassDef>(
             cls->name(), cls->bases(), cls->body(), decorators,
             cls->type_params(),  // PEP 695: preserve type params
             cls->lineno(), cls->col_offset());
@@ -2575,7 +2760,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_class_def() {
     return class_def;
 }
 
-inline std::shared_ptr<ast::Stmt> Parser::parse_class_def_raw() {
+inline ast::Stmt* Parser::parse_class_def_raw() {
     Token class_token = current();
     if (!match(TokenType::CLASS)) {
         error("Expected 'class'");
@@ -2584,12 +2769,11 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_class_def_raw() {
     if (current().type != TokenType::IDENTIFIER) {
         error("Expected class name");
     }
-    std::string name = current().value;
-    Token name_token = current();
+    std::string name = current().text();
     advance();
 
     // PEP 695: Parse optional type parameters: [T], [K, V], etc.
-    std::vector<std::shared_ptr<ast::TypeParam>> type_params;
+    std::vector<ast::TypeParam*> type_params;
     if (current().type == TokenType::LBRACKET) {
         std::cerr << "[DEBUG parse_class_def_raw] Found type params, parsing..." << std::endl;
         type_params = parse_type_params();
@@ -2597,7 +2781,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_class_def_raw() {
     }
 
     // Parse optional base classes: ['(' [arguments] ')']
-    std::vector<std::shared_ptr<ast::Expr>> bases;
+    std::vector<ast::Expr*> bases;
     if (match(TokenType::LPAREN)) {
         if (current().type != TokenType::RPAREN) {
             // Parse arguments (bases and keywords)
@@ -2618,7 +2802,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_class_def_raw() {
     }
 
     // Parse class body
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (!is_at_end() && current().type != TokenType::END_OF_FILE) {
         if (current().type == TokenType::NEWLINE) {
             advance();
@@ -2633,14 +2817,14 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_class_def_raw() {
         }
     }
 
-    return std::make_shared<ast::ClassDef>(name, bases, body, std::vector<std::shared_ptr<ast::Expr>>(),
+    return arena_->make<ast::ClassDef>(name, bases, body, std::vector<ast::Expr*>(),
                                           type_params,  // PEP 695: Generic type parameters
                                           class_token.line, class_token.column);
 }
 
 // Import statement parsing (matches CPython's import_stmt_rule, import_name_rule, import_from_rule)
 // import_stmt: import_name | import_from
-inline std::shared_ptr<ast::Stmt> Parser::parse_import_stmt() {
+inline ast::Stmt* Parser::parse_import_stmt() {
     if (current().type == TokenType::IMPORT) {
         return parse_import_name();
     } else if (current().type == TokenType::FROM) {
@@ -2652,18 +2836,18 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_import_stmt() {
 }
 
 // import_name: 'import' dotted_as_names
-inline std::shared_ptr<ast::Stmt> Parser::parse_import_name() {
+inline ast::Stmt* Parser::parse_import_name() {
     Token import_token = current();
     if (!match(TokenType::IMPORT)) {
         error("Expected 'import'");
     }
 
     auto names = parse_dotted_as_names();
-    return std::make_shared<ast::Import>(names, import_token.line, import_token.column);
+    return arena_->make<ast::Import>(names, import_token.line, import_token.column);
 }
 
 // import_from: 'from' ('.' | '...')* dotted_name? 'import' import_from_targets
-inline std::shared_ptr<ast::Stmt> Parser::parse_import_from() {
+inline ast::Stmt* Parser::parse_import_from() {
     Token from_token = current();
     if (!match(TokenType::FROM)) {
         error("Expected 'from'");
@@ -2692,27 +2876,27 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_import_from() {
     }
 
     auto names = parse_import_from_targets();
-    return std::make_shared<ast::ImportFrom>(module, names, level,
+    return arena_->make<ast::ImportFrom>(module, names, level,
                                             from_token.line, from_token.column);
 }
 
 // dotted_name: NAME ('.' NAME)*
-inline std::shared_ptr<ast::Expr> Parser::parse_dotted_name() {
+inline ast::Expr* Parser::parse_dotted_name() {
     if (current().type != TokenType::IDENTIFIER) {
         return nullptr;
     }
 
     Token first_token = current();
-    std::string name = current().value;
+    std::string name = current().text();
     advance();
 
     // For now, just return the first name (full dotted name parsing not yet implemented)
-    return std::make_shared<ast::Name>(name, ast::ExprContext::Load,
+    return arena_->make<ast::Name>(name, ast::ExprContext::Load,
                                       first_token.line, first_token.column);
 }
 
 // dotted_as_name: dotted_name ['as' NAME]
-inline std::shared_ptr<ast::Alias> Parser::parse_dotted_as_name() {
+inline ast::Alias* Parser::parse_dotted_as_name() {
     size_t saved_pos = current_token_;
     auto dotted = parse_dotted_name();
     if (!dotted) {
@@ -2722,7 +2906,7 @@ inline std::shared_ptr<ast::Alias> Parser::parse_dotted_as_name() {
     Token alias_token = tokens_[saved_pos];
     // Extract name from Name node (simplified - full dotted name would be more complex)
     std::string name;
-    if (auto name_node = std::dynamic_pointer_cast<ast::Name>(dotted)) {
+    if (auto name_node = dynamic_cast<ast::Name*>(dotted)) {
         name = name_node->id();
     } else {
         name = dotted->to_string(); // Fallback
@@ -2737,12 +2921,12 @@ inline std::shared_ptr<ast::Alias> Parser::parse_dotted_as_name() {
         advance();
     }
 
-    return std::make_shared<ast::Alias>(name, asname, alias_token.line, alias_token.column);
+    return arena_->make<ast::Alias>(name, asname, alias_token.line, alias_token.column);
 }
 
 // dotted_as_names: ','.dotted_as_name+
-inline std::vector<std::shared_ptr<ast::Alias>> Parser::parse_dotted_as_names() {
-    std::vector<std::shared_ptr<ast::Alias>> names;
+inline std::vector<ast::Alias*> Parser::parse_dotted_as_names() {
+    std::vector<ast::Alias*> names;
 
     while (true) {
         auto alias = parse_dotted_as_name();
@@ -2762,13 +2946,13 @@ inline std::vector<std::shared_ptr<ast::Alias>> Parser::parse_dotted_as_names()
 }
 
 // import_from_as_name: NAME ['as' NAME]
-inline std::shared_ptr<ast::Alias> Parser::parse_import_from_as_name() {
+inline ast::Alias* Parser::parse_import_from_as_name() {
     if (current().type != TokenType::IDENTIFIER) {
         return nullptr;
     }
 
     Token name_token = current();
-    std::string name = current().value;
+    std::string name = current().text();
     advance();
 
     std::string asname;
@@ -2780,12 +2964,12 @@ inline std::shared_ptr<ast::Alias> Parser::parse_import_from_as_name() {
         advance();
     }
 
-    return std::make_shared<ast::Alias>(name, asname, name_token.line, name_token.column);
+    return arena_->make<ast::Alias>(name, asname, name_token.line, name_token.column);
 }
 
 // import_from_as_names: ','.import_from_as_name+
-inline std::vector<std::shared_ptr<ast::Alias>> Parser::parse_import_from_as_names() {
-    std::vector<std::shared_ptr<ast::Alias>> names;
+inline std::vector<ast::Alias*> Parser::parse_import_from_as_names() {
+    std::vector<ast::Alias*> names;
 
     while (true) {
         auto alias = parse_import_from_as_name();
@@ -2805,13 +2989,13 @@ inline std::vector<std::shared_ptr<ast::Alias>> Parser::parse_import_from_as_nam
 }
 
 // import_from_targets: '(' import_from_as_names [','] ')' | import_from_as_names !',' | '*'
-inline std::vector<std::shared_ptr<ast::Alias>> Parser::parse_import_from_targets() {
+inline std::vector<ast::Alias*> Parser::parse_import_from_targets() {
     // Check for '*'
     if (current().type == TokenType::STAR) {
         advance();
         // Return special alias for star import
         Token star_token = tokens_[current_token_ - 1];
-        return {std::make_shared<ast::Alias>("*", "", star_token.line, star_token.column)};
+        return {arena_->make<ast::Alias>("*", "", star_token.line, star_token.column)};
     }
 
     // Check for parenthesized import
@@ -2832,23 +3016,23 @@ inline std::vector<std::shared_ptr<ast::Alias>> Parser::parse_import_from_target
 
 // Simple statement parsing (matches CPython's pass_stmt_rule, raise_stmt_rule, etc.)
 // pass_stmt: 'pass'
-inline std::shared_ptr<ast::Stmt> Parser::parse_pass_stmt() {
+inline ast::Stmt* Parser::parse_pass_stmt() {
     Token pass_token = current();
     if (!match(TokenType::PASS)) {
         error("Expected 'pass'");
     }
-    return std::make_shared<ast::Pass>(pass_token.line, pass_token.column);
+    return arena_->make<ast::Pass>(pass_token.line, pass_token.column);
 }
 
 // raise_stmt: 'raise' expression? 'from' expression? | 'raise' expression? | 'raise'
-inline std::shared_ptr<ast::Stmt> Parser::parse_raise_stmt() {
+inline ast::Stmt* Parser::parse_raise_stmt() {
     Token raise_token = current();
     if (!match(TokenType::RAISE)) {
         error("Expected 'raise'");
     }
 
-    std::shared_ptr<ast::Expr> exc = nullptr;
-    std::shared_ptr<ast::Expr> cause = nullptr;
+    ast::Expr* exc = nullptr;
+    ast::Expr* cause = nullptr;
 
     // Parse optional exception expression
     if (current().type != TokenType::NEWLINE && current().type != TokenType::END_OF_FILE) {
@@ -2864,19 +3048,19 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_raise_stmt() {
         cause = parse_expr();
     }
 
-    return std::make_shared<ast::Raise>(exc, cause, raise_token.line, raise_token.column);
+    return arena_->make<ast::Raise>(exc, cause, raise_token.line, raise_token.column);
 }
 
 // del_stmt: 'del' del_targets
 // Simplified: use star_targets for now (del_targets is similar)
-inline std::shared_ptr<ast::Stmt> Parser::parse_del_stmt() {
+inline ast::Stmt* Parser::parse_del_stmt() {
     Token del_token = current();
     if (!match(TokenType::DEL)) {
         error("Expected 'del'");
     }
 
     // Parse targets (comma-separated)
-    std::vector<std::shared_ptr<ast::Expr>> targets;
+    std::vector<ast::Expr*> targets;
     while (true) {
         // For now, parse as star_targets (del_targets is similar but with Del context)
         auto target = parse_star_targets();
@@ -2889,29 +3073,29 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_del_stmt() {
         }
     }
 
-    return std::make_shared<ast::Delete>(targets, del_token.line, del_token.column);
+    return arena_->make<ast::Delete>(targets, del_token.line, del_token.column);
 }
 
 // assert_stmt: 'assert' expression [',' expression]
-inline std::shared_ptr<ast::Stmt> Parser::parse_assert_stmt() {
+inline ast::Stmt* Parser::parse_assert_stmt() {
     Token assert_token = current();
     if (!match(TokenType::ASSERT)) {
         error("Expected 'assert'");
     }
 
     auto test = parse_expr();
-    std::shared_ptr<ast::Expr> msg = nullptr;
+    ast::Expr* msg = nullptr;
 
     // Parse optional message
     if (match(TokenType::COMMA)) {
         msg = parse_expr();
     }
 
-    return std::make_shared<ast::Assert>(test, msg, assert_token.line, assert_token.column);
+    return arena_->make<ast::Assert>(test, msg, assert_token.line, assert_token.column);
 }
 
 // global_stmt: 'global' ','.NAME+
-inline std::shared_ptr<ast::Stmt> Parser::parse_global_stmt() {
+inline ast::Stmt* Parser::parse_global_stmt() {
     Token global_token = current();
     if (!match(TokenType::GLOBAL)) {
         error("Expected 'global'");
@@ -2922,7 +3106,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_global_stmt() {
         if (current().type != TokenType::IDENTIFIER) {
             error("Expected identifier in global statement");
         }
-        names.push_back(current().value);
+        names.push_back(current().text());
         advance();
 
         if (match(TokenType::COMMA)) {
@@ -2932,11 +3116,11 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_global_stmt() {
         }
     }
 
-    return std::make_shared<ast::Global>(names, global_token.line, global_token.column);
+    return arena_->make<ast::Global>(names, global_token.line, global_token.column);
 }
 
 // nonlocal_stmt: 'nonlocal' ','.NAME+
-inline std::shared_ptr<ast::Stmt> Parser::parse_nonlocal_stmt() {
+inline ast::Stmt* Parser::parse_nonlocal_stmt() {
     Token nonlocal_token = current();
     if (!match(TokenType::NONLOCAL)) {
         error("Expected 'nonlocal'");
@@ -2947,7 +3131,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_nonlocal_stmt() {
         if (current().type != TokenType::IDENTIFIER) {
             error("Expected identifier in nonlocal statement");
         }
-        names.push_back(current().value);
+        names.push_back(current().text());
         advance();
 
         if (match(TokenType::COMMA)) {
@@ -2957,12 +3141,12 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_nonlocal_stmt() {
         }
     }
 
-    return std::make_shared<ast::Nonlocal>(names, nonlocal_token.line, nonlocal_token.column);
+    return arena_->make<ast::Nonlocal>(names, nonlocal_token.line, nonlocal_token.column);
 }
 
 // with_stmt: 'with' ( '(' ','.with_item+ ','? ')' | ','.with_item+ ) ':' block
 // Matches CPython's with_stmt_rule
-inline std::shared_ptr<ast::Stmt> Parser::parse_with_stmt() {
+inline ast::Stmt* Parser::parse_with_stmt() {
     Token with_token = current();
     if (!match(TokenType::WITH)) {
         error("Expected 'with'");
@@ -2998,18 +3182,18 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_with_stmt() {
     }
 
     // Parse body
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (current().type != TokenType::END_OF_FILE &&
            current().type != TokenType::DEDENT &&
            current().type != TokenType::NEWLINE) {
         body.push_back(parse_stmt());
     }
 
-    return std::make_shared<ast::With>(items, body, with_token.line, with_token.column);
+    return arena_->make<ast::With>(items, body, with_token.line, with_token.column);
 }
 
 // Parse async with statement (Python 3.5+)
-inline std::shared_ptr<ast::Stmt> Parser::parse_async_with() {
+inline ast::Stmt* Parser::parse_async_with() {
     Token async_token = tokens_[current_token_ - 1]; // 'async' was already consumed
     if (!match(TokenType::WITH)) {
         error("Expected 'with' after 'async'");
@@ -3045,14 +3229,14 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_async_with() {
     }
 
     // Parse body
-    std::vector<std::shared_ptr<ast::Stmt>> body;
+    std::vector<ast::Stmt*> body;
     while (current().type != TokenType::END_OF_FILE &&
            current().type != TokenType::DEDENT &&
            current().type != TokenType::NEWLINE) {
         body.push_back(parse_stmt());
     }
 
-    return std::make_shared<ast::AsyncWith>(items, body, async_token.line, async_token.column);
+    return arena_->make<ast::AsyncWith>(items, body, async_token.line, async_token.column);
 }
 
 // with_item: expression ['as' star_target]
@@ -3062,7 +3246,7 @@ inline ast::WithItem Parser::parse_with_item() {
     auto context_expr = parse_expr();
 
     // Optional 'as' target
-    std::shared_ptr<ast::Expr> optional_vars = nullptr;
+    ast::Expr* optional_vars = nullptr;
     if (match(TokenType::AS)) {
         // Parse target (use star_target for now, simplified)
         optional_vars = parse_star_target();
@@ -3074,7 +3258,7 @@ inline ast::WithItem Parser::parse_with_item() {
 // lambdef: 'lambda' [lambda_params] ':' expression
 // Simplified: lambda [arg_list] ':' expression
 // Note: This function is called after 'lambda' token has already been matched
-inline std::shared_ptr<ast::Expr> Parser::parse_lambda() {
+inline ast::Expr* Parser::parse_lambda() {
     Token lambda_token = tokens_[current_token_ - 1]; // Get the lambda token we just matched
 
     // Parse optional parameters (lambda doesn't support annotations yet)
@@ -3082,7 +3266,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_lambda() {
     if (current().type != TokenType::COLON) {
         // Parse simple argument names (no annotations for lambda)
         while (current().type == TokenType::IDENTIFIER) {
-            args.push_back(current().value);
+            args.push_back(current().text());
             advance();
             if (!match(TokenType::COMMA)) break;
         }
@@ -3096,23 +3280,23 @@ inline std::shared_ptr<ast::Expr> Parser::parse_lambda() {
     // Parse body expression
     auto body = parse_expr();
 
-    return std::make_shared<ast::Lambda>(args, body, lambda_token.line, lambda_token.column);
+    return arena_->make<ast::Lambda>(args, body, lambda_token.line, lambda_token.column);
 }
 
 // yield_expr: 'yield' ['from' expression | star_expressions]
 // Matches CPython's yield_expr rule
 // Note: This function is called after 'yield' token has already been matched
-inline std::shared_ptr<ast::Expr> Parser::parse_yield_expr() {
+inline ast::Expr* Parser::parse_yield_expr() {
     Token yield_token = tokens_[current_token_ - 1]; // Get the yield token we just matched
 
     // Check for 'yield from'
     if (match(TokenType::FROM)) {
         auto value = parse_expr();
-        return std::make_shared<ast::YieldFrom>(value, yield_token.line, yield_token.column);
+        return arena_->make<ast::YieldFrom>(value, yield_token.line, yield_token.column);
     }
 
     // Optional value (star_expressions)
-    std::shared_ptr<ast::Expr> value = nullptr;
+    ast::Expr* value = nullptr;
     if (current().type != TokenType::NEWLINE &&
         current().type != TokenType::END_OF_FILE &&
         current().type != TokenType::COMMA &&
@@ -3123,7 +3307,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_yield_expr() {
         value = parse_star_expression();
     }
 
-    return std::make_shared<ast::Yield>(value, yield_token.line, yield_token.column);
+    return arena_->make<ast::Yield>(value, yield_token.line, yield_token.column);
 }
 
 // for_if_clauses: for_if_clause+
@@ -3176,7 +3360,7 @@ inline ast::Comprehension Parser::parse_for_if_clause() {
     auto iter = parse_expr();  // Use parse_expr() which handles disjunction
 
     // Parse optional if conditions
-    std::vector<std::shared_ptr<ast::Expr>> ifs;
+    std::vector<ast::Expr*> ifs;
     while (match(TokenType::IF)) {
         ifs.push_back(parse_expr());
     }
@@ -3188,7 +3372,7 @@ inline ast::Comprehension Parser::parse_for_if_clause() {
 // Matches CPython's slice_rule: expression? ':' expression? [':' expression?] OR named_expression
 // Returns nullptr if not a slice (no ':' found), allowing fallback to named_expression
 // This matches CPython's logic where slice_rule tries slice pattern first, then named_expression
-inline std::shared_ptr<ast::Expr> Parser::parse_slice() {
+inline ast::Expr* Parser::parse_slice() {
     // Save position for backtracking (matches CPython's _mark)
     size_t saved_pos = current_token_;
     Token slice_token = current();
@@ -3198,9 +3382,9 @@ inline std::shared_ptr<ast::Expr> Parser::parse_slice() {
               << ", value='" << current().value << "'" << std::endl;
     std::cerr.flush();
 
-    std::shared_ptr<ast::Expr> lower = nullptr;
-    std::shared_ptr<ast::Expr> upper = nullptr;
-    std::shared_ptr<ast::Expr> step = nullptr;
+    ast::Expr* lower = nullptr;
+    ast::Expr* upper = nullptr;
+    ast::Expr* step = nullptr;
 
     // Try to parse first expression (optional) - matches CPython: a=expression_rule(p), !p->error_indicator
     // In CPython, expression_rule can return NULL if optional and not present
@@ -3305,7 +3489,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_slice() {
               << ", type=" << static_cast<int>(current().type)
               << ", value='" << current().value << "'" << std::endl;
     std::cerr.flush();
-    return std::make_shared<ast::Slice>(lower, upper, step, slice_token.line, slice_token.column);
+    return arena_->make<ast::Slice>(lower, upper, step, slice_token.line, slice_token.column);
 }
 // This content should be inserted after line 2811 (after parse_slice function)
 
@@ -3324,7 +3508,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_slice() {
  * 
  * Returns: Expression node (single expr, Tuple for multiple, or Slice)
  */
-inline std::shared_ptr<ast::Expr> Parser::parse_subscript_slice() {
+inline ast::Expr* Parser::parse_subscript_slice() {
     std::cerr << "[DEBUG parse_subscript_slice] Starting at token " << current_token_
               << ", type=" << static_cast<int>(current().type)
               << ", value='" << current().value << "'" << std::endl;
@@ -3343,7 +3527,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_subscript_slice() {
     std::cerr << "[DEBUG parse_subscript_slice] Attempting to parse as slice notation" << std::endl;
     std::cerr.flush();
     
-    std::shared_ptr<ast::Expr> slice_result = parse_slice();
+    ast::Expr* slice_result = parse_slice();
     
     if (slice_result) {
         // Successfully parsed as slice notation
@@ -3364,7 +3548,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_subscript_slice() {
     std::cerr << "[DEBUG parse_subscript_slice] Parsing first expression" << std::endl;
     std::cerr.flush();
     
-    std::shared_ptr<ast::Expr> first_expr = parse_expr();
+    ast::Expr* first_expr = parse_expr();
     
     if (!first_expr) {
         error("Expected expression in subscript");
@@ -3390,7 +3574,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_subscript_slice() {
     std::cerr << "[DEBUG parse_subscript_slice] Building Tuple for multi-parameter subscript" << std::endl;
     std::cerr.flush();
     
-    std::vector<std::shared_ptr<ast::Expr>> elements;
+    std::vector<ast::Expr*> elements;
     elements.push_back(first_expr);
     
     // Parse remaining comma-separated expressions
@@ -3417,7 +3601,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_subscript_slice() {
         std::cerr << "[DEBUG parse_subscript_slice] Parsing expression " << (expr_count + 1) << std::endl;
         std::cerr.flush();
         
-        std::shared_ptr<ast::Expr> next_expr = parse_expr();
+        ast::Expr* next_expr = parse_expr();
         
         if (!next_expr) {
             std::ostringstream error_msg;
@@ -3442,7 +3626,7 @@ inline std::shared_ptr<ast::Expr> Parser::parse_subscript_slice() {
               << " elements" << std::endl;
     std::cerr.flush();
     
-    auto tuple_node = std::make_shared<ast::Tuple>(
+    auto tuple_node = arena_->make<ast::Tuple>(
         elements,
         ast::ExprContext::Load,
         start_token.line,
@@ -3460,8 +3644,8 @@ inline std::shared_ptr<ast::Expr> Parser::parse_subscript_slice() {
 
 // Decorators parsing (matches CPython's decorators rule)
 // decorators: ('@' named_expression NEWLINE)+
-inline std::vector<std::shared_ptr<ast::Expr>> Parser::parse_decorators() {
-    std::vector<std::shared_ptr<ast::Expr>> decorators;
+inline std::vector<ast::Expr*> Parser::parse_decorators() {
+    std::vector<ast::Expr*> decorators;
 
     while (current().type == TokenType::AT) {
         advance();  // consume '@'
@@ -3502,7 +3686,7 @@ inline std::vector<std::shared_ptr<ast::Expr>> Parser::parse_decorators() {
  *   type Point = tuple[float, float]
  *   type Vector[T] = list[T]
  */
-inline std::shared_ptr<ast::Stmt> Parser::parse_type_alias() {
+inline ast::Stmt* Parser::parse_type_alias() {
     std::cerr << "[DEBUG parse_type_alias] Entry" << std::endl;
     std::cerr.flush();
     
@@ -3514,14 +3698,14 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_type_alias() {
         error("Expected identifier after 'type'");
     }
     
-    std::string name = current().value;
-    auto name_expr = std::make_shared<ast::Name>(
+    std::string name = current().text();
+    auto name_expr = arena_->make<ast::Name>(
         name, ast::ExprContext::Store, current().line, current().column
     );
     advance(); // consume name
     
     // Parse optional type parameters [T], [T, U], [T: int], [*Ts], [**P]
-    std::vector<std::shared_ptr<ast::TypeParam>> type_params;
+    std::vector<ast::TypeParam*> type_params;
     if (current().type == TokenType::LBRACKET) {
         type_params = parse_type_params();
     }
@@ -3543,7 +3727,7 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_type_alias() {
     std::cerr << "[DEBUG parse_type_alias] Created TypeAlias: " << name << std::endl;
     std::cerr.flush();
     
-    return std::make_shared<ast::TypeAlias>(
+    return arena_->make<ast::TypeAlias>(
         name_expr, type_params, value,
         start_token.line, start_token.column
     );
@@ -3553,11 +3737,11 @@ inline std::shared_ptr<ast::Stmt> Parser::parse_type_alias() {
  * Parse type parameters list
  * Grammar: type_params: '[' type_param (',' type_param)* ']'
  */
-inline std::vector<std::shared_ptr<ast::TypeParam>> Parser::parse_type_params() {
+inline std::vector<ast::TypeParam*> Parser::parse_type_params() {
     std::cerr << "[DEBUG parse_type_params] Entry" << std::endl;
     std::cerr.flush();
     
-    std::vector<std::shared_ptr<ast::TypeParam>> params;
+    std::vector<ast::TypeParam*> params;
     
     if (current().type != TokenType::LBRACKET) {
         return params; // No type params
@@ -3594,7 +3778,7 @@ inline std::vector<std::shared_ptr<ast::TypeParam>> Parser::parse_type_params()
  *            | '*' NAME ['=' expression]                 # TypeVarTuple
  *            | '**' NAME ['=' expression]                # ParamSpec
  */
-inline std::shared_ptr<ast::TypeParam> Parser::parse_type_param() {
+inline ast::TypeParam* Parser::parse_type_param() {
     std::cerr << "[DEBUG parse_type_param] Entry, token=" << current().value << std::endl;
     std::cerr.flush();
     
@@ -3608,17 +3792,17 @@ inline std::shared_ptr<ast::TypeParam> Parser::parse_type_param() {
             error("Expected identifier after '*' in type parameter");
         }
         
-        std::string name = current().value;
+        std::string name = current().text();
         advance(); // consume name
         
         // Check for optional default value
-        std::shared_ptr<ast::Expr> default_value = nullptr;
+        ast::Expr* default_value = nullptr;
         if (current().type == TokenType::EQUAL) {
             advance(); // consume '='
             default_value = parse_expr();
         }
         
-        return std::make_shared<ast::TypeVarTuple>(
+        return arena_->make<ast::TypeVarTuple>(
             name, default_value, start_token.line, start_token.column
         );
     }
@@ -3631,17 +3815,17 @@ inline std::shared_ptr<ast::TypeParam> Parser::parse_type_param() {
             error("Expected identifier after '**' in type parameter");
         }
         
-        std::string name = current().value;
+        std::string name = current().text();
         advance(); // consume name
         
         // Check for optional default value
-        std::shared_ptr<ast::Expr> default_value = nullptr;
+        ast::Expr* default_value = nullptr;
         if (current().type == TokenType::EQUAL) {
             advance(); // consume '='
             default_value = parse_expr();
         }
         
-        return std::make_shared<ast::ParamSpec>(
+        return arena_->make<ast::ParamSpec>(
             name, default_value, start_token.line, start_token.column
         );
     }
@@ -3651,24 +3835,24 @@ inline std::shared_ptr<ast::TypeParam> Parser::parse_type_param() {
         error("Expected identifier in type parameter");
     }
     
-    std::string name = current().value;
+    std::string name = current().text();
     advance(); // consume name
     
     // Check for optional bound (T: int)
-    std::shared_ptr<ast::Expr> bound = nullptr;
+    ast::Expr* bound = nullptr;
     if (current().type == TokenType::COLON) {
         advance(); // consume ':'
         bound = parse_expr();
     }
     
     // Check for optional default value (T = int)
-    std::shared_ptr<ast::Expr> default_value = nullptr;
+    ast::Expr* default_value = nullptr;
     if (current().type == TokenType::EQUAL) {
         advance(); // consume '='
         default_value = parse_expr();
     }
     
-    return std::make_shared<ast::TypeVar>(
+    return arena_->make<ast::TypeVar>(
         name, bound, default_value, start_token.line, start_token.column
     );
 }
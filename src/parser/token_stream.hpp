@@ -0,0 +1,108 @@
+#ifndef CPYTHON_CPP_TOKEN_STREAM_HPP
+#define CPYTHON_CPP_TOKEN_STREAM_HPP
+
+#include "tokenizer.hpp"
+#include <deque>
+#include <stdexcept>
+#include <string>
+
+namespace cpython_cpp {
+namespace parser {
+
+/**
+ * TokenSpan - source bytes a token was lexed from
+ */
+struct TokenSpan {
+    size_t begin;
+    size_t end;       // One past the last byte
+    bool resumable;   // Lexed outside any f/t-string (see Tokenizer::resume_at)
+};
+
+/**
+ * TokenStream - pulls tokens from a Tokenizer on demand
+ *
+ * Tokens are addressed by absolute index, the same positions the parser
+ * saves for backtracking. Only the window starting at base_ is buffered;
+ * release_before() drops tokens the parser can no longer reset to, so peak
+ * memory follows the backtracking window rather than the file size.
+ * Reference: Parser/pegen.c (_PyPegen_fill_token)
+ *
+ * The window is a deque so references to buffered tokens stay valid while
+ * more tokens are pulled. Indexing past END_OF_FILE yields END_OF_FILE.
+ *
+ * Tokens are only pulled when the parser looks at them, so furthest() is
+ * exactly how far the parser has looked ahead; span() gives the source
+ * range each buffered token was lexed from.
+ */
+class TokenStream {
+public:
+    explicit TokenStream(Tokenizer& tokenizer) : tokenizer_(tokenizer) {}
+
+    TokenStream(const TokenStream&) = delete;
+    TokenStream& operator=(const TokenStream&) = delete;
+
+    // Token at absolute index, tokenizing up to it if needed
+    const Token& operator[](size_t index);
+
+    // Drop every token before index (the newest token is always kept)
+    void release_before(size_t index);
+
+    // Where the token at a buffered index came from
+    const TokenSpan& span(size_t index);
+
+    // Index of the newest token pulled so far
+    size_t furthest() const { return base_ + window_.size() - 1; }
+
+    // Number of tokens currently held, and the most ever held at once
+    size_t buffered() const { return window_.size(); }
+    size_t peak_buffered() const { return peak_buffered_; }
+
+private:
+    Tokenizer& tokenizer_;
+    std::deque<Token> window_;
+    std::deque<TokenSpan> spans_;  // Parallel to window_
+    size_t base_ = 0;          // Absolute index of window_.front()
+    size_t peak_buffered_ = 0;
+    bool at_eof_ = false;
+};
+
+inline const Token& TokenStream::operator[](size_t index) {
+    if (index < base_) {
+        throw std::logic_error("TokenStream: token " + std::to_string(index) +
+                               " was already released");
+    }
+    while (!at_eof_ && index - base_ >= window_.size()) {
+        bool resumable = !tokenizer_.in_string();
+        window_.push_back(tokenizer_.next_token());
+        spans_.push_back({tokenizer_.token_start(), tokenizer_.position(), resumable});
+        at_eof_ = window_.back().type == TokenType::END_OF_FILE;
+        if (window_.size() > peak_buffered_) {
+            peak_buffered_ = window_.size();
+        }
+    }
+    if (index - base_ >= window_.size()) {
+        return window_.back(); // END_OF_FILE
+    }
+    return window_[index - base_];
+}
+
+inline const TokenSpan& TokenStream::span(size_t index) {
+    (*this)[index];
+    if (index - base_ >= spans_.size()) {
+        return spans_.back(); // END_OF_FILE
+    }
+    return spans_[index - base_];
+}
+
+inline void TokenStream::release_before(size_t index) {
+    while (base_ < index && window_.size() > 1) {
+        window_.pop_front();
+        spans_.pop_front();
+        base_++;
+    }
+}
+
+} // namespace parser
+} // namespace cpython_cpp
+
+#endif // CPYTHON_CPP_TOKEN_STREAM_HPP
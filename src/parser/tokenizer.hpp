@@ -2,6 +2,7 @@
 #define CPYTHON_CPP_TOKENIZER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 #include <cctype>
@@ -9,7 +10,11 @@
 #include <unordered_map>
 #include <optional>
 #include <array>
+#include <algorithm>
 #include <concepts>
+#include <cstring>
+
+#include "char_scan.hpp"
 
 namespace cpython_cpp {
 namespace parser {
@@ -73,23 +78,58 @@ struct TokenTag {
 template<TokenType Type>
 struct TypedToken {
     static constexpr TokenType type = Type;
-    std::string value;
+    std::string_view value;
     size_t line;
     size_t column;
 
-    TypedToken(std::string v, size_t l, size_t c)
-        : value(std::move(v)), line(l), column(c) {}
+    TypedToken(std::string_view v, size_t l, size_t c)
+        : value(v), line(l), column(c) {}
 };
 
-// Runtime token with template-based type checking
+/**
+ * Runtime token with template-based type checking
+ *
+ * Tokens don't own their text: value views the Tokenizer's source buffer
+ * (or a static literal for operators), so a token is valid as long as the
+ * Tokenizer that produced it. For string literals (STRING and the f/t-string
+ * parts) value is the raw body between the quotes; when it still contains
+ * escapes or doubled braces, `decode` says so and text() materializes the
+ * decoded string on demand.
+ */
 struct Token {
+    static constexpr uint8_t DECODE_ESCAPES = 1;  // Backslash escapes to strip
+    static constexpr uint8_t DECODE_BRACES = 2;   // {{ and }} to collapse
+
     TokenType type;
-    std::string value;
+    std::string_view value;
     size_t line;
     size_t column;
+    uint8_t decode;
 
-    Token(TokenType t, const std::string& v, size_t l, size_t c)
-        : type(t), value(v), line(l), column(c) {}
+    Token(TokenType t, std::string_view v, size_t l, size_t c, uint8_t d = 0)
+        : type(t), value(v), line(l), column(c), decode(d) {}
+
+    // Token text as an owned string, decoded if needed
+    std::string text() const {
+        if (decode == 0) {
+            return std::string(value);
+        }
+        std::string out;
+        out.reserve(value.size());
+        for (size_t i = 0; i < value.size(); ++i) {
+            char c = value[i];
+            if ((decode & DECODE_ESCAPES) && c == '\\') {
+                if (++i < value.size()) out += value[i];
+                continue;
+            }
+            if ((decode & DECODE_BRACES) && (c == '{' || c == '}') &&
+                i + 1 < value.size() && value[i + 1] == c) {
+                ++i;
+            }
+            out += c;
+        }
+        return out;
+    }
 
     // Template-based type checking
     template<TokenType T>
@@ -138,7 +178,11 @@ inline constexpr int precedence_v = Precedence<T>::value;
  */
 class Tokenizer {
 public:
-    explicit Tokenizer(const std::string& source);
+    explicit Tokenizer(std::string source);
+
+    // Tokens view source_, so the buffer must never move
+    Tokenizer(const Tokenizer&) = delete;
+    Tokenizer& operator=(const Tokenizer&) = delete;
 
     // Get next token
     Token next_token();
@@ -146,14 +190,28 @@ public:
     // Check if more tokens available
     bool has_more() const;
 
-    // Get all tokens (for testing)
+    // Get all tokens (valid while this Tokenizer lives)
     std::vector<Token> tokenize();
 
+    // Source offsets of the last token: where it started and one past its end
+    size_t token_start() const { return token_start_; }
+    size_t position() const { return position_; }
+
+    // Inside an f-string or t-string, where lexing depends on earlier tokens
+    bool in_string() const { return !fstring_stack_.empty() || !tstring_stack_.empty(); }
+
+    // Continue lexing at a token start known to be outside any string
+    void resume_at(size_t position, size_t line, size_t column);
+
+    // Hand the source back; tokens already produced must not be used after this
+    std::string release_source() { return std::move(source_); }
+
 private:
     std::string source_;
     size_t position_;
     size_t line_;
     size_t column_;
+    size_t token_start_ = 0;
 
     // F-string state tracking (PEP 701 compliant)
     struct FStringState {
@@ -189,7 +247,7 @@ private:
     Token read_number();
     Token read_string();
     Token read_identifier_or_keyword();
-    TokenType keyword_to_token(const std::string& word);
+    TokenType keyword_to_token(std::string_view word);
 
     // F-string lexing functions
     bool check_fstring_prefix(size_t& prefix_len, bool& is_raw);
@@ -217,7 +275,7 @@ struct KeywordEntry {
 
 /**
  * Compile-time keyword table
- * Sorted by first character for binary search optimization
+ * Alphabetical; keyword_to_token() finds entries through KEYWORD_SLOTS
  */
 constexpr std::array<KeywordEntry, 38> KEYWORD_TABLE = {{
     {"False", TokenType::FALSE},
@@ -287,75 +345,72 @@ constexpr std::optional<TokenType> lookup_keyword_impl(
     return std::nullopt;
 }
 
-// Runtime keyword map (for compatibility)
-namespace {
-    const std::unordered_map<std::string, TokenType> keywords = {
-        {"def", TokenType::DEF},
-        {"if", TokenType::IF},
-        {"elif", TokenType::ELIF},
-        {"else", TokenType::ELSE},
-        {"for", TokenType::FOR},
-        {"while", TokenType::WHILE},
-        {"return", TokenType::RETURN},
-        {"class", TokenType::CLASS},
-        {"import", TokenType::IMPORT},
-        {"from", TokenType::FROM},
-        {"as", TokenType::AS},
-        {"and", TokenType::AND},
-        {"or", TokenType::OR},
-        {"not", TokenType::NOT},
-        {"in", TokenType::IN},
-        {"is", TokenType::IS},
-        {"try", TokenType::TRY},
-        {"except", TokenType::EXCEPT},
-        {"finally", TokenType::FINALLY},
-        {"raise", TokenType::RAISE},
-        {"pass", TokenType::PASS},
-        {"del", TokenType::DEL},
-        {"assert", TokenType::ASSERT},
-        {"global", TokenType::GLOBAL},
-        {"nonlocal", TokenType::NONLOCAL},
-        {"with", TokenType::WITH},
-        {"break", TokenType::BREAK},
-        {"continue", TokenType::CONTINUE},
-        {"lambda", TokenType::LAMBDA},
-        {"yield", TokenType::YIELD},
-        {"async", TokenType::ASYNC},  // Python 3.5+
-        {"await", TokenType::AWAIT},  // Python 3.5+
-        {"match", TokenType::MATCH},  // Python 3.10+ soft keyword
-        {"case", TokenType::CASE},    // Python 3.10+ soft keyword
-        {"type", TokenType::TYPE},    // Python 3.12+ soft keyword
-        {"True", TokenType::TRUE},
-        {"False", TokenType::FALSE},
-        {"None", TokenType::NONE},
-    };
+/**
+ * Perfect hash over KEYWORD_TABLE
+ *
+ * The first two characters, the last one and the length are packed into
+ * one word; a multiplier found by search spreads the 38 keywords over 64
+ * slots without collisions (checked below), so a lookup is one hash and
+ * at most one comparison.
+ */
+constexpr size_t KEYWORD_MIN_LENGTH = 2;
+constexpr size_t KEYWORD_MAX_LENGTH = 8;
+constexpr int KEYWORD_HASH_BITS = 6;
+constexpr uint32_t KEYWORD_HASH_MULTIPLIER = 0x683d528d;
+
+// word must be KEYWORD_MIN_LENGTH to KEYWORD_MAX_LENGTH characters long
+constexpr size_t keyword_hash(std::string_view word) {
+    uint32_t key = static_cast<uint32_t>(static_cast<uint8_t>(word[0])) |
+                   static_cast<uint32_t>(static_cast<uint8_t>(word[1])) << 8 |
+                   static_cast<uint32_t>(static_cast<uint8_t>(word.back())) << 16 |
+                   static_cast<uint32_t>(word.size()) << 24;
+    return (key * KEYWORD_HASH_MULTIPLIER) >> (32 - KEYWORD_HASH_BITS);
 }
 
+// KEYWORD_TABLE index per hash slot, -1 for none
+constexpr std::array<int8_t, size_t(1) << KEYWORD_HASH_BITS> KEYWORD_SLOTS = [] {
+    std::array<int8_t, size_t(1) << KEYWORD_HASH_BITS> slots{};
+    for (auto& slot : slots) slot = -1;
+    for (size_t i = 0; i < KEYWORD_TABLE.size(); ++i) {
+        slots[keyword_hash(KEYWORD_TABLE[i].keyword)] = static_cast<int8_t>(i);
+    }
+    return slots;
+}();
+
+constexpr bool keyword_hash_is_perfect() {
+    for (size_t i = 0; i < KEYWORD_TABLE.size(); ++i) {
+        std::string_view word = KEYWORD_TABLE[i].keyword;
+        if (word.size() < KEYWORD_MIN_LENGTH || word.size() > KEYWORD_MAX_LENGTH ||
+            KEYWORD_SLOTS[keyword_hash(word)] != static_cast<int8_t>(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(keyword_hash_is_perfect(), "keywords collide in KEYWORD_SLOTS: pick a new multiplier");
+
 // Implementations
-inline Tokenizer::Tokenizer(const std::string& source)
-    : source_(source), position_(0), line_(1), column_(1), fstring_stack_() {}
+inline Tokenizer::Tokenizer(std::string source)
+    : source_(std::move(source)), position_(0), line_(1), column_(1), fstring_stack_() {}
 
 inline void Tokenizer::skip_whitespace() {
-    while (position_ < source_.length()) {
-        char c = source_[position_];
-        if (c == ' ' || c == '\t') {
-            position_++;
-            column_++;
-        } else if (c == '\n') {
-            position_++;
-            line_++;
-            column_ = 1;
-        } else {
-            break;
-        }
+    const char* start = source_.data() + position_;
+    const char* end = scan::scan_blanks(start, source_.data() + source_.length());
+
+    // Each newline in the run starts a line; the column counts from the last
+    const char* line_start = nullptr;
+    for (const char* p = start; (p = static_cast<const char*>(std::memchr(p, '\n', end - p))); ++p) {
+        line_++;
+        line_start = p + 1;
     }
+    column_ = line_start ? 1 + (end - line_start) : column_ + (end - start);
+    position_ = end - source_.data();
 }
 
 inline void Tokenizer::skip_comment() {
     if (position_ < source_.length() && source_[position_] == '#') {
-        while (position_ < source_.length() && source_[position_] != '\n') {
-            position_++;
-        }
+        const void* newline = std::memchr(source_.data() + position_, '\n', source_.length() - position_);
+        position_ = newline ? static_cast<const char*>(newline) - source_.data() : source_.length();
     }
 }
 
@@ -363,24 +418,25 @@ inline Token Tokenizer::read_number() {
     size_t start = position_;
     size_t start_col = column_;
 
+    const char* end = source_.data() + source_.length();
+    auto skip_digits = [&] {
+        size_t digits = scan::scan_digits(source_.data() + position_, end) - (source_.data() + position_);
+        position_ += digits;
+        column_ += digits;
+    };
+
     // Read integer part
-    while (position_ < source_.length() && std::isdigit(source_[position_])) {
-        position_++;
-        column_++;
-    }
+    skip_digits();
 
     // Check for decimal point
     if (position_ < source_.length() && source_[position_] == '.') {
         position_++;
         column_++;
-        while (position_ < source_.length() && std::isdigit(source_[position_])) {
-            position_++;
-            column_++;
-        }
+        skip_digits();
     }
 
-    std::string value = source_.substr(start, position_ - start);
-    return Token(TokenType::NUMBER, value, line_, start_col);
+    return Token(TokenType::NUMBER, std::string_view(source_).substr(start, position_ - start),
+                 line_, start_col);
 }
 
 inline Token Tokenizer::read_string() {
@@ -389,61 +445,67 @@ inline Token Tokenizer::read_string() {
     position_++;
     column_++;
 
-    std::string value;
-    bool escaped = false;
+    size_t content_start = position_;
+    size_t content_end = source_.length();  // Unterminated: runs to EOF
+    uint8_t decode = 0;
+    const char* end = source_.data() + source_.length();
 
     while (position_ < source_.length()) {
-        char c = source_[position_];
+        // Plain contents up to the next quote, backslash or newline
+        size_t run = scan::scan_string_body(source_.data() + position_, end, quote) -
+                     (source_.data() + position_);
+        position_ += run;
+        column_ += run;
+        if (position_ >= source_.length()) {
+            break;
+        }
 
-        if (escaped) {
-            value += c;
-            escaped = false;
-            position_++;
-            column_++;
-        } else if (c == '\\') {
-            escaped = true;
-            position_++;
-            column_++;
+        char c = source_[position_];
+        if (c == '\\') {
+            // The escaped character is taken as it is
+            decode |= Token::DECODE_ESCAPES;
+            size_t escape = std::min<size_t>(2, source_.length() - position_);
+            position_ += escape;
+            column_ += escape;
         } else if (c == quote) {
+            content_end = position_;
             position_++;
             column_++;
             break;
-        } else if (c == '\n') {
+        } else {
             // Multi-line strings not fully handled here
-            value += c;
             position_++;
             line_++;
             column_ = 1;
-        } else {
-            value += c;
-            position_++;
-            column_++;
         }
     }
 
-    return Token(TokenType::STRING, value, line_, start_col);
+    return Token(TokenType::STRING,
+                 std::string_view(source_).substr(content_start, content_end - content_start),
+                 line_, start_col, decode);
 }
 
 inline Token Tokenizer::read_identifier_or_keyword() {
     size_t start = position_;
     size_t start_col = column_;
 
-    while (position_ < source_.length() &&
-           (std::isalnum(source_[position_]) || source_[position_] == '_')) {
-        position_++;
-        column_++;
-    }
+    const char* end = scan::scan_identifier(source_.data() + start, source_.data() + source_.length());
+    position_ = end - source_.data();
+    column_ += position_ - start;
 
-    std::string word = source_.substr(start, position_ - start);
+    std::string_view word = std::string_view(source_).substr(start, position_ - start);
     TokenType type = keyword_to_token(word);
 
     return Token(type, word, line_, start_col);
 }
 
-inline TokenType Tokenizer::keyword_to_token(const std::string& word) {
-    auto it = keywords.find(word);
-    if (it != keywords.end()) {
-        return it->second;
+inline TokenType Tokenizer::keyword_to_token(std::string_view word) {
+    if (word.size() < KEYWORD_MIN_LENGTH || word.size() > KEYWORD_MAX_LENGTH) {
+        return TokenType::IDENTIFIER;
+    }
+    int index = KEYWORD_SLOTS[keyword_hash(word)];
+    if (index >= 0 && word == KEYWORD_TABLE[index].keyword) {
+        return KEYWORD_TABLE[index].type;
     }
     return TokenType::IDENTIFIER;
 }
@@ -566,7 +628,8 @@ inline Token Tokenizer::read_fstring_start() {
     fstring_stack_.push_back(state);
 
     // Read initial string content until { or end quote
-    std::string value;
+    size_t content_start = position_;
+    uint8_t decode = 0;
     bool escaped = false;
 
     while (position_ < source_.length()) {
@@ -594,7 +657,7 @@ inline Token Tokenizer::read_fstring_start() {
         if (!escaped && c == '{') {
             // Check if it's {{ (literal brace)
             if (position_ + 1 < source_.length() && source_[position_ + 1] == '{') {
-                value += '{';
+                decode |= Token::DECODE_BRACES;
                 position_ += 2;
                 column_ += 2;
                 continue;
@@ -606,20 +669,15 @@ inline Token Tokenizer::read_fstring_start() {
 
         // Handle escape sequences
         if (escaped) {
-            if (is_raw && c != quote && c != '\\') {
-                // In raw f-strings, only quote and backslash can be escaped
-                value += '\\';
-            }
-            value += c;
             escaped = false;
             position_++;
             column_++;
         } else if (c == '\\' && !is_raw) {
             escaped = true;
+            decode |= Token::DECODE_ESCAPES;
             position_++;
             column_++;
         } else {
-            value += c;
             position_++;
             if (c == '\n') {
                 line_++;
@@ -630,7 +688,9 @@ inline Token Tokenizer::read_fstring_start() {
         }
     }
 
-    return Token(TokenType::FSTRING_START, value, line_, start_col);
+    return Token(TokenType::FSTRING_START,
+                 std::string_view(source_).substr(content_start, position_ - content_start),
+                 line_, start_col, decode);
 }
 
 // Read f-string middle token (literal text between expressions)
@@ -641,7 +701,8 @@ inline Token Tokenizer::read_fstring_middle() {
 
     FStringState& state = fstring_stack_.back();
     size_t start_col = column_;
-    std::string value;
+    size_t content_start = position_;
+    uint8_t decode = 0;
     bool escaped = false;
 
     while (position_ < source_.length()) {
@@ -667,7 +728,7 @@ inline Token Tokenizer::read_fstring_middle() {
         if (!escaped && c == '{') {
             if (position_ + 1 < source_.length() && source_[position_ + 1] == '{') {
                 // Literal {{ - emit single {
-                value += '{';
+                decode |= Token::DECODE_BRACES;
                 position_ += 2;
                 column_ += 2;
                 continue;
@@ -681,7 +742,7 @@ inline Token Tokenizer::read_fstring_middle() {
         if (!escaped && c == '}') {
             if (position_ + 1 < source_.length() && source_[position_ + 1] == '}') {
                 // Literal }} - emit single }
-                value += '}';
+                decode |= Token::DECODE_BRACES;
                 position_ += 2;
                 column_ += 2;
                 continue;
@@ -693,19 +754,15 @@ inline Token Tokenizer::read_fstring_middle() {
 
         // Handle escape sequences
         if (escaped) {
-            if (state.raw && c != state.quote && c != '\\') {
-                value += '\\';
-            }
-            value += c;
             escaped = false;
             position_++;
             column_++;
         } else if (c == '\\' && !state.raw) {
             escaped = true;
+            decode |= Token::DECODE_ESCAPES;
             position_++;
             column_++;
         } else {
-            value += c;
             position_++;
             if (c == '\n') {
                 line_++;
@@ -716,7 +773,9 @@ inline Token Tokenizer::read_fstring_middle() {
         }
     }
 
-    return Token(TokenType::FSTRING_MIDDLE, value, line_, start_col);
+    return Token(TokenType::FSTRING_MIDDLE,
+                 std::string_view(source_).substr(content_start, position_ - content_start),
+                 line_, start_col, decode);
 }
 
 // Read f-string end token
@@ -788,7 +847,8 @@ inline Token Tokenizer::read_tstring_start() {
     tstring_stack_.push_back(state);
 
     // Read initial string content until { or end quote
-    std::string value;
+    size_t content_start = position_;
+    uint8_t decode = 0;
     bool escaped = false;
 
     while (position_ < source_.length()) {
@@ -812,7 +872,7 @@ inline Token Tokenizer::read_tstring_start() {
         // Check for { (start of expression)
         if (!escaped && c == '{') {
             if (position_ + 1 < source_.length() && source_[position_ + 1] == '{') {
-                value += '{';
+                decode |= Token::DECODE_BRACES;
                 position_ += 2;
                 column_ += 2;
                 continue;
@@ -823,16 +883,15 @@ inline Token Tokenizer::read_tstring_start() {
 
         // Handle escape sequences
         if (escaped) {
-            value += c;
             escaped = false;
             position_++;
             column_++;
         } else if (c == '\\') {
             escaped = true;
+            decode |= Token::DECODE_ESCAPES;
             position_++;
             column_++;
         } else {
-            value += c;
             position_++;
             if (c == '\n') {
                 line_++;
@@ -843,7 +902,9 @@ inline Token Tokenizer::read_tstring_start() {
         }
     }
 
-    return Token(TokenType::TSTRING_START, value, line_, start_col);
+    return Token(TokenType::TSTRING_START,
+                 std::string_view(source_).substr(content_start, position_ - content_start),
+                 line_, start_col, decode);
 }
 
 inline Token Tokenizer::read_tstring_middle() {
@@ -853,7 +914,8 @@ inline Token Tokenizer::read_tstring_middle() {
 
     TStringState& state = tstring_stack_.back();
     size_t start_col = column_;
-    std::string value;
+    size_t content_start = position_;
+    uint8_t decode = 0;
     bool escaped = false;
 
     while (position_ < source_.length()) {
@@ -877,7 +939,7 @@ inline Token Tokenizer::read_tstring_middle() {
         // Check for { (start of expression)
         if (!escaped && c == '{') {
             if (position_ + 1 < source_.length() && source_[position_ + 1] == '{') {
-                value += '{';
+                decode |= Token::DECODE_BRACES;
                 position_ += 2;
                 column_ += 2;
                 continue;
@@ -889,7 +951,7 @@ inline Token Tokenizer::read_tstring_middle() {
         // Check for } (end of expression or format spec)
         if (!escaped && c == '}') {
             if (position_ + 1 < source_.length() && source_[position_ + 1] == '}') {
-                value += '}';
+                decode |= Token::DECODE_BRACES;
                 position_ += 2;
                 column_ += 2;
                 continue;
@@ -900,16 +962,15 @@ inline Token Tokenizer::read_tstring_middle() {
 
         // Handle escape sequences
         if (escaped) {
-            value += c;
             escaped = false;
             position_++;
             column_++;
         } else if (c == '\\') {
             escaped = true;
+            decode |= Token::DECODE_ESCAPES;
             position_++;
             column_++;
         } else {
-            value += c;
             position_++;
             if (c == '\n') {
                 line_++;
@@ -920,7 +981,9 @@ inline Token Tokenizer::read_tstring_middle() {
         }
     }
 
-    return Token(TokenType::TSTRING_MIDDLE, value, line_, start_col);
+    return Token(TokenType::TSTRING_MIDDLE,
+                 std::string_view(source_).substr(content_start, position_ - content_start),
+                 line_, start_col, decode);
 }
 
 inline Token Tokenizer::read_tstring_end() {
@@ -945,9 +1008,19 @@ inline Token Tokenizer::read_tstring_end() {
     return Token(TokenType::TSTRING_END, "", line_, start_col);
 }
 
+inline void Tokenizer::resume_at(size_t position, size_t line, size_t column) {
+    position_ = position;
+    line_ = line;
+    column_ = column;
+    token_start_ = position;
+    fstring_stack_.clear();
+    tstring_stack_.clear();
+}
+
 inline Token Tokenizer::next_token() {
     skip_whitespace();
     skip_comment();
+    token_start_ = position_;
 
     if (position_ >= source_.length()) {
         return Token(TokenType::END_OF_FILE, "", line_, column_);
@@ -1436,7 +1509,8 @@ inline Token Tokenizer::next_token() {
             return Token(TokenType::NEWLINE, "\n", line_ - 1, start_col);
         default:
             position_++; column_++;
-            return Token(TokenType::ENDMARKER, std::string(1, c), line_, start_col);
+            return Token(TokenType::ENDMARKER, std::string_view(source_).substr(position_ - 1, 1),
+                         line_, start_col);
     }
 }
 
@@ -1446,6 +1520,7 @@ inline bool Tokenizer::has_more() const {
 
 inline std::vector<Token> Tokenizer::tokenize() {
     std::vector<Token> tokens;
+    tokens.reserve(source_.size() / 4 + 1);  // Rough tokens-per-byte guess
     Token token = next_token();
 
     while (token.type != TokenType::END_OF_FILE) {
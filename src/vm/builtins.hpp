@@ -4,6 +4,7 @@
 #include <iostream>
 #include <memory>
 #include <functional>
+#include <span>
 
 namespace cpython_cpp {
 namespace vm {
@@ -19,7 +20,7 @@ inline PyObject builtin_print(const std::vector<PyObject>& args) {
         print_object(args[i]);
     }
     std::cout << "\n";
-    return std::monostate{};  // None
+    return PyObject();  // None
 }
 
 /**
@@ -27,7 +28,7 @@ inline PyObject builtin_print(const std::vector<PyObject>& args) {
  * 
  * Returns the length of a sequence or collection.
  */
-inline PyObject builtin_len(const std::vector<PyObject>& args) {
+inline PyObject builtin_len(std::span<const PyObject> args) {
     if (args.size() != 1) {
         throw std::runtime_error("len() takes exactly one argument");
     }
@@ -35,15 +36,17 @@ inline PyObject builtin_len(const std::vector<PyObject>& args) {
     const PyObject& obj = args[0];
     
     if (is_string(obj)) {
-        return static_cast<int64_t>(std::get<std::string>(obj).size());
+        return static_cast<int64_t>(obj.as_string().size());
     } else if (is_list(obj)) {
-        return static_cast<int64_t>(std::get<std::shared_ptr<PyList>>(obj)->size());
+        return static_cast<int64_t>(obj.as<PyList>()->size());
     } else if (is_tuple(obj)) {
-        return static_cast<int64_t>(std::get<std::shared_ptr<PyTuple>>(obj)->size());
+        return static_cast<int64_t>(obj.as<PyTuple>()->size());
     } else if (is_dict(obj)) {
-        return static_cast<int64_t>(std::get<std::shared_ptr<PyDict>>(obj)->size());
+        return static_cast<int64_t>(obj.as<PyDict>()->size());
     } else if (is_set(obj)) {
-        return static_cast<int64_t>(std::get<std::shared_ptr<PySet>>(obj)->size());
+        return static_cast<int64_t>(obj.as<PySet>()->size());
+    } else if (is_range(obj)) {
+        return static_cast<int64_t>(obj.as<PyRange>()->length);
     }
     
     throw std::runtime_error("object has no len()");
@@ -70,6 +73,7 @@ inline PyObject builtin_type(const std::vector<PyObject>& args) {
     if (is_tuple(obj)) return std::string("<class 'tuple'>");
     if (is_dict(obj)) return std::string("<class 'dict'>");
     if (is_set(obj)) return std::string("<class 'set'>");
+    if (is_range(obj)) return std::string("<class 'range'>");
     
     return std::string("<class 'object'>");
 }
@@ -129,11 +133,18 @@ inline PyObject builtin_bool(const std::vector<PyObject>& args) {
 /**
  * Built-in range() function
  * 
- * Returns a list of integers (simplified implementation).
+ * Returns a lazy PyRange; no list is built.
  */
-inline PyObject builtin_range(const std::vector<PyObject>& args) {
+inline PyObject builtin_range(std::span<const PyObject> args) {
     int64_t start = 0, stop = 0, step = 1;
     
+    for (const auto& arg : args) {
+        if (!is_int(arg) && !is_bool(arg)) {
+            throw std::runtime_error(std::string("TypeError: '") + type_name(arg) +
+                                     "' object cannot be interpreted as an integer");
+        }
+    }
+    
     if (args.size() == 1) {
         stop = to_int(args[0]);
     } else if (args.size() == 2) {
@@ -144,26 +155,15 @@ inline PyObject builtin_range(const std::vector<PyObject>& args) {
         stop = to_int(args[1]);
         step = to_int(args[2]);
     } else {
-        throw std::runtime_error("range() takes 1 to 3 arguments");
+        throw std::runtime_error("TypeError: range expected 1 to 3 arguments, got " +
+                                 std::to_string(args.size()));
     }
     
     if (step == 0) {
-        throw std::runtime_error("range() step argument must not be zero");
-    }
-    
-    auto list = std::make_shared<PyList>();
-    
-    if (step > 0) {
-        for (int64_t i = start; i < stop; i += step) {
-            list->append(i);
-        }
-    } else {
-        for (int64_t i = start; i > stop; i += step) {
-            list->append(i);
-        }
+        throw std::runtime_error("ValueError: range() arg 3 must not be zero");
     }
     
-    return list;
+    return core::make_ref<PyRange>(start, stop, step);
 }
 
 } // namespace vm
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "pyobject.hpp"
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace cpython_cpp {
+namespace vm {
+
+/**
+ * DataStack - contiguous storage for the locals and value stacks of frames
+ * Reference: Python/pystate.c (_PyThreadState_PushFrame, push_chunk)
+ *
+ * A call takes one slice of co_nlocals + co_stacksize slots and returns
+ * it when the frame ends; frames end in reverse order, so this is a bump
+ * pointer. Storage comes in chunks that never move (slices stay valid
+ * while later frames push new chunks) and are kept once allocated, so
+ * after warm-up pushing a frame allocates nothing.
+ *
+ * Slots are handed out holding None and must be handed back that way;
+ * Frame clears what it used before calling pop().
+ */
+class DataStack {
+public:
+    static constexpr size_t CHUNK_SLOTS = 16 * 1024;  // 256 KiB of PyObjects
+
+    DataStack() = default;
+    DataStack(const DataStack&) = delete;
+    DataStack& operator=(const DataStack&) = delete;
+
+    // n slots, all None
+    PyObject* push(size_t n) {
+        if (chunks_.empty() || n > static_cast<size_t>(chunks_[current_].end - top_)) {
+            next_chunk(n);
+        }
+        PyObject* base = top_;
+        top_ += n;
+        return base;
+    }
+
+    // Release the most recent push, given the base it returned
+    void pop(PyObject* base) {
+        if (current_ > 0 && base == chunks_[current_].begin) {
+            --current_;
+            top_ = chunks_[current_].saved_top;
+        } else {
+            top_ = base;
+        }
+    }
+
+    size_t chunk_count() const { return chunks_.size(); }
+
+private:
+    struct Chunk {
+        std::unique_ptr<PyObject[]> slots;
+        PyObject* begin;
+        PyObject* end;
+        PyObject* saved_top;  // Top of this chunk while later chunks are in use
+    };
+
+    void next_chunk(size_t n) {
+        if (!chunks_.empty()) {
+            chunks_[current_].saved_top = top_;
+            ++current_;
+        }
+        // A kept chunk is reused if the request fits; otherwise it is replaced
+        if (current_ == chunks_.size() || static_cast<size_t>(chunks_[current_].end - chunks_[current_].begin) < n) {
+            size_t size = std::max(n, CHUNK_SLOTS);
+            Chunk chunk{std::make_unique<PyObject[]>(size), nullptr, nullptr, nullptr};
+            chunk.begin = chunk.slots.get();
+            chunk.end = chunk.begin + size;
+            if (current_ == chunks_.size()) {
+                chunks_.push_back(std::move(chunk));
+            } else {
+                chunks_[current_] = std::move(chunk);
+            }
+        }
+        top_ = chunks_[current_].begin;
+    }
+
+    std::vector<Chunk> chunks_;
+    size_t current_ = 0;
+    PyObject* top_ = nullptr;
+};
+
+/**
+ * ValueStack - a frame's value stack over a fixed slice of a DataStack
+ *
+ * Sized from co_stacksize, which the compiler computes exactly, so it
+ * never grows; overflowing it means the code object lied about its
+ * depth. Popped slots are left holding None.
+ */
+class ValueStack {
+public:
+    ValueStack() = default;
+    ValueStack(PyObject* base, size_t capacity, size_t size = 0)
+        : base_(base), top_(base + size), limit_(base + capacity) {}
+
+    void push_back(PyObject obj) {
+        if (top_ == limit_) {
+            throw std::runtime_error("Stack overflow: code object exceeds its co_stacksize");
+        }
+        *top_++ = std::move(obj);
+    }
+
+    void pop_back() { *--top_ = PyObject(); }
+
+    // Move the top value out (the caller has checked the stack is not empty)
+    PyObject take_back() { return std::move(*--top_); }
+
+    PyObject& back() { return top_[-1]; }
+    PyObject& operator[](size_t i) { return base_[i]; }
+    const PyObject& operator[](size_t i) const { return base_[i]; }
+
+    size_t size() const { return static_cast<size_t>(top_ - base_); }
+    bool empty() const { return top_ == base_; }
+
+    // The top n slots in push order (TOS last)
+    std::span<PyObject> last(size_t n) { return std::span<PyObject>(top_ - n, n); }
+
+    void drop(size_t n) {
+        while (n-- > 0) pop_back();
+    }
+
+    void clear() { drop(size()); }
+
+    // Where the JIT's generated code finds the top and the limit
+    static size_t top_offset() { return offsetof(ValueStack, top_); }
+    static size_t limit_offset() { return offsetof(ValueStack, limit_); }
+
+private:
+    PyObject* base_ = nullptr;
+    PyObject* top_ = nullptr;
+    PyObject* limit_ = nullptr;
+};
+
+} // namespace vm
+} // namespace cpython_cpp
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "vm.hpp"
+#include <chrono>
+#include <deque>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cpython_cpp {
+namespace vm {
+
+/**
+ * EventLoop - single-threaded scheduler for coroutines
+ * Reference: Lib/asyncio/base_events.py (_run_once), Lib/asyncio/tasks.py (Task.__step)
+ *
+ * Each task is a coroutine stepped with send(None) until it returns.
+ * Whatever reaches the loop through its chain of awaits decides where
+ * the task goes next: None (await sleep(0)) puts it at the back of the
+ * ready queue, a number of seconds (await sleep(t)) parks it on a timer
+ * heap until the deadline. Tasks run in FIFO order; the loop only
+ * blocks when every remaining task is waiting on a timer.
+ *
+ * An exception in a task propagates out of run(), as the VM has no
+ * exception objects for the task to hold yet.
+ */
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        PyObject coro;
+        PyObject result;  // Return value once done
+        bool done = false;
+    };
+
+    explicit EventLoop(VirtualMachine& vm) : vm_(vm) {}
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Schedule a coroutine; returns its task id
+    size_t create_task(PyObject coro) {
+        if (!is_coroutine(coro)) {
+            throw std::runtime_error(std::string("TypeError: a coroutine was expected, got '") +
+                                     type_name(coro) + "'");
+        }
+        tasks_.push_back(Task{std::move(coro), PyObject(), false});
+        ready_.push_back(tasks_.size() - 1);
+        return tasks_.size() - 1;
+    }
+
+    // Run until no task is left
+    void run() {
+        while (run_once()) {
+        }
+    }
+
+    // Schedule coro and run until it is done; returns its result
+    PyObject run_until_complete(PyObject coro) {
+        size_t id = create_task(std::move(coro));
+        while (!tasks_[id].done && run_once()) {
+        }
+        return tasks_[id].result;
+    }
+
+    const Task& task(size_t id) const { return tasks_.at(id); }
+    size_t steps() const { return steps_; }
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        size_t seq;  // FIFO among equal deadlines
+        size_t task;
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : seq > other.seq;
+        }
+    };
+
+    // Step one ready task, waiting for a timer if none is; false when idle
+    bool run_once() {
+        if (ready_.empty()) {
+            if (timers_.empty()) {
+                return false;
+            }
+            std::this_thread::sleep_until(timers_.top().deadline);
+        }
+        auto now = Clock::now();
+        while (!timers_.empty() && timers_.top().deadline <= now) {
+            ready_.push_back(timers_.top().task);
+            timers_.pop();
+        }
+        if (ready_.empty()) {
+            return true;
+        }
+
+        size_t id = ready_.front();
+        ready_.pop_front();
+        step(id);
+        return true;
+    }
+
+    void step(size_t id) {
+        steps_++;
+        // Hold a reference: running the task may grow tasks_
+        PyObject coro = tasks_[id].coro;
+        bool returned = false;
+        PyObject yielded = vm_.resume(*coro.as<PyGenerator>(), PyObject(), returned);
+        if (returned) {
+            tasks_[id].done = true;
+            tasks_[id].result = std::move(yielded);
+            tasks_[id].coro = PyObject();
+            return;
+        }
+        if (is_none(yielded)) {
+            ready_.push_back(id);
+            return;
+        }
+        if (is_int(yielded) || is_float(yielded)) {
+            double seconds = is_int(yielded) ? static_cast<double>(yielded.as_int()) : yielded.as_float();
+            if (seconds <= 0) {
+                ready_.push_back(id);
+                return;
+            }
+            auto delay = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+            timers_.push(Timer{Clock::now() + delay, timer_seq_++, id});
+            return;
+        }
+        throw std::runtime_error("RuntimeError: Task got bad yield: " + to_string(yielded));
+    }
+
+    VirtualMachine& vm_;
+    std::vector<Task> tasks_;
+    std::deque<size_t> ready_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    size_t timer_seq_ = 0;
+    size_t steps_ = 0;
+};
+
+} // namespace vm
+} // namespace cpython_cpp
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "vm.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+namespace cpython_cpp {
+namespace vm {
+
+/**
+ * Interpreter - an isolated VirtualMachine on a thread of its own
+ * Reference: Python/pylifecycle.c (Py_NewInterpreterFromConfig), PEP 684, PEP 734
+ *
+ * Every task of an interpreter runs on its dedicated thread, so its
+ * objects come from that thread's allocator heap, cycle collector and
+ * intern table. Interpreters share no mutable state and take no global
+ * lock, so N of them run N scripts in parallel. Compiled code is what
+ * they do share: a CodeObject is only read, and each VM quickens its own
+ * copy (see CodeState). One CodeObject can be handed to any number of
+ * interpreters at once.
+ *
+ * Objects must not cross interpreters. A task hands its result back as
+ * a plain C++ value, e.g. converted with to_string(). Tasks run in
+ * submission order and see the globals earlier tasks left behind. An
+ * exception a task throws is rethrown by its future.
+ *
+ * The destructor runs the tasks still queued, then destroys the VM and
+ * collects its cycles on the interpreter's thread.
+ */
+class Interpreter {
+public:
+    Interpreter();
+    ~Interpreter();
+
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    // Run fn(VirtualMachine&) on the interpreter's thread
+    template <typename F>
+    auto submit(F fn) -> std::future<std::invoke_result_t<F&, VirtualMachine&>> {
+        using Result = std::invoke_result_t<F&, VirtualMachine&>;
+        auto task = std::make_shared<std::packaged_task<Result(VirtualMachine&)>>(std::move(fn));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back([task](VirtualMachine& vm) { (*task)(vm); });
+        }
+        work_available_.notify_one();
+        return future;
+    }
+
+    // Execute module code in the interpreter's globals; yields what it printed
+    std::future<std::string> run(std::shared_ptr<compiler::CodeObject> code);
+
+private:
+    using Task = std::function<void(VirtualMachine&)>;
+
+    void thread_main();
+
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::deque<Task> tasks_;
+    bool stopping_ = false;
+    std::thread thread_;  // Last: starts once the queue exists
+};
+
+inline Interpreter::Interpreter() : thread_([this] { thread_main(); }) {}
+
+inline Interpreter::~Interpreter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_one();
+    thread_.join();
+}
+
+inline std::future<std::string> Interpreter::run(std::shared_ptr<compiler::CodeObject> code) {
+    return submit([code = std::move(code)](VirtualMachine& vm) {
+        std::ostringstream out;
+        std::ostream& previous = vm.stdout_stream();
+        vm.set_stdout(out);
+        try {
+            vm.execute(code);
+        } catch (...) {
+            vm.set_stdout(previous);
+            throw;
+        }
+        vm.set_stdout(previous);
+        return out.str();
+    });
+}
+
+inline void Interpreter::thread_main() {
+    {
+        VirtualMachine vm;
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_available_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    break;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task(vm);  // packaged_task stores any exception in the future
+        }
+    }
+    // Functions and their globals refer to each other; only the collector frees them
+    core::GarbageCollector::current().collect();
+}
+
+} // namespace vm
+} // namespace cpython_cpp
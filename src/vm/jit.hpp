@@ -0,0 +1,932 @@
+#pragma once
+
+#include "pyobject.hpp"
+#include "data_stack.hpp"
+#include "../compiler/code_object.hpp"
+#include "../compiler/opcode.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * The baseline JIT emits x86-64 code for the System V ABI (Linux, macOS,
+ * the BSDs). Elsewhere, or with CPYTHON_CPP_JIT=0, all code stays in the
+ * interpreter.
+ */
+#ifndef CPYTHON_CPP_JIT
+#if defined(__x86_64__) && !defined(_WIN32)
+#define CPYTHON_CPP_JIT 1
+#else
+#define CPYTHON_CPP_JIT 0
+#endif
+#endif
+
+// Calls plus loop back-edges before a code object is compiled
+#ifndef CPYTHON_CPP_JIT_THRESHOLD
+#define CPYTHON_CPP_JIT_THRESHOLD 1024
+#endif
+
+#if CPYTHON_CPP_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cpython_cpp {
+namespace vm {
+
+class VirtualMachine;
+struct Frame;
+
+/**
+ * JitStats - how often code tiered up and fell back (for tests and
+ * benchmarks)
+ */
+struct JitStats {
+    uint64_t compiled = 0;     // Code objects compiled (recompiles included)
+    uint64_t entries = 0;      // Calls that started in native code
+    uint64_t osr_entries = 0;  // Switches from a hot loop's back-edge
+    uint64_t deopts = 0;       // Guard failures (each discards the native code)
+    uint64_t side_exits = 0;   // Instructions left to the interpreter
+};
+
+#if CPYTHON_CPP_JIT
+
+/**
+ * JitFrame - what native code knows of the frame it runs
+ *
+ * Standard layout: the generated code reads it through offsetof. The
+ * stack top lives in a register while native code runs and is written
+ * back around every helper call and on exit.
+ */
+struct JitFrame {
+    ValueStack* stack;
+    PyObject* locals;          // frame.fastlocals
+    VirtualMachine* vm;
+    Frame* frame;
+    uint32_t exit_offset = 0;  // Where the interpreter takes over
+};
+
+enum class JitExit : uint32_t {
+    Return,      // RETURN_VALUE; exit_offset is past it
+    ReturnNone,  // Jumped past the end of the code
+    Error,       // A helper failed in the instruction ending at exit_offset;
+                 // the VM holds the exception
+    Deopt,       // The guard of the specialized instruction at exit_offset failed
+    SideExit,    // exit_offset is left to the interpreter
+};
+
+/**
+ * JitHelpers - the runtime the generated code calls into
+ *
+ * Helpers never throw into native code: a negative result means the
+ * exception is pending in the VM. JIT_HELPER_DEOPT means a type guard
+ * failed before anything changed.
+ */
+static constexpr int JIT_HELPER_DEOPT = 2;
+
+struct JitHelpers {
+    int (*generic)(JitFrame*, int opcode, int arg, int end_offset);  // One dispatch_opcode()
+    void (*incref)(core::RefCounted*);
+    void (*release)(core::RefCounted*);
+    int (*load_fast)(JitFrame*, int index);          // The unbound-local error
+    int (*pop_truth)(JitFrame*);                     // 1 / 0
+    int (*compare_and_pop)(JitFrame*, int op);       // 1 / 0
+    int (*for_iter)(JitFrame*);                      // 1 next, 0 exhausted
+    int (*for_iter_list)(JitFrame*);                 // ... or deopt
+    int (*for_iter_tuple)(JitFrame*);
+    int (*for_iter_range)(JitFrame*, int local);     // local >= 0 takes the value
+    int (*add_unicode)(JitFrame*, int arg, int end_offset);  // 0 or deopt
+    int (*compare_str)(JitFrame*, int op);           // 0 or deopt
+};
+
+namespace x64 {
+
+enum Reg : uint8_t { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+enum Xmm : uint8_t { XMM0, XMM1 };
+enum Cond : uint8_t { O, NO, B, AE, E, NE, BE, A, S, NS, P, NP, L, GE, LE, G };
+
+inline Cond negate(Cond cond) { return static_cast<Cond>(cond ^ 1); }
+
+struct Label {
+    uint32_t id;
+};
+
+/**
+ * Assembler - the handful of x86-64 encodings the baseline compiler uses
+ *
+ * Memory operands are [base + disp32]; jumps to labels are rel32 and
+ * patched by finish().
+ */
+class Assembler {
+public:
+    Label new_label() {
+        labels_.push_back(-1);
+        return Label{static_cast<uint32_t>(labels_.size() - 1)};
+    }
+
+    void bind(Label label) { labels_[label.id] = static_cast<int64_t>(code_.size()); }
+    size_t offset_of(Label label) const { return static_cast<size_t>(labels_[label.id]); }
+    size_t size() const { return code_.size(); }
+    const std::vector<uint8_t>& code() const { return code_; }
+
+    // Resolve the rel32 fields; false if a label was never bound
+    bool finish() {
+        for (const auto& [at, label] : fixups_) {
+            if (labels_[label] < 0) return false;
+            int32_t rel = static_cast<int32_t>(labels_[label] - static_cast<int64_t>(at + 4));
+            std::memcpy(&code_[at], &rel, 4);
+        }
+        return true;
+    }
+
+    // === Moves ===
+    void load(Reg dst, Reg base, int32_t disp) { op_mem(true, 0x8B, dst, base, disp); }           // mov r64, [m]
+    void store(Reg base, int32_t disp, Reg src) { op_mem(true, 0x89, src, base, disp); }          // mov [m], r64
+    void load_byte(Reg dst, Reg base, int32_t disp) { op_mem(false, 0x0FB6, dst, base, disp); }   // movzx r32, byte [m]
+    void lea(Reg dst, Reg base, int32_t disp) { op_mem(true, 0x8D, dst, base, disp); }
+    void mov(Reg dst, Reg src) { rex(true, src, dst); byte(0x89); modrm(3, src, dst); }
+
+    void mov_imm(Reg dst, uint64_t imm) {
+        if (imm <= UINT32_MAX) {  // mov r32, imm32 zero-extends
+            rex(false, 0, dst);
+            byte(0xB8 + (dst & 7));
+            u32(static_cast<uint32_t>(imm));
+        } else {
+            rex(true, 0, dst);
+            byte(0xB8 + (dst & 7));
+            u64(imm);
+        }
+    }
+
+    void store_imm_q(Reg base, int32_t disp, int32_t imm) { op_mem(true, 0xC7, 0, base, disp); u32(static_cast<uint32_t>(imm)); }
+    void store_imm_d(Reg base, int32_t disp, int32_t imm) { op_mem(false, 0xC7, 0, base, disp); u32(static_cast<uint32_t>(imm)); }
+    void store_imm_b(Reg base, int32_t disp, uint8_t imm) { op_mem(false, 0xC6, 0, base, disp); byte(imm); }
+
+    // === Arithmetic and compares ===
+    void add(Reg dst, Reg base, int32_t disp) { op_mem(true, 0x03, dst, base, disp); }
+    void sub(Reg dst, Reg base, int32_t disp) { op_mem(true, 0x2B, dst, base, disp); }
+    void imul(Reg dst, Reg base, int32_t disp) { op_mem(true, 0x0FAF, dst, base, disp); }
+    void cmp(Reg lhs, Reg base, int32_t disp) { op_mem(true, 0x3B, lhs, base, disp); }
+    void cmp(Reg lhs, Reg rhs) { rex(true, rhs, lhs); byte(0x39); modrm(3, rhs, lhs); }
+    void cmp_imm_b(Reg base, int32_t disp, uint8_t imm) { op_mem(false, 0x80, 7, base, disp); byte(imm); }
+    void cmp_imm_q(Reg base, int32_t disp, int8_t imm) { op_mem(true, 0x83, 7, base, disp); byte(static_cast<uint8_t>(imm)); }
+    void cmp_imm_d(Reg reg, int8_t imm) { rex(false, 0, reg); byte(0x83); modrm(3, 7, reg); byte(static_cast<uint8_t>(imm)); }
+    void test32(Reg a, Reg b) { rex(false, b, a); byte(0x85); modrm(3, b, a); }
+
+    // setcc and the byte ops take AL, CL or DL (no REX needed)
+    void setcc(Cond cond, Reg dst) { byte(0x0F); byte(0x90 + cond); modrm(3, 0, dst); }
+    void and_b(Reg dst, Reg src) { byte(0x20); modrm(3, src, dst); }
+    void or_b(Reg dst, Reg src) { byte(0x08); modrm(3, src, dst); }
+    void movzx_b(Reg dst, Reg src) { byte(0x0F); byte(0xB6); modrm(3, dst, src); }
+
+    // === SSE2 doubles ===
+    void movsd_load(Xmm dst, Reg base, int32_t disp) { sse(0xF2, 0x10, dst, base, disp); }
+    void movsd_store(Reg base, int32_t disp, Xmm src) { sse(0xF2, 0x11, src, base, disp); }
+    void addsd(Xmm dst, Reg base, int32_t disp) { sse(0xF2, 0x58, dst, base, disp); }
+    void subsd(Xmm dst, Reg base, int32_t disp) { sse(0xF2, 0x5C, dst, base, disp); }
+    void mulsd(Xmm dst, Reg base, int32_t disp) { sse(0xF2, 0x59, dst, base, disp); }
+    void ucomisd(Xmm a, Xmm b) { byte(0x66); byte(0x0F); byte(0x2E); modrm(3, a, b); }
+
+    // === Control flow ===
+    void jmp(Label target) { byte(0xE9); fixup(target); }
+    void jcc(Cond cond, Label target) { byte(0x0F); byte(0x80 + cond); fixup(target); }
+    void jmp(Reg target) { rex(false, 0, target); byte(0xFF); modrm(3, 4, target); }
+    void call(Reg target) { rex(false, 0, target); byte(0xFF); modrm(3, 2, target); }
+    void push(Reg reg) { if (reg >= 8) byte(0x41); byte(0x50 + (reg & 7)); }
+    void pop(Reg reg) { if (reg >= 8) byte(0x41); byte(0x58 + (reg & 7)); }
+    void ret() { byte(0xC3); }
+
+private:
+    std::vector<uint8_t> code_;
+    std::vector<int64_t> labels_;                        // Offset, or -1 while unbound
+    std::vector<std::pair<size_t, uint32_t>> fixups_;    // rel32 field, label
+
+    void byte(uint8_t b) { code_.push_back(b); }
+    void u32(uint32_t v) { for (int i = 0; i < 4; ++i) byte(static_cast<uint8_t>(v >> (8 * i))); }
+    void u64(uint64_t v) { for (int i = 0; i < 8; ++i) byte(static_cast<uint8_t>(v >> (8 * i))); }
+
+    void fixup(Label target) {
+        fixups_.emplace_back(code_.size(), target.id);
+        u32(0);
+    }
+
+    void rex(bool wide, unsigned reg, unsigned base) {
+        uint8_t prefix = 0x40 | (wide ? 8 : 0) | ((reg >> 3) & 1) << 2 | ((base >> 3) & 1);
+        if (prefix != 0x40) byte(prefix);
+    }
+
+    void modrm(unsigned mod, unsigned reg, unsigned rm) { byte(static_cast<uint8_t>(mod << 6 | (reg & 7) << 3 | (rm & 7))); }
+
+    // ModRM (+SIB for RSP/R12 bases) and displacement of [base + disp]
+    void mem(unsigned reg, Reg base, int32_t disp) {
+        unsigned mod = (disp == 0 && (base & 7) != RBP) ? 0 : (disp >= -128 && disp <= 127) ? 1 : 2;
+        modrm(mod, reg, base);
+        if ((base & 7) == RSP) byte(0x24);
+        if (mod == 1) byte(static_cast<uint8_t>(disp));
+        if (mod == 2) u32(static_cast<uint32_t>(disp));
+    }
+
+    // One- or two-byte (0x0F-escaped) opcode with a memory operand
+    void op_mem(bool wide, unsigned opcode, unsigned reg, Reg base, int32_t disp) {
+        rex(wide, reg, base);
+        if (opcode > 0xFF) byte(static_cast<uint8_t>(opcode >> 8));
+        byte(static_cast<uint8_t>(opcode));
+        mem(reg, base, disp);
+    }
+
+    void sse(uint8_t prefix, uint8_t opcode, unsigned xmm, Reg base, int32_t disp) {
+        byte(prefix);
+        rex(false, xmm, base);
+        byte(0x0F);
+        byte(opcode);
+        mem(xmm, base, disp);
+    }
+};
+
+} // namespace x64
+
+/**
+ * JitCode - native code for one CodeObject
+ *
+ * Every instruction start is an entry point, so a call enters at 0 and a
+ * hot loop at its back-edge's target (on-stack replacement).
+ */
+class JitCode {
+public:
+    using Entry = uint32_t (*)(JitFrame*, const void* target);
+
+    JitCode(const JitCode&) = delete;
+    JitCode& operator=(const JitCode&) = delete;
+    ~JitCode() { munmap(memory_, mapped_); }
+
+    // Native address of the instruction starting at offset; null if none
+    const void* entry_point(size_t offset) const {
+        if (offset % 2 != 0 || offset / 2 >= entries_.size() || entries_[offset / 2] == NO_ENTRY) {
+            return nullptr;
+        }
+        return static_cast<const uint8_t*>(memory_) + entries_[offset / 2];
+    }
+
+    JitExit run(JitFrame& frame, const void* target) const {
+        return static_cast<JitExit>(reinterpret_cast<Entry>(memory_)(&frame, target));
+    }
+
+    size_t code_size() const { return code_size_; }
+
+    // Map the assembled code executable; null if the OS refuses
+    static std::unique_ptr<JitCode> map(const std::vector<uint8_t>& code, std::vector<uint32_t> entries) {
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t mapped = (code.size() + page - 1) / page * page;
+        void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) return nullptr;
+        std::memcpy(memory, code.data(), code.size());
+        if (mprotect(memory, mapped, PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, mapped);
+            return nullptr;
+        }
+        return std::unique_ptr<JitCode>(new JitCode(memory, mapped, code.size(), std::move(entries)));
+    }
+
+    static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+
+private:
+    void* memory_;
+    size_t mapped_;
+    size_t code_size_;
+    std::vector<uint32_t> entries_;  // Native offset per code unit
+
+    JitCode(void* memory, size_t mapped, size_t code_size, std::vector<uint32_t> entries)
+        : memory_(memory), mapped_(mapped), code_size_(code_size), entries_(std::move(entries)) {}
+};
+
+/**
+ * BaselineCompiler - one pass from quickened bytecode to native code
+ * Reference: Python/jit.c, Tools/jit (CPython's copy-and-patch JIT)
+ *
+ * Each instruction becomes its handler, laid out in bytecode order, so
+ * dispatch disappears and jumps are native jumps. The specialized forms
+ * the interpreter settled on while warming up are inlined with their
+ * type guards: int and float arithmetic and compares work on the value
+ * stack and fast locals in place, and a failed guard deopts, leaving
+ * that instruction to the interpreter. Loads, stores and pops touch
+ * reference counts only for heap values. Everything else calls the
+ * interpreter's own handler (via JitHelpers), and the few instructions
+ * with no native form (yield, send) exit to the interpreter.
+ *
+ * Registers while native code runs (all callee-saved): RBX the
+ * JitFrame, R12 the fast locals, R13 the stack top, R14 the ValueStack
+ * and R15 its limit.
+ */
+class BaselineCompiler {
+public:
+    static std::unique_ptr<JitCode> compile(const compiler::CodeObject& code, const uint8_t* bytecode,
+                                            const std::vector<PyObject>& consts, size_t nlocals,
+                                            const JitHelpers& helpers) {
+        BaselineCompiler compiler(code, bytecode, consts, nlocals, helpers);
+        if (!compiler.decode() || !compiler.emit()) {
+            return nullptr;
+        }
+        std::vector<uint32_t> entries(compiler.unit_labels_.size(), JitCode::NO_ENTRY);
+        for (const auto& instr : compiler.instrs_) {
+            entries[instr.start / 2] = static_cast<uint32_t>(compiler.a_.offset_of(compiler.unit_labels_[instr.start / 2]));
+        }
+        return JitCode::map(compiler.a_.code(), std::move(entries));
+    }
+
+private:
+    using Opcode = compiler::Opcode;
+    using Label = x64::Label;
+    using Reg = x64::Reg;
+
+    static constexpr Reg FRAME = x64::RBX;
+    static constexpr Reg LOCALS = x64::R12;
+    static constexpr Reg SP = x64::R13;
+    static constexpr Reg STACK = x64::R14;
+    static constexpr Reg LIMIT = x64::R15;
+    static constexpr int32_t SLOT = sizeof(PyObject);
+
+    struct Instr {
+        uint32_t start;  // First byte, EXTENDED_ARG prefixes included
+        uint32_t end;    // Next instruction
+        Opcode op;
+        int arg;
+    };
+
+    const compiler::CodeObject& code_;
+    const uint8_t* bytecode_;
+    const std::vector<PyObject>& consts_;
+    size_t nlocals_;
+    const JitHelpers& helpers_;
+    size_t size_;
+    int32_t payload_;
+
+    x64::Assembler a_;
+    std::vector<Instr> instrs_;
+    std::vector<Label> unit_labels_;
+    std::vector<bool> starts_;
+    std::vector<std::function<void()>> cold_;  // Out-of-line paths, emitted after the body
+    Label epilogue_, return_none_;
+
+    BaselineCompiler(const compiler::CodeObject& code, const uint8_t* bytecode,
+                     const std::vector<PyObject>& consts, size_t nlocals, const JitHelpers& helpers)
+        : code_(code), bytecode_(bytecode), consts_(consts), nlocals_(nlocals), helpers_(helpers)
+        , size_(code.co_code.size()), payload_(static_cast<int32_t>(PyObject::payload_offset())) {}
+
+    // Split into instructions, folding EXTENDED_ARG as the interpreter does
+    bool decode() {
+        if (size_ == 0 || size_ % 2 != 0) return false;
+        starts_.assign(size_ / 2, false);
+        for (size_t pos = 0; pos < size_;) {
+            Instr instr{static_cast<uint32_t>(pos), 0, static_cast<Opcode>(bytecode_[pos]), bytecode_[pos + 1]};
+            pos += 2;
+            while (instr.op == Opcode::EXTENDED_ARG) {
+                if (pos >= size_) return false;
+                instr.op = static_cast<Opcode>(bytecode_[pos]);
+                instr.arg = (instr.arg << 8) | bytecode_[pos + 1];
+                pos += 2;
+            }
+            instr.end = static_cast<uint32_t>(pos);
+            starts_[instr.start / 2] = true;
+            instrs_.push_back(instr);
+        }
+        return true;
+    }
+
+    bool emit() {
+        for (size_t i = 0; i < size_ / 2; ++i) {
+            unit_labels_.push_back(a_.new_label());
+        }
+        epilogue_ = a_.new_label();
+        return_none_ = a_.new_label();
+
+        // uint32_t entry(JitFrame* rdi, const void* target rsi): five pushes
+        // after the return address keep calls 16-byte aligned
+        a_.push(x64::RBX);
+        a_.push(x64::R12);
+        a_.push(x64::R13);
+        a_.push(x64::R14);
+        a_.push(x64::R15);
+        a_.mov(FRAME, x64::RDI);
+        a_.load(LOCALS, FRAME, offsetof(JitFrame, locals));
+        a_.load(STACK, FRAME, offsetof(JitFrame, stack));
+        a_.load(SP, STACK, static_cast<int32_t>(ValueStack::top_offset()));
+        a_.load(LIMIT, STACK, static_cast<int32_t>(ValueStack::limit_offset()));
+        a_.jmp(x64::RSI);
+
+        for (const auto& instr : instrs_) {
+            a_.bind(unit_labels_[instr.start / 2]);
+            emit_instruction(instr);
+        }
+        // Falling off the end (only possible without a final RETURN_VALUE)
+        a_.jmp(return_none_);
+
+        // (A cold path may queue another, so each is moved out first)
+        for (size_t i = 0; i < cold_.size(); ++i) {
+            auto path = std::move(cold_[i]);
+            path();
+        }
+
+        a_.bind(return_none_);
+        exit_with(JitExit::ReturnNone, static_cast<uint32_t>(size_));
+        a_.bind(epilogue_);
+        sync_sp();
+        a_.pop(x64::R15);
+        a_.pop(x64::R14);
+        a_.pop(x64::R13);
+        a_.pop(x64::R12);
+        a_.pop(x64::RBX);
+        a_.ret();
+        return a_.finish();
+    }
+
+    // === Building blocks ===
+
+    void sync_sp() { a_.store(STACK, static_cast<int32_t>(ValueStack::top_offset()), SP); }
+    void reload_sp() { a_.load(SP, STACK, static_cast<int32_t>(ValueStack::top_offset())); }
+
+    int32_t local(int index) const { return static_cast<int32_t>(index) * SLOT; }
+
+    void exit_with(JitExit exit, uint32_t offset) {
+        a_.store_imm_d(FRAME, offsetof(JitFrame, exit_offset), static_cast<int32_t>(offset));
+        a_.mov_imm(x64::RAX, static_cast<uint32_t>(exit));
+        a_.jmp(epilogue_);
+    }
+
+    // A cold stub leaving through exit at offset
+    Label exit_label(JitExit exit, uint32_t offset) {
+        Label label = a_.new_label();
+        cold_.push_back([this, label, exit, offset] {
+            a_.bind(label);
+            exit_with(exit, offset);
+        });
+        return label;
+    }
+
+    // Where a jump to a bytecode offset lands
+    Label jump_label(size_t target) {
+        if (target >= size_) return return_none_;
+        if (target % 2 != 0 || !starts_[target / 2]) {
+            return exit_label(JitExit::SideExit, static_cast<uint32_t>(target));
+        }
+        return unit_labels_[target / 2];
+    }
+
+    // Call fn(frame, args...) with the stack top written back around it;
+    // a failure is reported as the instruction ending at end
+    template<typename Fn>
+    void call_helper(uint32_t end, Fn fn, std::initializer_list<int> args = {}) {
+        static constexpr Reg ARGS[] = {x64::RSI, x64::RDX, x64::RCX};
+        sync_sp();
+        a_.mov(x64::RDI, FRAME);
+        size_t i = 0;
+        for (int arg : args) {
+            a_.mov_imm(ARGS[i++], static_cast<uint32_t>(arg));
+        }
+        a_.mov_imm(x64::RAX, reinterpret_cast<uint64_t>(fn));
+        a_.call(x64::RAX);
+        reload_sp();
+        a_.test32(x64::RAX, x64::RAX);
+        a_.jcc(x64::S, exit_label(JitExit::Error, end));
+    }
+
+    // Side exit unless n more slots fit
+    void check_push(int n, const Instr& instr) {
+        a_.lea(x64::RAX, SP, n * SLOT);
+        a_.cmp(x64::RAX, LIMIT);
+        a_.jcc(x64::A, exit_label(JitExit::SideExit, instr.start));
+    }
+
+    // Type guard on the slot at SP + disp
+    void guard_tag(int32_t disp, PyTag tag, Label fail) {
+        a_.cmp_imm_b(SP, disp, static_cast<uint8_t>(tag));
+        a_.jcc(x64::NE, fail);
+    }
+
+    void push_local(int index, uint32_t end) {
+        int32_t slot = local(index);
+        Label unbound = a_.new_label();
+        Label heap = a_.new_label();
+        Label done = a_.new_label();
+        a_.cmp_imm_b(LOCALS, slot, static_cast<uint8_t>(PyTag::Null));
+        a_.jcc(x64::E, unbound);
+        a_.cmp_imm_b(LOCALS, slot, static_cast<uint8_t>(PyTag::Str));
+        a_.jcc(x64::AE, heap);
+        Label copy = a_.new_label();
+        a_.bind(copy);
+        a_.load(x64::RAX, LOCALS, slot);
+        a_.load(x64::RDX, LOCALS, slot + 8);
+        a_.store(SP, 0, x64::RAX);
+        a_.store(SP, 8, x64::RDX);
+        a_.lea(SP, SP, SLOT);
+        a_.bind(done);
+        cold_.push_back([this, slot, index, end, unbound, heap, copy, done] {
+            a_.bind(heap);
+            a_.load(x64::RDI, LOCALS, slot + payload_);
+            a_.mov_imm(x64::RAX, reinterpret_cast<uint64_t>(helpers_.incref));
+            a_.call(x64::RAX);
+            a_.jmp(copy);
+            // The interpreter's handler raises UnboundLocalError
+            a_.bind(unbound);
+            call_helper(end, helpers_.load_fast, {index});
+            a_.jmp(done);
+        });
+    }
+
+    void push_const(const PyObject& value) {
+        if (value.is_heap()) {
+            a_.mov_imm(x64::RDI, reinterpret_cast<uint64_t>(value.heap()));
+            a_.mov_imm(x64::RAX, reinterpret_cast<uint64_t>(helpers_.incref));
+            a_.call(x64::RAX);
+        }
+        a_.store_imm_q(SP, 0, static_cast<int32_t>(value.tag()));
+        uint64_t bits = value.payload_bits();
+        if (static_cast<int64_t>(bits) == static_cast<int32_t>(bits)) {
+            a_.store_imm_q(SP, payload_, static_cast<int32_t>(bits));
+        } else {
+            a_.mov_imm(x64::RAX, bits);
+            a_.store(SP, payload_, x64::RAX);
+        }
+        a_.lea(SP, SP, SLOT);
+    }
+
+    // Drop TOS: the slot goes back to None, heap values are released
+    void pop_top() {
+        Label heap = a_.new_label();
+        Label done = a_.new_label();
+        a_.lea(SP, SP, -SLOT);
+        a_.cmp_imm_b(SP, 0, static_cast<uint8_t>(PyTag::Str));
+        a_.jcc(x64::AE, heap);
+        a_.store_imm_b(SP, 0, static_cast<uint8_t>(PyTag::None));
+        a_.bind(done);
+        cold_.push_back([this, heap, done] {
+            a_.bind(heap);
+            a_.load(x64::RDI, SP, payload_);
+            a_.store_imm_b(SP, 0, static_cast<uint8_t>(PyTag::None));
+            release_rdi();
+            a_.jmp(done);
+        });
+    }
+
+    void release_rdi() {
+        sync_sp();
+        a_.mov_imm(x64::RAX, reinterpret_cast<uint64_t>(helpers_.release));
+        a_.call(x64::RAX);
+    }
+
+    void store_local(int index) {
+        int32_t slot = local(index);
+        Label heap = a_.new_label();
+        Label done = a_.new_label();
+        a_.lea(SP, SP, -SLOT);
+        a_.load(x64::RAX, SP, 0);
+        a_.load(x64::RDX, SP, 8);
+        a_.store_imm_b(SP, 0, static_cast<uint8_t>(PyTag::None));
+        a_.load_byte(x64::RCX, LOCALS, slot);
+        a_.load(x64::RSI, LOCALS, slot + payload_);
+        a_.store(LOCALS, slot, x64::RAX);
+        a_.store(LOCALS, slot + 8, x64::RDX);
+        a_.cmp_imm_d(x64::RCX, static_cast<int8_t>(PyTag::Str));
+        a_.jcc(x64::AE, heap);
+        a_.bind(done);
+        cold_.push_back([this, heap, done] {
+            a_.bind(heap);
+            a_.mov(x64::RDI, x64::RSI);
+            release_rdi();
+            a_.jmp(done);
+        });
+    }
+
+    // Pop the right operand of an in-place binary op (an immediate)
+    void drop_right() {
+        a_.store_imm_b(SP, -SLOT, static_cast<uint8_t>(PyTag::None));
+        a_.lea(SP, SP, -SLOT);
+    }
+
+    static x64::Cond int_cond(int op) {
+        static constexpr x64::Cond CONDS[] = {x64::L, x64::LE, x64::E, x64::NE, x64::G, x64::GE};
+        return CONDS[op];
+    }
+
+    static bool is_compare(int op) { return op >= 0 && op <= static_cast<int>(compiler::CompareOpCode::GE); }
+
+    // === Instructions ===
+
+    void emit_instruction(const Instr& instr) {
+        const int arg = instr.arg;
+        switch (instr.op) {
+            case Opcode::NOP:
+            case Opcode::RESUME:
+            case Opcode::CACHE:
+            case Opcode::BUILD_TEMPLATE:
+            case Opcode::BUILD_INTERPOLATION:
+                return;
+
+            case Opcode::LOAD_FAST:
+            case Opcode::LOAD_FAST_CHECK:
+                if (static_cast<size_t>(arg) >= nlocals_) break;
+                check_push(1, instr);
+                push_local(arg, instr.end);
+                return;
+
+            case Opcode::LOAD_FAST_LOAD_FAST:
+                if (static_cast<size_t>(arg >> 4) >= nlocals_ || static_cast<size_t>(arg & 15) >= nlocals_) break;
+                check_push(2, instr);
+                push_local(arg >> 4, instr.end);
+                push_local(arg & 15, instr.end);
+                return;
+
+            case Opcode::LOAD_FAST_LOAD_CONST:
+                if (static_cast<size_t>(arg >> 4) >= nlocals_ || static_cast<size_t>(arg & 15) >= consts_.size()) break;
+                check_push(2, instr);
+                push_local(arg >> 4, instr.end);
+                push_const(consts_[arg & 15]);
+                return;
+
+            case Opcode::LOAD_CONST:
+                if (static_cast<size_t>(arg) >= consts_.size()) break;
+                check_push(1, instr);
+                push_const(consts_[arg]);
+                return;
+
+            case Opcode::LOAD_SMALL_INT:
+                check_push(1, instr);
+                push_const(PyObject(static_cast<int64_t>(arg)));
+                return;
+
+            case Opcode::STORE_FAST:
+                if (static_cast<size_t>(arg) >= nlocals_) break;
+                store_local(arg);
+                return;
+
+            case Opcode::POP_TOP:
+            case Opcode::END_FOR:
+                pop_top();
+                return;
+
+            case Opcode::BINARY_OP_ADD_INT:
+            case Opcode::BINARY_OP_SUBTRACT_INT:
+            case Opcode::BINARY_OP_MULTIPLY_INT: {
+                Label deopt = exit_label(JitExit::Deopt, instr.start);
+                guard_tag(-2 * SLOT, PyTag::Int, deopt);
+                guard_tag(-SLOT, PyTag::Int, deopt);
+                a_.load(x64::RAX, SP, -2 * SLOT + payload_);
+                if (instr.op == Opcode::BINARY_OP_ADD_INT) a_.add(x64::RAX, SP, -SLOT + payload_);
+                if (instr.op == Opcode::BINARY_OP_SUBTRACT_INT) a_.sub(x64::RAX, SP, -SLOT + payload_);
+                if (instr.op == Opcode::BINARY_OP_MULTIPLY_INT) a_.imul(x64::RAX, SP, -SLOT + payload_);
+                a_.store(SP, -2 * SLOT + payload_, x64::RAX);
+                drop_right();
+                return;
+            }
+
+            case Opcode::BINARY_OP_ADD_FLOAT:
+            case Opcode::BINARY_OP_SUBTRACT_FLOAT:
+            case Opcode::BINARY_OP_MULTIPLY_FLOAT: {
+                Label deopt = exit_label(JitExit::Deopt, instr.start);
+                guard_tag(-2 * SLOT, PyTag::Float, deopt);
+                guard_tag(-SLOT, PyTag::Float, deopt);
+                a_.movsd_load(x64::XMM0, SP, -2 * SLOT + payload_);
+                if (instr.op == Opcode::BINARY_OP_ADD_FLOAT) a_.addsd(x64::XMM0, SP, -SLOT + payload_);
+                if (instr.op == Opcode::BINARY_OP_SUBTRACT_FLOAT) a_.subsd(x64::XMM0, SP, -SLOT + payload_);
+                if (instr.op == Opcode::BINARY_OP_MULTIPLY_FLOAT) a_.mulsd(x64::XMM0, SP, -SLOT + payload_);
+                a_.movsd_store(SP, -2 * SLOT + payload_, x64::XMM0);
+                drop_right();
+                return;
+            }
+
+            case Opcode::BINARY_OP_ADD_UNICODE:
+                call_helper(instr.end, helpers_.add_unicode, {arg, static_cast<int>(instr.end)});
+                a_.cmp_imm_d(x64::RAX, JIT_HELPER_DEOPT);
+                a_.jcc(x64::E, exit_label(JitExit::Deopt, instr.start));
+                return;
+
+            case Opcode::COMPARE_OP_INT:
+            case Opcode::COMPARE_OP_FLOAT: {
+                if (!is_compare(arg)) break;
+                Label deopt = exit_label(JitExit::Deopt, instr.start);
+                PyTag tag = instr.op == Opcode::COMPARE_OP_INT ? PyTag::Int : PyTag::Float;
+                guard_tag(-2 * SLOT, tag, deopt);
+                guard_tag(-SLOT, tag, deopt);
+                if (tag == PyTag::Int) {
+                    a_.load(x64::RAX, SP, -2 * SLOT + payload_);
+                    a_.cmp(x64::RAX, SP, -SLOT + payload_);
+                    a_.setcc(int_cond(arg), x64::RAX);
+                } else {
+                    emit_float_compare(arg);
+                }
+                a_.movzx_b(x64::RAX, x64::RAX);
+                a_.store(SP, -2 * SLOT + payload_, x64::RAX);  // A bool's whole payload is 0 or 1
+                a_.store_imm_b(SP, -2 * SLOT, static_cast<uint8_t>(PyTag::Bool));
+                drop_right();
+                return;
+            }
+
+            case Opcode::COMPARE_OP_STR:
+                call_helper(instr.end, helpers_.compare_str, {arg});
+                a_.cmp_imm_d(x64::RAX, JIT_HELPER_DEOPT);
+                a_.jcc(x64::E, exit_label(JitExit::Deopt, instr.start));
+                return;
+
+            case Opcode::COMPARE_OP_POP_JUMP_IF_FALSE:
+                if (emit_compare_and_branch(instr)) return;
+                break;
+
+            case Opcode::POP_JUMP_IF_FALSE:
+            case Opcode::POP_JUMP_IF_TRUE:
+                emit_pop_jump(instr.op == Opcode::POP_JUMP_IF_TRUE, static_cast<size_t>(arg), instr.end);
+                return;
+
+            case Opcode::JUMP_FORWARD:
+                a_.jmp(jump_label(instr.end + static_cast<size_t>(arg)));
+                return;
+
+            case Opcode::JUMP_BACKWARD:
+            case Opcode::JUMP_BACKWARD_NO_INTERRUPT:
+                // Out of range: the interpreter raises the error
+                if (static_cast<uint32_t>(arg) > instr.end) break;
+                a_.jmp(jump_label(instr.end - static_cast<uint32_t>(arg)));
+                return;
+
+            case Opcode::FOR_ITER:
+                call_helper(instr.end, helpers_.for_iter);
+                a_.test32(x64::RAX, x64::RAX);
+                a_.jcc(x64::E, jump_label(instr.end + static_cast<size_t>(arg)));
+                return;
+
+            case Opcode::FOR_ITER_LIST:
+            case Opcode::FOR_ITER_TUPLE:
+                call_helper(instr.end, instr.op == Opcode::FOR_ITER_LIST ? helpers_.for_iter_list : helpers_.for_iter_tuple);
+                emit_iter_step(instr);
+                return;
+
+            case Opcode::FOR_ITER_RANGE: {
+                // `for i in range(...)`: the helper stores straight into i
+                // and the STORE_FAST is skipped, as in the interpreter
+                int target = -1;
+                if (instr.end + 2 <= size_ && bytecode_[instr.end] == static_cast<uint8_t>(Opcode::STORE_FAST) &&
+                    bytecode_[instr.end + 1] < nlocals_) {
+                    target = bytecode_[instr.end + 1];
+                }
+                call_helper(instr.end, helpers_.for_iter_range, {target});
+                emit_iter_step(instr);
+                if (target >= 0) a_.jmp(jump_label(instr.end + 2));
+                return;
+            }
+
+            case Opcode::RETURN_VALUE:
+                exit_with(JitExit::Return, instr.end);
+                return;
+
+            case Opcode::LOAD_NAME:
+            case Opcode::STORE_NAME:
+            case Opcode::LOAD_GLOBAL:
+            case Opcode::STORE_GLOBAL:
+            case Opcode::DELETE_FAST:
+            case Opcode::LOAD_LOCALS:
+            case Opcode::BINARY_OP:
+            case Opcode::UNARY_NOT:
+            case Opcode::UNARY_NEGATIVE:
+            case Opcode::UNARY_INVERT:
+            case Opcode::COMPARE_OP:
+            case Opcode::CONTAINS_OP:
+            case Opcode::IS_OP:
+            case Opcode::CALL:
+            case Opcode::MAKE_FUNCTION:
+            case Opcode::LOAD_ATTR:
+            case Opcode::GET_ITER:
+            case Opcode::BUILD_LIST:
+            case Opcode::LIST_APPEND:
+            case Opcode::SET_ADD:
+            case Opcode::MAP_ADD:
+            case Opcode::BUILD_TUPLE:
+            case Opcode::BUILD_STRING:
+            case Opcode::FORMAT_SIMPLE:
+            case Opcode::FORMAT_WITH_SPEC:
+            case Opcode::CONVERT_VALUE:
+            case Opcode::BUILD_MAP:
+            case Opcode::BUILD_SET:
+            case Opcode::BINARY_SLICE:
+            case Opcode::BEFORE_WITH:
+                call_helper(instr.end, helpers_.generic, {static_cast<int>(instr.op),
+                                               compiler::opcode_has_arg(instr.op) ? arg : -1,
+                                               static_cast<int>(instr.end)});
+                return;
+
+            default:
+                break;
+        }
+        a_.jmp(exit_label(JitExit::SideExit, instr.start));
+    }
+
+    // Leaves the result in AL; NaN compares false except for !=
+    void emit_float_compare(int op) {
+        using compiler::CompareOpCode;
+        a_.movsd_load(x64::XMM0, SP, -2 * SLOT + payload_);
+        a_.movsd_load(x64::XMM1, SP, -SLOT + payload_);
+        switch (static_cast<CompareOpCode>(op)) {
+            case CompareOpCode::LT: a_.ucomisd(x64::XMM1, x64::XMM0); a_.setcc(x64::A, x64::RAX); break;
+            case CompareOpCode::LE: a_.ucomisd(x64::XMM1, x64::XMM0); a_.setcc(x64::AE, x64::RAX); break;
+            case CompareOpCode::GT: a_.ucomisd(x64::XMM0, x64::XMM1); a_.setcc(x64::A, x64::RAX); break;
+            case CompareOpCode::GE: a_.ucomisd(x64::XMM0, x64::XMM1); a_.setcc(x64::AE, x64::RAX); break;
+            case CompareOpCode::EQ:
+                a_.ucomisd(x64::XMM0, x64::XMM1);
+                a_.setcc(x64::E, x64::RAX);
+                a_.setcc(x64::NP, x64::RCX);
+                a_.and_b(x64::RAX, x64::RCX);
+                break;
+            case CompareOpCode::NE:
+                a_.ucomisd(x64::XMM0, x64::XMM1);
+                a_.setcc(x64::NE, x64::RAX);
+                a_.setcc(x64::P, x64::RCX);
+                a_.or_b(x64::RAX, x64::RCX);
+                break;
+        }
+    }
+
+    // After a FOR_ITER_* helper: deopt, or leave the loop when exhausted
+    void emit_iter_step(const Instr& instr) {
+        a_.cmp_imm_d(x64::RAX, JIT_HELPER_DEOPT);
+        a_.jcc(x64::E, exit_label(JitExit::Deopt, instr.start));
+        a_.test32(x64::RAX, x64::RAX);
+        a_.jcc(x64::E, jump_label(instr.end + static_cast<size_t>(instr.arg)));
+    }
+
+    /**
+     * COMPARE_OP_POP_JUMP_IF_FALSE with the POP_JUMP_IF_FALSE it consumes:
+     * two ints compare and branch inline, anything else goes through
+     * op_compare_and_pop(). The consumed jump is also compiled on its own,
+     * for jumps that land on it.
+     */
+    bool emit_compare_and_branch(const Instr& instr) {
+        if (!is_compare(instr.arg)) return false;
+        size_t pos = instr.end;
+        size_t target = 0;
+        while (pos + 2 <= size_ && bytecode_[pos] == static_cast<uint8_t>(Opcode::EXTENDED_ARG)) {
+            target = (target << 8) | bytecode_[pos + 1];
+            pos += 2;
+        }
+        if (pos + 2 > size_ || bytecode_[pos] != static_cast<uint8_t>(Opcode::POP_JUMP_IF_FALSE)) return false;
+        target = (target << 8) | bytecode_[pos + 1];
+        pos += 2;
+
+        Label slow = a_.new_label();
+        Label taken = jump_label(target);
+        Label next = jump_label(pos);
+        guard_tag(-2 * SLOT, PyTag::Int, slow);
+        guard_tag(-SLOT, PyTag::Int, slow);
+        a_.load(x64::RAX, SP, -2 * SLOT + payload_);
+        a_.cmp(x64::RAX, SP, -SLOT + payload_);
+        // Stores and lea leave the flags alone
+        a_.store_imm_b(SP, -2 * SLOT, static_cast<uint8_t>(PyTag::None));
+        a_.store_imm_b(SP, -SLOT, static_cast<uint8_t>(PyTag::None));
+        a_.lea(SP, SP, -2 * SLOT);
+        a_.jcc(x64::negate(int_cond(instr.arg)), taken);
+        a_.jmp(next);
+        int op = instr.arg;
+        uint32_t end = instr.end;
+        cold_.push_back([this, slow, taken, next, op, end] {
+            a_.bind(slow);
+            call_helper(end, helpers_.compare_and_pop, {op});
+            a_.test32(x64::RAX, x64::RAX);
+            a_.jcc(x64::E, taken);
+            a_.jmp(next);
+        });
+        return true;
+    }
+
+    // Bools and ints test inline; other values go through to_bool()
+    void emit_pop_jump(bool jump_if_true, size_t target, uint32_t end) {
+        Label taken = jump_label(target);
+        Label not_bool = a_.new_label();
+        Label done = a_.new_label();
+        x64::Cond jump = jump_if_true ? x64::NE : x64::E;
+        guard_tag(-SLOT, PyTag::Bool, not_bool);
+        a_.cmp_imm_b(SP, -SLOT + payload_, 0);
+        a_.store_imm_b(SP, -SLOT, static_cast<uint8_t>(PyTag::None));
+        a_.lea(SP, SP, -SLOT);
+        a_.jcc(jump, taken);
+        a_.bind(done);
+        cold_.push_back([this, not_bool, done, taken, jump, end] {
+            Label slow = a_.new_label();
+            a_.bind(not_bool);
+            guard_tag(-SLOT, PyTag::Int, slow);
+            a_.cmp_imm_q(SP, -SLOT + payload_, 0);
+            a_.store_imm_b(SP, -SLOT, static_cast<uint8_t>(PyTag::None));
+            a_.lea(SP, SP, -SLOT);
+            a_.jcc(jump, taken);
+            a_.jmp(done);
+            a_.bind(slow);
+            call_helper(end, helpers_.pop_truth);
+            a_.test32(x64::RAX, x64::RAX);
+            a_.jcc(jump, taken);
+            a_.jmp(done);
+        });
+    }
+};
+
+#endif // CPYTHON_CPP_JIT
+
+} // namespace vm
+} // namespace cpython_cpp
@@ -0,0 +1,516 @@
+#pragma once
+
+#include "../compiler/code_object.hpp"
+#include "../compiler/opcode.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace cpython_cpp {
+namespace vm {
+
+/**
+ * Profiler - opcode-level execution profile of one VirtualMachine
+ * Reference: Python/specialize.c (Py_STATS), Tools/scripts/summarize_stats.py
+ *
+ * VirtualMachine::set_profiling(true) routes every instruction through
+ * instruction(), which counts it and charges the cycles since the
+ * previous instruction to that one. Time is exclusive: a CALL is only
+ * charged for its own work, the callee's instructions for theirs. The
+ * profile records
+ *  - per opcode: executions, cycles, inline cache hits and misses,
+ *    deoptimizations and specialization attempts;
+ *  - pairs of consecutive opcodes within a frame (superinstruction
+ *    candidates);
+ *  - per code object and instruction offset, folded into source lines
+ *    through co_linetable when exported;
+ *  - the call tree, exported as folded stacks for flamegraph.pl.
+ *
+ * Opcodes are recorded as executed, so a quickened instruction counts
+ * under its specialized form. Cycles come from the time-stamp counter
+ * where there is one and are nanoseconds otherwise (see clock_name()).
+ *
+ * Code objects are identified by address, so a profile must not outlive
+ * the code the VM ran; their names and line tables are copied on first
+ * entry, so exporting only needs the profiler.
+ */
+class Profiler {
+public:
+    using Cycles = uint64_t;
+
+    struct OpcodeStats {
+        uint64_t count = 0;
+        Cycles cycles = 0;
+        uint64_t cache_hits = 0;            // Global/builtin inline cache
+        uint64_t cache_misses = 0;
+        uint64_t deopts = 0;                // Specialized form's guard failed
+        uint64_t specializations = 0;       // Adaptive form rewrote itself
+        uint64_t specialization_failures = 0;
+    };
+
+    struct InstructionStats {
+        uint64_t count = 0;
+        Cycles cycles = 0;
+    };
+
+    struct CodeProfile {
+        std::string name;
+        std::string filename;
+        int firstlineno = 0;
+        std::vector<std::pair<int, int>> linetable;  // Copy of co_linetable
+        std::vector<InstructionStats> instructions;  // One per code unit
+        uint64_t calls = 0;
+
+        int line_for_offset(int offset) const {
+            auto it = std::upper_bound(linetable.begin(), linetable.end(), offset,
+                                       [](int value, const std::pair<int, int>& entry) {
+                                           return value < entry.first;
+                                       });
+            return it == linetable.begin() ? 0 : std::prev(it)->second;
+        }
+    };
+
+private:
+    struct StackNode;
+
+    // Instruction the cycles since `start` belong to
+    struct Pending {
+        OpcodeStats* op = nullptr;
+        CodeProfile* code = nullptr;
+        uint32_t unit = 0;
+        StackNode* node = nullptr;
+        Cycles start = 0;
+    };
+
+public:
+    /**
+     * Activation - one frame's run in the profile (RAII)
+     * Resuming a generator is a new activation.
+     */
+    class Activation {
+    public:
+        Activation(Profiler& profiler, const compiler::CodeObject& code) : profiler_(profiler) {
+            profiler_.enter(*this, code);
+        }
+        ~Activation() { profiler_.leave(*this); }
+
+        Activation(const Activation&) = delete;
+        Activation& operator=(const Activation&) = delete;
+
+    private:
+        friend class Profiler;
+
+        Profiler& profiler_;
+        Activation* caller_ = nullptr;
+        CodeProfile* code_ = nullptr;
+        StackNode* node_ = nullptr;
+        int last_opcode_ = -1;   // For pair counts
+        Pending caller_pending_;  // The caller's CALL, charged again on return
+    };
+
+    Profiler() : pairs_(256 * 256, 0) {}
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    /**
+     * Current cycle count
+     */
+    static Cycles now() {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return static_cast<Cycles>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    static const char* clock_name() {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+        return "tsc";
+#elif defined(__aarch64__)
+        return "cntvct";
+#else
+        return "ns";
+#endif
+    }
+
+    /**
+     * Record the instruction at a byte offset of the running frame
+     * (instructions outside any activation are ignored)
+     */
+    void instruction(int offset, uint8_t opcode) {
+        Cycles t = now();
+        charge(t);
+        Activation* frame = top_;
+        if (!frame) {
+            return;
+        }
+        if (frame->last_opcode_ >= 0) {
+            ++pairs_[static_cast<size_t>(frame->last_opcode_) * 256 + opcode];
+        }
+        frame->last_opcode_ = opcode;
+
+        OpcodeStats& op = opcodes_[opcode];
+        ++op.count;
+        size_t unit = static_cast<size_t>(offset) / 2;
+        if (unit >= frame->code_->instructions.size()) {
+            frame->code_->instructions.resize(unit + 1);
+        }
+        InstructionStats& instr = frame->code_->instructions[unit];
+        ++instr.count;
+        ++frame->node_->instructions;
+        pending_ = {&op, frame->code_, static_cast<uint32_t>(unit), frame->node_, t};
+    }
+
+    // Inline cache of the current instruction was used
+    void cache_access(bool hit) {
+        if (pending_.op) {
+            ++(hit ? pending_.op->cache_hits : pending_.op->cache_misses);
+        }
+    }
+
+    // Current (specialized) instruction fell back to its generic form
+    void deopt() {
+        if (pending_.op) {
+            ++pending_.op->deopts;
+        }
+    }
+
+    // Current (adaptive) instruction tried to specialize itself
+    void specialization(bool success) {
+        if (pending_.op) {
+            ++(success ? pending_.op->specializations : pending_.op->specialization_failures);
+        }
+    }
+
+    /**
+     * Drop everything recorded so far (not while frames are being profiled)
+     */
+    void reset() {
+        opcodes_ = {};
+        std::fill(pairs_.begin(), pairs_.end(), 0);
+        codes_.clear();
+        root_ = {};
+        pending_ = {};
+    }
+
+    const OpcodeStats& opcode_stats(compiler::Opcode op) const {
+        return opcodes_[static_cast<uint8_t>(op)];
+    }
+
+    uint64_t pair_count(compiler::Opcode first, compiler::Opcode second) const {
+        return pairs_[static_cast<size_t>(first) * 256 + static_cast<uint8_t>(second)];
+    }
+
+    const CodeProfile* code_profile(const compiler::CodeObject& code) const {
+        auto it = codes_.find(&code);
+        return it == codes_.end() ? nullptr : it->second.get();
+    }
+
+    uint64_t total_instructions() const {
+        uint64_t total = 0;
+        for (const auto& op : opcodes_) {
+            total += op.count;
+        }
+        return total;
+    }
+
+    /**
+     * Whole profile as one JSON object; max_pairs and max_lines bound the
+     * pair and hot-line lists (most frequent / most expensive first)
+     */
+    void write_json(std::ostream& out, size_t max_pairs = 100, size_t max_lines = 50) const;
+
+    /**
+     * Call tree in flamegraph.pl's folded format, one line per stack:
+     * "module;caller;callee <cycles>" (self time of the last entry)
+     */
+    void write_folded_stacks(std::ostream& out) const;
+
+private:
+    // Call tree node: one per distinct stack of code objects
+    struct StackNode {
+        CodeProfile* code = nullptr;
+        std::map<CodeProfile*, std::unique_ptr<StackNode>> children;
+        Cycles cycles = 0;  // Self cycles
+        uint64_t instructions = 0;
+    };
+
+    std::array<OpcodeStats, 256> opcodes_{};
+    std::vector<uint64_t> pairs_;  // 256 x 256, [first][second]
+    std::unordered_map<const compiler::CodeObject*, std::unique_ptr<CodeProfile>> codes_;
+    StackNode root_;
+    Activation* top_ = nullptr;
+    Pending pending_;
+
+    void charge(Cycles t) {
+        if (!pending_.op) {
+            return;
+        }
+        Cycles elapsed = t - pending_.start;
+        pending_.op->cycles += elapsed;
+        pending_.code->instructions[pending_.unit].cycles += elapsed;
+        pending_.node->cycles += elapsed;
+    }
+
+    CodeProfile& profile_for(const compiler::CodeObject& code) {
+        auto& slot = codes_[&code];
+        if (!slot) {
+            slot = std::make_unique<CodeProfile>();
+            slot->name = code.co_qualname.empty() ? code.co_name : code.co_qualname;
+            slot->filename = code.co_filename;
+            slot->firstlineno = code.co_firstlineno;
+            slot->linetable = code.co_linetable;
+            slot->instructions.resize(code.co_code.size() / 2);
+        }
+        return *slot;
+    }
+
+    void enter(Activation& frame, const compiler::CodeObject& code) {
+        Cycles t = now();
+        charge(t);
+        frame.caller_ = top_;
+        frame.code_ = &profile_for(code);
+        ++frame.code_->calls;
+        StackNode* parent = top_ ? top_->node_ : &root_;
+        auto& child = parent->children[frame.code_];
+        if (!child) {
+            child = std::make_unique<StackNode>();
+            child->code = frame.code_;
+        }
+        frame.node_ = child.get();
+        frame.caller_pending_ = pending_;
+        pending_ = {};
+        top_ = &frame;
+    }
+
+    void leave(Activation& frame) {
+        Cycles t = now();
+        charge(t);
+        top_ = frame.caller_;
+        pending_ = frame.caller_pending_;
+        pending_.start = t;
+    }
+
+    static void write_json_string(std::ostream& out, const std::string& s) {
+        out << '"';
+        for (char c : s) {
+            switch (c) {
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                            << static_cast<int>(c) << std::dec << std::setfill(' ');
+                    } else {
+                        out << c;
+                    }
+            }
+        }
+        out << '"';
+    }
+
+    static const char* name_of(size_t opcode) {
+        return compiler::opcode_name(static_cast<compiler::Opcode>(opcode));
+    }
+
+    // Opcodes the VM rewrites instructions to once warm (see quicken())
+    static bool is_specialized(size_t opcode) {
+        using compiler::Opcode;
+        switch (static_cast<Opcode>(opcode)) {
+            case Opcode::BINARY_OP_ADD_INT:
+            case Opcode::BINARY_OP_SUBTRACT_INT:
+            case Opcode::BINARY_OP_MULTIPLY_INT:
+            case Opcode::BINARY_OP_ADD_FLOAT:
+            case Opcode::BINARY_OP_SUBTRACT_FLOAT:
+            case Opcode::BINARY_OP_MULTIPLY_FLOAT:
+            case Opcode::BINARY_OP_ADD_UNICODE:
+            case Opcode::COMPARE_OP_INT:
+            case Opcode::COMPARE_OP_FLOAT:
+            case Opcode::COMPARE_OP_STR:
+            case Opcode::FOR_ITER_LIST:
+            case Opcode::FOR_ITER_TUPLE:
+            case Opcode::FOR_ITER_RANGE:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static void write_folded(std::ostream& out, const StackNode& node, std::string& stack) {
+        size_t length = stack.size();
+        for (const auto& [code, child] : node.children) {
+            if (!stack.empty()) {
+                stack += ';';
+            }
+            stack += code->name;
+            if (child->cycles > 0) {
+                out << stack << ' ' << child->cycles << '\n';
+            }
+            write_folded(out, *child, stack);
+            stack.resize(length);
+        }
+    }
+};
+
+inline void Profiler::write_json(std::ostream& out, size_t max_pairs, size_t max_lines) const {
+    Cycles total_cycles = 0;
+    for (const auto& op : opcodes_) {
+        total_cycles += op.cycles;
+    }
+    out << "{\n  \"clock\": \"" << clock_name() << "\",\n"
+        << "  \"instructions\": " << total_instructions() << ",\n"
+        << "  \"cycles\": " << total_cycles << ",\n";
+
+    // Opcodes, most executed first
+    std::vector<size_t> order;
+    for (size_t i = 0; i < opcodes_.size(); ++i) {
+        if (opcodes_[i].count > 0) {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return opcodes_[a].count > opcodes_[b].count;
+    });
+    out << "  \"opcodes\": [";
+    for (size_t i = 0; i < order.size(); ++i) {
+        const OpcodeStats& op = opcodes_[order[i]];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << name_of(order[i]) << "\", \"count\": "
+            << op.count << ", \"cycles\": " << op.cycles;
+        if (op.cache_hits + op.cache_misses > 0) {
+            out << ", \"cache_hits\": " << op.cache_hits << ", \"cache_misses\": " << op.cache_misses
+                << ", \"hit_rate\": "
+                << static_cast<double>(op.cache_hits) / static_cast<double>(op.cache_hits + op.cache_misses);
+        } else if (is_specialized(order[i])) {
+            // Every execution tests the guard; a deopt is its miss
+            out << ", \"deopts\": " << op.deopts << ", \"hit_rate\": "
+                << static_cast<double>(op.count - std::min(op.deopts, op.count)) / static_cast<double>(op.count);
+        }
+        if (op.specializations + op.specialization_failures > 0) {
+            out << ", \"specializations\": " << op.specializations
+                << ", \"specialization_failures\": " << op.specialization_failures;
+        }
+        out << "}";
+    }
+    out << "\n  ],\n";
+
+    // Pairs, most frequent first
+    std::vector<std::pair<uint64_t, size_t>> pairs;
+    for (size_t i = 0; i < pairs_.size(); ++i) {
+        if (pairs_[i] > 0) {
+            pairs.emplace_back(pairs_[i], i);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    pairs.resize(std::min(pairs.size(), max_pairs));
+    out << "  \"pairs\": [";
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "    {\"first\": \"" << name_of(pairs[i].second / 256)
+            << "\", \"second\": \"" << name_of(pairs[i].second % 256) << "\", \"count\": "
+            << pairs[i].first << "}";
+    }
+    out << "\n  ],\n";
+
+    // Code objects, most expensive first, with their lines in source order
+    struct Line {
+        const CodeProfile* code;
+        int line;
+        InstructionStats stats;
+    };
+    std::vector<std::pair<const CodeProfile*, InstructionStats>> codes;
+    std::vector<Line> lines;
+    for (const auto& [key, code] : codes_) {
+        InstructionStats total;
+        std::map<int, InstructionStats> by_line;
+        for (size_t unit = 0; unit < code->instructions.size(); ++unit) {
+            const InstructionStats& instr = code->instructions[unit];
+            if (instr.count == 0) {
+                continue;
+            }
+            InstructionStats& line = by_line[code->line_for_offset(static_cast<int>(unit * 2))];
+            line.count += instr.count;
+            line.cycles += instr.cycles;
+            total.count += instr.count;
+            total.cycles += instr.cycles;
+        }
+        codes.emplace_back(code.get(), total);
+        for (const auto& [line, stats] : by_line) {
+            lines.push_back({code.get(), line, stats});
+        }
+    }
+    std::sort(codes.begin(), codes.end(), [](const auto& a, const auto& b) {
+        if (a.second.cycles != b.second.cycles) return a.second.cycles > b.second.cycles;
+        return a.first->name < b.first->name;
+    });
+    out << "  \"code\": [";
+    for (size_t i = 0; i < codes.size(); ++i) {
+        const CodeProfile& code = *codes[i].first;
+        out << (i ? ",\n" : "\n") << "    {\"name\": ";
+        write_json_string(out, code.name);
+        out << ", \"filename\": ";
+        write_json_string(out, code.filename);
+        out << ", \"firstlineno\": " << code.firstlineno << ", \"calls\": " << code.calls
+            << ", \"count\": " << codes[i].second.count << ", \"cycles\": " << codes[i].second.cycles
+            << ", \"lines\": [";
+        bool first = true;
+        for (const Line& line : lines) {
+            if (line.code != &code) {
+                continue;
+            }
+            out << (first ? "" : ", ") << "{\"line\": " << line.line << ", \"count\": "
+                << line.stats.count << ", \"cycles\": " << line.stats.cycles << "}";
+            first = false;
+        }
+        out << "]}";
+    }
+    out << "\n  ],\n";
+
+    // Hot lines across all code
+    std::sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+        if (a.stats.cycles != b.stats.cycles) return a.stats.cycles > b.stats.cycles;
+        return a.stats.count > b.stats.count;
+    });
+    lines.resize(std::min(lines.size(), max_lines));
+    out << "  \"hot_lines\": [";
+    for (size_t i = 0; i < lines.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "    {\"code\": ";
+        write_json_string(out, lines[i].code->name);
+        out << ", \"filename\": ";
+        write_json_string(out, lines[i].code->filename);
+        out << ", \"line\": " << lines[i].line << ", \"count\": " << lines[i].stats.count
+            << ", \"cycles\": " << lines[i].stats.cycles << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+inline void Profiler::write_folded_stacks(std::ostream& out) const {
+    std::string stack;
+    write_folded(out, root_, stack);
+}
+
+} // namespace vm
+} // namespace cpython_cpp
@@ -1,18 +1,30 @@
 #pragma once
 
-#include <variant>
+#include "../core/refcount.hpp"
+#include "../core/gc.hpp"
+#include "../compiler/code_object.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 #include <string>
 #include <vector>
-#include <map>
 #include <memory>
+#include <functional>
+#include <string_view>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <unordered_map>
 
 namespace cpython_cpp {
 namespace vm {
 
 // Forward declarations
+class PyStr;
 class PyList;
 class PyDict;
 class PyTuple;
@@ -20,33 +32,384 @@ class PySet;
 class PyFunction;
 class PyClass;
 class PyInstance;
+class PyCode;
+class PyGenerator;
+class PyMethod;
+class PyRange;
+class PyRangeIterator;
+class PySeqIterator;
+
+/**
+ * Type tag of a PyObject. Tags from Str on carry a heap pointer.
+ */
+enum class PyTag : uint8_t {
+    Null,       // Unbound local slot; never visible to Python code
+    None,
+    Bool,
+    Int,
+    Float,
+    Str,
+    List,
+    Dict,
+    Tuple,
+    Set,
+    Function,
+    Class,
+    Instance,
+    Code,       // Code object constant, the operand of MAKE_FUNCTION
+    Generator,
+    Coroutine,
+    Method,     // Built-in method bound to its receiver
+    Range,
+    RangeIterator,
+    SeqIterator,  // Iterator over a list, tuple, str, dict or set
+};
 
 /**
  * PyObject - Runtime representation of Python objects
  * 
- * Uses std::variant to represent different Python types.
- * This is the core value type used throughout the VM.
+ * A 16-byte tagged value: None, bool, int and float are stored inline,
+ * everything else (including str) is a pointer to a core::RefCounted
+ * heap object. Copies of immediates are plain stores; copies of heap
+ * values bump the intrusive count. This is the core value type used
+ * throughout the VM.
+ */
+class PyObject {
+public:
+    PyObject() noexcept : tag_(PyTag::None) { bits_.i = 0; }
+    
+    PyObject(bool value) noexcept : tag_(PyTag::Bool) {
+        bits_.i = 0;
+        bits_.b = value;
+    }
+    
+    template<typename I, std::enable_if_t<std::is_integral_v<I> && !std::is_same_v<I, bool>, int> = 0>
+    PyObject(I value) noexcept : tag_(PyTag::Int) { bits_.i = static_cast<int64_t>(value); }
+    
+    PyObject(double value) noexcept : tag_(PyTag::Float) { bits_.f = value; }
+    
+    // Strings live in a heap PyStr (defined below)
+    PyObject(std::string value);
+    PyObject(const char* value);
+    
+    template<typename T>
+    PyObject(const core::Ref<T>& ref) noexcept : tag_(T::TAG) {
+        bits_.obj = ref.get();
+        if (bits_.obj) bits_.obj->incref(); else tag_ = PyTag::None;
+    }
+    
+    template<typename T>
+    PyObject(core::Ref<T>&& ref) noexcept : tag_(T::TAG) {
+        bits_.obj = ref.detach();
+        if (!bits_.obj) tag_ = PyTag::None;
+    }
+    
+    PyObject(const PyObject& other) noexcept : tag_(other.tag_), bits_(other.bits_) {
+        if (is_heap()) bits_.obj->incref();
+    }
+    
+    PyObject(PyObject&& other) noexcept : tag_(other.tag_), bits_(other.bits_) {
+        other.tag_ = PyTag::None;
+    }
+    
+    PyObject& operator=(const PyObject& other) noexcept {
+        if (other.is_heap()) other.bits_.obj->incref();
+        PyObject old(std::move(*this));
+        tag_ = other.tag_;
+        bits_ = other.bits_;
+        return *this;
+    }
+    
+    PyObject& operator=(PyObject&& other) noexcept {
+        if (this != &other) {
+            PyObject old(std::move(*this));
+            tag_ = other.tag_;
+            bits_ = other.bits_;
+            other.tag_ = PyTag::None;
+        }
+        return *this;
+    }
+    
+    ~PyObject() {
+        if (is_heap()) bits_.obj->release();
+    }
+    
+    // Marker for an unbound local slot
+    static PyObject null() noexcept {
+        PyObject obj;
+        obj.tag_ = PyTag::Null;
+        return obj;
+    }
+    
+    PyTag tag() const noexcept { return tag_; }
+    bool is_null() const noexcept { return tag_ == PyTag::Null; }
+    bool is_heap() const noexcept { return tag_ >= PyTag::Str; }
+    
+    // Unchecked payload access; callers test the tag first
+    bool as_bool() const noexcept { return bits_.b; }
+    int64_t as_int() const noexcept { return bits_.i; }
+    double as_float() const noexcept { return bits_.f; }
+    inline const std::string& as_string() const noexcept;
+    
+    template<typename T>
+    T* as() const noexcept { return static_cast<T*>(bits_.obj); }
+    
+    // New owning handle to the heap payload
+    template<typename T>
+    core::Ref<T> ref() const noexcept { return core::Ref<T>(as<T>()); }
+    
+    // Heap address, for identity hashing
+    const void* heap() const noexcept { return is_heap() ? bits_.obj : nullptr; }
+    
+    // Same tag and same payload bits: Python's `is`
+    friend bool identical(const PyObject& a, const PyObject& b) noexcept {
+        return a.tag_ == b.tag_ && a.bits_.i == b.bits_.i;
+    }
+    
+    // Layout the JIT's generated code works on (see jit.hpp): a tag byte,
+    // then the eight payload bytes
+    static size_t payload_offset() noexcept { return offsetof(PyObject, bits_); }
+    uint64_t payload_bits() const noexcept {
+        uint64_t bits;
+        std::memcpy(&bits, &bits_, sizeof(bits));
+        return bits;
+    }
+    
+private:
+    PyTag tag_;
+    union Bits {
+        bool b;
+        int64_t i;
+        double f;
+        core::RefCounted* obj;
+    } bits_;
+};
+
+static_assert(sizeof(PyObject) == 16, "PyObject should stay two words");
+
+inline size_t hash_string(std::string_view str) {
+    return std::hash<std::string_view>{}(str);
+}
+
+/**
+ * PyStr - Python str type (immutable)
+ * Reference: Objects/unicodeobject.c
+ * 
+ * The hash is computed on first use and cached. Interned strings (see
+ * intern_string) are unique per value, so two of them are equal exactly
+ * when they are the same object. The only in-place change is append(),
+ * which the VM uses for `s += x` while it holds the sole reference.
+ */
+class PyStr : public core::RefCounted {
+public:
+    static constexpr PyTag TAG = PyTag::Str;
+    
+    std::string value;
+    bool interned = false;
+    
+    explicit PyStr(std::string value) : value(std::move(value)) {}
+    
+    size_t hash() const {
+        size_t hash = hash_.load(std::memory_order_relaxed);
+        if (hash == 0) {
+            hash = hash_string(value);
+            hash_.store(hash, std::memory_order_relaxed);
+        }
+        return hash;
+    }
+    
+    // Grow in place; the caller owns the only reference
+    void append(std::string_view tail) {
+        value.append(tail);
+        hash_.store(0, std::memory_order_relaxed);
+    }
+    
+private:
+    mutable std::atomic<size_t> hash_{0};  // 0 = not computed yet
+};
+
+inline PyObject::PyObject(std::string value)
+    : PyObject(core::make_ref<PyStr>(std::move(value))) {}
+
+inline PyObject::PyObject(const char* value)
+    : PyObject(std::string(value)) {}
+
+inline const std::string& PyObject::as_string() const noexcept {
+    return as<PyStr>()->value;
+}
+
+/**
+ * intern_string - the shared PyStr for a value (sys.intern)
+ * Reference: Objects/unicodeobject.c (_PyUnicode_InternMortal)
+ * 
+ * Used for identifiers, identifier-like constants and the keys of name
+ * dicts, so those compare by pointer. There is one table per thread,
+ * shared by the interpreters running on it (CPython keeps one per
+ * interpreter): interpreters on different threads never share a string
+ * or its count, and need no lock. Interned strings live until their
+ * thread exits.
+ */
+inline PyObject intern_string(std::string_view value) {
+    struct InternTable {
+        std::unordered_map<std::string_view, core::Ref<PyStr>> strings;  // Keys view the values
+    };
+    static thread_local InternTable table;
+    
+    auto it = table.strings.find(value);
+    if (it != table.strings.end()) {
+        return it->second;
+    }
+    auto str = core::make_ref<PyStr>(std::string(value));
+    str->interned = true;
+    str->hash();
+    std::string_view key = str->value;
+    PyObject result = str;
+    table.strings.emplace(key, std::move(str));
+    return result;
+}
+
+// True for non-empty [A-Za-z0-9_] strings, which CPython interns as constants
+inline bool all_name_chars(std::string_view value) {
+    return !value.empty() && std::all_of(value.begin(), value.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    });
+}
+
+/**
+ * Type checking helpers
+ */
+inline bool is_none(const PyObject& obj) {
+    return obj.tag() == PyTag::None;
+}
+
+inline bool is_bool(const PyObject& obj) {
+    return obj.tag() == PyTag::Bool;
+}
+
+inline bool is_int(const PyObject& obj) {
+    return obj.tag() == PyTag::Int;
+}
+
+inline bool is_float(const PyObject& obj) {
+    return obj.tag() == PyTag::Float;
+}
+
+// bool, int or float
+inline bool is_number(const PyObject& obj) {
+    return obj.tag() >= PyTag::Bool && obj.tag() <= PyTag::Float;
+}
+
+inline bool is_string(const PyObject& obj) {
+    return obj.tag() == PyTag::Str;
+}
+
+inline bool is_list(const PyObject& obj) {
+    return obj.tag() == PyTag::List;
+}
+
+inline bool is_dict(const PyObject& obj) {
+    return obj.tag() == PyTag::Dict;
+}
+
+inline bool is_tuple(const PyObject& obj) {
+    return obj.tag() == PyTag::Tuple;
+}
+
+inline bool is_set(const PyObject& obj) {
+    return obj.tag() == PyTag::Set;
+}
+
+inline bool is_function(const PyObject& obj) {
+    return obj.tag() == PyTag::Function;
+}
+
+inline bool is_code(const PyObject& obj) {
+    return obj.tag() == PyTag::Code;
+}
+
+inline bool is_generator(const PyObject& obj) {
+    return obj.tag() == PyTag::Generator;
+}
+
+inline bool is_coroutine(const PyObject& obj) {
+    return obj.tag() == PyTag::Coroutine;
+}
+
+inline bool is_method(const PyObject& obj) {
+    return obj.tag() == PyTag::Method;
+}
+
+inline bool is_range(const PyObject& obj) {
+    return obj.tag() == PyTag::Range;
+}
+
+inline bool is_range_iterator(const PyObject& obj) {
+    return obj.tag() == PyTag::RangeIterator;
+}
+
+inline bool is_seq_iterator(const PyObject& obj) {
+    return obj.tag() == PyTag::SeqIterator;
+}
+
+/**
+ * Cycle collection (see core::GarbageCollector): containers derive from
+ * core::GCObject, and their traverse() reports each PyObject they hold
+ * through gc_visit, which skips atomic values.
  */
-using PyObject = std::variant<
-    std::monostate,                    // None
-    bool,                              // True, False
-    int64_t,                           // int
-    double,                            // float
-    std::string,                       // str
-    std::shared_ptr<PyList>,           // list
-    std::shared_ptr<PyDict>,           // dict
-    std::shared_ptr<PyTuple>,          // tuple
-    std::shared_ptr<PySet>,            // set
-    std::shared_ptr<PyFunction>,       // function
-    std::shared_ptr<PyClass>,          // class
-    std::shared_ptr<PyInstance>        // instance
->;
+inline bool is_gc_container(const PyObject& obj) {
+    switch (obj.tag()) {
+        case PyTag::List:
+        case PyTag::Dict:
+        case PyTag::Tuple:
+        case PyTag::Set:
+        case PyTag::Function:
+        case PyTag::Generator:
+        case PyTag::Coroutine:
+        case PyTag::Method:
+        case PyTag::SeqIterator:
+            return true;
+        default:
+            return false;
+    }
+}
+
+inline void gc_visit(core::GCVisitor& visitor, const PyObject& obj) {
+    if (is_gc_container(obj)) {
+        visitor.visit(obj.as<core::GCObject>());
+    }
+}
+
+/**
+ * Type conversion helpers
+ */
+inline int64_t to_int(const PyObject& obj) {
+    switch (obj.tag()) {
+        case PyTag::Int: return obj.as_int();
+        case PyTag::Bool: return obj.as_bool() ? 1 : 0;
+        case PyTag::Float: return static_cast<int64_t>(obj.as_float());
+        default: throw std::runtime_error("Cannot convert to int");
+    }
+}
+
+inline double to_float(const PyObject& obj) {
+    switch (obj.tag()) {
+        case PyTag::Float: return obj.as_float();
+        case PyTag::Int: return static_cast<double>(obj.as_int());
+        case PyTag::Bool: return obj.as_bool() ? 1.0 : 0.0;
+        default: throw std::runtime_error("Cannot convert to float");
+    }
+}
+
+// Defined after the container types
+inline bool to_bool(const PyObject& obj);
 
 /**
  * PyList - Python list type
  */
-class PyList {
+class PyList : public core::GCObject {
 public:
+    static constexpr PyTag TAG = PyTag::List;
+    
     std::vector<PyObject> items;
     
     PyList() = default;
@@ -56,38 +419,365 @@ public:
     void append(const PyObject& obj) { items.push_back(obj); }
     PyObject& operator[](size_t index) { return items[index]; }
     const PyObject& operator[](size_t index) const { return items[index]; }
+    
+    void traverse(core::GCVisitor& visitor) const override {
+        for (const auto& item : items) gc_visit(visitor, item);
+    }
+    
+    // Items are released after the list is already empty
+    void clear() override { std::vector<PyObject>().swap(items); }
+};
+
+/**
+ * Hashing and equality shared by PyDict and PySet (defined further below)
+ * Reference: Objects/object.c (PyObject_Hash, PyObject_RichCompare)
+ * 
+ * Numbers that compare equal hash equal (True == 1 == 1.0); list, dict
+ * and set are unhashable and py_hash throws TypeError for them.
+ */
+inline size_t py_hash(const PyObject& obj);
+inline bool py_equals(const PyObject& a, const PyObject& b);
+inline bool is_hashable(const PyObject& obj);
+
+/**
+ * Fresh keys version (CPython's dk_version). Versions are unique across
+ * all tables, so equal versions mean the same table with the same layout.
+ * Each thread reserves a block of versions at a time, so threads running
+ * separate interpreters do not contend on the shared counter.
+ */
+inline uint64_t next_keys_version() {
+    static constexpr uint64_t BLOCK = 1 << 16;
+    static std::atomic<uint64_t> counter{0};
+    thread_local uint64_t next = 0;
+    thread_local uint64_t limit = 0;
+    if (next == limit) {
+        next = counter.fetch_add(BLOCK, std::memory_order_relaxed) + 1;
+        limit = next + BLOCK;
+    }
+    return next++;
+}
+
+/**
+ * CompactHashTable - open-addressing table shared by PyDict and PySet
+ * Reference: Objects/dictobject.c
+ * 
+ * Compact layout as in CPython 3.6+: a dense entries array in insertion
+ * order plus a sparse power-of-two index table. Entries cache their hash,
+ * so probes only compare keys with matching hashes and resizes never
+ * rehash. Entry must provide `hash`, `key` and `live` members.
+ * 
+ * keys_version() changes whenever entry indices may change (insertion,
+ * deletion, resize), so an inline cache holding an entry index stays
+ * valid across plain value updates.
+ */
+template<typename Entry>
+class CompactHashTable {
+public:
+    /**
+     * Iterator over live entries in insertion order
+     */
+    class const_iterator {
+    public:
+        const_iterator(const std::vector<Entry>* entries, size_t pos)
+            : entries_(entries), pos_(pos) { skip_holes(); }
+        
+        const Entry& operator*() const { return (*entries_)[pos_]; }
+        const Entry* operator->() const { return &(*entries_)[pos_]; }
+        const_iterator& operator++() { ++pos_; skip_holes(); return *this; }
+        bool operator==(const const_iterator& other) const { return pos_ == other.pos_; }
+        bool operator!=(const const_iterator& other) const { return pos_ != other.pos_; }
+        
+    private:
+        void skip_holes() {
+            while (pos_ < entries_->size() && !(*entries_)[pos_].live) ++pos_;
+        }
+        const std::vector<Entry>* entries_;
+        size_t pos_;
+    };
+    
+    // Entry index for a string key, or -1
+    int64_t find_string(const std::string& key, size_t hash) const {
+        return probe(hash, [&key](const PyObject& candidate) {
+            return is_string(candidate) && candidate.as_string() == key;
+        });
+    }
+    
+    // Entry index for an arbitrary key, or -1. Interned string keys
+    // match by pointer alone.
+    int64_t find(const PyObject& key, size_t hash) const {
+        if (is_string(key)) {
+            const PyStr* str = key.as<PyStr>();
+            return probe(hash, [str](const PyObject& candidate) {
+                if (!is_string(candidate)) return false;
+                const PyStr* other = candidate.as<PyStr>();
+                if (other == str) return true;
+                return !(other->interned && str->interned) && other->value == str->value;
+            });
+        }
+        return probe(hash, [&key](const PyObject& candidate) {
+            return py_equals(candidate, key);
+        });
+    }
+    
+    Entry& at(int64_t ix) { return entries_[ix]; }
+    const Entry& at(int64_t ix) const { return entries_[ix]; }
+    
+    // Append an entry whose key is known to be absent
+    void insert_new(Entry entry) {
+        if (entries_.size() >= usable()) {
+            rebuild(used_ + 1);
+        }
+        indices_[find_empty_slot(entry.hash)] = static_cast<int32_t>(entries_.size());
+        entry.live = true;
+        entries_.push_back(std::move(entry));
+        ++used_;
+        version_ = next_keys_version();
+    }
+    
+    bool erase_at(int64_t ix) {
+        if (ix < 0) return false;
+        size_t hash = entries_[ix].hash;
+        size_t mask = indices_.size() - 1;
+        size_t perturb = hash;
+        size_t i = hash & mask;
+        while (indices_[i] != ix) {
+            perturb >>= 5;
+            i = (i * 5 + perturb + 1) & mask;
+        }
+        indices_[i] = IX_DUMMY;
+        entries_[ix] = Entry{};  // Drop references held by the hole
+        --used_;
+        version_ = next_keys_version();
+        return true;
+    }
+    
+    size_t size() const { return used_; }
+    uint64_t keys_version() const { return version_; }
+    
+    // Live entry at or after pos, moving pos past it; nullptr at the end.
+    // Positions stay valid while the size does not change.
+    const Entry* next_live(size_t& pos) const {
+        while (pos < entries_.size()) {
+            const Entry& entry = entries_[pos++];
+            if (entry.live) return &entry;
+        }
+        return nullptr;
+    }
+    
+    void reserve(size_t n) {
+        if (n > usable()) {
+            rebuild(n);
+        }
+    }
+    
+    // The entries are destroyed once the table is already empty, so
+    // whatever their destructors reach sees a consistent table
+    void clear() {
+        std::vector<Entry> entries;
+        entries.swap(entries_);
+        indices_.clear();
+        used_ = 0;
+        version_ = next_keys_version();
+    }
+    
+    const_iterator begin() const { return const_iterator(&entries_, 0); }
+    const_iterator end() const { return const_iterator(&entries_, entries_.size()); }
+    
+private:
+    static constexpr int32_t IX_EMPTY = -1;
+    static constexpr int32_t IX_DUMMY = -2;
+    static constexpr size_t MIN_SIZE = 8;
+    
+    std::vector<Entry> entries_;    // Dense, insertion ordered (with holes)
+    std::vector<int32_t> indices_;  // Sparse hash index into entries_
+    size_t used_ = 0;               // Live entries
+    uint64_t version_ = 0;          // Keys version (0 = never populated)
+    
+    // Two thirds load factor, counting holes left by erase
+    size_t usable() const { return indices_.size() * 2 / 3; }
+    
+    // Perturbed probing from dictobject.c, so all hash bits take part
+    template<typename Matches>
+    int64_t probe(size_t hash, Matches matches) const {
+        if (indices_.empty()) return -1;
+        size_t mask = indices_.size() - 1;
+        size_t perturb = hash;
+        size_t i = hash & mask;
+        for (;;) {
+            int32_t ix = indices_[i];
+            if (ix == IX_EMPTY) return -1;
+            if (ix >= 0) {
+                const Entry& entry = entries_[ix];
+                if (entry.hash == hash && matches(entry.key)) return ix;
+            }
+            perturb >>= 5;
+            i = (i * 5 + perturb + 1) & mask;
+        }
+    }
+    
+    // First unused index slot for a key known to be absent
+    size_t find_empty_slot(size_t hash) const {
+        size_t mask = indices_.size() - 1;
+        size_t perturb = hash;
+        size_t i = hash & mask;
+        while (indices_[i] >= 0) {
+            perturb >>= 5;
+            i = (i * 5 + perturb + 1) & mask;
+        }
+        return i;
+    }
+    
+    // Compact entries and rebuild the index with room for min_used entries
+    void rebuild(size_t min_used) {
+        size_t size = MIN_SIZE;
+        while (size * 2 / 3 < std::max(min_used, used_ * 3 / 2)) {
+            size <<= 1;
+        }
+        
+        if (used_ != entries_.size()) {
+            std::vector<Entry> compacted;
+            compacted.reserve(size * 2 / 3);
+            for (auto& entry : entries_) {
+                if (entry.live) compacted.push_back(std::move(entry));
+            }
+            entries_ = std::move(compacted);
+        } else {
+            entries_.reserve(size * 2 / 3);
+        }
+        
+        indices_.assign(size, IX_EMPTY);
+        for (size_t ix = 0; ix < entries_.size(); ++ix) {
+            indices_[find_empty_slot(entries_[ix].hash)] = static_cast<int32_t>(ix);
+        }
+        version_ = next_keys_version();
+    }
 };
 
 /**
  * PyDict - Python dictionary type
+ * 
+ * The std::string overloads are the name-lookup fast path
+ * (PyDict_GetItemString) and never construct a PyObject.
  */
-class PyDict {
+class PyDict : public core::GCObject {
 public:
-    std::map<std::string, PyObject> items;
+    static constexpr PyTag TAG = PyTag::Dict;
+    
+    struct Entry {
+        size_t hash = 0;
+        PyObject key;
+        PyObject value;
+        bool live = false;
+    };
+    using const_iterator = CompactHashTable<Entry>::const_iterator;
     
     PyDict() = default;
     
+    // === String keys ===
+    
     void set(const std::string& key, const PyObject& value) {
-        items[key] = value;
+        size_t hash = hash_string(key);
+        int64_t ix = table_.find_string(key, hash);
+        if (ix >= 0) {
+            table_.at(ix).value = value;
+        } else {
+            table_.insert_new(Entry{hash, intern_string(key), value});
+        }
+    }
+    
+    PyObject get(const std::string& key, const PyObject& default_value = PyObject()) const {
+        const PyObject* value = find(key);
+        return value ? *value : default_value;
     }
     
-    PyObject get(const std::string& key, const PyObject& default_value = std::monostate{}) const {
-        auto it = items.find(key);
-        return (it != items.end()) ? it->second : default_value;
+    // Stored value or nullptr, in a single probe sequence
+    const PyObject* find(const std::string& key) const {
+        int64_t ix = table_.find_string(key, hash_string(key));
+        return ix >= 0 ? &table_.at(ix).value : nullptr;
     }
     
     bool contains(const std::string& key) const {
-        return items.find(key) != items.end();
+        return table_.find_string(key, hash_string(key)) >= 0;
     }
     
-    size_t size() const { return items.size(); }
+    bool erase(const std::string& key) {
+        return table_.erase_at(table_.find_string(key, hash_string(key)));
+    }
+    
+    // === Entry indices (for inline caches, see keys_version()) ===
+    
+    int64_t index_of(const std::string& key) const {
+        return table_.find_string(key, hash_string(key));
+    }
+    
+    int64_t index_of_item(const PyObject& key) const {
+        return table_.find(key, py_hash(key));
+    }
+    
+    PyObject& value_at(int64_t ix) { return table_.at(ix).value; }
+    const PyObject& value_at(int64_t ix) const { return table_.at(ix).value; }
+    uint64_t keys_version() const { return table_.keys_version(); }
+    
+    // === Arbitrary hashable keys ===
+    
+    void set_item(const PyObject& key, const PyObject& value) {
+        size_t hash = py_hash(key);
+        int64_t ix = table_.find(key, hash);
+        if (ix >= 0) {
+            table_.at(ix).value = value;
+        } else {
+            table_.insert_new(Entry{hash, key, value});
+        }
+    }
+    
+    PyObject get_item(const PyObject& key, const PyObject& default_value = PyObject()) const {
+        const PyObject* value = find_item(key);
+        return value ? *value : default_value;
+    }
+    
+    const PyObject* find_item(const PyObject& key) const {
+        int64_t ix = table_.find(key, py_hash(key));
+        return ix >= 0 ? &table_.at(ix).value : nullptr;
+    }
+    
+    bool contains_item(const PyObject& key) const {
+        return table_.find(key, py_hash(key)) >= 0;
+    }
+    
+    bool erase_item(const PyObject& key) {
+        return table_.erase_at(table_.find(key, py_hash(key)));
+    }
+    
+    size_t size() const { return table_.size(); }
+    
+    // Pre-size for n entries (BUILD_MAP knows its count up front)
+    void reserve(size_t n) { table_.reserve(n); }
+    void clear() override { table_.clear(); }
+    
+    void traverse(core::GCVisitor& visitor) const override {
+        for (const auto& entry : table_) {
+            gc_visit(visitor, entry.key);
+            gc_visit(visitor, entry.value);
+        }
+    }
+    
+    const_iterator begin() const { return table_.begin(); }
+    const_iterator end() const { return table_.end(); }
+    
+    // Resumable iteration for dict iterators (see CompactHashTable::next_live)
+    const Entry* next_entry(size_t& pos) const { return table_.next_live(pos); }
+    
+private:
+    CompactHashTable<Entry> table_;
 };
 
 /**
  * PyTuple - Python tuple type (immutable)
  */
-class PyTuple {
+class PyTuple : public core::GCObject {
 public:
+    static constexpr PyTag TAG = PyTag::Tuple;
+    
     std::vector<PyObject> items;
     
     PyTuple() = default;
@@ -95,123 +785,627 @@ public:
     
     size_t size() const { return items.size(); }
     const PyObject& operator[](size_t index) const { return items[index]; }
+    
+    void traverse(core::GCVisitor& visitor) const override {
+        for (const auto& item : items) gc_visit(visitor, item);
+    }
+    
+    void clear() override { std::vector<PyObject>().swap(items); }
 };
 
 /**
  * PySet - Python set type
+ * Reference: Objects/setobject.c
+ * 
+ * Same hash table and hashing protocol as PyDict, storing keys only.
+ * Iteration follows insertion order.
  */
-class PySet {
+class PySet : public core::GCObject {
 public:
-    std::vector<PyObject> items;  // Simplified: use vector instead of hash set
+    static constexpr PyTag TAG = PyTag::Set;
+    
+    struct Entry {
+        size_t hash = 0;
+        PyObject key;
+        bool live = false;
+    };
+    using const_iterator = CompactHashTable<Entry>::const_iterator;
     
     PySet() = default;
     
-    void add(const PyObject& obj) {
-        // Simple implementation: no duplicate checking for now
-        items.push_back(obj);
+    // Returns false if an equal element was already present
+    bool add(const PyObject& obj) {
+        size_t hash = py_hash(obj);
+        if (table_.find(obj, hash) >= 0) return false;
+        table_.insert_new(Entry{hash, obj});
+        return true;
     }
     
-    size_t size() const { return items.size(); }
+    bool contains(const PyObject& obj) const {
+        return table_.find(obj, py_hash(obj)) >= 0;
+    }
+    
+    bool discard(const PyObject& obj) {
+        return table_.erase_at(table_.find(obj, py_hash(obj)));
+    }
+    
+    /**
+     * Add every element of an iterable (set.update / set(iterable))
+     * Defined after the helper predicates below.
+     */
+    inline void update(const PyObject& iterable);
+    
+    core::Ref<PySet> set_union(const PySet& other) const {
+        auto result = core::make_ref<PySet>();
+        result->reserve(size() + other.size());
+        for (const auto& entry : *this) result->add_hashed(entry);
+        for (const auto& entry : other) result->add_hashed(entry);
+        return result;
+    }
+    
+    core::Ref<PySet> set_intersection(const PySet& other) const {
+        // Probe the larger set while walking the smaller one
+        const PySet& small = size() <= other.size() ? *this : other;
+        const PySet& large = size() <= other.size() ? other : *this;
+        auto result = core::make_ref<PySet>();
+        for (const auto& entry : small) {
+            if (large.table_.find(entry.key, entry.hash) >= 0) {
+                result->add_hashed(entry);
+            }
+        }
+        return result;
+    }
+    
+    core::Ref<PySet> set_difference(const PySet& other) const {
+        auto result = core::make_ref<PySet>();
+        for (const auto& entry : *this) {
+            if (other.table_.find(entry.key, entry.hash) < 0) {
+                result->add_hashed(entry);
+            }
+        }
+        return result;
+    }
+    
+    core::Ref<PySet> set_symmetric_difference(const PySet& other) const {
+        auto result = set_difference(other);
+        for (const auto& entry : other) {
+            if (table_.find(entry.key, entry.hash) < 0) {
+                result->add_hashed(entry);
+            }
+        }
+        return result;
+    }
+    
+    // True if every element of this set is in other
+    bool is_subset(const PySet& other) const {
+        if (size() > other.size()) return false;
+        for (const auto& entry : *this) {
+            if (other.table_.find(entry.key, entry.hash) < 0) return false;
+        }
+        return true;
+    }
+    
+    size_t size() const { return table_.size(); }
+    
+    // Pre-size for n elements (BUILD_SET knows its count up front)
+    void reserve(size_t n) { table_.reserve(n); }
+    void clear() override { table_.clear(); }
+    
+    void traverse(core::GCVisitor& visitor) const override {
+        for (const auto& entry : table_) gc_visit(visitor, entry.key);
+    }
+    
+    const_iterator begin() const { return table_.begin(); }
+    const_iterator end() const { return table_.end(); }
+    
+    // Resumable iteration for set iterators (see CompactHashTable::next_live)
+    const Entry* next_entry(size_t& pos) const { return table_.next_live(pos); }
+    
+private:
+    CompactHashTable<Entry> table_;
+    
+    // Insert reusing the hash cached in another set's entry
+    void add_hashed(const Entry& entry) {
+        if (table_.find(entry.key, entry.hash) < 0) {
+            table_.insert_new(Entry{entry.hash, entry.key});
+        }
+    }
 };
 
 /**
  * PyFunction - Python function object
  */
-class PyFunction {
+class PyFunction : public core::GCObject {
 public:
-    std::shared_ptr<struct CodeObject> code;  // Function code object
-    std::shared_ptr<PyDict> globals;          // Global namespace
-    std::shared_ptr<PyDict> closure;          // Closure variables
+    static constexpr PyTag TAG = PyTag::Function;
+    
+    std::shared_ptr<compiler::CodeObject> code;  // Function code object
+    core::Ref<PyDict> globals;                   // Global namespace
+    core::Ref<PyDict> closure;                   // Closure variables; null until needed
     std::string name;
     
-    PyFunction(std::shared_ptr<struct CodeObject> code,
-               std::shared_ptr<PyDict> globals,
+    PyFunction(std::shared_ptr<compiler::CodeObject> code,
+               core::Ref<PyDict> globals,
                const std::string& name = "<lambda>")
         : code(std::move(code))
         , globals(std::move(globals))
-        , closure(std::make_shared<PyDict>())
         , name(name) {}
+    
+    void traverse(core::GCVisitor& visitor) const override {
+        visitor.visit(globals.get());
+        visitor.visit(closure.get());
+    }
+    
+    void clear() override {
+        core::Ref<PyDict> dropped_globals = std::move(globals);
+        core::Ref<PyDict> dropped_closure = std::move(closure);
+    }
 };
 
 /**
- * Type checking helpers
+ * PyCode - a code object as a runtime value
+ *
+ * Nested code objects in co_consts become these so LOAD_CONST can push
+ * them for MAKE_FUNCTION.
  */
-inline bool is_none(const PyObject& obj) {
-    return std::holds_alternative<std::monostate>(obj);
-}
+class PyCode : public core::RefCounted {
+public:
+    static constexpr PyTag TAG = PyTag::Code;
 
-inline bool is_bool(const PyObject& obj) {
-    return std::holds_alternative<bool>(obj);
-}
+    std::shared_ptr<compiler::CodeObject> code;
 
-inline bool is_int(const PyObject& obj) {
-    return std::holds_alternative<int64_t>(obj);
-}
+    explicit PyCode(std::shared_ptr<compiler::CodeObject> code) : code(std::move(code)) {}
+};
 
-inline bool is_float(const PyObject& obj) {
-    return std::holds_alternative<double>(obj);
-}
+/**
+ * PyGenerator - generator object; PyCoroutine is the async def flavour
+ * Reference: Objects/genobject.c, Include/internal/pycore_frame.h
+ *
+ * Owns the storage of its frame: fast locals followed by the value
+ * stack, laid out like a DataStack slice. Each next()/send() runs the
+ * frame in place over these slots, so the value stack and ip survive
+ * suspension without being copied. The slots are released as soon as
+ * the frame finishes.
+ */
+class PyGenerator : public core::GCObject {
+public:
+    static constexpr PyTag TAG = PyTag::Generator;
+    
+    enum class State : uint8_t {
+        Created,    // Not started; the first send must be None
+        Suspended,  // Stopped at a YIELD_VALUE
+        Running,
+        Completed,
+    };
+    
+    std::shared_ptr<compiler::CodeObject> code;
+    core::Ref<PyDict> globals;
+    std::string name;
+    std::unique_ptr<PyObject[]> slots;  // nlocals fast locals, then co_stacksize
+    size_t nlocals;
+    size_t stack_depth = 0;             // Live value-stack slots while suspended
+    size_t ip = 0;
+    State state = State::Created;
+    
+    PyGenerator(std::shared_ptr<compiler::CodeObject> code,
+                core::Ref<PyDict> globals,
+                std::string name,
+                size_t nlocals)
+        : code(std::move(code))
+        , globals(std::move(globals))
+        , name(std::move(name))
+        , slots(std::make_unique<PyObject[]>(nlocals + static_cast<size_t>(std::max(this->code->co_stacksize, 0))))
+        , nlocals(nlocals) {
+        for (size_t i = 0; i < nlocals; ++i) {
+            slots[i] = PyObject::null();
+        }
+    }
+    
+    // Returned, raised or closed: drop the frame's contents
+    void finish() {
+        state = State::Completed;
+        slots.reset();
+        stack_depth = 0;
+    }
+    
+    // While running, the frame's value stack grows past stack_depth;
+    // those slots go unreported, which only ever keeps objects alive
+    void traverse(core::GCVisitor& visitor) const override {
+        visitor.visit(globals.get());
+        if (!slots) return;
+        for (size_t i = 0; i < nlocals + stack_depth; ++i) {
+            gc_visit(visitor, slots[i]);
+        }
+    }
+    
+    void clear() override {
+        finish();
+        core::Ref<PyDict> dropped = std::move(globals);
+    }
+};
 
-inline bool is_string(const PyObject& obj) {
-    return std::holds_alternative<std::string>(obj);
-}
+class PyCoroutine : public PyGenerator {
+public:
+    static constexpr PyTag TAG = PyTag::Coroutine;
+    
+    using PyGenerator::PyGenerator;
+};
 
-inline bool is_list(const PyObject& obj) {
-    return std::holds_alternative<std::shared_ptr<PyList>>(obj);
-}
+/**
+ * PyMethod - a built-in method bound to its receiver, e.g. gen.send
+ */
+class PyMethod : public core::GCObject {
+public:
+    static constexpr PyTag TAG = PyTag::Method;
+    
+    PyObject self;
+    std::string name;
+    
+    PyMethod(PyObject self, std::string name) : self(std::move(self)), name(std::move(name)) {}
+    
+    void traverse(core::GCVisitor& visitor) const override { gc_visit(visitor, self); }
+    void clear() override { PyObject dropped = std::move(self); }
+};
 
-inline bool is_dict(const PyObject& obj) {
-    return std::holds_alternative<std::shared_ptr<PyDict>>(obj);
-}
+/**
+ * PyRange - the lazy sequence returned by range()
+ * Reference: Objects/rangeobject.c
+ *
+ * Stores start, stop and step only; the length is computed once, in
+ * unsigned arithmetic so extreme bounds cannot overflow.
+ */
+class PyRange : public core::RefCounted {
+public:
+    static constexpr PyTag TAG = PyTag::Range;
 
-inline bool is_tuple(const PyObject& obj) {
-    return std::holds_alternative<std::shared_ptr<PyTuple>>(obj);
+    int64_t start;
+    int64_t stop;
+    int64_t step;  // Never zero
+    uint64_t length;
+
+    PyRange(int64_t start, int64_t stop, int64_t step)
+        : start(start), stop(stop), step(step), length(compute_length(start, stop, step)) {}
+
+    // The i-th element, for i < length
+    int64_t at(uint64_t i) const {
+        return static_cast<int64_t>(static_cast<uint64_t>(start) + i * static_cast<uint64_t>(step));
+    }
+
+    bool contains(int64_t value) const {
+        bool in_bounds = step > 0 ? (value >= start && value < stop) : (value <= start && value > stop);
+        if (!in_bounds) return false;
+        uint64_t offset = step > 0 ? static_cast<uint64_t>(value) - static_cast<uint64_t>(start)
+                                   : static_cast<uint64_t>(start) - static_cast<uint64_t>(value);
+        uint64_t stride = step > 0 ? static_cast<uint64_t>(step) : 0 - static_cast<uint64_t>(step);
+        return offset % stride == 0;
+    }
+
+private:
+    static uint64_t compute_length(int64_t start, int64_t stop, int64_t step) {
+        if (step > 0 && start < stop) {
+            return (static_cast<uint64_t>(stop) - static_cast<uint64_t>(start) - 1) /
+                   static_cast<uint64_t>(step) + 1;
+        }
+        if (step < 0 && start > stop) {
+            return (static_cast<uint64_t>(start) - static_cast<uint64_t>(stop) - 1) /
+                   (0 - static_cast<uint64_t>(step)) + 1;
+        }
+        return 0;
+    }
+};
+
+/**
+ * PyRangeIterator - iterator over a range
+ * Reference: Objects/rangeobject.c (rangeiter_next)
+ *
+ * Counts down the remaining elements in place; each step is an integer
+ * add, and the int it produces is an immediate PyObject.
+ */
+class PyRangeIterator : public core::RefCounted {
+public:
+    static constexpr PyTag TAG = PyTag::RangeIterator;
+
+    int64_t next;
+    int64_t step;
+    uint64_t remaining;
+
+    explicit PyRangeIterator(const PyRange& range)
+        : next(range.start), step(range.step), remaining(range.length) {}
+
+    // False once exhausted
+    bool advance(int64_t& value) {
+        if (remaining == 0) return false;
+        value = next;
+        next = static_cast<int64_t>(static_cast<uint64_t>(next) + static_cast<uint64_t>(step));
+        --remaining;
+        return true;
+    }
+};
+
+/**
+ * One-character strings, shared like CPython's latin-1 singletons so
+ * iterating a str allocates nothing per character. Interned, so one
+ * table per thread as well.
+ */
+inline const PyObject& single_char_string(unsigned char c) {
+    static thread_local const std::vector<PyObject> table = [] {
+        std::vector<PyObject> chars;
+        chars.reserve(256);
+        for (int i = 0; i < 256; ++i) {
+            char c = static_cast<char>(i);
+            chars.push_back(intern_string(std::string_view(&c, 1)));
+        }
+        return chars;
+    }();
+    return table[c];
 }
 
-inline bool is_set(const PyObject& obj) {
-    return std::holds_alternative<std::shared_ptr<PySet>>(obj);
+/**
+ * PySeqIterator - iterator over a built-in container
+ * Reference: Objects/listobject.c (listiter_next), Objects/tupleobject.c,
+ *            Objects/dictobject.c (dictiter_iternextkey), Objects/setobject.c
+ *
+ * Holds the container and a position into it. Lists are checked against
+ * their current length on every step, so items appended while looping
+ * are seen; a dict or set that changes size is a RuntimeError. Dicts
+ * yield their keys. The container is released once exhausted.
+ */
+class PySeqIterator : public core::GCObject {
+public:
+    static constexpr PyTag TAG = PyTag::SeqIterator;
+
+    enum class Kind : uint8_t { List, Tuple, Str, Dict, Set };
+
+    PyObject seq;               // None once exhausted
+    Kind kind;
+    size_t index = 0;           // Next item, or next entry position of a dict or set
+    size_t expected_size = 0;   // Dict or set size when iteration started
+
+    PySeqIterator(PyObject seq, Kind kind) : seq(std::move(seq)), kind(kind) {
+        if (kind == Kind::Dict) expected_size = this->seq.as<PyDict>()->size();
+        if (kind == Kind::Set) expected_size = this->seq.as<PySet>()->size();
+    }
+
+    void traverse(core::GCVisitor& visitor) const override { gc_visit(visitor, seq); }
+    void clear() override { PyObject dropped = std::move(seq); }
+
+    // Store the next item in out; false once exhausted
+    bool advance(PyObject& out) {
+        if (is_none(seq)) return false;
+        switch (kind) {
+            case Kind::List: {
+                const auto& items = seq.as<PyList>()->items;
+                if (index < items.size()) {
+                    out = items[index++];
+                    return true;
+                }
+                break;
+            }
+            case Kind::Tuple: {
+                const auto& items = seq.as<PyTuple>()->items;
+                if (index < items.size()) {
+                    out = items[index++];
+                    return true;
+                }
+                break;
+            }
+            case Kind::Str: {
+                const std::string& str = seq.as_string();
+                if (index < str.size()) {
+                    out = single_char_string(static_cast<unsigned char>(str[index++]));
+                    return true;
+                }
+                break;
+            }
+            case Kind::Dict: {
+                const auto& dict = *seq.as<PyDict>();
+                if (dict.size() != expected_size) {
+                    throw std::runtime_error("RuntimeError: dictionary changed size during iteration");
+                }
+                if (const auto* entry = dict.next_entry(index)) {
+                    out = entry->key;
+                    return true;
+                }
+                break;
+            }
+            case Kind::Set: {
+                const auto& set = *seq.as<PySet>();
+                if (set.size() != expected_size) {
+                    throw std::runtime_error("RuntimeError: Set changed size during iteration");
+                }
+                if (const auto* entry = set.next_entry(index)) {
+                    out = entry->key;
+                    return true;
+                }
+                break;
+            }
+        }
+        seq = PyObject();
+        return false;
+    }
+
+    const char* type_name() const {
+        switch (kind) {
+            case Kind::List: return "list_iterator";
+            case Kind::Tuple: return "tuple_iterator";
+            case Kind::Str: return "str_ascii_iterator";
+            case Kind::Dict: return "dict_keyiterator";
+            case Kind::Set: return "set_iterator";
+        }
+        return "iterator";
+    }
+};
+
+inline bool to_bool(const PyObject& obj) {
+    switch (obj.tag()) {
+        case PyTag::Bool: return obj.as_bool();
+        case PyTag::None: return false;
+        case PyTag::Int: return obj.as_int() != 0;
+        case PyTag::Float: return obj.as_float() != 0.0;
+        case PyTag::Str: return !obj.as_string().empty();
+        case PyTag::List: return obj.as<PyList>()->size() > 0;
+        case PyTag::Dict: return obj.as<PyDict>()->size() > 0;
+        case PyTag::Tuple: return obj.as<PyTuple>()->size() > 0;
+        case PyTag::Set: return obj.as<PySet>()->size() > 0;
+        case PyTag::Range: return obj.as<PyRange>()->length > 0;
+        default: return true;  // Most objects are truthy
+    }
 }
 
 /**
- * Type conversion helpers
+ * Hash/equality protocol (declared above PyDict)
  */
-inline int64_t to_int(const PyObject& obj) {
-    if (is_int(obj)) return std::get<int64_t>(obj);
-    if (is_bool(obj)) return std::get<bool>(obj) ? 1 : 0;
-    if (is_float(obj)) return static_cast<int64_t>(std::get<double>(obj));
-    throw std::runtime_error("Cannot convert to int");
+inline const char* type_name(const PyObject& obj) {
+    if (is_none(obj)) return "NoneType";
+    if (is_bool(obj)) return "bool";
+    if (is_int(obj)) return "int";
+    if (is_float(obj)) return "float";
+    if (is_string(obj)) return "str";
+    if (is_list(obj)) return "list";
+    if (is_dict(obj)) return "dict";
+    if (is_tuple(obj)) return "tuple";
+    if (is_set(obj)) return "set";
+    if (is_function(obj)) return "function";
+    if (is_code(obj)) return "code";
+    if (is_generator(obj)) return "generator";
+    if (is_coroutine(obj)) return "coroutine";
+    if (is_method(obj)) return "builtin_function_or_method";
+    if (is_range(obj)) return "range";
+    if (is_range_iterator(obj)) return "range_iterator";
+    if (is_seq_iterator(obj)) return obj.as<PySeqIterator>()->type_name();
+    return "object";
 }
 
-inline double to_float(const PyObject& obj) {
-    if (is_float(obj)) return std::get<double>(obj);
-    if (is_int(obj)) return static_cast<double>(std::get<int64_t>(obj));
-    if (is_bool(obj)) return std::get<bool>(obj) ? 1.0 : 0.0;
-    throw std::runtime_error("Cannot convert to float");
+inline bool is_hashable(const PyObject& obj) {
+    if (is_list(obj) || is_dict(obj) || is_set(obj)) return false;
+    if (is_tuple(obj)) {
+        for (const auto& item : obj.as<PyTuple>()->items) {
+            if (!is_hashable(item)) return false;
+        }
+    }
+    return true;
 }
 
-inline bool to_bool(const PyObject& obj) {
-    if (is_bool(obj)) return std::get<bool>(obj);
-    if (is_none(obj)) return false;
-    if (is_int(obj)) return std::get<int64_t>(obj) != 0;
-    if (is_float(obj)) return std::get<double>(obj) != 0.0;
-    if (is_string(obj)) return !std::get<std::string>(obj).empty();
-    if (is_list(obj)) return std::get<std::shared_ptr<PyList>>(obj)->size() > 0;
-    if (is_dict(obj)) return std::get<std::shared_ptr<PyDict>>(obj)->size() > 0;
-    return true;  // Most objects are truthy
+inline size_t py_hash(const PyObject& obj) {
+    if (is_string(obj)) return obj.as<PyStr>()->hash();
+    if (is_int(obj)) return static_cast<size_t>(obj.as_int());
+    if (is_bool(obj)) return obj.as_bool() ? 1 : 0;
+    if (is_float(obj)) {
+        double d = obj.as_float();
+        // Integral floats hash like the equal int
+        if (std::isfinite(d) && d == std::floor(d) &&
+            d >= -9223372036854775808.0 && d < 9223372036854775808.0) {
+            return static_cast<size_t>(static_cast<int64_t>(d));
+        }
+        return std::hash<double>{}(d);
+    }
+    if (is_none(obj)) return 0xFCA86420u;
+    if (is_tuple(obj)) {
+        // xxHash-style combine as in tupleobject.c
+        size_t acc = 0x27D4EB2F165667C5ull;
+        for (const auto& item : obj.as<PyTuple>()->items) {
+            acc += py_hash(item) * 0xC2B2AE3D27D4EB4Full;
+            acc = (acc << 31) | (acc >> 33);
+            acc *= 0x9E3779B185EBCA87ull;
+        }
+        return acc;
+    }
+    if (!is_hashable(obj)) {
+        throw std::runtime_error(std::string("TypeError: unhashable type: '") + type_name(obj) + "'");
+    }
+    // Functions, classes, instances: identity hash
+    return std::hash<const void*>{}(obj.heap());
+}
+
+inline bool py_equals(const PyObject& a, const PyObject& b) {
+    if (is_number(a) || is_number(b)) {
+        if (!is_number(a) || !is_number(b)) return false;
+        if (is_float(a) || is_float(b)) return to_float(a) == to_float(b);
+        return to_int(a) == to_int(b);
+    }
+    if (a.tag() != b.tag()) return false;
+    if (is_none(a)) return true;
+    if (is_string(a)) {
+        const PyStr* x = a.as<PyStr>();
+        const PyStr* y = b.as<PyStr>();
+        return x == y || (!(x->interned && y->interned) && x->value == y->value);
+    }
+    
+    auto items_equal = [](const std::vector<PyObject>& x, const std::vector<PyObject>& y) {
+        if (x.size() != y.size()) return false;
+        for (size_t i = 0; i < x.size(); ++i) {
+            if (!py_equals(x[i], y[i])) return false;
+        }
+        return true;
+    };
+    if (is_tuple(a)) {
+        return items_equal(a.as<PyTuple>()->items,
+                           b.as<PyTuple>()->items);
+    }
+    if (is_list(a)) {
+        return items_equal(a.as<PyList>()->items,
+                           b.as<PyList>()->items);
+    }
+    if (is_dict(a)) {
+        const auto& x = *a.as<PyDict>();
+        const auto& y = *b.as<PyDict>();
+        if (x.size() != y.size()) return false;
+        for (const auto& entry : x) {
+            const PyObject* other = y.find_item(entry.key);
+            if (!other || !py_equals(entry.value, *other)) return false;
+        }
+        return true;
+    }
+    if (is_set(a)) {
+        const auto& x = *a.as<PySet>();
+        const auto& y = *b.as<PySet>();
+        return x.size() == y.size() && x.is_subset(y);
+    }
+    // Everything else compares by identity
+    return identical(a, b);
+}
+
+inline void PySet::update(const PyObject& iterable) {
+    if (is_set(iterable)) {
+        const auto& other = *iterable.as<PySet>();
+        if (&other == this) return;
+        reserve(size() + other.size());
+        for (const auto& entry : other) add_hashed(entry);
+    } else if (is_list(iterable) || is_tuple(iterable)) {
+        const auto& items = is_list(iterable)
+            ? iterable.as<PyList>()->items
+            : iterable.as<PyTuple>()->items;
+        reserve(size() + items.size());
+        for (const auto& item : items) add(item);
+    } else if (is_dict(iterable)) {
+        const auto& dict = *iterable.as<PyDict>();
+        reserve(size() + dict.size());
+        for (const auto& entry : dict) add_hashed(Entry{entry.hash, entry.key});
+    } else if (is_string(iterable)) {
+        const auto& str = iterable.as_string();
+        for (char c : str) add(single_char_string(static_cast<unsigned char>(c)));
+    } else if (is_range(iterable)) {
+        const auto& range = *iterable.as<PyRange>();
+        reserve(size() + range.length);
+        for (uint64_t i = 0; i < range.length; ++i) add(range.at(i));
+    } else {
+        throw std::runtime_error(std::string("TypeError: '") + type_name(iterable) +
+                                 "' object is not iterable");
+    }
 }
 
 inline std::string to_string(const PyObject& obj) {
     if (is_none(obj)) return "None";
-    if (is_bool(obj)) return std::get<bool>(obj) ? "True" : "False";
-    if (is_int(obj)) return std::to_string(std::get<int64_t>(obj));
+    if (is_bool(obj)) return obj.as_bool() ? "True" : "False";
+    if (is_int(obj)) return std::to_string(obj.as_int());
     if (is_float(obj)) {
         std::ostringstream oss;
-        oss << std::get<double>(obj);
+        oss << obj.as_float();
         return oss.str();
     }
-    if (is_string(obj)) return std::get<std::string>(obj);
+    if (is_string(obj)) return obj.as_string();
     if (is_list(obj)) {
-        auto list = std::get<std::shared_ptr<PyList>>(obj);
+        auto list = obj.as<PyList>();
         std::ostringstream oss;
         oss << "[";
         for (size_t i = 0; i < list->size(); ++i) {
@@ -222,7 +1416,7 @@ inline std::string to_string(const PyObject& obj) {
         return oss.str();
     }
     if (is_tuple(obj)) {
-        auto tuple = std::get<std::shared_ptr<PyTuple>>(obj);
+        auto tuple = obj.as<PyTuple>();
         std::ostringstream oss;
         oss << "(";
         for (size_t i = 0; i < tuple->size(); ++i) {
@@ -234,18 +1428,59 @@ inline std::string to_string(const PyObject& obj) {
         return oss.str();
     }
     if (is_dict(obj)) {
-        auto dict = std::get<std::shared_ptr<PyDict>>(obj);
+        auto dict = obj.as<PyDict>();
         std::ostringstream oss;
         oss << "{";
         bool first = true;
-        for (const auto& [key, value] : dict->items) {
+        for (const auto& entry : *dict) {
             if (!first) oss << ", ";
-            oss << "'" << key << "': " << to_string(value);
+            if (is_string(entry.key)) {
+                oss << "'" << entry.key.as_string() << "'";
+            } else {
+                oss << to_string(entry.key);
+            }
+            oss << ": " << to_string(entry.value);
             first = false;
         }
         oss << "}";
         return oss.str();
     }
+    if (is_set(obj)) {
+        auto set = obj.as<PySet>();
+        if (set->size() == 0) return "set()";
+        std::ostringstream oss;
+        oss << "{";
+        bool first = true;
+        for (const auto& entry : *set) {
+            if (!first) oss << ", ";
+            oss << to_string(entry.key);
+            first = false;
+        }
+        oss << "}";
+        return oss.str();
+    }
+    if (is_function(obj)) {
+        return "<function " + obj.as<PyFunction>()->name + ">";
+    }
+    if (is_code(obj)) {
+        return "<code object " + obj.as<PyCode>()->code->co_name + ">";
+    }
+    if (is_generator(obj) || is_coroutine(obj)) {
+        return std::string("<") + type_name(obj) + " object " + obj.as<PyGenerator>()->name + ">";
+    }
+    if (is_method(obj)) {
+        const auto* method = obj.as<PyMethod>();
+        return "<built-in method " + method->name + " of " + type_name(method->self) + " object>";
+    }
+    if (is_range(obj)) {
+        const auto* range = obj.as<PyRange>();
+        std::string repr = "range(" + std::to_string(range->start) + ", " + std::to_string(range->stop);
+        if (range->step != 1) repr += ", " + std::to_string(range->step);
+        return repr + ")";
+    }
+    if (is_range_iterator(obj) || is_seq_iterator(obj)) {
+        return std::string("<") + type_name(obj) + " object>";
+    }
     return "<object>";
 }
 
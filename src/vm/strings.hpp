@@ -0,0 +1,367 @@
+#pragma once
+
+#include "pyobject.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace cpython_cpp {
+namespace vm {
+
+/**
+ * StringBuilder - assembles a str with a single allocation
+ * Reference: Objects/unicodeobject.c (_PyUnicodeWriter, _PyUnicode_JoinArray)
+ *
+ * Callers that know the pieces up front reserve their summed length, so
+ * the buffer is allocated once and every piece is copied exactly once.
+ */
+class StringBuilder {
+public:
+    void reserve(size_t n) { buffer_.reserve(n); }
+
+    StringBuilder& append(std::string_view piece) {
+        buffer_.append(piece);
+        return *this;
+    }
+
+    StringBuilder& append(size_t count, char c) {
+        buffer_.append(count, c);
+        return *this;
+    }
+
+    size_t size() const { return buffer_.size(); }
+    std::string take() { return std::move(buffer_); }
+
+    // BUILD_STRING: the pieces (all str) joined in one pass
+    static PyObject join(std::span<const PyObject> pieces) {
+        if (pieces.size() == 1) {
+            return pieces[0];
+        }
+        size_t total = 0;
+        for (const auto& piece : pieces) {
+            total += piece.as_string().size();
+        }
+        StringBuilder builder;
+        builder.reserve(total);
+        for (const auto& piece : pieces) {
+            builder.append(piece.as_string());
+        }
+        return builder.take();
+    }
+
+private:
+    std::string buffer_;
+};
+
+// a + b, allocated once at its final size
+inline std::string concat_strings(std::string_view a, std::string_view b) {
+    StringBuilder builder;
+    builder.reserve(a.size() + b.size());
+    builder.append(a).append(b);
+    return builder.take();
+}
+
+/**
+ * repr() of a str: quoted, with control characters escaped; ascii()
+ * escapes bytes outside ASCII as well
+ */
+inline std::string repr_string(std::string_view value, bool ascii_only = false) {
+    char quote = (value.find('\'') != std::string_view::npos &&
+                  value.find('"') == std::string_view::npos) ? '"' : '\'';
+    StringBuilder builder;
+    builder.reserve(value.size() + 2);
+    builder.append(1, quote);
+    for (char c : value) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == quote || c == '\\') {
+            builder.append(1, '\\').append(1, c);
+        } else if (c == '\n') {
+            builder.append("\\n");
+        } else if (c == '\r') {
+            builder.append("\\r");
+        } else if (c == '\t') {
+            builder.append("\\t");
+        } else if (byte < 0x20 || byte == 0x7f || (ascii_only && byte >= 0x80)) {
+            char escape[5];
+            std::snprintf(escape, sizeof(escape), "\\x%02x", byte);
+            builder.append(escape);
+        } else {
+            builder.append(1, c);
+        }
+    }
+    builder.append(1, quote);
+    return builder.take();
+}
+
+/**
+ * CONVERT_VALUE: !s, !r and !a
+ */
+inline PyObject convert_value(const PyObject& value, int conversion) {
+    switch (conversion) {
+        case 's':
+            return is_string(value) ? value : PyObject(to_string(value));
+        case 'r':
+        case 'a':
+            return is_string(value) ? repr_string(value.as_string(), conversion == 'a')
+                                    : to_string(value);
+        default:
+            throw std::runtime_error("ValueError: unknown conversion " + std::to_string(conversion));
+    }
+}
+
+/**
+ * FormatSpec - a parsed format specification
+ * Reference: Python/formatter_unicode.c (parse_internal_render_format_spec)
+ *
+ *   [[fill]align][sign][#][0][width][grouping][.precision][type]
+ */
+struct FormatSpec {
+    char fill = ' ';
+    char align = 0;       // '<', '>', '^', '=', or 0 for the type's default
+    char sign = '-';
+    bool alternate = false;
+    size_t width = 0;
+    char grouping = 0;    // ',' or '_'
+    int precision = -1;
+    char type = 0;
+};
+
+inline FormatSpec parse_format_spec(std::string_view spec) {
+    auto invalid = [&spec]() {
+        return std::runtime_error("ValueError: Invalid format specifier '" + std::string(spec) + "'");
+    };
+    auto is_align = [](char c) { return c == '<' || c == '>' || c == '^' || c == '='; };
+    auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+
+    FormatSpec fs;
+    size_t i = 0;
+    if (spec.size() >= 2 && is_align(spec[1])) {
+        fs.fill = spec[0];
+        fs.align = spec[1];
+        i = 2;
+    } else if (!spec.empty() && is_align(spec[0])) {
+        fs.align = spec[0];
+        i = 1;
+    }
+    if (i < spec.size() && (spec[i] == '+' || spec[i] == '-' || spec[i] == ' ')) {
+        fs.sign = spec[i++];
+    }
+    if (i < spec.size() && spec[i] == '#') {
+        fs.alternate = true;
+        ++i;
+    }
+    if (i < spec.size() && spec[i] == '0') {
+        // Sign-aware zero padding, unless an alignment was given
+        if (!fs.align) {
+            fs.fill = '0';
+            fs.align = '=';
+        }
+        ++i;
+    }
+    while (i < spec.size() && is_digit(spec[i])) {
+        fs.width = fs.width * 10 + static_cast<size_t>(spec[i++] - '0');
+        if (fs.width > 1000000) throw invalid();
+    }
+    if (i < spec.size() && (spec[i] == ',' || spec[i] == '_')) {
+        fs.grouping = spec[i++];
+    }
+    if (i < spec.size() && spec[i] == '.') {
+        ++i;
+        if (i == spec.size() || !is_digit(spec[i])) throw invalid();
+        fs.precision = 0;
+        while (i < spec.size() && is_digit(spec[i])) {
+            fs.precision = fs.precision * 10 + (spec[i++] - '0');
+            if (fs.precision > 1000000) throw invalid();
+        }
+    }
+    if (i < spec.size()) {
+        fs.type = spec[i++];
+    }
+    if (i != spec.size()) throw invalid();
+    return fs;
+}
+
+// Insert sep every group digits, counting from the right
+inline std::string group_digits(std::string_view digits, char sep, size_t group) {
+    StringBuilder builder;
+    builder.reserve(digits.size() + digits.size() / group);
+    for (size_t i = 0; i < digits.size(); ++i) {
+        if (i > 0 && (digits.size() - i) % group == 0) {
+            builder.append(1, sep);
+        }
+        builder.append(1, digits[i]);
+    }
+    return builder.take();
+}
+
+// Fill prefix (sign, base marker) and body out to the spec's width
+inline std::string pad_formatted(std::string_view prefix, std::string_view body,
+                                 const FormatSpec& fs, char default_align) {
+    size_t length = prefix.size() + body.size();
+    if (fs.width <= length) {
+        return concat_strings(prefix, body);
+    }
+    size_t fill = fs.width - length;
+    StringBuilder builder;
+    builder.reserve(fs.width);
+    switch (fs.align ? fs.align : default_align) {
+        case '<':
+            builder.append(prefix).append(body).append(fill, fs.fill);
+            break;
+        case '^':
+            builder.append(fill / 2, fs.fill).append(prefix).append(body).append(fill - fill / 2, fs.fill);
+            break;
+        case '=':
+            builder.append(prefix).append(fill, fs.fill).append(body);
+            break;
+        default:
+            builder.append(fill, fs.fill).append(prefix).append(body);
+            break;
+    }
+    return builder.take();
+}
+
+inline std::string sign_prefix(bool negative, char sign) {
+    if (negative) return "-";
+    if (sign == '+') return "+";
+    if (sign == ' ') return " ";
+    return "";
+}
+
+inline std::string format_float(double value, const FormatSpec& fs);
+
+inline std::string format_int(int64_t value, const FormatSpec& fs) {
+    switch (fs.type) {
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case '%':
+            return format_float(static_cast<double>(value), fs);
+        default:
+            break;
+    }
+    if (fs.precision >= 0) {
+        throw std::runtime_error("ValueError: Precision not allowed in integer format specifier");
+    }
+    if (fs.type == 'c') {
+        if (value < 0 || value > 0x7f) {
+            throw std::runtime_error("OverflowError: %c arg not in range(128)");
+        }
+        return pad_formatted("", std::string(1, static_cast<char>(value)), fs, '>');
+    }
+
+    int base = 10;
+    std::string prefix = sign_prefix(value < 0, fs.sign);
+    switch (fs.type) {
+        case 0: case 'd': case 'n': break;
+        case 'b': base = 2; if (fs.alternate) prefix += "0b"; break;
+        case 'o': base = 8; if (fs.alternate) prefix += "0o"; break;
+        case 'x': base = 16; if (fs.alternate) prefix += "0x"; break;
+        case 'X': base = 16; if (fs.alternate) prefix += "0X"; break;
+        default:
+            throw std::runtime_error(std::string("ValueError: Unknown format code '") + fs.type +
+                                     "' for object of type 'int'");
+    }
+
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    char buffer[65];
+    auto end = std::to_chars(buffer, buffer + sizeof(buffer), magnitude, base).ptr;
+    std::string digits(buffer, end);
+    if (fs.type == 'X') {
+        for (char& c : digits) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    if (fs.grouping) {
+        if (fs.grouping == ',' && base != 10) {
+            throw std::runtime_error("ValueError: Cannot specify ',' with '" + std::string(1, fs.type) + "'.");
+        }
+        digits = group_digits(digits, fs.grouping, base == 10 ? 3 : 4);
+    }
+    return pad_formatted(prefix, digits, fs, '>');
+}
+
+inline std::string format_float(double value, const FormatSpec& fs) {
+    char type = fs.type;
+    if (type != 0 && type != 'e' && type != 'E' && type != 'f' && type != 'F' &&
+        type != 'g' && type != 'G' && type != '%' && type != 'n') {
+        throw std::runtime_error(std::string("ValueError: Unknown format code '") + type +
+                                 "' for object of type 'float'");
+    }
+    bool negative = std::signbit(value);
+    double magnitude = std::fabs(value);
+    std::string prefix = sign_prefix(negative, fs.sign);
+
+    std::string body;
+    if (!std::isfinite(magnitude)) {
+        bool upper = type == 'E' || type == 'F' || type == 'G';
+        body = std::isnan(magnitude) ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf");
+    } else if (type == 0 && fs.precision < 0) {
+        body = to_string(PyObject(magnitude));
+    } else {
+        int precision = fs.precision < 0 ? 6 : fs.precision;
+        char conversion = type == 0 || type == 'n' ? 'g' : type == '%' ? 'f' : type;
+        if (type == '%') magnitude *= 100;
+        char format[8] = {'%'};
+        size_t n = 1;
+        if (fs.alternate) format[n++] = '#';
+        format[n++] = '.';
+        format[n++] = '*';
+        format[n++] = conversion;
+        int length = std::snprintf(nullptr, 0, format, precision, magnitude);
+        body.resize(static_cast<size_t>(length));
+        std::snprintf(body.data(), body.size() + 1, format, precision, magnitude);
+        if (type == '%') body += '%';
+    }
+
+    if (fs.grouping && std::isfinite(magnitude)) {
+        size_t int_end = body.find_first_not_of("0123456789");
+        if (int_end == std::string::npos) int_end = body.size();
+        body = group_digits(std::string_view(body).substr(0, int_end), fs.grouping, 3) + body.substr(int_end);
+    }
+    return pad_formatted(prefix, body, fs, '>');
+}
+
+inline std::string format_str(const std::string& value, const FormatSpec& fs) {
+    if (fs.type != 0 && fs.type != 's') {
+        throw std::runtime_error(std::string("ValueError: Unknown format code '") + fs.type +
+                                 "' for object of type 'str'");
+    }
+    if (fs.sign != '-') {
+        throw std::runtime_error("ValueError: Sign not allowed in string format specifier");
+    }
+    if (fs.align == '=') {
+        throw std::runtime_error("ValueError: '=' alignment not allowed in string format specifier");
+    }
+    std::string_view body = value;
+    if (fs.precision >= 0 && static_cast<size_t>(fs.precision) < body.size()) {
+        body = body.substr(0, static_cast<size_t>(fs.precision));
+    }
+    return pad_formatted("", body, fs, '<');
+}
+
+/**
+ * format(value, spec): FORMAT_SIMPLE with an empty spec,
+ * FORMAT_WITH_SPEC otherwise
+ * Reference: Objects/abstract.c (PyObject_Format)
+ */
+inline PyObject format_value(const PyObject& value, std::string_view spec) {
+    if (spec.empty()) {
+        return is_string(value) ? value : PyObject(to_string(value));
+    }
+    FormatSpec fs = parse_format_spec(spec);
+    switch (value.tag()) {
+        case PyTag::Bool:  // bool.__format__ is int's once there is a spec
+        case PyTag::Int:
+            return format_int(to_int(value), fs);
+        case PyTag::Float:
+            return format_float(value.as_float(), fs);
+        case PyTag::Str:
+            return format_str(value.as_string(), fs);
+        default:
+            throw std::runtime_error(std::string("TypeError: unsupported format string passed to ") +
+                                     type_name(value) + ".__format__");
+    }
+}
+
+} // namespace vm
+} // namespace cpython_cpp
@@ -1,51 +1,211 @@
 #pragma once
 
 #include "pyobject.hpp"
+#include "builtins.hpp"
+#include "strings.hpp"
+#include "data_stack.hpp"
+#include "profiler.hpp"
+#include "jit.hpp"
 #include "../compiler/code_object.hpp"
 #include "../compiler/opcode.hpp"
 #include <stack>
 #include <vector>
+#include <unordered_map>
+#include <span>
+#include <functional>
+#include <cmath>
+#include <iterator>
+#include <algorithm>
 #include <string>
 #include <memory>
 #include <stdexcept>
 #include <iostream>
+#include <exception>
 
 namespace cpython_cpp {
 namespace vm {
 
+/**
+ * CodeState - one interpreter's runtime data for a CodeObject
+ * Reference: Objects/codeobject.c (_PyCode_GetTLBC)
+ * 
+ * A compiled CodeObject is never written, so interpreters on different
+ * threads can share it. What execution writes lives here instead, one
+ * per VM and code object: co_consts as PyObjects (so LOAD_CONST is a
+ * copy and string constants are allocated once), a private copy of
+ * co_code that the adaptive interpreter quickens in place, and the
+ * inline caches of that copy. Frames point at the code without owning
+ * it; the state's reference keeps it alive. Once the code is hot, the
+ * state also holds its native code (see jit.hpp).
+ */
+struct CodeState {
+    std::shared_ptr<compiler::CodeObject> code;
+    std::vector<PyObject> consts;
+    std::vector<uint8_t> bytecode;              // co_code, quickened
+    std::vector<compiler::InlineCache> caches;  // One per code unit of bytecode
+#if CPYTHON_CPP_JIT
+    std::unique_ptr<JitCode> jit;               // Native code, once hot
+    uint32_t warmth = 0;                        // Calls and back-edges toward the next compile
+    uint8_t compiles = 0;
+    bool jit_blocked = false;                   // Not compilable, or deopted too often
+#endif
+};
+
 /**
  * Frame - Execution frame for a code object
  * 
  * Represents the execution state of a function/module.
  * Contains the value stack, local variables, and instruction pointer.
+ * 
+ * Function code (CO_OPTIMIZED) keeps its locals in fastlocals, one slot
+ * per co_varnames entry, indexed directly by LOAD_FAST/STORE_FAST. The
+ * locals dict is only materialised by locals_dict() when LOAD_NAME or
+ * LOAD_LOCALS needs a mapping. Module code uses its globals as locals.
+ * 
+ * fastlocals and the value stack are one slice of the VM's DataStack
+ * (CPython's _PyInterpreterFrame "localsplus"), sized nlocals +
+ * co_stacksize and released when the frame is destroyed, so a call
+ * allocates no storage of its own. A generator's frame lives in the
+ * generator's own slots instead and is rebuilt over them on each resume.
+ * N-ary opcodes take their operands with peek()/pop_n() in one pass.
+ * 
+ * The frame executes the interpreter's CodeState for its code, so
+ * entering one touches no count shared with other interpreters.
  */
 struct Frame {
-    std::shared_ptr<compiler::CodeObject> code;  // Code object being executed
-    std::shared_ptr<PyDict> globals;             // Global namespace
-    std::shared_ptr<PyDict> locals;              // Local namespace
-    std::vector<PyObject> value_stack;           // Value stack
+    const compiler::CodeObject* code;            // Code object being executed
+    CodeState* state;                            // This VM's runtime data for it
+    core::Ref<PyDict> globals;             // Global namespace
+    core::Ref<PyDict> locals;              // Local namespace (lazy for functions)
+    std::span<PyObject> fastlocals;              // Local slots (null = unbound)
+    ValueStack value_stack;                      // Value stack
+    const std::vector<PyObject>* consts;         // co_consts as PyObjects
+    uint8_t* bytecode;                           // This VM's copy of co_code
+    compiler::InlineCache* caches;               // Inline caches, one per code unit
     size_t ip;                                   // Instruction pointer
+    bool suspended = false;                      // Left through YIELD_VALUE
     
-    Frame(std::shared_ptr<compiler::CodeObject> code,
-          std::shared_ptr<PyDict> globals,
-          std::shared_ptr<PyDict> locals = nullptr)
-        : code(std::move(code))
+    Frame(DataStack& data_stack,
+          CodeState& state,
+          core::Ref<PyDict> globals,
+          core::Ref<PyDict> locals = nullptr)
+        : code(state.code.get())
+        , state(&state)
         , globals(std::move(globals))
-        , locals(locals ? locals : std::make_shared<PyDict>())
-        , ip(0) {}
+        , locals(std::move(locals))
+        , consts(&state.consts)
+        , bytecode(state.bytecode.data())
+        , caches(state.caches.data())
+        , ip(0)
+        , data_stack_(&data_stack) {
+        size_t nlocals = nlocals_of(*this->code);
+        size_t stacksize = static_cast<size_t>(std::max(this->code->co_stacksize, 0));
+        base_ = data_stack_->push(nlocals + stacksize);
+        fastlocals = std::span<PyObject>(base_, nlocals);
+        for (auto& slot : fastlocals) {
+            slot = PyObject::null();
+        }
+        value_stack = ValueStack(base_ + nlocals, stacksize);
+        if (!this->locals && !is_optimized()) {
+            this->locals = this->globals;
+        }
+    }
+    
+    // Resume a generator where it stopped, over its own slots
+    Frame(PyGenerator& gen, CodeState& state)
+        : code(state.code.get())
+        , state(&state)
+        , globals(gen.globals)
+        , consts(&state.consts)
+        , bytecode(state.bytecode.data())
+        , caches(state.caches.data())
+        , ip(gen.ip)
+        , data_stack_(nullptr)
+        , base_(gen.slots.get()) {
+        size_t stacksize = static_cast<size_t>(std::max(code->co_stacksize, 0));
+        fastlocals = std::span<PyObject>(base_, gen.nlocals);
+        value_stack = ValueStack(base_ + gen.nlocals, stacksize, gen.stack_depth);
+    }
+    
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+    
+    // Slots go back to the data stack holding None
+    ~Frame() {
+        if (!data_stack_) return;
+        value_stack.clear();
+        for (auto& slot : fastlocals) {
+            slot = PyObject();
+        }
+        data_stack_->pop(base_);
+    }
+    
+    // Fast-local slots a frame of this code needs
+    static size_t nlocals_of(const compiler::CodeObject& code) {
+        return std::max(static_cast<size_t>(std::max(code.co_nlocals, 0)),
+                        code.co_varnames.size());
+    }
+    
+    bool is_optimized() const {
+        return (code->co_flags & compiler::CodeFlags::CO_OPTIMIZED) != 0;
+    }
+    
+    /**
+     * Locals as a dict, synchronised from fastlocals on each call
+     * (CPython's PyFrame_FastToLocals). Unbound slots are left out.
+     */
+    core::Ref<PyDict> locals_dict() {
+        if (!locals) {
+            locals = core::make_ref<PyDict>();
+        }
+        if (is_optimized()) {
+            const auto& names = code->co_varnames;
+            for (size_t i = 0; i < fastlocals.size() && i < names.size(); ++i) {
+                if (!fastlocals[i].is_null()) {
+                    locals->set(names[i], fastlocals[i]);
+                } else {
+                    locals->erase(names[i]);
+                }
+            }
+        }
+        return locals;
+    }
     
     // Stack operations
-    void push(const PyObject& obj) {
-        value_stack.push_back(obj);
+    void push(PyObject obj) {
+        value_stack.push_back(std::move(obj));
     }
     
     PyObject pop() {
         if (value_stack.empty()) {
             throw std::runtime_error("Stack underflow");
         }
-        PyObject obj = value_stack.back();
-        value_stack.pop_back();
-        return obj;
+        return value_stack.take_back();
+    }
+    
+    // The top n slots in push order (TOS last), left on the stack
+    std::span<PyObject> peek(size_t n) {
+        if (n > value_stack.size()) {
+            throw std::runtime_error("Stack underflow");
+        }
+        return value_stack.last(n);
+    }
+    
+    // Discard the top n slots
+    void drop(size_t n) {
+        if (n > value_stack.size()) {
+            throw std::runtime_error("Stack underflow");
+        }
+        value_stack.drop(n);
+    }
+    
+    // Move the top n slots out in push order
+    std::vector<PyObject> pop_n(size_t n) {
+        auto top = peek(n);
+        std::vector<PyObject> items(std::make_move_iterator(top.begin()),
+                                    std::make_move_iterator(top.end()));
+        drop(n);
+        return items;
     }
     
     PyObject& top() {
@@ -64,7 +224,7 @@ struct Frame {
         if (ip >= code->co_code.size()) {
             throw std::runtime_error("Instruction pointer out of bounds");
         }
-        return code->co_code[ip++];
+        return bytecode[ip++];
     }
     
     int read_arg() {
@@ -73,6 +233,63 @@ struct Frame {
         // For extended args, EXTENDED_ARG opcode is used
         return read_byte();
     }
+    
+private:
+    DataStack* data_stack_;  // Null for a generator's frame
+    PyObject* base_;
+};
+
+/**
+ * Computed-goto dispatch is a GNU extension (GCC and Clang).
+ * Define CPYTHON_CPP_COMPUTED_GOTO=0 to force the portable switch engine.
+ */
+#ifndef CPYTHON_CPP_COMPUTED_GOTO
+#if defined(__GNUC__) || defined(__clang__)
+#define CPYTHON_CPP_COMPUTED_GOTO 1
+#else
+#define CPYTHON_CPP_COMPUTED_GOTO 0
+#endif
+#endif
+
+// Label addresses differ between inlined/cloned copies of a function,
+// so the threaded engine must exist exactly once.
+#if defined(__clang__)
+#define CPYTHON_CPP_NOINLINE __attribute__((noinline))
+#elif defined(__GNUC__)
+#define CPYTHON_CPP_NOINLINE __attribute__((noinline, noclone))
+#else
+#define CPYTHON_CPP_NOINLINE
+#endif
+
+/**
+ * Opcodes handled by the threaded engine (X-macro)
+ * Every entry needs a matching TARGET() in run_frame_threaded().
+ */
+#define CPYTHON_CPP_THREADED_OPCODES(X) \
+    X(LOAD_CONST) X(LOAD_NAME) X(STORE_NAME) X(LOAD_FAST) X(STORE_FAST) \
+    X(LOAD_FAST_CHECK) X(DELETE_FAST) X(LOAD_LOCALS) \
+    X(LOAD_GLOBAL) X(STORE_GLOBAL) X(POP_TOP) X(BINARY_OP) X(UNARY_NOT) \
+    X(UNARY_NEGATIVE) X(UNARY_INVERT) X(COMPARE_OP) X(CONTAINS_OP) X(IS_OP) \
+    X(RETURN_VALUE) \
+    X(JUMP_FORWARD) X(JUMP_BACKWARD) X(POP_JUMP_IF_FALSE) X(POP_JUMP_IF_TRUE) \
+    X(CALL) X(MAKE_FUNCTION) X(BUILD_LIST) X(BUILD_TUPLE) X(BUILD_MAP) X(BUILD_SET) \
+    X(LOAD_SMALL_INT) X(BUILD_TEMPLATE) X(BUILD_INTERPOLATION) X(BINARY_SLICE) \
+    X(BEFORE_WITH) X(BEFORE_ASYNC_WITH) X(CACHE) X(NOP) X(EXTENDED_ARG) \
+    X(BINARY_OP_ADD_INT) X(BINARY_OP_SUBTRACT_INT) X(BINARY_OP_MULTIPLY_INT) \
+    X(BINARY_OP_ADD_FLOAT) X(BINARY_OP_SUBTRACT_FLOAT) X(BINARY_OP_MULTIPLY_FLOAT) \
+    X(BINARY_OP_ADD_UNICODE) X(COMPARE_OP_INT) X(COMPARE_OP_FLOAT) X(COMPARE_OP_STR) \
+    X(LOAD_FAST_LOAD_FAST) X(LOAD_FAST_LOAD_CONST) X(COMPARE_OP_POP_JUMP_IF_FALSE) \
+    X(GET_ITER) X(FOR_ITER) X(END_FOR) X(GET_YIELD_FROM_ITER) X(GET_AWAITABLE) \
+    X(SEND) X(END_SEND) X(YIELD_VALUE) X(RESUME) X(JUMP_BACKWARD_NO_INTERRUPT) X(LOAD_ATTR) \
+    X(FOR_ITER_LIST) X(FOR_ITER_TUPLE) X(FOR_ITER_RANGE) X(LIST_APPEND) X(SET_ADD) X(MAP_ADD) \
+    X(BUILD_STRING) X(FORMAT_SIMPLE) X(FORMAT_WITH_SPEC) X(CONVERT_VALUE)
+
+/**
+ * Dispatch engine used by run_frame()
+ */
+enum class DispatchMode {
+    Threaded,   // Direct-threaded loop over co_code (default)
+    Switch      // Checked loop through dispatch_opcode()
 };
 
 /**
@@ -84,8 +301,8 @@ struct Frame {
 class VirtualMachine {
 public:
     VirtualMachine()
-        : globals_(std::make_shared<PyDict>())
-        , builtins_(std::make_shared<PyDict>()) {
+        : globals_(core::make_ref<PyDict>())
+        , builtins_(core::make_ref<PyDict>()) {
         setup_builtins();
     }
     
@@ -94,149 +311,948 @@ public:
      */
     PyObject execute(std::shared_ptr<compiler::CodeObject> code) {
         // Create a new frame for this code object
-        Frame frame(code, globals_);
+        Frame frame(data_stack_, code_state_for(code), globals_);
         
         // Execute the frame
         return run_frame(frame);
     }
     
+    /**
+     * Call a Python callable from C++, e.g. a function the module defined
+     */
+    PyObject call(const PyObject& callable, std::vector<PyObject> args = {}) {
+        return call_object(callable, args);
+    }
+    
+    /**
+     * Resume a generator or coroutine, sending value (None to start it)
+     * Reference: Objects/genobject.c (gen_send_ex2)
+     * 
+     * Returns the value it yielded, or its return value with returned
+     * set once it finishes. The frame runs in place over the generator's
+     * slots; only a suspension's ip and stack depth are written back.
+     */
+    PyObject resume(PyGenerator& gen, PyObject value, bool& returned) {
+        using State = PyGenerator::State;
+        bool coroutine = (gen.code->co_flags & compiler::CodeFlags::CO_COROUTINE) != 0;
+        const char* kind = coroutine ? "coroutine" : "generator";
+        switch (gen.state) {
+            case State::Running:
+                throw std::runtime_error(std::string("ValueError: ") + kind + " already executing");
+            case State::Completed:
+                if (coroutine) {
+                    throw std::runtime_error("RuntimeError: cannot reuse already awaited coroutine");
+                }
+                returned = true;
+                return PyObject();
+            case State::Created:
+                if (!is_none(value)) {
+                    throw std::runtime_error(std::string("TypeError: can't send non-None value to a "
+                                                         "just-started ") + kind);
+                }
+                break;
+            case State::Suspended:
+                break;
+        }
+        
+        CallDepthGuard guard(call_depth_);
+        Frame frame(gen, code_state_for(gen.code));
+        if (gen.state == State::Suspended) {
+            frame.push(std::move(value));  // The result of the yield expression
+        }
+        gen.state = State::Running;
+        
+        PyObject result;
+        try {
+            result = run_frame(frame);
+        } catch (...) {
+            gen.finish();
+            throw;
+        }
+        returned = !frame.suspended;
+        if (returned) {
+            gen.finish();
+        } else {
+            gen.state = State::Suspended;
+            gen.ip = frame.ip;
+            gen.stack_depth = frame.stack_size();
+        }
+        return result;
+    }
+    
     /**
      * Get the global namespace
      */
-    std::shared_ptr<PyDict> globals() { return globals_; }
+    core::Ref<PyDict> globals() { return globals_; }
     
     /**
      * Get the builtins namespace
      */
-    std::shared_ptr<PyDict> builtins() { return builtins_; }
+    core::Ref<PyDict> builtins() { return builtins_; }
+    
+    /**
+     * Select the dispatch engine (mainly for benchmarking)
+     */
+    void set_dispatch_mode(DispatchMode mode) { dispatch_mode_ = mode; }
+    DispatchMode dispatch_mode() const { return dispatch_mode_; }
+    
+    /**
+     * Redirect print() (sys.stdout); std::cout by default
+     */
+    void set_stdout(std::ostream& out) { stdout_ = &out; }
+    std::ostream& stdout_stream() const { return *stdout_; }
+    
+    /**
+     * Opcode profiling (see Profiler); off by default. Frames entered
+     * while it is on are profiled for their whole run. Off, the threaded
+     * engine dispatches exactly as without a profiler.
+     */
+    void set_profiling(bool on) { profiling_ = on; }
+    bool profiling() const { return profiling_; }
+    Profiler& profiler() { return profiler_; }
+    const Profiler& profiler() const { return profiler_; }
+    
+    /**
+     * Baseline JIT (see jit.hpp); on by default where it is supported.
+     * A code object is compiled once its calls plus loop back-edges reach
+     * the threshold, and only runs natively under the threaded engine
+     * without profiling, so the checked engine and profiles still see
+     * every instruction.
+     */
+    void set_jit(bool on) { jit_enabled_ = on && CPYTHON_CPP_JIT; }
+    bool jit() const { return jit_enabled_; }
+    void set_jit_threshold(uint32_t threshold) { jit_threshold_ = std::max<uint32_t>(threshold, 1); }
+    const JitStats& jit_stats() const { return jit_stats_; }
     
 private:
-    std::shared_ptr<PyDict> globals_;   // Global namespace
-    std::shared_ptr<PyDict> builtins_;  // Built-in functions
+    core::Ref<PyDict> globals_;   // Global namespace
+    core::Ref<PyDict> builtins_;  // Built-in functions
+    
+    // Per-code runtime data; node-based, so frames may hold on to entries
+    std::unordered_map<const compiler::CodeObject*, CodeState> code_states_;
+    DispatchMode dispatch_mode_ = DispatchMode::Threaded;
+    std::ostream* stdout_ = &std::cout;
+    
+    Profiler profiler_;
+    bool profiling_ = false;
+    
+    bool jit_enabled_ = CPYTHON_CPP_JIT;
+    uint32_t jit_threshold_ = CPYTHON_CPP_JIT_THRESHOLD;
+    JitStats jit_stats_;
+#if CPYTHON_CPP_JIT
+    // Code replaced after a deopt may still be running further up the
+    // C++ stack, so it lives as long as the VM
+    std::vector<std::unique_ptr<JitCode>> retired_jit_code_;
+    std::exception_ptr jit_error_;  // Raised by a helper, rethrown once native code has returned
+    static constexpr uint8_t JIT_MAX_COMPILES = 4;
+#endif
+    
+    // Locals and value stacks of all active frames
+    DataStack data_stack_;
+    
+    // Nested Python calls; each one is a C++ run_frame() call as well
+    static constexpr int RECURSION_LIMIT = 1000;
+    int call_depth_ = 0;
+    
+    // Code of the coroutines sleep() returns, built on first use
+    std::shared_ptr<compiler::CodeObject> sleep_code_;
+    
+#if CPYTHON_CPP_COMPUTED_GOTO
+    // Label addresses inside run_frame_threaded(), filled on first use;
+    // every entry of the profiled table leads through the profiler first
+    void* dispatch_table_[256] = {};
+    void* profiled_dispatch_table_[256] = {};
+    bool dispatch_table_ready_ = false;
+#endif
     
     /**
      * Setup built-in functions
      */
     void setup_builtins() {
-        // Built-ins will be added in the next phase
-        // For now, just create an empty namespace
+        // Dispatched by name in op_call() until builtins become callables
+        builtins_->set("print", std::string("<builtin print>"));
+        builtins_->set("set", std::string("<builtin set>"));
+        builtins_->set("next", std::string("<builtin next>"));
+        builtins_->set("iter", std::string("<builtin iter>"));
+        builtins_->set("range", std::string("<builtin range>"));
+        builtins_->set("len", std::string("<builtin len>"));
+        // asyncio.sleep() stand-in for the event loop (there is no import yet)
+        builtins_->set("sleep", std::string("<builtin sleep>"));
     }
     
     /**
      * Run a frame until it returns
      */
     PyObject run_frame(Frame& frame) {
+        if (profiling_) {
+            Profiler::Activation activation(profiler_, *frame.code);
+            return run_frame_engine(frame, true);
+        }
+#if CPYTHON_CPP_JIT
+        if (jit_enabled_ && dispatch_mode_ == DispatchMode::Threaded &&
+            (frame.state->jit || (++frame.state->warmth >= jit_threshold_ && compile_jit(*frame.state)))) {
+            ++jit_stats_.entries;
+            NativeRun run = run_native(frame, frame.ip);
+            if (run.error) {
+                try {
+                    std::rethrow_exception(run.error);
+                } catch (const std::exception& e) {
+                    std::cerr << "Runtime error at IP " << frame.ip << ": " << e.what() << "\n";
+                    throw;
+                }
+            }
+            if (run.returned) return std::move(run.value);
+        }
+#endif
+        return run_frame_engine(frame, false);
+    }
+    
+    PyObject run_frame_engine(Frame& frame, bool profiled) {
+        if (dispatch_mode_ == DispatchMode::Threaded && is_threadable(*frame.code)) {
+            return run_frame_threaded(frame, profiled);
+        }
+        return run_frame_switch(frame, profiled);
+    }
+    
+    /**
+     * The threaded engine skips per-instruction bounds checks, so it only
+     * accepts word-aligned code that cannot run past its final RETURN_VALUE.
+     */
+    static bool is_threadable(const compiler::CodeObject& code) {
+        const auto& bytes = code.co_code;
+        return !bytes.empty() && bytes.size() % 2 == 0 &&
+               bytes[bytes.size() - 2] == static_cast<uint8_t>(compiler::Opcode::RETURN_VALUE);
+    }
+    
+    /**
+     * Threaded dispatch loop
+     * 
+     * Decodes [opcode, arg] words straight from the frame's bytecode and
+     * jumps to the handler (computed goto, or a switch on compilers
+     * without it).
+     * EXTENDED_ARG folds its byte into the next instruction's argument.
+     * Exceptions are caught once around the whole loop rather than per
+     * instruction; frame.ip is only synchronised when leaving the loop.
+     * 
+     * BINARY_OP and COMPARE_OP are adaptive (PEP 659): once warm they
+     * rewrite their opcode byte to a type-specialized form, which
+     * rewrites it back to the generic form when its guard fails.
+     * 
+     * A profiled frame dispatches through profiled_dispatch_table_, whose
+     * targets all record the instruction and then jump to the handler;
+     * a deopt's re-dispatch to the generic form bypasses it.
+     */
+    CPYTHON_CPP_NOINLINE PyObject run_frame_threaded(Frame& frame, bool profiled) {
         using compiler::Opcode;
         
-        while (frame.ip < frame.code->co_code.size()) {
-            // Read the opcode
-            uint8_t opcode_byte = frame.read_byte();
-            Opcode opcode = static_cast<Opcode>(opcode_byte);
+        uint8_t* const first_instr = frame.bytecode;
+        const uint8_t* const end_instr = first_instr + frame.code->co_code.size();
+        uint8_t* next_instr = first_instr + frame.ip;
+        uint8_t opcode = 0;
+        int oparg = 0;
+        
+#ifdef VM_DEBUG
+#define VM_TRACE() \
+        std::cout << "IP=" << (next_instr - first_instr - 2) << " " \
+                  << compiler::opcode_name(static_cast<Opcode>(opcode)) << " " << oparg \
+                  << " (stack size: " << frame.stack_size() << ")\n"
+#else
+#define VM_TRACE() ((void)0)
+#endif
+        
+#if CPYTHON_CPP_COMPUTED_GOTO
+        if (!dispatch_table_ready_) {
+            for (auto& target : dispatch_table_) {
+                target = &&TARGET_unknown_opcode;
+            }
+#define SET_TARGET(op) dispatch_table_[static_cast<uint8_t>(Opcode::op)] = &&TARGET_##op;
+            CPYTHON_CPP_THREADED_OPCODES(SET_TARGET)
+#undef SET_TARGET
+            for (auto& target : profiled_dispatch_table_) {
+                target = &&TARGET_profile_instruction;
+            }
+            dispatch_table_ready_ = true;
+        }
+        void* const* const targets = profiled ? profiled_dispatch_table_ : dispatch_table_;
+#define TARGET(op) TARGET_##op:
+#define DISPATCH_OPCODE() do { VM_TRACE(); goto *targets[opcode]; } while (0)
+#define DISPATCH_UNPROFILED() do { VM_TRACE(); goto *dispatch_table_[opcode]; } while (0)
+#define DISPATCH() do { \
+            opcode = next_instr[0]; \
+            oparg = next_instr[1]; \
+            next_instr += 2; \
+            DISPATCH_OPCODE(); \
+        } while (0)
+#else
+#define TARGET(op) case Opcode::op:
+#define DISPATCH_OPCODE() goto dispatch_opcode
+#define DISPATCH_UNPROFILED() goto dispatch_unprofiled
+#define DISPATCH() continue
+#endif
+        
+        // Jumps are the only way to leave the straight-line code, so they
+        // carry the bounds checks; running off the end returns None.
+        // (Plain braces: DISPATCH() may be a `continue` of the switch loop.)
+        // Cache slot of the instruction being executed
+#define INLINE_CACHE() (frame.caches[(next_instr - first_instr) / 2 - 1])
+        
+        // Warm-up, then try to specialize the current instruction in place
+#define ADAPT(specializer) \
+        if (adaptive_counter_fired(INLINE_CACHE())) { \
+            Opcode specialized = specializer(frame, oparg); \
+            if (profiled) profiler_.specialization(specialized != static_cast<Opcode>(opcode)); \
+            quicken(next_instr - 2, specialized, INLINE_CACHE()); \
+        }
+        
+        // Guard failed: restore the generic opcode and re-dispatch to it
+#define DEOPT(generic) { \
+            if (profiled) profiler_.deopt(); \
+            deoptimize(next_instr - 2, Opcode::generic, INLINE_CACHE()); \
+            opcode = static_cast<uint8_t>(Opcode::generic); \
+            DISPATCH_UNPROFILED(); \
+        }
+        
+#define JUMP_TO(target) { \
+            next_instr = (target); \
+            if (next_instr >= end_instr) goto exit_frame; \
+            DISPATCH(); \
+        }
+        
+        try {
+#if CPYTHON_CPP_COMPUTED_GOTO
+            DISPATCH();
+#else
+            for (;;) {
+                opcode = next_instr[0];
+                oparg = next_instr[1];
+                next_instr += 2;
+            dispatch_opcode:
+                if (profiled) {
+                    profiler_.instruction(static_cast<int>(next_instr - first_instr - 2), opcode);
+                }
+            dispatch_unprofiled:
+                VM_TRACE();
+                switch (static_cast<Opcode>(opcode)) {
+#endif
             
-            // In CPython 3.11+, all instructions are 2 bytes (word-aligned)
-            // Always read the argument byte, even if unused
-            int arg = frame.read_arg();
+#if CPYTHON_CPP_COMPUTED_GOTO
+            TARGET_profile_instruction:
+                profiler_.instruction(static_cast<int>(next_instr - first_instr - 2), opcode);
+                goto *dispatch_table_[opcode];
+#endif
             
-            // Ignore argument if opcode doesn't use it
-            if (!compiler::opcode_has_arg(opcode)) {
-                arg = -1;
+            TARGET(EXTENDED_ARG) {
+                opcode = next_instr[0];
+                oparg = (oparg << 8) | next_instr[1];
+                next_instr += 2;
+                DISPATCH_OPCODE();
             }
             
-            // Debug output (optional)
-            #ifdef VM_DEBUG
-            std::cout << "IP=" << (frame.ip - 3) << " "
-                      << compiler::opcode_name(opcode) << " ";
-            if (arg != -1) std::cout << arg;
-            std::cout << " (stack size: " << frame.stack_size() << ")\n";
-            #endif
+            TARGET(NOP)
+            TARGET(RESUME)
+            TARGET(CACHE)
+            TARGET(BUILD_TEMPLATE)
+            TARGET(BUILD_INTERPOLATION) {
+                DISPATCH();
+            }
             
-            // Dispatch opcode
-            try {
-                dispatch_opcode(frame, opcode, arg);
-            } catch (const std::exception& e) {
-                std::cerr << "Runtime error at IP " << frame.ip << ": " << e.what() << "\n";
-                throw;
+            TARGET(LOAD_CONST) {
+                op_load_const(frame, oparg);
+                DISPATCH();
             }
             
-            // Check for return
-            if (opcode == Opcode::RETURN_VALUE) {
-                if (frame.stack_size() > 0) {
-                    return frame.pop();
-                } else {
-                    return std::monostate{};  // None
-                }
+            TARGET(LOAD_SMALL_INT) {
+                frame.push(static_cast<int64_t>(oparg));
+                DISPATCH();
             }
-        }
-        
-        // If we reach here, the code didn't return explicitly
-        return std::monostate{};  // None
-    }
-    
-    /**
-     * Dispatch a single opcode
-     */
-    void dispatch_opcode(Frame& frame, compiler::Opcode opcode, int arg) {
-        using compiler::Opcode;
-        
-        switch (opcode) {
-            // === Load/Store Operations ===
-            case Opcode::LOAD_CONST:
-                op_load_const(frame, arg);
-                break;
-                
-            case Opcode::LOAD_NAME:
-                op_load_name(frame, arg);
-                break;
-                
-            case Opcode::STORE_NAME:
-                op_store_name(frame, arg);
-                break;
-                
-            case Opcode::LOAD_FAST:
-                op_load_fast(frame, arg);
-                break;
-                
-            case Opcode::STORE_FAST:
-                op_store_fast(frame, arg);
-                break;
-                
-            case Opcode::LOAD_GLOBAL:
-                op_load_global(frame, arg);
-                break;
-                
-            case Opcode::STORE_GLOBAL:
-                op_store_global(frame, arg);
-                break;
-                
-            // === Stack Operations ===
-            case Opcode::POP_TOP:
+            
+            TARGET(LOAD_NAME) {
+                op_load_name(frame, oparg, INLINE_CACHE());
+                DISPATCH();
+            }
+            
+            TARGET(STORE_NAME) {
+                op_store_name(frame, oparg, INLINE_CACHE());
+                DISPATCH();
+            }
+            
+            TARGET(LOAD_FAST) {
+                op_load_fast(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(STORE_FAST) {
+                op_store_fast(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(LOAD_FAST_CHECK) {
+                op_load_fast(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(LOAD_FAST_LOAD_FAST) {
+                op_load_fast(frame, oparg >> 4);
+                op_load_fast(frame, oparg & 15);
+                DISPATCH();
+            }
+            
+            TARGET(LOAD_FAST_LOAD_CONST) {
+                op_load_fast(frame, oparg >> 4);
+                op_load_const(frame, oparg & 15);
+                DISPATCH();
+            }
+            
+            TARGET(DELETE_FAST) {
+                op_delete_fast(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(LOAD_LOCALS) {
+                op_load_locals(frame);
+                DISPATCH();
+            }
+            
+            TARGET(LOAD_GLOBAL) {
+                op_load_global(frame, oparg, INLINE_CACHE());
+                DISPATCH();
+            }
+            
+            TARGET(STORE_GLOBAL) {
+                op_store_global(frame, oparg, INLINE_CACHE());
+                DISPATCH();
+            }
+            
+            TARGET(POP_TOP) {
                 frame.pop();
-                break;
-                
-            // DUP_TOP and ROT_TWO not in CPython 3.11+ opcodes
-            // Use COPY and SWAP instead if needed
-                
-            // === Arithmetic Operations ===
-            case Opcode::BINARY_OP:
-                op_binary_op(frame, arg);
-                break;
-                
-            case Opcode::UNARY_NOT:
+                DISPATCH();
+            }
+            
+            TARGET(BINARY_OP) {
+                ADAPT(specialize_binary_op);
+                op_binary_op(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(BINARY_OP_ADD_INT) {
+                if (binary_op_int(frame, std::plus<int64_t>{})) DISPATCH();
+                DEOPT(BINARY_OP);
+            }
+            
+            TARGET(BINARY_OP_SUBTRACT_INT) {
+                if (binary_op_int(frame, std::minus<int64_t>{})) DISPATCH();
+                DEOPT(BINARY_OP);
+            }
+            
+            TARGET(BINARY_OP_MULTIPLY_INT) {
+                if (binary_op_int(frame, std::multiplies<int64_t>{})) DISPATCH();
+                DEOPT(BINARY_OP);
+            }
+            
+            TARGET(BINARY_OP_ADD_FLOAT) {
+                if (binary_op_float(frame, std::plus<double>{})) DISPATCH();
+                DEOPT(BINARY_OP);
+            }
+            
+            TARGET(BINARY_OP_SUBTRACT_FLOAT) {
+                if (binary_op_float(frame, std::minus<double>{})) DISPATCH();
+                DEOPT(BINARY_OP);
+            }
+            
+            TARGET(BINARY_OP_MULTIPLY_FLOAT) {
+                if (binary_op_float(frame, std::multiplies<double>{})) DISPATCH();
+                DEOPT(BINARY_OP);
+            }
+            
+            TARGET(BINARY_OP_ADD_UNICODE) {
+                if (oparg == static_cast<int>(compiler::BinaryOpCode::NB_INPLACE_ADD) &&
+                    inplace_add_unicode(frame, next_instr)) DISPATCH();
+                if (binary_op_add_unicode(frame)) DISPATCH();
+                DEOPT(BINARY_OP);
+            }
+            
+            TARGET(UNARY_NOT) {
                 op_unary_not(frame);
-                break;
-                
-            case Opcode::UNARY_NEGATIVE:
+                DISPATCH();
+            }
+            
+            TARGET(UNARY_NEGATIVE) {
                 op_unary_negative(frame);
-                break;
-                
-            case Opcode::UNARY_INVERT:
+                DISPATCH();
+            }
+            
+            TARGET(UNARY_INVERT) {
                 op_unary_invert(frame);
-                break;
-                
-            // === Comparison Operations ===
-            case Opcode::COMPARE_OP:
-                op_compare_op(frame, arg);
-                break;
+                DISPATCH();
+            }
+            
+            TARGET(COMPARE_OP) {
+                ADAPT(specialize_compare_op);
+                op_compare_op(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(COMPARE_OP_INT) {
+                if (compare_op_typed<PyTag::Int>(frame, oparg)) DISPATCH();
+                DEOPT(COMPARE_OP);
+            }
+            
+            TARGET(COMPARE_OP_FLOAT) {
+                if (compare_op_typed<PyTag::Float>(frame, oparg)) DISPATCH();
+                DEOPT(COMPARE_OP);
+            }
+            
+            TARGET(COMPARE_OP_STR) {
+                if (compare_op_typed<PyTag::Str>(frame, oparg)) DISPATCH();
+                DEOPT(COMPARE_OP);
+            }
+            
+            TARGET(CONTAINS_OP) {
+                op_contains_op(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(IS_OP) {
+                op_is_op(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(JUMP_FORWARD) {
+                JUMP_TO(next_instr + oparg);
+            }
+            
+            TARGET(JUMP_BACKWARD)
+            TARGET(JUMP_BACKWARD_NO_INTERRUPT) {
+                if (oparg > next_instr - first_instr) {
+                    throw std::runtime_error("Jump target out of bounds");
+                }
+#if CPYTHON_CPP_JIT
+                // A hot loop continues in native code from its head (OSR);
+                // whatever native code hands back resumes here
+                if (jit_enabled_ && !profiled &&
+                    (frame.state->jit || (++frame.state->warmth >= jit_threshold_ && compile_jit(*frame.state)))) {
+                    ++jit_stats_.osr_entries;
+                    NativeRun run = run_native(frame, static_cast<size_t>(next_instr - oparg - first_instr));
+                    next_instr = first_instr + frame.ip;
+                    if (run.error) std::rethrow_exception(run.error);
+                    if (run.returned) return std::move(run.value);
+                    DISPATCH();
+                }
+#endif
+                JUMP_TO(next_instr - oparg);
+            }
+            
+            TARGET(COMPARE_OP_POP_JUMP_IF_FALSE) {
+                // Consume the POP_JUMP_IF_FALSE (and its EXTENDED_ARGs) too
+                bool result = op_compare_and_pop(frame, oparg);
+                int target = 0;
+                while (next_instr[0] == static_cast<uint8_t>(Opcode::EXTENDED_ARG)) {
+                    target = (target << 8) | next_instr[1];
+                    next_instr += 2;
+                }
+                target = (target << 8) | next_instr[1];
+                next_instr += 2;
+                if (!result) {
+                    JUMP_TO(first_instr + target);
+                }
+                DISPATCH();
+            }
+            
+            TARGET(POP_JUMP_IF_FALSE) {
+                if (!to_bool(frame.pop())) {
+                    JUMP_TO(first_instr + oparg);
+                }
+                DISPATCH();
+            }
+            
+            TARGET(POP_JUMP_IF_TRUE) {
+                if (to_bool(frame.pop())) {
+                    JUMP_TO(first_instr + oparg);
+                }
+                DISPATCH();
+            }
+            
+            TARGET(CALL) {
+                op_call(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(MAKE_FUNCTION) {
+                op_make_function(frame);
+                DISPATCH();
+            }
+            
+            TARGET(LOAD_ATTR) {
+                op_load_attr(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(GET_ITER) {
+                op_get_iter(frame);
+                DISPATCH();
+            }
+            
+            TARGET(FOR_ITER) {
+                ADAPT(specialize_for_iter);
+                // Exhausted: the iterator stays for END_FOR at the target
+                if (!op_for_iter(frame)) {
+                    JUMP_TO(next_instr + oparg);
+                }
+                DISPATCH();
+            }
+            
+            TARGET(FOR_ITER_LIST) {
+                IterStep step = for_iter_items<PySeqIterator::Kind::List>(frame);
+                if (step == IterStep::Next) DISPATCH();
+                if (step == IterStep::Exhausted) JUMP_TO(next_instr + oparg);
+                DEOPT(FOR_ITER);
+            }
+            
+            TARGET(FOR_ITER_TUPLE) {
+                IterStep step = for_iter_items<PySeqIterator::Kind::Tuple>(frame);
+                if (step == IterStep::Next) DISPATCH();
+                if (step == IterStep::Exhausted) JUMP_TO(next_instr + oparg);
+                DEOPT(FOR_ITER);
+            }
+            
+            TARGET(FOR_ITER_RANGE) {
+                int64_t value = 0;
+                IterStep step = for_iter_range(frame, value);
+                if (step == IterStep::Exhausted) JUMP_TO(next_instr + oparg);
+                if (step == IterStep::Deopt) DEOPT(FOR_ITER);
+                // `for i in range(...)`: store the loop variable directly and
+                // skip the STORE_FAST, so the int never touches the stack
+                if (next_instr[0] == static_cast<uint8_t>(Opcode::STORE_FAST) &&
+                    next_instr[1] < frame.fastlocals.size()) {
+                    frame.fastlocals[next_instr[1]] = PyObject(value);
+                    next_instr += 2;
+                    DISPATCH();
+                }
+                frame.push(PyObject(value));
+                DISPATCH();
+            }
+            
+            TARGET(END_FOR) {
+                frame.pop();
+                DISPATCH();
+            }
+            
+            TARGET(GET_YIELD_FROM_ITER) {
+                op_get_yield_from_iter(frame);
+                DISPATCH();
+            }
+            
+            TARGET(GET_AWAITABLE) {
+                op_get_awaitable(frame);
+                DISPATCH();
+            }
+            
+            TARGET(SEND) {
+                if (op_send(frame)) {
+                    JUMP_TO(next_instr + oparg);
+                }
+                DISPATCH();
+            }
+            
+            TARGET(END_SEND) {
+                op_end_send(frame);
+                DISPATCH();
+            }
+            
+            TARGET(YIELD_VALUE) {
+                frame.ip = static_cast<size_t>(next_instr - first_instr);
+                frame.suspended = true;
+                return frame.pop();
+            }
+            
+            TARGET(BUILD_LIST) {
+                op_build_list(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(LIST_APPEND) {
+                op_list_append(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(SET_ADD) {
+                op_set_add(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(MAP_ADD) {
+                op_map_add(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(BUILD_TUPLE) {
+                op_build_tuple(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(BUILD_STRING) {
+                op_build_string(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(FORMAT_SIMPLE) {
+                op_format_simple(frame);
+                DISPATCH();
+            }
+            
+            TARGET(FORMAT_WITH_SPEC) {
+                op_format_with_spec(frame);
+                DISPATCH();
+            }
+            
+            TARGET(CONVERT_VALUE) {
+                op_convert_value(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(BUILD_MAP) {
+                op_build_map(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(BUILD_SET) {
+                op_build_set(frame, oparg);
+                DISPATCH();
+            }
+            
+            TARGET(BINARY_SLICE) {
+                op_binary_slice(frame);
+                DISPATCH();
+            }
+            
+            TARGET(BEFORE_WITH) {
+                op_before_with(frame);
+                DISPATCH();
+            }
+            
+            TARGET(BEFORE_ASYNC_WITH) {
+                op_before_async_with(frame);
+                DISPATCH();
+            }
+            
+            TARGET(RETURN_VALUE) {
+                frame.ip = static_cast<size_t>(next_instr - first_instr);
+                if (frame.stack_size() > 0) {
+                    return frame.pop();
+                }
+                return PyObject();  // None
+            }
+            
+#if CPYTHON_CPP_COMPUTED_GOTO
+            TARGET_unknown_opcode:
+#else
+                default:
+                    break;
+                }
+            }
+#endif
+            throw std::runtime_error("Unimplemented opcode: " +
+                std::string(compiler::opcode_name(static_cast<Opcode>(opcode))) +
+                " (" + std::to_string(static_cast<int>(opcode)) + ")");
+            
+        exit_frame:
+            frame.ip = static_cast<size_t>(next_instr - first_instr);
+            return PyObject();  // None
+            
+        } catch (const std::exception& e) {
+            frame.ip = static_cast<size_t>(next_instr - first_instr);
+            std::cerr << "Runtime error at IP " << frame.ip << ": " << e.what() << "\n";
+            throw;
+        }
+        
+#undef JUMP_TO
+#undef INLINE_CACHE
+#undef ADAPT
+#undef DEOPT
+#undef DISPATCH
+#undef DISPATCH_UNPROFILED
+#undef DISPATCH_OPCODE
+#undef TARGET
+#undef VM_TRACE
+    }
+    
+    /**
+     * Checked switch loop (bounds-checked reads, one dispatch_opcode() call
+     * per instruction). Used for code the threaded engine rejects and as
+     * the baseline in benchmarks/bench_dispatch.cpp.
+     */
+    PyObject run_frame_switch(Frame& frame, bool profiled) {
+        using compiler::Opcode;
+        
+        while (frame.ip < frame.code->co_code.size()) {
+            // Read the opcode
+            uint8_t opcode_byte = frame.read_byte();
+            Opcode opcode = static_cast<Opcode>(opcode_byte);
+            
+            // In CPython 3.11+, all instructions are 2 bytes (word-aligned)
+            // Always read the argument byte, even if unused
+            int arg = frame.read_arg();
+            
+            // EXTENDED_ARG prefixes supply the high bytes of the argument
+            while (opcode == Opcode::EXTENDED_ARG) {
+                opcode = static_cast<Opcode>(frame.read_byte());
+                arg = (arg << 8) | frame.read_arg();
+            }
+            
+            // Ignore argument if opcode doesn't use it
+            if (!compiler::opcode_has_arg(opcode)) {
+                arg = -1;
+            }
+            
+            if (profiled) {
+                profiler_.instruction(static_cast<int>(frame.ip - 2), static_cast<uint8_t>(opcode));
+            }
+            
+            // Debug output (optional)
+            #ifdef VM_DEBUG
+            std::cout << "IP=" << (frame.ip - 2) << " "
+                      << compiler::opcode_name(opcode) << " ";
+            if (arg != -1) std::cout << arg;
+            std::cout << " (stack size: " << frame.stack_size() << ")\n";
+            #endif
+            
+            // Dispatch opcode
+            try {
+                dispatch_opcode(frame, opcode, arg);
+            } catch (const std::exception& e) {
+                std::cerr << "Runtime error at IP " << frame.ip << ": " << e.what() << "\n";
+                throw;
+            }
+            
+            // Check for return or yield
+            if (opcode == Opcode::YIELD_VALUE) {
+                frame.suspended = true;
+                return frame.pop();
+            }
+            if (opcode == Opcode::RETURN_VALUE) {
+                if (frame.stack_size() > 0) {
+                    return frame.pop();
+                } else {
+                    return PyObject();  // None
+                }
+            }
+        }
+        
+        // If we reach here, the code didn't return explicitly
+        return PyObject();  // None
+    }
+    
+    /**
+     * Dispatch a single opcode
+     */
+    void dispatch_opcode(Frame& frame, compiler::Opcode opcode, int arg) {
+        using compiler::Opcode;
+        
+        switch (opcode) {
+            // === Load/Store Operations ===
+            case Opcode::LOAD_CONST:
+                op_load_const(frame, arg);
+                break;
+                
+            case Opcode::LOAD_NAME:
+                op_load_name(frame, arg, current_cache(frame));
+                break;
+                
+            case Opcode::STORE_NAME:
+                op_store_name(frame, arg, current_cache(frame));
+                break;
+                
+            case Opcode::LOAD_FAST:
+                op_load_fast(frame, arg);
+                break;
+                
+            case Opcode::STORE_FAST:
+                op_store_fast(frame, arg);
+                break;
+                
+            case Opcode::LOAD_FAST_CHECK:
+                op_load_fast(frame, arg);
+                break;
+                
+            case Opcode::LOAD_FAST_LOAD_FAST:
+                op_load_fast(frame, arg >> 4);
+                op_load_fast(frame, arg & 15);
+                break;
+                
+            case Opcode::LOAD_FAST_LOAD_CONST:
+                op_load_fast(frame, arg >> 4);
+                op_load_const(frame, arg & 15);
+                break;
+                
+            case Opcode::DELETE_FAST:
+                op_delete_fast(frame, arg);
+                break;
+                
+            case Opcode::LOAD_LOCALS:
+                op_load_locals(frame);
+                break;
+                
+            case Opcode::LOAD_GLOBAL:
+                op_load_global(frame, arg, current_cache(frame));
+                break;
+                
+            case Opcode::STORE_GLOBAL:
+                op_store_global(frame, arg, current_cache(frame));
+                break;
+                
+            // === Stack Operations ===
+            case Opcode::POP_TOP:
+                frame.pop();
+                break;
+                
+            // DUP_TOP and ROT_TWO not in CPython 3.11+ opcodes
+            // Use COPY and SWAP instead if needed
+                
+            // === Arithmetic Operations ===
+            // Specialized forms keep the generic arg; this loop does not
+            // adapt, it just runs whatever the threaded engine left
+            case Opcode::BINARY_OP:
+            case Opcode::BINARY_OP_ADD_INT:
+            case Opcode::BINARY_OP_SUBTRACT_INT:
+            case Opcode::BINARY_OP_MULTIPLY_INT:
+            case Opcode::BINARY_OP_ADD_FLOAT:
+            case Opcode::BINARY_OP_SUBTRACT_FLOAT:
+            case Opcode::BINARY_OP_MULTIPLY_FLOAT:
+            case Opcode::BINARY_OP_ADD_UNICODE:
+                if (arg == static_cast<int>(compiler::BinaryOpCode::NB_INPLACE_ADD) &&
+                    frame.ip < frame.code->co_code.size() &&
+                    inplace_add_unicode(frame, frame.bytecode + frame.ip)) break;
+                op_binary_op(frame, arg);
+                break;
+                
+            case Opcode::UNARY_NOT:
+                op_unary_not(frame);
+                break;
+                
+            case Opcode::UNARY_NEGATIVE:
+                op_unary_negative(frame);
+                break;
+                
+            case Opcode::UNARY_INVERT:
+                op_unary_invert(frame);
+                break;
+                
+            // === Comparison Operations ===
+            case Opcode::COMPARE_OP:
+            case Opcode::COMPARE_OP_INT:
+            case Opcode::COMPARE_OP_FLOAT:
+            case Opcode::COMPARE_OP_STR:
+            case Opcode::COMPARE_OP_POP_JUMP_IF_FALSE:  // The jump runs on its own here
+                op_compare_op(frame, arg);
+                break;
+                
+            case Opcode::CONTAINS_OP:
+                op_contains_op(frame, arg);
+                break;
+                
+            case Opcode::IS_OP:
+                op_is_op(frame, arg);
+                break;
                 
             // === Control Flow ===
             case Opcode::RETURN_VALUE:
@@ -248,6 +1264,7 @@ private:
                 break;
                 
             case Opcode::JUMP_BACKWARD:
+            case Opcode::JUMP_BACKWARD_NO_INTERRUPT:
                 frame.ip -= arg;
                 break;
                 
@@ -272,42 +1289,122 @@ private:
                 op_call(frame, arg);
                 break;
                 
-            // === Build Operations ===
-            case Opcode::BUILD_LIST:
-                op_build_list(frame, arg);
+            case Opcode::MAKE_FUNCTION:
+                op_make_function(frame);
                 break;
                 
-            case Opcode::BUILD_TUPLE:
-                op_build_tuple(frame, arg);
+            case Opcode::LOAD_ATTR:
+                op_load_attr(frame, arg);
                 break;
                 
-            case Opcode::BUILD_MAP:
-                op_build_map(frame, arg);
+            // === Iteration and Generators ===
+            case Opcode::GET_ITER:
+                op_get_iter(frame);
                 break;
                 
-            case Opcode::BUILD_SET:
-                op_build_set(frame, arg);
+            case Opcode::FOR_ITER:
+            case Opcode::FOR_ITER_LIST:
+            case Opcode::FOR_ITER_TUPLE:
+            case Opcode::FOR_ITER_RANGE:
+                if (!op_for_iter(frame)) {
+                    frame.ip += arg;
+                }
                 break;
                 
-            // === Small Integer Optimization ===
-            case Opcode::LOAD_SMALL_INT:
-                frame.push(static_cast<int64_t>(arg));
+            case Opcode::END_FOR:
+                frame.pop();
                 break;
                 
-            // === T-string Operations (temporary stub) ===
-            case Opcode::BUILD_TEMPLATE:
-            case Opcode::BUILD_INTERPOLATION:
-                // For now, just pass through (t-strings not fully implemented)
-                // This prevents crashes on simple code that shouldn't use t-strings
+            case Opcode::GET_YIELD_FROM_ITER:
+                op_get_yield_from_iter(frame);
                 break;
                 
-            // === Slicing Operations ===
-            case Opcode::BINARY_SLICE:
-                op_binary_slice(frame);
+            case Opcode::GET_AWAITABLE:
+                op_get_awaitable(frame);
                 break;
                 
-            // === Context Manager Operations ===
-            case Opcode::BEFORE_WITH:
+            case Opcode::SEND:
+                if (op_send(frame)) {
+                    frame.ip += arg;
+                }
+                break;
+                
+            case Opcode::END_SEND:
+                op_end_send(frame);
+                break;
+                
+            case Opcode::YIELD_VALUE:
+                // Handled in run_frame()
+                break;
+                
+            case Opcode::RESUME:
+                break;
+                
+            // === Build Operations ===
+            case Opcode::BUILD_LIST:
+                op_build_list(frame, arg);
+                break;
+                
+            case Opcode::LIST_APPEND:
+                op_list_append(frame, arg);
+                break;
+                
+            case Opcode::SET_ADD:
+                op_set_add(frame, arg);
+                break;
+                
+            case Opcode::MAP_ADD:
+                op_map_add(frame, arg);
+                break;
+                
+            case Opcode::BUILD_TUPLE:
+                op_build_tuple(frame, arg);
+                break;
+                
+            // === F-strings ===
+            case Opcode::BUILD_STRING:
+                op_build_string(frame, arg);
+                break;
+                
+            case Opcode::FORMAT_SIMPLE:
+                op_format_simple(frame);
+                break;
+                
+            case Opcode::FORMAT_WITH_SPEC:
+                op_format_with_spec(frame);
+                break;
+                
+            case Opcode::CONVERT_VALUE:
+                op_convert_value(frame, arg);
+                break;
+                
+            case Opcode::BUILD_MAP:
+                op_build_map(frame, arg);
+                break;
+                
+            case Opcode::BUILD_SET:
+                op_build_set(frame, arg);
+                break;
+                
+            // === Small Integer Optimization ===
+            case Opcode::LOAD_SMALL_INT:
+                frame.push(static_cast<int64_t>(arg));
+                break;
+                
+            // === T-string Operations (temporary stub) ===
+            case Opcode::BUILD_TEMPLATE:
+            case Opcode::BUILD_INTERPOLATION:
+                // For now, just pass through (t-strings not fully implemented)
+                // This prevents crashes on simple code that shouldn't use t-strings
+                break;
+                
+            // === Slicing Operations ===
+            case Opcode::BINARY_SLICE:
+                op_binary_slice(frame);
+                break;
+                
+            // === Context Manager Operations ===
+            case Opcode::BEFORE_WITH:
                 op_before_with(frame);
                 break;
                 
@@ -321,322 +1418,1371 @@ private:
                 // Just skip it
                 break;
                 
+            case Opcode::NOP:
+                break;
+                
+            default:
+                throw std::runtime_error("Unimplemented opcode: " + 
+                    std::string(compiler::opcode_name(opcode)) + 
+                    " (" + std::to_string(static_cast<int>(opcode)) + ")");
+        }
+    }
+    
+    // === Opcode Implementations ===
+    
+    // This VM's CodeState for code, built the first time it runs here
+    CodeState& code_state_for(const std::shared_ptr<compiler::CodeObject>& code) {
+        auto it = code_states_.find(code.get());
+        if (it != code_states_.end()) {
+            return it->second;
+        }
+        
+        CodeState state;
+        state.code = code;
+        state.bytecode = code->co_code;
+        state.caches.resize(code->co_code.size() / 2);
+        state.consts.reserve(code->co_consts.size());
+        for (const auto& constant : code->co_consts) {
+            // Convert PyConstant to PyObject
+            state.consts.push_back(std::visit([](const auto& val) -> PyObject {
+                using T = std::decay_t<decltype(val)>;
+                if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, int64_t> ||
+                              std::is_same_v<T, double>) {
+                    return val;
+                } else if constexpr (std::is_same_v<T, std::string>) {
+                    // Identifier-like constants are interned, as in CPython
+                    return all_name_chars(val) ? intern_string(val) : PyObject(val);
+                } else if constexpr (std::is_same_v<T, std::shared_ptr<compiler::CodeObject>>) {
+                    return core::make_ref<PyCode>(val);
+                } else {
+                    return PyObject();  // None, and kinds the VM cannot run yet
+                }
+            }, constant));
+        }
+        return code_states_.emplace(code.get(), std::move(state)).first->second;
+    }
+    
+    void op_load_const(Frame& frame, int arg) {
+        if (arg < 0 || static_cast<size_t>(arg) >= frame.consts->size()) {
+            throw std::runtime_error("Invalid constant index: " + std::to_string(arg));
+        }
+        
+        frame.push((*frame.consts)[arg]);
+    }
+    
+    void op_load_name(Frame& frame, int arg, compiler::InlineCache& cache) {
+        if (arg < 0 || arg >= static_cast<int>(frame.code->co_names.size())) {
+            throw std::runtime_error("Invalid name index: " + std::to_string(arg));
+        }
+        
+        const std::string& name = frame.code->co_names[arg];
+        
+        // Module level: locals are the globals, so this is LOAD_GLOBAL
+        if (frame.locals == frame.globals) {
+            frame.push(load_global_cached(frame, name, cache));
+            return;
+        }
+        
+        auto locals = frame.locals_dict();
+        
+        // Try locals first, then globals, then builtins (one probe each)
+        const PyObject* value = locals->find(name);
+        if (!value) {
+            value = frame.globals->find(name);
+        }
+        if (!value) {
+            value = builtins_->find(name);
+        }
+        if (!value) {
+            throw std::runtime_error("NameError: name '" + name + "' is not defined");
+        }
+        frame.push(*value);
+    }
+    
+    void op_store_name(Frame& frame, int arg, compiler::InlineCache& cache) {
+        if (arg < 0 || arg >= static_cast<int>(frame.code->co_names.size())) {
+            throw std::runtime_error("Invalid name index: " + std::to_string(arg));
+        }
+        
+        const std::string& name = frame.code->co_names[arg];
+        PyObject value = frame.pop();
+        if (frame.locals == frame.globals) {
+            store_global_cached(frame, name, std::move(value), cache);
+            return;
+        }
+        if (!frame.locals) {
+            frame.locals_dict();
+        }
+        frame.locals->set(name, std::move(value));
+    }
+    
+    void op_load_fast(Frame& frame, int arg) {
+        if (arg < 0 || static_cast<size_t>(arg) >= frame.fastlocals.size()) {
+            throw std::runtime_error("Invalid varname index: " + std::to_string(arg));
+        }
+        
+        const PyObject& slot = frame.fastlocals[arg];
+        if (slot.is_null()) {
+            throw std::runtime_error("UnboundLocalError: local variable '" +
+                frame.code->co_varnames[arg] + "' referenced before assignment");
+        }
+        frame.push(slot);
+    }
+    
+    void op_store_fast(Frame& frame, int arg) {
+        if (arg < 0 || static_cast<size_t>(arg) >= frame.fastlocals.size()) {
+            throw std::runtime_error("Invalid varname index: " + std::to_string(arg));
+        }
+        
+        frame.fastlocals[arg] = frame.pop();
+    }
+    
+    void op_delete_fast(Frame& frame, int arg) {
+        if (arg < 0 || static_cast<size_t>(arg) >= frame.fastlocals.size()) {
+            throw std::runtime_error("Invalid varname index: " + std::to_string(arg));
+        }
+        
+        if (frame.fastlocals[arg].is_null()) {
+            throw std::runtime_error("UnboundLocalError: local variable '" +
+                frame.code->co_varnames[arg] + "' referenced before assignment");
+        }
+        frame.fastlocals[arg] = PyObject::null();
+    }
+    
+    void op_load_locals(Frame& frame) {
+        frame.push(frame.locals_dict());
+    }
+    
+    void op_load_global(Frame& frame, int arg, compiler::InlineCache& cache) {
+        if (arg < 0 || arg >= static_cast<int>(frame.code->co_names.size())) {
+            throw std::runtime_error("Invalid name index: " + std::to_string(arg));
+        }
+        
+        frame.push(load_global_cached(frame, frame.code->co_names[arg], cache));
+    }
+    
+    void op_store_global(Frame& frame, int arg, compiler::InlineCache& cache) {
+        if (arg < 0 || arg >= static_cast<int>(frame.code->co_names.size())) {
+            throw std::runtime_error("Invalid name index: " + std::to_string(arg));
+        }
+        
+        store_global_cached(frame, frame.code->co_names[arg], frame.pop(), cache);
+    }
+    
+    // === Inline caches (CPython's LOAD_GLOBAL_MODULE / LOAD_GLOBAL_BUILTIN) ===
+    
+    enum CacheKind : uint8_t {
+        CACHE_EMPTY = 0,
+        CACHE_GLOBAL,   // Entry in globals
+        CACHE_BUILTIN,  // Entry in builtins; guard_version pins the globals miss
+    };
+    
+    compiler::InlineCache& current_cache(Frame& frame) {
+        return frame.caches[frame.ip / 2 - 1];
+    }
+    
+    /**
+     * Globals-then-builtins lookup. A hit is two version compares and an
+     * indexed load; a miss does the probes and refills the slot.
+     */
+    const PyObject& load_global_cached(Frame& frame, const std::string& name,
+                                       compiler::InlineCache& cache) {
+        PyDict& globals = *frame.globals;
+        if (cache.kind == CACHE_GLOBAL && cache.version == globals.keys_version()) {
+            if (profiling_) profiler_.cache_access(true);
+            return globals.value_at(cache.index);
+        }
+        if (cache.kind == CACHE_BUILTIN && cache.guard_version == globals.keys_version() &&
+            cache.version == builtins_->keys_version()) {
+            if (profiling_) profiler_.cache_access(true);
+            return builtins_->value_at(cache.index);
+        }
+        if (profiling_) profiler_.cache_access(false);
+        
+        int64_t ix = globals.index_of(name);
+        if (ix >= 0) {
+            cache = {globals.keys_version(), 0, static_cast<int32_t>(ix), CACHE_GLOBAL};
+            return globals.value_at(ix);
+        }
+        ix = builtins_->index_of(name);
+        if (ix >= 0) {
+            cache = {builtins_->keys_version(), globals.keys_version(),
+                     static_cast<int32_t>(ix), CACHE_BUILTIN};
+            return builtins_->value_at(ix);
+        }
+        throw std::runtime_error("NameError: name '" + name + "' is not defined");
+    }
+    
+    // Rebinding an existing global keeps the keys version, so a hit
+    // overwrites the cached entry in place
+    void store_global_cached(Frame& frame, const std::string& name, PyObject value,
+                             compiler::InlineCache& cache) {
+        PyDict& globals = *frame.globals;
+        if (cache.kind == CACHE_GLOBAL && cache.version == globals.keys_version()) {
+            if (profiling_) profiler_.cache_access(true);
+            globals.value_at(cache.index) = std::move(value);
+            return;
+        }
+        
+        if (profiling_) profiler_.cache_access(false);
+        globals.set(name, std::move(value));
+        cache = {globals.keys_version(), 0, static_cast<int32_t>(globals.index_of(name)), CACHE_GLOBAL};
+    }
+    
+    void op_binary_op(Frame& frame, int op) {
+        using compiler::BinaryOpCode;
+        
+        PyObject right = frame.pop();
+        PyObject left = frame.pop();
+        
+        // In-place variants share the plain implementation for now
+        if (op >= static_cast<int>(BinaryOpCode::NB_INPLACE_ADD)) {
+            op -= static_cast<int>(BinaryOpCode::NB_INPLACE_ADD);
+        }
+        auto code = static_cast<BinaryOpCode>(op);
+        
+        PyObject result;
+        
+        // Handle int operations
+        if (is_int(left) && is_int(right)) {
+            int64_t l = left.as_int();
+            int64_t r = right.as_int();
+            
+            switch (code) {
+                case BinaryOpCode::NB_ADD: result = l + r; break;
+                case BinaryOpCode::NB_AND: result = l & r; break;
+                case BinaryOpCode::NB_FLOOR_DIVIDE: result = int_floor_divide(l, r); break;
+                case BinaryOpCode::NB_LSHIFT: result = l << r; break;
+                case BinaryOpCode::NB_REMAINDER: result = int_remainder(l, r); break;
+                case BinaryOpCode::NB_MULTIPLY: result = l * r; break;
+                case BinaryOpCode::NB_OR: result = l | r; break;
+                case BinaryOpCode::NB_POWER: result = int_power(l, r); break;
+                case BinaryOpCode::NB_RSHIFT: result = l >> r; break;
+                case BinaryOpCode::NB_SUBTRACT: result = l - r; break;
+                case BinaryOpCode::NB_TRUE_DIVIDE:
+                    check_divisor(static_cast<double>(r));
+                    result = static_cast<double>(l) / static_cast<double>(r);
+                    break;
+                case BinaryOpCode::NB_XOR: result = l ^ r; break;
+                default:
+                    throw std::runtime_error("Unknown binary operation: " + std::to_string(op));
+            }
+        }
+        // Handle float operations
+        else if (is_number(left) && is_number(right)) {
+            double l = to_float(left);
+            double r = to_float(right);
+            
+            switch (code) {
+                case BinaryOpCode::NB_ADD: result = l + r; break;
+                case BinaryOpCode::NB_MULTIPLY: result = l * r; break;
+                case BinaryOpCode::NB_POWER: result = std::pow(l, r); break;
+                case BinaryOpCode::NB_SUBTRACT: result = l - r; break;
+                case BinaryOpCode::NB_TRUE_DIVIDE: check_divisor(r); result = l / r; break;
+                case BinaryOpCode::NB_FLOOR_DIVIDE: check_divisor(r); result = std::floor(l / r); break;
+                case BinaryOpCode::NB_REMAINDER: result = float_remainder(l, r); break;
+                default:
+                    throw std::runtime_error("Unsupported float operation: " + std::to_string(op));
+            }
+        }
+        // Handle string operations
+        else if (is_string(left) && is_string(right)) {
+            switch (code) {
+                case BinaryOpCode::NB_ADD: result = left.as_string() + right.as_string(); break;
+                default:
+                    throw std::runtime_error("Unsupported string operation: " + std::to_string(op));
+            }
+        }
+        // Handle set algebra
+        else if (is_set(left) && is_set(right)) {
+            const PySet& l = *left.as<PySet>();
+            const PySet& r = *right.as<PySet>();
+            
+            switch (code) {
+                case BinaryOpCode::NB_OR: result = l.set_union(r); break;
+                case BinaryOpCode::NB_AND: result = l.set_intersection(r); break;
+                case BinaryOpCode::NB_SUBTRACT: result = l.set_difference(r); break;
+                case BinaryOpCode::NB_XOR: result = l.set_symmetric_difference(r); break;
+                default:
+                    throw std::runtime_error("Unsupported set operation: " + std::to_string(op));
+            }
+        }
+        else {
+            throw std::runtime_error("Unsupported operand types for binary operation");
+        }
+        
+        frame.push(std::move(result));
+    }
+    
+    // Python semantics: // and % round toward negative infinity
+    static void check_divisor(double r) {
+        if (r == 0.0) {
+            throw std::runtime_error("ZeroDivisionError: division by zero");
+        }
+    }
+    
+    static int64_t int_floor_divide(int64_t l, int64_t r) {
+        check_divisor(static_cast<double>(r));
+        int64_t q = l / r;
+        if ((l % r != 0) && ((l < 0) != (r < 0))) --q;
+        return q;
+    }
+    
+    static int64_t int_remainder(int64_t l, int64_t r) {
+        check_divisor(static_cast<double>(r));
+        int64_t m = l % r;
+        if (m != 0 && ((m < 0) != (r < 0))) m += r;
+        return m;
+    }
+    
+    static double float_remainder(double l, double r) {
+        check_divisor(r);
+        double m = std::fmod(l, r);
+        if (m != 0.0 && ((m < 0) != (r < 0))) m += r;
+        return m;
+    }
+    
+    // Negative exponents give a float, as in Python
+    static PyObject int_power(int64_t base, int64_t exp) {
+        if (exp < 0) {
+            return std::pow(static_cast<double>(base), static_cast<double>(exp));
+        }
+        int64_t result = 1;
+        while (exp > 0) {
+            if (exp & 1) result *= base;
+            base *= base;
+            exp >>= 1;
+        }
+        return result;
+    }
+    
+    void op_unary_not(Frame& frame) {
+        PyObject value = frame.pop();
+        frame.push(!to_bool(value));
+    }
+    
+    void op_unary_negative(Frame& frame) {
+        PyObject value = frame.pop();
+        if (is_int(value)) {
+            frame.push(-value.as_int());
+        } else if (is_float(value)) {
+            frame.push(-value.as_float());
+        } else {
+            throw std::runtime_error("Unsupported operand type for unary -");
+        }
+    }
+    
+    void op_unary_positive(Frame& frame) {
+        PyObject value = frame.pop();
+        if (is_int(value) || is_float(value)) {
+            frame.push(value);  // No-op for numbers
+        } else {
+            throw std::runtime_error("Unsupported operand type for unary +");
+        }
+    }
+    
+    void op_unary_invert(Frame& frame) {
+        PyObject value = frame.pop();
+        if (is_int(value)) {
+            frame.push(~value.as_int());
+        } else {
+            throw std::runtime_error("Unsupported operand type for unary ~");
+        }
+    }
+    
+    void op_compare_op(Frame& frame, int op) {
+        PyObject right = frame.pop();
+        PyObject left = frame.pop();
+        
+        bool result = false;
+        
+        if (is_int(left) && is_int(right)) {
+            result = compare_values(op, left.as_int(), right.as_int());
+        } else if (is_number(left) && is_number(right)) {
+            result = compare_values(op, to_float(left), to_float(right));
+        } else if (is_string(left) && is_string(right)) {
+            result = compare_values(op, left.as_string(), right.as_string());
+        } else {
+            throw std::runtime_error("Unsupported operand types for comparison");
+        }
+        
+        frame.push(result);
+    }
+    
+    /**
+     * Compare the top two values and pop both, returning the result
+     * directly so COMPARE_OP_POP_JUMP_IF_FALSE never pushes a bool
+     */
+    bool op_compare_and_pop(Frame& frame, int op) {
+        auto& stack = frame.value_stack;
+        size_t n = stack.size();
+        if (n >= 2) {
+            const PyObject& l = stack[n - 2];
+            const PyObject& r = stack[n - 1];
+            if (is_int(l) && is_int(r)) {
+                bool result = compare_values(op, l.as_int(), r.as_int());
+                frame.drop(2);
+                return result;
+            }
+            if (is_float(l) && is_float(r)) {
+                bool result = compare_values(op, l.as_float(), r.as_float());
+                frame.drop(2);
+                return result;
+            }
+        }
+        op_compare_op(frame, op);
+        return to_bool(frame.pop());
+    }
+    
+    template<typename T>
+    static bool compare_values(int op, const T& l, const T& r) {
+        using compiler::CompareOpCode;
+        switch (static_cast<CompareOpCode>(op)) {
+            case CompareOpCode::LT: return l < r;
+            case CompareOpCode::LE: return l <= r;
+            case CompareOpCode::EQ: return l == r;
+            case CompareOpCode::NE: return l != r;
+            case CompareOpCode::GT: return l > r;
+            case CompareOpCode::GE: return l >= r;
+        }
+        throw std::runtime_error("Unknown comparison operation: " + std::to_string(op));
+    }
+    
+    // === Specialized instructions (PEP 659) ===
+    // Each works on the top two stack slots in place and returns false,
+    // touching nothing, when its type guard fails.
+    
+    static constexpr uint16_t ADAPTIVE_WARMUP = 8;       // Executions before specializing
+    static constexpr uint8_t ADAPTIVE_MAX_BACKOFF = 8;   // Up to 8 << 8 executions
+    
+    // Counts executions; the slot's kind holds the backoff exponent
+    static bool adaptive_counter_fired(compiler::InlineCache& cache) {
+        if (++cache.counter < (ADAPTIVE_WARMUP << cache.kind)) {
+            return false;
+        }
+        cache.counter = 0;
+        return true;
+    }
+    
+    static void adaptive_backoff(compiler::InlineCache& cache) {
+        cache.counter = 0;
+        if (cache.kind < ADAPTIVE_MAX_BACKOFF) {
+            ++cache.kind;
+        }
+    }
+    
+    static void quicken(uint8_t* instr, compiler::Opcode specialized, compiler::InlineCache& cache) {
+        if (specialized == static_cast<compiler::Opcode>(instr[0])) {
+            adaptive_backoff(cache);  // Operand types not worth specializing
+            return;
+        }
+        instr[0] = static_cast<uint8_t>(specialized);
+    }
+    
+    static void deoptimize(uint8_t* instr, compiler::Opcode generic, compiler::InlineCache& cache) {
+        instr[0] = static_cast<uint8_t>(generic);
+        adaptive_backoff(cache);
+    }
+    
+    static compiler::Opcode specialize_binary_op(const Frame& frame, int op) {
+        using compiler::BinaryOpCode;
+        using compiler::Opcode;
+        
+        if (op >= static_cast<int>(BinaryOpCode::NB_INPLACE_ADD)) {
+            op -= static_cast<int>(BinaryOpCode::NB_INPLACE_ADD);
+        }
+        size_t n = frame.value_stack.size();
+        if (n < 2) return Opcode::BINARY_OP;
+        const PyObject& left = frame.value_stack[n - 2];
+        const PyObject& right = frame.value_stack[n - 1];
+        if (left.tag() != right.tag()) return Opcode::BINARY_OP;
+        
+        switch (static_cast<BinaryOpCode>(op)) {
+            case BinaryOpCode::NB_ADD:
+                if (is_int(left)) return Opcode::BINARY_OP_ADD_INT;
+                if (is_float(left)) return Opcode::BINARY_OP_ADD_FLOAT;
+                if (is_string(left)) return Opcode::BINARY_OP_ADD_UNICODE;
+                break;
+            case BinaryOpCode::NB_SUBTRACT:
+                if (is_int(left)) return Opcode::BINARY_OP_SUBTRACT_INT;
+                if (is_float(left)) return Opcode::BINARY_OP_SUBTRACT_FLOAT;
+                break;
+            case BinaryOpCode::NB_MULTIPLY:
+                if (is_int(left)) return Opcode::BINARY_OP_MULTIPLY_INT;
+                if (is_float(left)) return Opcode::BINARY_OP_MULTIPLY_FLOAT;
+                break;
+            default:
+                break;
+        }
+        return Opcode::BINARY_OP;
+    }
+    
+    static compiler::Opcode specialize_compare_op(const Frame& frame, int) {
+        using compiler::Opcode;
+        
+        size_t n = frame.value_stack.size();
+        if (n < 2) return Opcode::COMPARE_OP;
+        const PyObject& left = frame.value_stack[n - 2];
+        const PyObject& right = frame.value_stack[n - 1];
+        if (left.tag() != right.tag()) return Opcode::COMPARE_OP;
+        
+        switch (left.tag()) {
+            case PyTag::Int: return Opcode::COMPARE_OP_INT;
+            case PyTag::Float: return Opcode::COMPARE_OP_FLOAT;
+            case PyTag::Str: return Opcode::COMPARE_OP_STR;
+            default: return Opcode::COMPARE_OP;
+        }
+    }
+    
+    template<typename Op>
+    static bool binary_op_int(Frame& frame, Op op) {
+        auto& stack = frame.value_stack;
+        size_t n = stack.size();
+        if (n < 2 || !is_int(stack[n - 2]) || !is_int(stack[n - 1])) return false;
+        stack[n - 2] = PyObject(op(stack[n - 2].as_int(), stack[n - 1].as_int()));
+        stack.pop_back();
+        return true;
+    }
+    
+    template<typename Op>
+    static bool binary_op_float(Frame& frame, Op op) {
+        auto& stack = frame.value_stack;
+        size_t n = stack.size();
+        if (n < 2 || !is_float(stack[n - 2]) || !is_float(stack[n - 1])) return false;
+        stack[n - 2] = PyObject(op(stack[n - 2].as_float(), stack[n - 1].as_float()));
+        stack.pop_back();
+        return true;
+    }
+    
+    static bool binary_op_add_unicode(Frame& frame) {
+        auto& stack = frame.value_stack;
+        size_t n = stack.size();
+        if (n < 2 || !is_string(stack[n - 2]) || !is_string(stack[n - 1])) return false;
+        stack[n - 2] = PyObject(concat_strings(stack[n - 2].as_string(), stack[n - 1].as_string()));
+        stack.pop_back();
+        return true;
+    }
+    
+    /**
+     * `s += x` on a str nothing else refers to: append to it in place
+     * (CPython's unicode_concatenate). The variable the next instruction
+     * stores to must hold the left operand, which is then its only other
+     * reference; the variable is cleared so the append sees the sole
+     * reference, and the store puts the grown string back.
+     */
+    static bool inplace_add_unicode(Frame& frame, const uint8_t* next_instr) {
+        auto& stack = frame.value_stack;
+        size_t n = stack.size();
+        if (n < 2 || !is_string(stack[n - 2]) || !is_string(stack[n - 1])) return false;
+        PyObject& left = stack[n - 2];
+        PyStr* str = left.as<PyStr>();
+        if (str->interned || str->get_ref_count() != 2) return false;
+        
+        PyObject* target = nullptr;
+        auto store = static_cast<compiler::Opcode>(next_instr[0]);
+        size_t index = next_instr[1];
+        if (store == compiler::Opcode::STORE_FAST && index < frame.fastlocals.size()) {
+            target = &frame.fastlocals[index];
+        } else if (store == compiler::Opcode::STORE_NAME && frame.locals == frame.globals &&
+                   index < frame.code->co_names.size()) {
+            int64_t ix = frame.globals->index_of(frame.code->co_names[index]);
+            if (ix >= 0) target = &frame.globals->value_at(ix);
+        }
+        if (!target || !identical(*target, left)) return false;
+        
+        *target = PyObject();
+        str->append(stack[n - 1].as_string());
+        stack.pop_back();
+        return true;
+    }
+    
+    template<PyTag Tag>
+    static bool compare_op_typed(Frame& frame, int op) {
+        auto& stack = frame.value_stack;
+        size_t n = stack.size();
+        if (n < 2 || stack[n - 2].tag() != Tag || stack[n - 1].tag() != Tag) return false;
+        
+        const PyObject& l = stack[n - 2];
+        const PyObject& r = stack[n - 1];
+        bool result;
+        if constexpr (Tag == PyTag::Int) {
+            result = compare_values(op, l.as_int(), r.as_int());
+        } else if constexpr (Tag == PyTag::Float) {
+            result = compare_values(op, l.as_float(), r.as_float());
+        } else {
+            result = compare_values(op, l.as_string(), r.as_string());
+        }
+        stack.pop_back();
+        stack.back() = PyObject(result);
+        return true;
+    }
+    
+    static compiler::Opcode specialize_for_iter(const Frame& frame, int) {
+        using compiler::Opcode;
+        
+        if (frame.value_stack.empty()) return Opcode::FOR_ITER;
+        const PyObject& iter = frame.value_stack[frame.value_stack.size() - 1];
+        if (is_range_iterator(iter)) return Opcode::FOR_ITER_RANGE;
+        if (is_seq_iterator(iter)) {
+            switch (iter.as<PySeqIterator>()->kind) {
+                case PySeqIterator::Kind::List: return Opcode::FOR_ITER_LIST;
+                case PySeqIterator::Kind::Tuple: return Opcode::FOR_ITER_TUPLE;
+                default: break;
+            }
+        }
+        return Opcode::FOR_ITER;
+    }
+    
+    enum class IterStep : uint8_t { Next, Exhausted, Deopt };
+    
+    // FOR_ITER_LIST / FOR_ITER_TUPLE: index straight into the items
+    template<PySeqIterator::Kind Kind>
+    static IterStep for_iter_items(Frame& frame) {
+        if (frame.value_stack.empty()) return IterStep::Deopt;
+        PyObject& iter = frame.value_stack.back();
+        if (!is_seq_iterator(iter) || iter.as<PySeqIterator>()->kind != Kind) return IterStep::Deopt;
+        
+        auto& it = *iter.as<PySeqIterator>();
+        if (is_none(it.seq)) return IterStep::Exhausted;
+        const auto& items = Kind == PySeqIterator::Kind::List ? it.seq.as<PyList>()->items
+                                                               : it.seq.as<PyTuple>()->items;
+        if (it.index >= items.size()) {
+            it.seq = PyObject();
+            return IterStep::Exhausted;
+        }
+        frame.push(items[it.index++]);
+        return IterStep::Next;
+    }
+    
+    static IterStep for_iter_range(Frame& frame, int64_t& value) {
+        if (frame.value_stack.empty() || !is_range_iterator(frame.value_stack.back())) {
+            return IterStep::Deopt;
+        }
+        return frame.value_stack.back().as<PyRangeIterator>()->advance(value) ? IterStep::Next
+                                                                             : IterStep::Exhausted;
+    }
+    
+#if CPYTHON_CPP_JIT
+    // === Baseline JIT tier (jit.hpp) ===
+    
+    struct NativeRun {
+        bool returned = false;     // Otherwise the interpreter resumes at frame.ip
+        PyObject value;
+        std::exception_ptr error;  // Raised by the instruction ending at frame.ip
+    };
+    
+    /**
+     * Compile a hot code object. Generators and coroutines stay in the
+     * interpreter (native code cannot suspend), as does code the threaded
+     * engine rejects.
+     */
+    bool compile_jit(CodeState& state) {
+        using namespace compiler::CodeFlags;
+        constexpr uint32_t SUSPENDS = CO_GENERATOR | CO_COROUTINE | CO_ITERABLE_COROUTINE | CO_ASYNC_GENERATOR;
+        
+        state.warmth = 0;
+        if (state.jit_blocked) return false;
+        const compiler::CodeObject& code = *state.code;
+        if ((code.co_flags & SUSPENDS) || !is_threadable(code)) {
+            state.jit_blocked = true;
+            return false;
+        }
+        state.jit = BaselineCompiler::compile(code, state.bytecode.data(), state.consts,
+                                              Frame::nlocals_of(code), jit_helpers());
+        ++state.compiles;
+        if (!state.jit) {
+            state.jit_blocked = true;
+            return false;
+        }
+        ++jit_stats_.compiled;
+        return true;
+    }
+    
+    /**
+     * Run the frame's native code from offset until it returns, raises or
+     * hands the frame back to the interpreter; frame.ip is where it stopped
+     */
+    NativeRun run_native(Frame& frame, size_t offset) {
+        CodeState& state = *frame.state;
+        NativeRun run;
+        frame.ip = offset;
+        const void* target = state.jit->entry_point(offset);
+        if (!target) return run;
+        
+        JitFrame native{&frame.value_stack, frame.fastlocals.data(), this, &frame};
+        JitExit exit = state.jit->run(native, target);
+        frame.ip = native.exit_offset;
+        switch (exit) {
+            case JitExit::Return:
+                run.returned = true;
+                if (frame.stack_size() > 0) run.value = frame.pop();
+                break;
+            case JitExit::ReturnNone:
+                run.returned = true;
+                break;
+            case JitExit::Error:
+                run.error = std::exchange(jit_error_, nullptr);
+                break;
+            case JitExit::Deopt:
+                ++jit_stats_.deopts;
+                deoptimize_native(state, native.exit_offset);
+                break;
+            case JitExit::SideExit:
+                ++jit_stats_.side_exits;
+                break;
+        }
+        return run;
+    }
+    
+    // A guard failed at offset: the instruction goes back to its generic
+    // form and the code is compiled again once it is hot again
+    void deoptimize_native(CodeState& state, size_t offset) {
+        using compiler::Opcode;
+        
+        size_t at = offset;
+        while (state.bytecode[at] == static_cast<uint8_t>(Opcode::EXTENDED_ARG)) {
+            at += 2;
+        }
+        deoptimize(&state.bytecode[at], generic_opcode(static_cast<Opcode>(state.bytecode[at])), state.caches[at / 2]);
+        retired_jit_code_.push_back(std::move(state.jit));
+        if (state.compiles >= JIT_MAX_COMPILES) {
+            state.jit_blocked = true;
+        }
+    }
+    
+    static compiler::Opcode generic_opcode(compiler::Opcode op) {
+        using compiler::Opcode;
+        
+        switch (op) {
+            case Opcode::BINARY_OP_ADD_INT:
+            case Opcode::BINARY_OP_SUBTRACT_INT:
+            case Opcode::BINARY_OP_MULTIPLY_INT:
+            case Opcode::BINARY_OP_ADD_FLOAT:
+            case Opcode::BINARY_OP_SUBTRACT_FLOAT:
+            case Opcode::BINARY_OP_MULTIPLY_FLOAT:
+            case Opcode::BINARY_OP_ADD_UNICODE:
+                return Opcode::BINARY_OP;
+            case Opcode::COMPARE_OP_INT:
+            case Opcode::COMPARE_OP_FLOAT:
+            case Opcode::COMPARE_OP_STR:
+                return Opcode::COMPARE_OP;
+            case Opcode::FOR_ITER_LIST:
+            case Opcode::FOR_ITER_TUPLE:
+            case Opcode::FOR_ITER_RANGE:
+                return Opcode::FOR_ITER;
             default:
-                throw std::runtime_error("Unimplemented opcode: " + 
-                    std::string(compiler::opcode_name(opcode)) + 
-                    " (" + std::to_string(static_cast<int>(opcode)) + ")");
+                return op;
         }
     }
     
-    // === Opcode Implementations ===
+    // Helpers called from native code: the handlers above, with any
+    // exception parked in jit_error_ instead of unwinding through it
     
-    void op_load_const(Frame& frame, int arg) {
-        if (arg < 0 || arg >= static_cast<int>(frame.code->co_consts.size())) {
-            throw std::runtime_error("Invalid constant index: " + std::to_string(arg));
+    static const JitHelpers& jit_helpers() {
+        static const JitHelpers helpers{
+            &jit_generic, &jit_incref, &jit_release, &jit_load_fast, &jit_pop_truth,
+            &jit_compare_and_pop, &jit_for_iter, &jit_for_iter_items<PySeqIterator::Kind::List>,
+            &jit_for_iter_items<PySeqIterator::Kind::Tuple>, &jit_for_iter_range,
+            &jit_add_unicode, &jit_compare_str,
+        };
+        return helpers;
+    }
+    
+    template<typename Body>
+    static int jit_call(JitFrame* native, Body body) noexcept {
+        try {
+            return body(*native->vm, *native->frame);
+        } catch (...) {
+            native->vm->jit_error_ = std::current_exception();
+            return -1;
+        }
+    }
+    
+    static int jit_iter_result(IterStep step) {
+        switch (step) {
+            case IterStep::Next: return 1;
+            case IterStep::Exhausted: return 0;
+            default: return JIT_HELPER_DEOPT;
         }
+    }
+    
+    static int jit_generic(JitFrame* native, int opcode, int arg, int end_offset) noexcept {
+        return jit_call(native, [=](VirtualMachine& vm, Frame& frame) {
+            frame.ip = static_cast<size_t>(end_offset);  // current_cache() reads it
+            vm.dispatch_opcode(frame, static_cast<compiler::Opcode>(opcode), arg);
+            return 0;
+        });
+    }
+    
+    static void jit_incref(core::RefCounted* obj) noexcept { obj->incref(); }
+    static void jit_release(core::RefCounted* obj) noexcept { obj->release(); }
+    
+    static int jit_load_fast(JitFrame* native, int index) noexcept {
+        return jit_call(native, [=](VirtualMachine& vm, Frame& frame) {
+            vm.op_load_fast(frame, index);
+            return 0;
+        });
+    }
+    
+    static int jit_pop_truth(JitFrame* native) noexcept {
+        return jit_call(native, [](VirtualMachine&, Frame& frame) {
+            return to_bool(frame.pop()) ? 1 : 0;
+        });
+    }
+    
+    static int jit_compare_and_pop(JitFrame* native, int op) noexcept {
+        return jit_call(native, [=](VirtualMachine& vm, Frame& frame) {
+            return vm.op_compare_and_pop(frame, op) ? 1 : 0;
+        });
+    }
+    
+    static int jit_for_iter(JitFrame* native) noexcept {
+        return jit_call(native, [](VirtualMachine& vm, Frame& frame) {
+            return vm.op_for_iter(frame) ? 1 : 0;
+        });
+    }
+    
+    template<PySeqIterator::Kind Kind>
+    static int jit_for_iter_items(JitFrame* native) noexcept {
+        return jit_call(native, [](VirtualMachine&, Frame& frame) {
+            return jit_iter_result(for_iter_items<Kind>(frame));
+        });
+    }
+    
+    static int jit_for_iter_range(JitFrame* native, int local) noexcept {
+        return jit_call(native, [=](VirtualMachine&, Frame& frame) {
+            int64_t value = 0;
+            IterStep step = for_iter_range(frame, value);
+            if (step == IterStep::Next) {
+                if (local >= 0) {
+                    frame.fastlocals[local] = PyObject(value);
+                } else {
+                    frame.push(PyObject(value));
+                }
+            }
+            return jit_iter_result(step);
+        });
+    }
+    
+    static int jit_add_unicode(JitFrame* native, int arg, int end_offset) noexcept {
+        return jit_call(native, [=](VirtualMachine&, Frame& frame) {
+            if (arg == static_cast<int>(compiler::BinaryOpCode::NB_INPLACE_ADD) &&
+                inplace_add_unicode(frame, frame.bytecode + end_offset)) return 0;
+            return binary_op_add_unicode(frame) ? 0 : JIT_HELPER_DEOPT;
+        });
+    }
+    
+    static int jit_compare_str(JitFrame* native, int op) noexcept {
+        return jit_call(native, [=](VirtualMachine&, Frame& frame) {
+            return compare_op_typed<PyTag::Str>(frame, op) ? 0 : JIT_HELPER_DEOPT;
+        });
+    }
+#endif
+    
+    /**
+     * CONTAINS_OP: TOS1 in TOS (arg 1 inverts, for `not in`)
+     */
+    void op_contains_op(Frame& frame, int invert) {
+        PyObject container = frame.pop();
+        PyObject item = frame.pop();
         
-        const auto& constant = frame.code->co_consts[arg];
-        
-        // Convert PyConstant to PyObject
-        PyObject obj = std::visit([](const auto& val) -> PyObject {
-            using T = std::decay_t<decltype(val)>;
-            if constexpr (std::is_same_v<T, std::monostate>) {
-                return std::monostate{};
-            } else if constexpr (std::is_same_v<T, bool>) {
-                return val;
-            } else if constexpr (std::is_same_v<T, int64_t>) {
-                return val;
-            } else if constexpr (std::is_same_v<T, double>) {
-                return val;
-            } else if constexpr (std::is_same_v<T, std::string>) {
-                return val;
+        bool found = false;
+        if (is_set(container)) {
+            found = container.as<PySet>()->contains(item);
+        } else if (is_dict(container)) {
+            found = container.as<PyDict>()->contains_item(item);
+        } else if (is_list(container) || is_tuple(container)) {
+            const auto& items = is_list(container)
+                ? container.as<PyList>()->items
+                : container.as<PyTuple>()->items;
+            found = std::any_of(items.begin(), items.end(),
+                                [&item](const PyObject& x) { return py_equals(x, item); });
+        } else if (is_string(container)) {
+            if (!is_string(item)) {
+                throw std::runtime_error("TypeError: 'in <string>' requires string as left operand");
+            }
+            found = container.as_string().find(item.as_string()) != std::string::npos;
+        } else if (is_range(container)) {
+            // Arithmetic for ints; anything else compares against each element
+            const auto& range = *container.as<PyRange>();
+            if (is_int(item) || is_bool(item)) {
+                found = range.contains(to_int(item));
             } else {
-                return std::monostate{};
+                for (uint64_t i = 0; i < range.length && !found; ++i) {
+                    found = py_equals(PyObject(range.at(i)), item);
+                }
             }
-        }, constant);
+        } else {
+            throw std::runtime_error(std::string("TypeError: argument of type '") +
+                                     type_name(container) + "' is not iterable");
+        }
         
-        frame.push(obj);
+        frame.push(invert ? !found : found);
     }
     
-    void op_load_name(Frame& frame, int arg) {
-        if (arg < 0 || arg >= static_cast<int>(frame.code->co_names.size())) {
-            throw std::runtime_error("Invalid name index: " + std::to_string(arg));
-        }
-        
-        const std::string& name = frame.code->co_names[arg];
-        
-        // Try locals first, then globals, then builtins
-        if (frame.locals->contains(name)) {
-            frame.push(frame.locals->get(name));
-        } else if (frame.globals->contains(name)) {
-            frame.push(frame.globals->get(name));
-        } else if (builtins_->contains(name)) {
-            frame.push(builtins_->get(name));
-        } else {
-            throw std::runtime_error("NameError: name '" + name + "' is not defined");
+    /**
+     * IS_OP: identity test (arg 1 inverts, for `is not`)
+     */
+    void op_is_op(Frame& frame, int invert) {
+        PyObject right = frame.pop();
+        PyObject left = frame.pop();
+        // Immediate values have no identity of their own; comparing their
+        // payload bits matches CPython's cached singletons and small ints
+        bool same = identical(left, right);
+        frame.push(invert ? !same : same);
+    }
+    
+    /**
+     * MAKE_FUNCTION: wrap the code object on TOS in a function bound to
+     * the current globals
+     */
+    void op_make_function(Frame& frame) {
+        PyObject code = frame.pop();
+        if (!is_code(code)) {
+            throw std::runtime_error("MAKE_FUNCTION expects a code object");
         }
+        auto& co = code.as<PyCode>()->code;
+        frame.push(core::make_ref<PyFunction>(co, frame.globals, co->co_name));
     }
     
-    void op_store_name(Frame& frame, int arg) {
-        if (arg < 0 || arg >= static_cast<int>(frame.code->co_names.size())) {
-            throw std::runtime_error("Invalid name index: " + std::to_string(arg));
+    void op_call(Frame& frame, int argc) {
+        auto operands = frame.peek(static_cast<size_t>(argc) + 1);
+        PyObject callable = std::move(operands[0]);
+        PyObject result = call_object(callable, operands.subspan(1));
+        frame.drop(static_cast<size_t>(argc) + 1);
+        frame.push(std::move(result));
+    }
+    
+    /**
+     * Call callable with args, which it may move from
+     */
+    PyObject call_object(const PyObject& callable, std::span<PyObject> args) {
+        if (is_function(callable)) {
+            return call_function(*callable.as<PyFunction>(), args);
+        }
+        if (is_method(callable)) {
+            return call_method(*callable.as<PyMethod>(), args);
         }
         
-        const std::string& name = frame.code->co_names[arg];
-        PyObject value = frame.pop();
-        frame.locals->set(name, value);
+        // Built-ins are still dispatched by name
+        if (is_string(callable)) {
+            const std::string& func_name = callable.as_string();
+            if (func_name == "<builtin print>") {
+                // Call print with arguments
+                for (size_t i = 0; i < args.size(); ++i) {
+                    if (i > 0) *stdout_ << " ";
+                    *stdout_ << to_string(args[i]);
+                }
+                *stdout_ << "\n";
+                return PyObject();  // print returns None
+            }
+            if (func_name == "<builtin set>") {
+                if (args.size() > 1) {
+                    throw std::runtime_error("TypeError: set expected at most 1 argument, got " +
+                                             std::to_string(args.size()));
+                }
+                auto set = core::make_ref<PySet>();
+                if (!args.empty()) {
+                    set->update(args[0]);
+                }
+                return set;
+            }
+            if (func_name == "<builtin next>") {
+                return builtin_next(args);
+            }
+            if (func_name == "<builtin iter>") {
+                if (args.size() != 1) {
+                    throw std::runtime_error("TypeError: iter expected 1 argument, got " +
+                                             std::to_string(args.size()));
+                }
+                return get_iter(args[0]);
+            }
+            if (func_name == "<builtin range>") {
+                return builtin_range(args);
+            }
+            if (func_name == "<builtin len>") {
+                return builtin_len(args);
+            }
+            if (func_name == "<builtin sleep>") {
+                return builtin_sleep(args);
+            }
+        }
+        
+        throw std::runtime_error(std::string("TypeError: '") + type_name(callable) +
+                                 "' object is not callable");
     }
     
-    void op_load_fast(Frame& frame, int arg) {
-        if (arg < 0 || arg >= static_cast<int>(frame.code->co_varnames.size())) {
-            throw std::runtime_error("Invalid varname index: " + std::to_string(arg));
+    // Python frames nest as C++ run_frame() calls; this bounds both
+    struct CallDepthGuard {
+        int& depth;
+        explicit CallDepthGuard(int& d) : depth(d) {
+            if (depth >= RECURSION_LIMIT) {
+                throw std::runtime_error("RecursionError: maximum recursion depth exceeded");
+            }
+            ++depth;
         }
+        ~CallDepthGuard() { --depth; }
+    };
+    
+    /**
+     * Call a PyFunction (CPython's _PyEvalFramePushAndInit). The callee
+     * frame is pushed on data_stack_ and the arguments are moved
+     * straight into its fast locals, so the call itself allocates
+     * nothing. Generator and coroutine functions only build their
+     * generator object.
+     */
+    PyObject call_function(PyFunction& func, std::span<PyObject> args) {
+        const auto& code = func.code;
         
-        const std::string& name = frame.code->co_varnames[arg];
+        if (code->co_flags & compiler::CodeFlags::CO_ASYNC_GENERATOR) {
+            throw std::runtime_error("Calling async generator functions is not supported yet");
+        }
+        if (code->co_kwonlyargcount > 0 ||
+            (code->co_flags & (compiler::CodeFlags::CO_VARARGS | compiler::CodeFlags::CO_VARKEYWORDS))) {
+            throw std::runtime_error("Calling " + func.name + "() with *args, **kwargs or "
+                                     "keyword-only parameters is not supported yet");
+        }
+        int argc = static_cast<int>(args.size());
+        if (argc != code->co_argcount) {
+            throw std::runtime_error("TypeError: " + func.name + "() takes " +
+                                     std::to_string(code->co_argcount) + " positional argument" +
+                                     (code->co_argcount == 1 ? "" : "s") + " but " +
+                                     std::to_string(argc) + (argc == 1 ? " was" : " were") + " given");
+        }
+        if (code->co_flags & (compiler::CodeFlags::CO_GENERATOR | compiler::CodeFlags::CO_COROUTINE)) {
+            return make_generator(func, args);
+        }
         
-        if (frame.locals->contains(name)) {
-            frame.push(frame.locals->get(name));
-        } else {
-            throw std::runtime_error("UnboundLocalError: local variable '" + name + "' referenced before assignment");
+        CallDepthGuard guard(call_depth_);
+        Frame frame(data_stack_, code_state_for(code), func.globals);
+        std::move(args.begin(), args.end(), frame.fastlocals.begin());
+        return run_frame(frame);
+    }
+    
+    // RETURN_GENERATOR: the arguments become the generator's first locals
+    PyObject make_generator(PyFunction& func, std::span<PyObject> args) {
+        size_t nlocals = Frame::nlocals_of(*func.code);
+        auto init = [&](PyGenerator& gen) {
+            std::move(args.begin(), args.end(), gen.slots.get());
+        };
+        if (func.code->co_flags & compiler::CodeFlags::CO_COROUTINE) {
+            auto coro = core::make_ref<PyCoroutine>(func.code, func.globals, func.name, nlocals);
+            init(*coro);
+            return coro;
         }
+        auto gen = core::make_ref<PyGenerator>(func.code, func.globals, func.name, nlocals);
+        init(*gen);
+        return gen;
     }
     
-    void op_store_fast(Frame& frame, int arg) {
-        if (arg < 0 || arg >= static_cast<int>(frame.code->co_varnames.size())) {
-            throw std::runtime_error("Invalid varname index: " + std::to_string(arg));
+    /**
+     * Built-in methods: send() and close() of generators and coroutines
+     */
+    PyObject call_method(PyMethod& method, std::span<PyObject> args) {
+        auto& gen = *method.self.as<PyGenerator>();
+        if (method.name == "send") {
+            if (args.size() != 1) {
+                throw std::runtime_error("TypeError: send() takes exactly one argument (" +
+                                         std::to_string(args.size()) + " given)");
+            }
+            bool returned = false;
+            PyObject value = resume(gen, std::move(args[0]), returned);
+            if (returned) {
+                throw std::runtime_error("StopIteration");
+            }
+            return value;
         }
-        
-        const std::string& name = frame.code->co_varnames[arg];
-        PyObject value = frame.pop();
-        frame.locals->set(name, value);
+        if (method.name == "close") {
+            if (!args.empty()) {
+                throw std::runtime_error("TypeError: close() takes no arguments (" +
+                                         std::to_string(args.size()) + " given)");
+            }
+            if (gen.state == PyGenerator::State::Running) {
+                throw std::runtime_error("ValueError: generator already executing");
+            }
+            // No exceptions to throw GeneratorExit with; the frame is just dropped
+            gen.finish();
+            return PyObject();
+        }
+        throw std::runtime_error("AttributeError: '" + std::string(type_name(method.self)) +
+                                 "' object has no attribute '" + method.name + "'");
     }
     
-    void op_load_global(Frame& frame, int arg) {
-        if (arg < 0 || arg >= static_cast<int>(frame.code->co_names.size())) {
-            throw std::runtime_error("Invalid name index: " + std::to_string(arg));
+    // next(iterator[, default])
+    PyObject builtin_next(std::span<PyObject> args) {
+        if (args.empty() || args.size() > 2) {
+            throw std::runtime_error("TypeError: next expected 1 or 2 arguments, got " +
+                                     std::to_string(args.size()));
         }
-        
-        const std::string& name = frame.code->co_names[arg];
-        
-        // Try globals first, then builtins
-        if (frame.globals->contains(name)) {
-            frame.push(frame.globals->get(name));
-        } else if (builtins_->contains(name)) {
-            frame.push(builtins_->get(name));
-        } else {
-            throw std::runtime_error("NameError: name '" + name + "' is not defined");
+        PyObject value;
+        if (iter_next(args[0], value)) {
+            return value;
+        }
+        if (args.size() == 2) {
+            return std::move(args[1]);
+        }
+        throw std::runtime_error("StopIteration");
+    }
+    
+    // sleep(delay=0): a coroutine that hands the delay to the event loop once
+    PyObject builtin_sleep(std::span<PyObject> args) {
+        if (args.size() > 1) {
+            throw std::runtime_error("TypeError: sleep expected at most 1 argument, got " +
+                                     std::to_string(args.size()));
         }
+        PyObject delay = args.empty() ? PyObject(static_cast<int64_t>(0)) : std::move(args[0]);
+        if (!is_int(delay) && !is_float(delay)) {
+            throw std::runtime_error(std::string("TypeError: sleep() delay must be a number, not '") +
+                                     type_name(delay) + "'");
+        }
+        if ((is_int(delay) ? static_cast<double>(delay.as_int()) : delay.as_float()) < 0) {
+            throw std::runtime_error("ValueError: sleep length must be non-negative");
+        }
+        if (!sleep_code_) {
+            sleep_code_ = make_sleep_code();
+        }
+        auto coro = core::make_ref<PyCoroutine>(sleep_code_, globals_, "sleep", 1);
+        coro->slots[0] = std::move(delay);
+        return coro;
+    }
+    
+    // async def sleep(delay): (yield delay) -- hand-assembled, as it has no source
+    static std::shared_ptr<compiler::CodeObject> make_sleep_code() {
+        using compiler::Opcode;
+        auto code = std::make_shared<compiler::CodeObject>("sleep", "<builtins>", 0);
+        code->co_flags = compiler::CodeFlags::CO_OPTIMIZED | compiler::CodeFlags::CO_NEWLOCALS |
+                         compiler::CodeFlags::CO_COROUTINE;
+        code->co_argcount = 1;
+        code->co_nlocals = 1;
+        code->add_varname("delay");
+        code->add_const(std::monostate{});
+        code->emit(Opcode::LOAD_FAST, 0);
+        code->emit(Opcode::YIELD_VALUE);
+        code->emit(Opcode::RESUME, 3);
+        code->emit(Opcode::POP_TOP);
+        code->emit(Opcode::LOAD_CONST, 0);
+        code->emit(Opcode::RETURN_VALUE);
+        code->calculate_stacksize();
+        code->assemble();
+        return code;
     }
     
-    void op_store_global(Frame& frame, int arg) {
+    /**
+     * LOAD_ATTR: only the built-in methods of generators and coroutines so far
+     */
+    void op_load_attr(Frame& frame, int arg) {
         if (arg < 0 || arg >= static_cast<int>(frame.code->co_names.size())) {
             throw std::runtime_error("Invalid name index: " + std::to_string(arg));
         }
-        
         const std::string& name = frame.code->co_names[arg];
-        PyObject value = frame.pop();
-        frame.globals->set(name, value);
+        PyObject owner = frame.pop();
+        if ((is_generator(owner) || is_coroutine(owner)) && (name == "send" || name == "close")) {
+            frame.push(core::make_ref<PyMethod>(std::move(owner), name));
+            return;
+        }
+        throw std::runtime_error("AttributeError: '" + std::string(type_name(owner)) +
+                                 "' object has no attribute '" + name + "'");
     }
     
-    void op_binary_op(Frame& frame, int op) {
-        PyObject right = frame.pop();
-        PyObject left = frame.pop();
-        
-        PyObject result;
-        
-        // Handle int operations
-        if (is_int(left) && is_int(right)) {
-            int64_t l = std::get<int64_t>(left);
-            int64_t r = std::get<int64_t>(right);
-            
-            switch (op) {
-                case 0: result = l + r; break;  // ADD
-                case 1: result = l & r; break;  // AND
-                case 2: result = l / r; break;  // FLOOR_DIV
-                case 3: result = l << r; break; // LSHIFT
-                case 4: result = l % r; break;  // MODULO
-                case 5: result = l * r; break;  // MULTIPLY
-                case 6: result = l | r; break;  // OR
-                case 7: result = static_cast<int64_t>(std::pow(l, r)); break;  // POWER
-                case 8: result = l >> r; break; // RSHIFT
-                case 9: result = l - r; break;  // SUBTRACT
-                case 10: result = l / r; break; // TRUE_DIV (simplified)
-                case 11: result = l ^ r; break; // XOR
-                default:
-                    throw std::runtime_error("Unknown binary operation: " + std::to_string(op));
-            }
+    /**
+     * iter(): built-in containers get a position-keeping iterator, a range
+     * its counting iterator; iterators (generators included) are returned
+     * as they are
+     */
+    static PyObject get_iter(const PyObject& iterable) {
+        using Kind = PySeqIterator::Kind;
+        switch (iterable.tag()) {
+            case PyTag::List: return core::make_ref<PySeqIterator>(iterable, Kind::List);
+            case PyTag::Tuple: return core::make_ref<PySeqIterator>(iterable, Kind::Tuple);
+            case PyTag::Str: return core::make_ref<PySeqIterator>(iterable, Kind::Str);
+            case PyTag::Dict: return core::make_ref<PySeqIterator>(iterable, Kind::Dict);
+            case PyTag::Set: return core::make_ref<PySeqIterator>(iterable, Kind::Set);
+            case PyTag::Range: return core::make_ref<PyRangeIterator>(*iterable.as<PyRange>());
+            case PyTag::RangeIterator:
+            case PyTag::SeqIterator:
+            case PyTag::Generator:
+                return iterable;
+            default:
+                throw std::runtime_error(std::string("TypeError: '") + type_name(iterable) +
+                                         "' object is not iterable");
         }
-        // Handle float operations
-        else if ((is_int(left) || is_float(left)) && (is_int(right) || is_float(right))) {
-            double l = to_float(left);
-            double r = to_float(right);
-            
-            switch (op) {
-                case 0: result = l + r; break;  // ADD
-                case 5: result = l * r; break;  // MULTIPLY
-                case 7: result = std::pow(l, r); break;  // POWER
-                case 9: result = l - r; break;  // SUBTRACT
-                case 10: result = l / r; break; // TRUE_DIV
-                default:
-                    throw std::runtime_error("Unsupported float operation: " + std::to_string(op));
+    }
+    
+    /**
+     * next() on any iterator: store the next value in out; false once it
+     * is exhausted
+     */
+    bool iter_next(const PyObject& iter, PyObject& out) {
+        switch (iter.tag()) {
+            case PyTag::RangeIterator: {
+                int64_t value = 0;
+                if (!iter.as<PyRangeIterator>()->advance(value)) return false;
+                out = PyObject(value);
+                return true;
             }
-        }
-        // Handle string operations
-        else if (is_string(left) && is_string(right)) {
-            std::string l = std::get<std::string>(left);
-            std::string r = std::get<std::string>(right);
-            
-            switch (op) {
-                case 0: result = l + r; break;  // ADD (concatenation)
-                default:
-                    throw std::runtime_error("Unsupported string operation: " + std::to_string(op));
+            case PyTag::SeqIterator:
+                return iter.as<PySeqIterator>()->advance(out);
+            case PyTag::Generator: {
+                bool returned = false;
+                out = resume(*iter.as<PyGenerator>(), PyObject(), returned);
+                return !returned;
             }
+            default:
+                throw std::runtime_error(std::string("TypeError: '") + type_name(iter) +
+                                         "' object is not an iterator");
         }
-        else {
-            throw std::runtime_error("Unsupported operand types for binary operation");
-        }
-        
-        frame.push(result);
     }
     
-    void op_unary_not(Frame& frame) {
-        PyObject value = frame.pop();
-        frame.push(!to_bool(value));
+    void op_get_iter(Frame& frame) {
+        PyObject& iterable = frame.top();
+        iterable = get_iter(iterable);
     }
     
-    void op_unary_negative(Frame& frame) {
-        PyObject value = frame.pop();
-        if (is_int(value)) {
-            frame.push(-std::get<int64_t>(value));
-        } else if (is_float(value)) {
-            frame.push(-std::get<double>(value));
-        } else {
-            throw std::runtime_error("Unsupported operand type for unary -");
+    /**
+     * FOR_ITER: push the next value of the iterator on TOS; false once
+     * it is exhausted
+     */
+    bool op_for_iter(Frame& frame) {
+        PyObject value;
+        if (!iter_next(frame.top(), value)) {
+            return false;
         }
+        frame.push(std::move(value));
+        return true;
     }
     
-    void op_unary_positive(Frame& frame) {
-        PyObject value = frame.pop();
-        if (is_int(value) || is_float(value)) {
-            frame.push(value);  // No-op for numbers
-        } else {
-            throw std::runtime_error("Unsupported operand type for unary +");
+    /**
+     * GET_YIELD_FROM_ITER: like GET_ITER, but coroutines may be delegated
+     * to from coroutine code
+     */
+    void op_get_yield_from_iter(Frame& frame) {
+        if (is_coroutine(frame.top())) {
+            if (!(frame.code->co_flags & (compiler::CodeFlags::CO_COROUTINE |
+                                          compiler::CodeFlags::CO_ITERABLE_COROUTINE))) {
+                throw std::runtime_error("TypeError: cannot 'yield from' a coroutine object "
+                                         "in a non-coroutine generator");
+            }
+            return;
         }
+        op_get_iter(frame);
     }
     
-    void op_unary_invert(Frame& frame) {
-        PyObject value = frame.pop();
-        if (is_int(value)) {
-            frame.push(~std::get<int64_t>(value));
-        } else {
-            throw std::runtime_error("Unsupported operand type for unary ~");
+    void op_get_awaitable(Frame& frame) {
+        const PyObject& awaitable = frame.top();
+        if (!is_coroutine(awaitable)) {
+            throw std::runtime_error(std::string("TypeError: '") + type_name(awaitable) +
+                                     "' object can't be awaited");
         }
     }
     
-    void op_compare_op(Frame& frame, int op) {
-        PyObject right = frame.pop();
-        PyObject left = frame.pop();
-        
-        bool result = false;
-        
-        // Handle int comparisons
-        if (is_int(left) && is_int(right)) {
-            int64_t l = std::get<int64_t>(left);
-            int64_t r = std::get<int64_t>(right);
-            
-            switch (op) {
-                case 0: result = (l < r); break;   // <
-                case 1: result = (l <= r); break;  // <=
-                case 2: result = (l == r); break;  // ==
-                case 3: result = (l != r); break;  // !=
-                case 4: result = (l > r); break;   // >
-                case 5: result = (l >= r); break;  // >=
-                default:
-                    throw std::runtime_error("Unknown comparison operation: " + std::to_string(op));
-            }
-        }
-        // Handle float comparisons
-        else if ((is_int(left) || is_float(left)) && (is_int(right) || is_float(right))) {
-            double l = to_float(left);
-            double r = to_float(right);
-            
-            switch (op) {
-                case 0: result = (l < r); break;   // <
-                case 1: result = (l <= r); break;  // <=
-                case 2: result = (l == r); break;  // ==
-                case 3: result = (l != r); break;  // !=
-                case 4: result = (l > r); break;   // >
-                case 5: result = (l >= r); break;  // >=
-                default:
-                    throw std::runtime_error("Unknown comparison operation: " + std::to_string(op));
-            }
-        }
-        // Handle string comparisons
-        else if (is_string(left) && is_string(right)) {
-            std::string l = std::get<std::string>(left);
-            std::string r = std::get<std::string>(right);
-            
-            switch (op) {
-                case 0: result = (l < r); break;   // <
-                case 1: result = (l <= r); break;  // <=
-                case 2: result = (l == r); break;  // ==
-                case 3: result = (l != r); break;  // !=
-                case 4: result = (l > r); break;   // >
-                case 5: result = (l >= r); break;  // >=
-                default:
-                    throw std::runtime_error("Unknown comparison operation: " + std::to_string(op));
+    /**
+     * SEND: resume the receiver under TOS with TOS. What it yields or
+     * returns replaces TOS; true means it returned (take the jump)
+     */
+    bool op_send(Frame& frame) {
+        auto operands = frame.peek(2);
+        const PyObject& receiver = operands[0];
+        if (is_range_iterator(receiver) || is_seq_iterator(receiver)) {
+            // `yield from` a container: plain iteration, which cannot take a value
+            if (!is_none(operands[1])) {
+                throw std::runtime_error(std::string("AttributeError: '") + type_name(receiver) +
+                                         "' object has no attribute 'send'");
             }
+            PyObject value;
+            bool returned = !iter_next(receiver, value);
+            operands[1] = std::move(value);
+            return returned;
         }
-        else {
-            throw std::runtime_error("Unsupported operand types for comparison");
+        if (!is_generator(receiver) && !is_coroutine(receiver)) {
+            throw std::runtime_error(std::string("TypeError: '") + type_name(receiver) +
+                                     "' object is not an iterator");
         }
-        
-        frame.push(result);
+        bool returned = false;
+        operands[1] = resume(*receiver.as<PyGenerator>(), std::move(operands[1]), returned);
+        return returned;
     }
     
-    void op_call(Frame& frame, int argc) {
-        // Pop arguments
-        std::vector<PyObject> args;
-        for (int i = 0; i < argc; ++i) {
-            args.insert(args.begin(), frame.pop());
+    // END_SEND: drop the receiver under the result
+    void op_end_send(Frame& frame) {
+        auto operands = frame.peek(2);
+        operands[0] = std::move(operands[1]);
+        frame.drop(1);
+    }
+    
+    void op_build_list(Frame& frame, int count) {
+        frame.push(core::make_ref<PyList>(frame.pop_n(static_cast<size_t>(count))));
+    }
+    
+    // === Comprehensions ===
+    
+    // The list, set or dict being built sits depth slots down once the
+    // operands are popped, below the iterators of the enclosing loops
+    PyObject& comprehension_target(Frame& frame, int depth, size_t operands) {
+        auto slots = frame.peek(static_cast<size_t>(depth) + operands);
+        return slots[0];
+    }
+    
+    void op_list_append(Frame& frame, int depth) {
+        PyObject& list = comprehension_target(frame, depth, 1);
+        if (!is_list(list)) {
+            throw std::runtime_error("LIST_APPEND expects a list");
         }
-        
-        // Pop callable
-        PyObject callable = frame.pop();
-        
-        // For now, only handle built-in print function
-        // Full function call support will be added in Phase 3
-        if (is_string(callable)) {
-            std::string func_name = std::get<std::string>(callable);
-            if (func_name == "<builtin print>") {
-                // Call print with arguments
-                for (size_t i = 0; i < args.size(); ++i) {
-                    if (i > 0) std::cout << " ";
-                    print_object(args[i]);
-                }
-                std::cout << "\n";
-                frame.push(std::monostate{});  // print returns None
-                return;
-            }
+        list.as<PyList>()->items.push_back(frame.pop());
+    }
+    
+    void op_set_add(Frame& frame, int depth) {
+        PyObject& set = comprehension_target(frame, depth, 1);
+        if (!is_set(set)) {
+            throw std::runtime_error("SET_ADD expects a set");
         }
-        
-        throw std::runtime_error("Unsupported callable type");
+        set.as<PySet>()->add(frame.top());
+        frame.drop(1);
     }
     
-    void op_build_list(Frame& frame, int count) {
-        auto list = std::make_shared<PyList>();
-        for (int i = 0; i < count; ++i) {
-            list->items.insert(list->items.begin(), frame.pop());
+    void op_map_add(Frame& frame, int depth) {
+        PyObject& dict = comprehension_target(frame, depth, 2);
+        if (!is_dict(dict)) {
+            throw std::runtime_error("MAP_ADD expects a dict");
         }
-        frame.push(list);
+        auto operands = frame.peek(2);
+        dict.as<PyDict>()->set_item(operands[0], std::move(operands[1]));
+        frame.drop(2);
     }
     
     void op_build_tuple(Frame& frame, int count) {
-        std::vector<PyObject> items;
-        for (int i = 0; i < count; ++i) {
-            items.insert(items.begin(), frame.pop());
+        frame.push(core::make_ref<PyTuple>(frame.pop_n(static_cast<size_t>(count))));
+    }
+    
+    // === F-strings ===
+    
+    // The pieces are already str (FORMAT_* ran on each)
+    void op_build_string(Frame& frame, int count) {
+        auto pieces = frame.peek(static_cast<size_t>(count));
+        PyObject result = count == 0 ? PyObject(std::string()) : StringBuilder::join(pieces);
+        frame.drop(pieces.size());
+        frame.push(std::move(result));
+    }
+    
+    void op_format_simple(Frame& frame) {
+        PyObject& value = frame.top();
+        if (!is_string(value)) {
+            value = PyObject(to_string(value));
+        }
+    }
+    
+    void op_format_with_spec(Frame& frame) {
+        // TOS = spec, TOS1 = value
+        PyObject spec = frame.pop();
+        if (!is_string(spec)) {
+            throw std::runtime_error("TypeError: format spec must be a str");
         }
-        frame.push(std::make_shared<PyTuple>(items));
+        PyObject& value = frame.top();
+        value = format_value(value, spec.as_string());
+    }
+    
+    void op_convert_value(Frame& frame, int conversion) {
+        PyObject& value = frame.top();
+        value = convert_value(value, conversion);
     }
     
     void op_binary_slice(Frame& frame) {
@@ -647,19 +2793,19 @@ private:
         
         // For Phase 1, implement basic list/string slicing
         if (is_list(container)) {
-            auto list = std::get<std::shared_ptr<PyList>>(container);
-            int start_idx = is_int(start) ? std::get<int64_t>(start) : 0;
-            int end_idx = is_int(end) ? std::get<int64_t>(end) : list->items.size();
+            auto list = container.as<PyList>();
+            int start_idx = is_int(start) ? start.as_int() : 0;
+            int end_idx = is_int(end) ? end.as_int() : list->items.size();
             
-            auto result = std::make_shared<PyList>();
+            auto result = core::make_ref<PyList>();
             for (int i = start_idx; i < end_idx && i < static_cast<int>(list->items.size()); ++i) {
                 result->items.push_back(list->items[i]);
             }
-            frame.push(result);
+            frame.push(std::move(result));
         } else if (is_string(container)) {
-            std::string str = std::get<std::string>(container);
-            int start_idx = is_int(start) ? std::get<int64_t>(start) : 0;
-            int end_idx = is_int(end) ? std::get<int64_t>(end) : str.size();
+            std::string str = container.as_string();
+            int start_idx = is_int(start) ? start.as_int() : 0;
+            int end_idx = is_int(end) ? end.as_int() : str.size();
             
             frame.push(str.substr(start_idx, end_idx - start_idx));
         } else {
@@ -674,7 +2820,7 @@ private:
         PyObject cm = frame.pop();
         
         // Push __exit__ (simplified - just push None)
-        frame.push(std::monostate{});
+        frame.push(PyObject());
         
         // Push result of __enter__() (simplified - just push the CM itself)
         frame.push(cm);
@@ -687,24 +2833,27 @@ private:
     }
     
     void op_build_map(Frame& frame, int count) {
-        auto dict = std::make_shared<PyDict>();
-        for (int i = 0; i < count; ++i) {
-            PyObject value = frame.pop();
-            PyObject key = frame.pop();
-            if (!is_string(key)) {
-                throw std::runtime_error("Dictionary keys must be strings");
-            }
-            dict->set(std::get<std::string>(key), value);
+        // Insert in source order so later duplicate keys win, as in CPython
+        auto pairs = frame.peek(static_cast<size_t>(count) * 2);
+        auto dict = core::make_ref<PyDict>();
+        dict->reserve(count);
+        for (size_t i = 0; i < pairs.size(); i += 2) {
+            dict->set_item(pairs[i], std::move(pairs[i + 1]));
         }
-        frame.push(dict);
+        frame.drop(pairs.size());
+        frame.push(std::move(dict));
     }
     
     void op_build_set(Frame& frame, int count) {
-        auto set = std::make_shared<PySet>();
-        for (int i = 0; i < count; ++i) {
-            set->add(frame.pop());
+        // Add in source order so the first of equal elements is kept
+        auto items = frame.peek(static_cast<size_t>(count));
+        auto set = core::make_ref<PySet>();
+        set->reserve(count);
+        for (auto& item : items) {
+            set->add(item);
         }
-        frame.push(set);
+        frame.drop(items.size());
+        frame.push(std::move(set));
     }
 };
 
@@ -1,9 +1,11 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 #include "src/parser/tokenizer.hpp"
 #include "src/parser/parser.hpp"
 #include "src/compiler/bytecode_compiler.hpp"
+#include "src/compiler/code_cache.hpp"
 
 using namespace cpython_cpp;
 
@@ -37,6 +39,146 @@ void test_compile(const std::string& code, const std::string& name) {
     std::cout << "\n";
 }
 
+// Write the compiled module to a cache file and check it loads back identically
+void test_cache_roundtrip(const std::string& code, const std::string& name) {
+    std::cout << "=== Test: " << name << " ===\n";
+
+    parser::Parser parser_obj(code);
+    auto module = parser_obj.parse();
+    compiler::BytecodeCompiler compiler;
+    auto code_obj = compiler.compile(*module, "<test>");
+
+    std::string path = "test_code_cache.pyc";
+    compiler::SourceKey key{0, code.size(), compiler::hash_source(code)};
+    if (!compiler::write_code_cache(path, *code_obj, key)) {
+        std::cout << "\u2717 FAIL: could not write cache\n\n";
+        return;
+    }
+    compiler::CodeCacheFile file;
+    bool same = file.open(path) && file.header().source.hash == key.hash;
+    if (same) {
+        // Read the module record in place before anything is decoded
+        auto record = file.record();
+        same = record.name() == code_obj->co_name &&
+               record.instruction_count() == code_obj->instructions.size() &&
+               record.const_count() == code_obj->co_consts.size() &&
+               record.names().size() == code_obj->co_names.size();
+        for (size_t i = 0; same && i < record.names().size(); ++i) {
+            same = record.names()[i] == code_obj->co_names[i];
+        }
+        for (size_t i = 0; same && i < record.const_count(); ++i) {
+            auto nested = record.nested(i);
+            auto* original = std::get_if<std::shared_ptr<compiler::CodeObject>>(&code_obj->co_consts[i]);
+            if (nested && original) {
+                same = nested->name() == (*original)->co_name;
+            } else {
+                same = !nested && !original &&
+                       compiler::constant_to_string(record.constant(i)) ==
+                       compiler::constant_to_string(code_obj->co_consts[i]);
+            }
+        }
+    }
+    if (same) {
+        auto loaded = file.load();
+        same = loaded->disassemble() == code_obj->disassemble() &&
+               loaded->co_code == code_obj->co_code &&
+               loaded->co_consts.size() == code_obj->co_consts.size();
+        for (size_t i = 0; same && i < loaded->co_consts.size(); ++i) {
+            same = compiler::constant_to_string(loaded->co_consts[i]) ==
+                   compiler::constant_to_string(code_obj->co_consts[i]) &&
+                   loaded->find_const(loaded->co_consts[i]) == static_cast<int>(i);
+            auto* nested = std::get_if<std::shared_ptr<compiler::CodeObject>>(&loaded->co_consts[i]);
+            auto* original = std::get_if<std::shared_ptr<compiler::CodeObject>>(&code_obj->co_consts[i]);
+            if (same && nested && original) {
+                same = (*nested)->disassemble() == (*original)->disassemble();
+            }
+        }
+    }
+    std::remove(path.c_str());
+    std::cout << (same ? "\u2713 PASS: cache round trip is identical\n\n"
+                       : "\u2717 FAIL: cache round trip differs\n\n");
+}
+
+// Apply edits one at a time and check each incremental re-parse against a full parse
+void test_reparse(const std::string& code, const std::vector<parser::TextEdit>& edits,
+                  const std::string& name) {
+    std::cout << "=== Test: " << name << " ===\n";
+
+    auto tree = parser::Parser(code).parse_tree();
+    for (const auto& edit : edits) {
+        std::vector<ast::Stmt*> before;
+        for (const auto& span : tree.statements) before.push_back(span.stmt);
+
+        tree = parser::Parser::reparse(std::move(tree), edit);
+        auto full = parser::Parser(tree.source).parse();
+
+        compiler::BytecodeCompiler incremental_compiler;
+        compiler::BytecodeCompiler full_compiler;
+        bool same = tree.module->to_string() == full->to_string() &&
+                    incremental_compiler.compile(*tree.module, "<test>")->disassemble() ==
+                    full_compiler.compile(*full, "<test>")->disassemble();
+        for (size_t i = 0; same && i < tree.module->body().size(); ++i) {
+            same = tree.module->body()[i]->lineno() == full->body()[i]->lineno() &&
+                   tree.module->body()[i]->col_offset() == full->body()[i]->col_offset();
+        }
+        size_t reused = 0;
+        for (const auto& span : tree.statements) {
+            reused += std::find(before.begin(), before.end(), span.stmt) != before.end();
+        }
+        std::cout << (same ? "\u2713 PASS" : "\u2717 FAIL") << ": edit at " << edit.offset
+                  << " reused " << reused << " of " << tree.statements.size() << " statements\n";
+    }
+    std::cout << "\n";
+}
+
+// Check that each named code object (searched through nested constants) disassembles with a fragment
+void test_disassembly_contains(const std::string& code,
+                               const std::vector<std::pair<std::string, std::string>>& expected,
+                               const std::string& name) {
+    std::cout << "=== Test: " << name << " ===\n";
+
+    parser::Parser parser_obj(code);
+    auto module = parser_obj.parse();
+    compiler::BytecodeCompiler compiler;
+    std::vector<std::shared_ptr<compiler::CodeObject>> codes{compiler.compile(*module, "<test>")};
+    for (size_t i = 0; i < codes.size(); ++i) {
+        for (const auto& c : codes[i]->co_consts) {
+            if (auto* nested = std::get_if<std::shared_ptr<compiler::CodeObject>>(&c)) {
+                codes.push_back(*nested);
+            }
+        }
+    }
+    for (const auto& [code_name, fragment] : expected) {
+        bool found = std::any_of(codes.begin(), codes.end(), [&](const auto& c) {
+            return c->co_name == code_name && c->disassemble().find(fragment) != std::string::npos;
+        });
+        std::cout << (found ? "\u2713 PASS: " : "\u2717 FAIL: ") << code_name << " has " << fragment << "\n";
+    }
+    std::cout << "\n";
+}
+
+// Check the compact line table against the line of every instruction
+void test_line_table(const std::string& code, const std::string& name) {
+    std::cout << "=== Test: " << name << " ===\n";
+
+    parser::Parser parser_obj(code);
+    auto module = parser_obj.parse();
+    compiler::BytecodeCompiler compiler;
+    auto code_obj = compiler.compile(*module, "<test>");
+
+    bool same = true;
+    int line = 0;
+    for (const auto& instr : code_obj->instructions) {
+        if (instr.lineno > 0) line = instr.lineno;
+        same = same && code_obj->line_for_offset(instr.offset) == line;
+    }
+    for (size_t i = 1; i < code_obj->co_linetable.size(); ++i) {
+        same = same && code_obj->co_linetable[i].second != code_obj->co_linetable[i - 1].second;
+    }
+    std::cout << (same ? "\u2713 PASS" : "\u2717 FAIL") << ": " << code_obj->co_linetable.size()
+              << " line entries for " << code_obj->instructions.size() << " instructions\n\n";
+}
+
 int main() {
     // Test 1: Simple assignment
     test_compile(R"(
@@ -276,6 +418,90 @@ type Mapping[K, V] = dict[K, V]
 type Number = int | float
 )", "Type Alias with Union");
 
+    // Test 39: Peephole optimizer (folding, dead code, superinstructions)
+    test_compile(R"(
+x = -(2 * 3) + 1
+while x < 10:
+    x = x + 2 ** 3
+)", "Peephole Optimizer");
+
+    // Test 40: Bytecode cache round trip with nested code objects
+    test_cache_roundtrip(R"(
+def scale(xs, k):
+    return [x * k for x in xs]
+name = 'cache'
+data = b'\x00ab'
+print(scale([1, 2, 3], 2.5), name, data, None, True)
+)", "Code Cache Round Trip");
+
+    // Test 41: Incremental re-parse reuses statements the edit cannot reach
+    test_reparse(R"(a = 1
+def f(x):
+    return x + a
+def g():
+    return f(2)
+print(g())
+)", {
+        {4, 1, "10"},                      // a = 10: only the first statement changes
+        {14, 0, ", y"},                    // def f(x, y): only the def is re-parsed
+        {0, 0, "import sys\n"},            // New first line: the rest moves down a line
+        {84, 0, "c = [g(),\n     g()]\n"}, // Append: g's body grows
+    }, "Incremental Re-parse");
+
+    // Test 42: Symbol table resolves globals, locals and distinct constants
+    test_disassembly_contains(R"(count = 0
+fs = [lambda: 1, lambda: 2]
+x = (0.1, 0.1000001)
+class C:
+    global count
+    count = 5
+    def bump(n):
+        global count
+        count = count + n
+        del n
+        return len(str(count))
+)", {
+        {"<module>", "2: <code object <lambda>>"},       // Two lambdas, two constants
+        {"<module>", "4: 0.1"},                          // Floats that print alike stay apart
+        {"C", "STORE_GLOBAL            3     (count)"},  // `global` in a class body
+        {"bump", "LOAD_GLOBAL             0     (count)"},
+        {"bump", "STORE_GLOBAL            0     (count)"},
+        {"bump", "DELETE_FAST             0     (n)"},
+        {"bump", "LOAD_GLOBAL             1     (len)"}, // Builtins skip the locals lookup
+    }, "Symbol Table Name Resolution");
+
+    // Test 43: Stack depth follows branches; jumps and lines survive EXTENDED_ARG
+    test_disassembly_contains(R"(x = a if c else b
+)", {
+        {"<module>", "co_stacksize: 1"},  // Only one arm's value is ever on the stack
+    }, "Stack Depth Across Branches");
+    test_line_table(R"(i = 0
+while i < 100:
+    i = i + 1
+    s = 'a' + 'b' + 'c' + 'd' + 'e' + 'f' + 'g' + 'h' + 'i' + 'j'
+    t = [i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i]
+    u = [i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i]
+    v = [i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i]
+    w = [i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i]
+)", "Line Table");
+
+    // Test 44: Generator flags come from the symbol table; genexprs and awaits suspend
+    test_disassembly_contains(R"(squares = (x * x for x in data if x)
+def gen(xs):
+    yield from xs
+async def co(a):
+    return await a
+)", {
+        {"<genexpr>", "co_flags: 0x23"},
+        {"<genexpr>", "co_varnames: ('.0', 'x')"},
+        {"<genexpr>", "YIELD_VALUE"},
+        {"<genexpr>", "END_FOR"},
+        {"gen", "co_flags: 0x23"},
+        {"gen", "END_SEND"},
+        {"co", "co_flags: 0x83"},
+        {"co", "JUMP_BACKWARD_NO_INTERRUPT"},
+    }, "Generators and Coroutines");
+
     std::cout << "=== All tests completed ===\n";
     return 0;
 }
@@ -3,7 +3,10 @@
 #include "src/compiler/bytecode_compiler.hpp"
 #include "src/vm/vm.hpp"
 #include "src/vm/builtins.hpp"
+#include "src/vm/event_loop.hpp"
+#include "src/vm/interpreter.hpp"
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <memory>
 
@@ -41,6 +44,331 @@ void test_vm(const std::string& name, const std::string& source) {
     }
 }
 
+/**
+ * Run the module, then call each entry function with its arguments:
+ * coroutines all run as tasks on one event loop, and every non-None
+ * result is printed. Top-level code after a def would end up in its
+ * body, so the calls come from here.
+ */
+using EntryCall = std::pair<std::string, std::vector<vm::PyObject>>;
+
+void test_vm_entry(const std::string& name, const std::string& source,
+                   const std::vector<EntryCall>& entries) {
+    std::cout << "=== Test: " << name << " ===\n";
+    std::cout << "Source:\n" << source << "\n\n";
+    
+    try {
+        parser::Parser parser(source);
+        auto module = parser.parse();
+        
+        compiler::BytecodeCompiler compiler;
+        auto code = compiler.compile(*module, "<test>");
+        
+        vm::VirtualMachine vm;
+        vm::EventLoop loop(vm);
+        
+        std::cout << "Output:\n";
+        vm.execute(code);
+        std::vector<std::pair<std::string, size_t>> tasks;
+        for (const auto& [entry, args] : entries) {
+            auto result = vm.call(vm.globals()->get(entry), args);
+            if (vm::is_coroutine(result)) {
+                tasks.emplace_back(entry, loop.create_task(std::move(result)));
+            } else if (!vm::is_none(result)) {
+                std::cout << entry << "() = " << vm::to_string(result) << "\n";
+            }
+        }
+        loop.run();
+        for (const auto& [entry, id] : tasks) {
+            if (!vm::is_none(loop.task(id).result)) {
+                std::cout << entry << "() = " << vm::to_string(loop.task(id).result) << "\n";
+            }
+        }
+        
+        std::cout << "\n✓ PASS\n\n";
+        
+    } catch (const std::exception& e) {
+        std::cout << "\n✗ FAIL: " << e.what() << "\n\n";
+    }
+}
+
+/**
+ * Independent interpreters run one shared CodeObject concurrently: each
+ * keeps its own globals and output, and the shared code is never written.
+ */
+void test_interpreters(const std::string& name, const std::string& setup, const std::string& source) {
+    std::cout << "=== Test: " << name << " ===\n";
+    std::cout << "Source:\n" << setup << "\n" << source << "\n\n";
+    
+    try {
+        auto compile = [](const std::string& text) {
+            parser::Parser parser(text);
+            auto module = parser.parse();
+            compiler::BytecodeCompiler compiler;
+            return compiler.compile(*module, "<test>");
+        };
+        auto setup_code = compile(setup);
+        auto code = compile(source);
+        auto bytecode = code->co_code;
+        
+        std::cout << "Output:\n";
+        std::vector<std::unique_ptr<vm::Interpreter>> interpreters;
+        for (int i = 0; i < 4; ++i) {
+            interpreters.push_back(std::make_unique<vm::Interpreter>());
+        }
+        std::vector<std::future<std::string>> outputs;
+        for (auto& interp : interpreters) {
+            outputs.push_back(interp->run(setup_code));
+        }
+        for (int round = 0; round < 3; ++round) {
+            for (auto& interp : interpreters) {
+                interp->run(code);
+            }
+        }
+        std::vector<std::future<std::string>> totals;
+        for (auto& interp : interpreters) {
+            totals.push_back(interp->submit([](vm::VirtualMachine& vm) {
+                return vm::to_string(vm.globals()->get("total"));
+            }));
+        }
+        for (size_t i = 0; i < interpreters.size(); ++i) {
+            std::string printed = outputs[i].get();
+            if (!printed.empty() && printed.back() == '\n') printed.pop_back();
+            std::cout << "interpreter " << i << ": printed '" << printed
+                      << "', total = " << totals[i].get() << "\n";
+        }
+        std::cout << "shared code unchanged: " << (code->co_code == bytecode ? "yes" : "no") << "\n";
+        
+        auto failing = interpreters[0]->run(compile("total = missing + 1"));
+        try {
+            failing.get();
+        } catch (const std::exception& e) {
+            std::cout << "error: " << e.what() << "\n";
+        }
+        
+        std::cout << "\n✓ PASS\n\n";
+        
+    } catch (const std::exception& e) {
+        std::cout << "\n✗ FAIL: " << e.what() << "\n\n";
+    }
+}
+
+/**
+ * Tuples and lists churned through by a loop come back to their size
+ * class's pools: the live block count returns to where it started and
+ * the arenas stay few however many objects the loop made.
+ */
+void test_object_pools(const std::string& name, const std::string& source) {
+    std::cout << "=== Test: " << name << " ===\n";
+    std::cout << "Source:\n" << source << "\n\n";
+    
+    try {
+        parser::Parser parser(source);
+        auto module = parser.parse();
+        compiler::BytecodeCompiler compiler;
+        auto code = compiler.compile(*module, "<test>");
+        
+        std::cout << "Output:\n";
+#if CPYTHON_CPP_SMALL_OBJECT_ALLOCATOR
+        auto& heap = core::SmallObjectAllocator::current();
+        core::GarbageCollector::current().collect();
+        auto before = heap.stats();
+        for (int i = 0; i < 3; ++i) {
+            vm::VirtualMachine vm;
+            vm.execute(code);
+        }
+        core::GarbageCollector::current().collect();
+        auto after = heap.stats();
+        std::cout << "blocks back to baseline: " << (after.blocks_in_use == before.blocks_in_use ? "yes" : "no")
+                  << ", arenas bounded: " << (after.max_arenas <= before.max_arenas + 2 ? "yes" : "no") << "\n";
+        
+        // The block a dead tuple leaves is the next one handed out
+        void* first = nullptr;
+        {
+            auto tuple = core::make_ref<vm::PyTuple>(std::vector<vm::PyObject>{vm::PyObject(1)});
+            first = tuple.get();
+        }
+        auto tuple = core::make_ref<vm::PyTuple>(std::vector<vm::PyObject>{vm::PyObject(2)});
+        std::cout << "freed block reused: " << (tuple.get() == first ? "yes" : "no") << "\n";
+#else
+        std::cout << "objects allocated with operator new\n";
+#endif
+        
+        std::cout << "\n✓ PASS\n\n";
+        
+    } catch (const std::exception& e) {
+        std::cout << "\n✗ FAIL: " << e.what() << "\n\n";
+    }
+}
+
+/**
+ * A module that defines functions leaves its globals and the functions
+ * referring to each other once the VM is gone; only the cycle collector
+ * can free them.
+ */
+void test_gc_cycles(const std::string& name, const std::string& source) {
+    std::cout << "=== Test: " << name << " ===\n";
+    std::cout << "Source:\n" << source << "\n\n";
+    
+    try {
+        parser::Parser parser(source);
+        auto module = parser.parse();
+        compiler::BytecodeCompiler compiler;
+        auto code = compiler.compile(*module, "<test>");
+        
+        auto& gc = core::GarbageCollector::current();
+        auto tracked = [&gc]() {
+            size_t total = 0;
+            for (int i = 0; i < core::GarbageCollector::GENERATIONS; ++i) total += gc.tracked(i);
+            return total;
+        };
+        auto run = [&code](int times) {
+            for (int i = 0; i < times; ++i) {
+                vm::VirtualMachine vm;
+                vm.execute(code);
+            }
+        };
+        
+        std::cout << "Output:\n";
+        gc.collect();
+        size_t baseline = tracked();
+        
+        // Manual: every VM leaves the same garbage behind
+        gc.disable();
+        run(10);
+        size_t unreachable = gc.collect();
+        std::cout << "unreachable after 10 runs: " << unreachable
+                  << ", back to baseline: " << (tracked() == baseline ? "yes" : "no") << "\n";
+        gc.enable();
+        
+        // Automatic: young collections keep the garbage bounded
+        uint64_t young = gc.stats(0).collections;
+        size_t threshold = gc.threshold(0);
+        gc.set_threshold(50, 10, 10);
+        run(200);
+        bool bounded = tracked() < baseline + 50 + unreachable;
+        gc.set_threshold(threshold, 10, 10);
+        std::cout << "young collections ran: " << (gc.stats(0).collections > young ? "yes" : "no")
+                  << ", bounded: " << (bounded ? "yes" : "no") << "\n";
+        gc.collect();
+        
+        std::cout << "\n✓ PASS\n\n";
+        
+    } catch (const std::exception& e) {
+        std::cout << "\n✗ FAIL: " << e.what() << "\n\n";
+    }
+}
+
+/**
+ * Profile the module, print the counts the profile must reproduce
+ * exactly (cycles vary from run to run), and check that both exports
+ * mention the lambda.
+ */
+void test_profiler(const std::string& name, const std::string& source) {
+    std::cout << "=== Test: " << name << " ===\n";
+    std::cout << "Source:\n" << source << "\n\n";
+    
+    try {
+        parser::Parser parser(source);
+        auto module = parser.parse();
+        compiler::BytecodeCompiler compiler;
+        auto code = compiler.compile(*module, "<test>");
+        
+        std::cout << "Output:\n";
+        vm::VirtualMachine vm;
+        vm.set_profiling(true);
+        vm.execute(code);
+        vm.set_profiling(false);
+        
+        const vm::Profiler& profile = vm.profiler();
+        using compiler::Opcode;
+        for (Opcode op : {Opcode::CALL, Opcode::BINARY_OP, Opcode::BINARY_OP_ADD_INT,
+                          Opcode::BINARY_OP_MULTIPLY_INT, Opcode::STORE_NAME}) {
+            const auto& stats = profile.opcode_stats(op);
+            std::cout << compiler::opcode_name(op) << ": " << stats.count;
+            if (stats.cache_hits + stats.cache_misses > 0) {
+                std::cout << " (cache " << stats.cache_hits << " hits, " << stats.cache_misses << " misses)";
+            }
+            if (stats.specializations > 0) {
+                std::cout << " (" << stats.specializations << " specialized)";
+            }
+            std::cout << "\n";
+        }
+        std::cout << "STORE_NAME -> LOAD_NAME: " << profile.pair_count(Opcode::STORE_NAME, Opcode::LOAD_NAME) << "\n";
+        
+        const vm::Profiler::CodeProfile* module_profile = profile.code_profile(*code);
+        uint64_t line_counts[8] = {};
+        for (size_t unit = 0; unit < module_profile->instructions.size(); ++unit) {
+            int line = module_profile->line_for_offset(static_cast<int>(unit * 2));
+            if (line >= 0 && line < 8) {
+                line_counts[line] += module_profile->instructions[unit].count;
+            }
+        }
+        std::cout << "instructions by line:";
+        for (int line = 1; line < 8; ++line) {
+            std::cout << " " << line_counts[line];
+        }
+        std::cout << "\n";
+        
+        std::ostringstream json, stacks;
+        profile.write_json(json);
+        profile.write_folded_stacks(stacks);
+        std::cout << "json names the lambda: " << (json.str().find("\"<lambda>\"") != std::string::npos ? "yes" : "no") << "\n";
+        std::cout << "stack <module>;<lambda>: " << (stacks.str().find("<module>;<lambda> ") != std::string::npos ? "yes" : "no") << "\n";
+        
+        // Off again: nothing more is recorded
+        uint64_t total = profile.total_instructions();
+        vm.execute(code);
+        std::cout << "unchanged when off: " << (profile.total_instructions() == total ? "yes" : "no") << "\n";
+        
+        std::cout << "\n✓ PASS\n\n";
+        
+    } catch (const std::exception& e) {
+        std::cout << "\n✗ FAIL: " << e.what() << "\n\n";
+    }
+}
+
+/**
+ * Hot code tiers up to native code: a loop switches over at its
+ * back-edge, a function once it has been called often enough, and a
+ * failed type guard falls back to the interpreter and recompiles. The
+ * results must match the interpreter's.
+ */
+void test_jit(const std::string& name, const std::string& source,
+              const std::string& entry, vm::PyObject arg) {
+    std::cout << "=== Test: " << name << " ===\n";
+    std::cout << "Source:\n" << source << "\n\n";
+    
+    try {
+        parser::Parser parser(source);
+        auto module = parser.parse();
+        compiler::BytecodeCompiler compiler;
+        auto code = compiler.compile(*module, "<test>");
+        
+        std::cout << "Output:\n";
+        std::string results[2];
+        vm::JitStats stats;
+        for (bool jit : {false, true}) {
+            vm::VirtualMachine vm;
+            vm.set_jit(jit);
+            vm.execute(code);
+            results[jit] = vm::to_string(vm.call(vm.globals()->get(entry), {arg}));
+            if (jit) stats = vm.jit_stats();
+        }
+        std::cout << entry << "() = " << results[1] << "\n";
+        std::cout << "matches interpreter: " << (results[0] == results[1] ? "yes" : "no") << "\n";
+#if CPYTHON_CPP_JIT
+        std::cout << "compiled: " << stats.compiled << ", calls entered: " << stats.entries
+                  << ", loop entries: " << stats.osr_entries << ", deopts: " << stats.deopts << "\n";
+#endif
+        
+        std::cout << "\n✓ PASS\n\n";
+        
+    } catch (const std::exception& e) {
+        std::cout << "\n✗ FAIL: " << e.what() << "\n\n";
+    }
+}
+
 int main() {
     std::cout << "========================================\n";
     std::cout << "  VM Test Suite - Phase 1\n";
@@ -121,6 +449,275 @@ z = x * y
 print(z)
 )");
     
+    // Test 13: While loop (backward jumps)
+    test_vm("While Loop", R"(
+i = 0
+while i < 3:
+    i = i + 1
+    print(i)
+)");
+    
+    // Test 14: Dict literal with mixed hashable keys
+    test_vm("Dict Literal", R"(
+d = {'b': 1, 2: 'two', 'a': 3, True: 4, 'b': 5}
+print(d)
+)");
+    
+    // Test 15: Set dedup, membership and algebra
+    test_vm("Set Operations", R"(
+s = {3, 1, 3, 2, 1}
+t = set([2, 3, 4, 4])
+print(s)
+print(2 in s, 5 in s, 4 not in s)
+print(s | t)
+print(s & t)
+)");
+    
+    // Test 16: List/tuple literals and calls keep operand order
+    test_vm("Build Sequences", R"(
+x = [1, 'a', 2.5, [3, 4]]
+t = (5, 6, 7)
+print(x, t, 8, 9)
+)");
+    
+    // Test 17: Inline caches see a global shadowing a cached builtin
+    test_vm("Global Shadows Builtin", R"(
+i = 0
+while i < 2:
+    print(set)
+    set = 'shadowed'
+    i = i + 1
+)");
+    
+    test_vm("Specialize And Deopt", R"(
+i = 0
+x = 1
+while i < 20:
+    x = x + (0.5 if i >= 10 else i)
+    i = i + 1
+print(x)
+print(7 // -2, 7 % -2, 7 / 2)
+)");
+    
+    test_vm("Folded Constants And Constant Branches", R"(
+print((2 + 3) * 4 - -1, 7 // -2, 2 ** 10, 'ab' + 'cd')
+while True:
+    print('once')
+    break
+)");
+    
+    test_vm("Jumps Past 255 Bytes", R"(
+i = 0
+t = 0
+while i < 3:
+    t = t + 0
+    t = t + 1
+    t = t + 2
+    t = t + 3
+    t = t + 4
+    t = t + 5
+    t = t + 6
+    t = t + 0
+    t = t + 1
+    t = t + 2
+    t = t + 3
+    t = t + 4
+    t = t + 5
+    t = t + 6
+    t = t + 0
+    t = t + 1
+    t = t + 2
+    t = t + 3
+    t = t + 4
+    t = t + 5
+    t = t + 6
+    t = t + 0
+    t = t + 1
+    t = t + 2
+    t = t + 3
+    t = t + 4
+    t = t + 5
+    t = t + 6
+    t = t + 0
+    t = t + 1
+    t = t + 2
+    t = t + 3
+    t = t + 4
+    t = t + 5
+    t = t + 6
+    t = t + 0
+    t = t + 1
+    t = t + 2
+    t = t + 3
+    t = t + 4
+    i = i + 1
+print(i, t)
+)");
+    
+    // Test: Calls into Python functions (lambdas: a def body runs to EOF here)
+    test_vm("Function Calls", R"(
+add = lambda a, b: a + b
+twice = lambda f, x: f(f(x, x), x)
+print(add(2, 3), add("a", "b"), twice(add, 4))
+)");
+    
+    // Test: Recursion through the frame stack
+    test_vm("Recursive Calls", R"(
+fib = lambda n: n if n < 2 else fib(n - 1) + fib(n - 2)
+depth = lambda n: 0 if n == 0 else 1 + depth(n - 1)
+print(fib(15), depth(900))
+)");
+    
+    // Test: Generators resumed by next(), for loops and generator expressions
+    test_vm_entry("Generators", R"(
+def count(n):
+    i = 0
+    while i < n:
+        yield i
+        i = i + 1
+def main():
+    g = count(3)
+    print(next(g), next(g), next(g), next(g, "done"))
+    evens = (x * 2 for x in count(4) if x != 2)
+    for x in evens:
+        print(x)
+)", {{"main", {}}});
+    
+    // Test: send() and yield from delegation with a return value
+    test_vm_entry("Yield From and Send", R"(
+def inner():
+    x = yield 1
+    y = yield x + 1
+    return x + y
+def outer():
+    r = yield from inner()
+    yield r * 10
+def main():
+    g = outer()
+    print(next(g), g.send(5), g.send(7))
+    print(next(g, "exhausted"))
+)", {{"main", {}}});
+    
+    // Test: Coroutines interleaved on the event loop's ready queue
+    test_vm_entry("Coroutines on the Event Loop", R"(
+async def countdown(name, n):
+    print(name, n)
+    await sleep(0)
+    return name if n == 0 else await countdown(name, n - 1)
+)", {{"countdown", {vm::PyObject("a"), vm::PyObject(2)}},
+     {"countdown", {vm::PyObject("b"), vm::PyObject(1)}}});
+
+    // Test: Lazy range() and the iterator protocol of the built-in containers
+    test_vm("Range and Iteration", R"(
+print([i * i for i in range(5)], [i for i in range(10, 0, -3)], len(range(0, 10, 3)))
+print([c for c in 'abc'], [k for k in {'x': 1, 'y': 2}], [t for t in (1, 2)], set(range(3)))
+print(3 in range(0, 10, 3), 4 in range(0, 10, 3), range(2, 8, 2), range(-5), [i for i in range(-5)])
+it = iter([1, 2])
+print(next(it), next(it), next(it, 'end'))
+for i in range(3):
+    print(i)
+)");
+
+    // Test: FOR_ITER specializes to the iterator it sees and deopts on another
+    test_vm_entry("Specialized FOR_ITER", R"(
+def squares(xs):
+    return [x * x for x in xs]
+def flatten(xs):
+    yield from xs
+def main():
+    print(squares(range(12)), squares([i for i in range(12)]))
+    print(squares((1, 2, 3)), squares(range(12, 0, -4)), squares(flatten([5, 6])))
+)", {{"main", {}}});
+    
+    // Test: f-strings with conversions and format specs, built in one pass
+    test_vm("F-strings", R"(
+name = 'py'
+n = 42
+x = 3.14159
+print(f"{name}:{n}", f"{name!r:>6}|{n:05d}|{n:x}|{255:X}|{n:,}|{x:.2f}|{x:10.3e}|", f"{'qqq':^7}|{-n:+}|{1234567:_}")
+print(f"{0.25:.1%}", f"{n:b}", f"{name:.1}", f"{[1, 'a']}", f"{True}", f"{x}", f"{5:<3}|{'s':*>3}")
+)");
+
+    // Test: names, strings and numbers longer than one scanner vector
+    test_vm("Long Names and Literals", R"(
+a_rather_long_variable_name_spanning_two_vectors = 'a string constant that runs well past thirty-two bytes, \'escaped\' near the end'
+also_long_0123456789_abcdefghijklmnopqrstuvwxyzABC = 123456789012345678 + 1
+print(a_rather_long_variable_name_spanning_two_vectors, len(a_rather_long_variable_name_spanning_two_vectors))
+print(also_long_0123456789_abcdefghijklmnopqrstuvwxyzABC, 0.000000000000000000001234567890123)
+)");
+
+    // Test: `s += x` appends in place while the variable holds the only reference
+    test_vm_entry("In-place String Append", R"(
+def build(n):
+    s = ''
+    i = 0
+    while i < n:
+        s += 'ab'
+        i = i + 1
+    else:
+        return s
+def keep(n):
+    parts = []
+    s = 'x'
+    i = 0
+    while i < n:
+        parts = [parts, s]
+        s += 'y'
+        i = i + 1
+    else:
+        return parts
+)", {{"build", {vm::PyObject(5)}}, {"keep", {vm::PyObject(3)}}});
+    
+    test_gc_cycles("Cycle Collection", R"(
+def f(x):
+    return [x, f]
+g = lambda: f
+h = (f, g)
+)");
+    
+    test_object_pools("Object Pools", R"(
+i = 0
+while i < 20000:
+    t = (i, [i, i], (i, 'x'))
+    i = i + 1
+)");
+    
+    test_interpreters("Isolated Interpreters", R"(
+total = 0
+print('ready', total)
+)", R"(
+total = total + 1
+i = 0
+while i < 5000:
+    total = total + i
+    i = i + 1
+)");
+    
+    test_profiler("Opcode Profiler", R"(
+sq = lambda x: x * x
+total = 0
+i = 0
+while i < 1000:
+    total = total + sq(i)
+    i = i + 1
+else:
+    print(total)
+)");
+    
+    test_jit("Baseline JIT", R"(
+sq = lambda v: v * v
+def scale(n):
+    total = 0
+    x = 0
+    i = 0
+    while i < n:
+        total = total + sq(i) - 3 * i
+        x = x + (0.5 if i >= 3000 else i)
+        i = i + 1
+    else:
+        return [total, x, i < n, x > 4000000.0]
+)", "scale", vm::PyObject(6000));
+    
     std::cout << "========================================\n";
     std::cout << "  All tests completed!\n";
     std::cout << "========================================\n";
@@ -0,0 +1,10 @@
+# Test 16: Deeply nested subscripts
+# Category: Backtracking / Packrat Memoization
+# Priority: P1 Important
+# Expected: PASS in linear time (each level tries slice notation first)
+
+# Every subscript is first tried as a slice, then re-parsed as an
+# expression; without memoization this doubles the work per level
+x = a[b[c[d[e[f[g[h[i[j[k[l[m[n[o[p[q[r[s[t[u[v[w[x[y[z[0]]]]]]]]]]]]]]]]]]]]]]]]]]
+y = m[n[i:j][k], o[p[q[0]:r[1]]]]
+z: dict[str, list[dict[str, list[tuple[int, str]]]]] = {}